@@ -110,6 +110,128 @@ ReadWriteRpmb (
   return Status;
 }
 
+/**
+  Returns the size of the RPMB backed file, i.e. the variable store, the FTW
+  working area and the FTW spare area.
+
+  @retval    Size of the RPMB file in bytes
+**/
+STATIC
+UINTN
+RpmbFileSize (
+  VOID
+  )
+{
+  return PcdGet32 (PcdFlashNvStorageVariableSize) +
+         PcdGet32 (PcdFlashNvStorageFtwWorkingSize) +
+         PcdGet32 (PcdFlashNvStorageFtwSpareSize);
+}
+
+/**
+  Write all pending ranges of the in-memory copy to the RPMB.
+
+  Ranges are written in the order they were issued, each of them widened
+  to whole RPMB frames, so an interrupted flush leaves the device with a
+  prefix of the issued writes. Ranges which could not be written are kept
+  pending and retried by the next flush.
+
+  @param[in,out] Instance  MEM_INSTANCE pointer describing the device
+
+  @retval    EFI_SUCCESS           All pending ranges were written
+  @retval    EFI_UNSUPPORTED       SVC to op-tee not supported
+  @retval    EFI_INVALID_PARAMETER SVC to op-tee had an invalid param
+  @retval    EFI_ACCESS_DENIED     SVC to op-tee was denied
+  @retval    EFI_OUT_OF_RESOURCES  op-tee out of memory
+**/
+STATIC
+EFI_STATUS
+FlushDirtyRanges (
+  IN OUT MEM_INSTANCE *Instance
+  )
+{
+  RPMB_DIRTY_RANGE *Range;
+  EFI_STATUS       Status;
+  UINTN            Start;
+  UINTN            End;
+  UINTN            Index;
+
+  Status = EFI_SUCCESS;
+  for (Index = 0; Index < Instance->NDirtyRanges; Index++) {
+    Range = &Instance->DirtyRanges[Index];
+    Start = Range->Start & ~(RPMB_FRAME_SIZE - 1);
+    End = MIN (ALIGN_VALUE (Range->End, RPMB_FRAME_SIZE), RpmbFileSize ());
+
+    Status = ReadWriteRpmb (
+               SP_SVC_RPMB_WRITE,
+               (UINTN)Instance->MemBaseAddress + Start,
+               End - Start,
+               Start
+               );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  Instance->NDirtyRanges -= Index;
+  CopyMem (
+    Instance->DirtyRanges,
+    &Instance->DirtyRanges[Index],
+    Instance->NDirtyRanges * sizeof (RPMB_DIRTY_RANGE)
+    );
+
+  return Status;
+}
+
+/**
+  Record a write of the in-memory copy for the next flush.
+
+  A write extending the most recently issued range is merged into it, so
+  the erase of several blocks, or a write following one which could not
+  be flushed, goes out in as few RPMB frames as possible.
+
+  @param[in,out] Instance  MEM_INSTANCE pointer describing the device
+  @param[in]     Start     Offset into the RPMB file of the first byte
+  @param[in]     End       Offset into the RPMB file past the last byte
+
+  @retval    EFI_SUCCESS           Write recorded
+  @retval    EFI_UNSUPPORTED       SVC to op-tee not supported
+  @retval    EFI_INVALID_PARAMETER SVC to op-tee had an invalid param
+  @retval    EFI_ACCESS_DENIED     SVC to op-tee was denied
+  @retval    EFI_OUT_OF_RESOURCES  op-tee out of memory
+**/
+STATIC
+EFI_STATUS
+AddDirtyRange (
+  IN OUT MEM_INSTANCE *Instance,
+  IN     UINTN        Start,
+  IN     UINTN        End
+  )
+{
+  RPMB_DIRTY_RANGE *Last;
+  EFI_STATUS       Status;
+
+  if (Instance->NDirtyRanges > 0) {
+    Last = &Instance->DirtyRanges[Instance->NDirtyRanges - 1];
+    if (Start == Last->End) {
+      Last->End = End;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (Instance->NDirtyRanges == RPMB_MAX_DIRTY_RANGES) {
+    Status = FlushDirtyRanges (Instance);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  Instance->DirtyRanges[Instance->NDirtyRanges].Start = Start;
+  Instance->DirtyRanges[Instance->NDirtyRanges].End = End;
+  Instance->NDirtyRanges++;
+
+  return EFI_SUCCESS;
+}
+
 /**
   The GetAttributes() function retrieves the attributes and
   current settings of the block.
@@ -345,6 +467,10 @@ OpTeeRpmbFvbRead (
   fully flushed to the hardware before the Write() service
   returns.
 
+  The in-memory copy is updated first and the RPMB frames it covers are
+  written from it before returning. Frames which could not be written stay
+  pending and are retried by the next Write() or EraseBlocks().
+
   @param[in]     This                Indicates the EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL
                                      instance.
   @param[in]     Lba                 The starting logical block index to write to.
@@ -390,20 +516,19 @@ OpTeeRpmbFvbWrite (
   }
   Base = (VOID *)(UINTN)Instance->MemBaseAddress + (Lba * Instance->BlockSize) +
          Offset;
-  Status = ReadWriteRpmb (
-             SP_SVC_RPMB_WRITE,
-             (UINTN)Buffer,
-             *NumBytes,
-             (Lba * Instance->BlockSize) + Offset
+  Status = AddDirtyRange (
+             Instance,
+             (Lba * Instance->BlockSize) + Offset,
+             (Lba * Instance->BlockSize) + Offset + *NumBytes
              );
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
-  // Update the memory copy
+  // Update the memory copy and write the frames it covers to the device
   CopyMem (Base, Buffer, *NumBytes);
 
-  return Status;
+  return FlushDirtyRanges (Instance);
 }
 
 /**
@@ -464,47 +589,48 @@ OpTeeRpmbFvbErase (
   UINTN   NumLba;
   EFI_LBA Start;
   VOID    *Base;
-  VOID    *Buf;
   VA_LIST Args;
   EFI_STATUS Status;
 
   Instance = INSTANCE_FROM_FVB_THIS (This);
 
+  // Check the whole list before erasing anything
   VA_START (Args, This);
   for (Start = VA_ARG (Args, EFI_LBA);
        Start != EFI_LBA_LIST_TERMINATOR;
        Start = VA_ARG (Args, EFI_LBA)) {
     NumLba = VA_ARG (Args, UINTN);
     if (NumLba == 0 || Start + NumLba > Instance->NBlocks) {
+      VA_END (Args);
       return EFI_INVALID_PARAMETER;
     }
+  }
+  VA_END (Args);
+
+  VA_START (Args, This);
+  for (Start = VA_ARG (Args, EFI_LBA);
+       Start != EFI_LBA_LIST_TERMINATOR;
+       Start = VA_ARG (Args, EFI_LBA)) {
+    NumLba = VA_ARG (Args, UINTN);
     NumBytes = NumLba * Instance->BlockSize;
-    Base = (VOID *)(UINTN)Instance->MemBaseAddress +
-           (Start * Instance->BlockSize);
-    Buf = AllocatePool (NumLba * Instance->BlockSize);
-    if (Buf == NULL) {
-      return EFI_DEVICE_ERROR;
-    }
-    SetMem64 (Buf, NumLba * Instance->BlockSize, ~0UL);
-    // Write the device
-    Status = ReadWriteRpmb (
-               SP_SVC_RPMB_WRITE,
-               (UINTN)Buf,
-               NumBytes,
-               Start * Instance->BlockSize
+    Status = AddDirtyRange (
+               Instance,
+               Start * Instance->BlockSize,
+               (Start * Instance->BlockSize) + NumBytes
                );
     if (EFI_ERROR (Status)) {
-      FreePool (Buf);
+      VA_END (Args);
       return Status;
     }
     // Update the in memory copy
-    SetMem64 (Base, NumLba * Instance->BlockSize, ~0UL);
-    FreePool (Buf);
+    Base = (VOID *)(UINTN)Instance->MemBaseAddress +
+           (Start * Instance->BlockSize);
+    SetMem64 (Base, NumBytes, ~0UL);
   }
-
   VA_END (Args);
 
-  return EFI_SUCCESS;
+  // Write the device, adjacent ranges go out as one request
+  return FlushDirtyRanges (Instance);
 }
 
 /**
@@ -32,6 +32,26 @@
 #define INSTANCE_FROM_FVB_THIS(a)  CR (a, MEM_INSTANCE, FvbProtocol, \
                                       FLASH_SIGNATURE)
 
+/**
+ Size of an RPMB data frame. Pending ranges are widened to this
+ granularity before they are sent to OP-TEE.
+**/
+#define RPMB_FRAME_SIZE            256
+
+/**
+ Maximum number of disjoint ranges kept pending before they are flushed.
+**/
+#define RPMB_MAX_DIRTY_RANGES      16
+
+/**
+ Byte range [Start, End) of the in-memory copy which has not been
+ written to the RPMB yet.
+**/
+typedef struct {
+    UINTN                               Start;
+    UINTN                               End;
+} RPMB_DIRTY_RANGE;
+
 typedef struct _MEM_INSTANCE         MEM_INSTANCE;
 typedef EFI_STATUS (*MEM_INITIALIZE) (MEM_INSTANCE* Instance);
 
@@ -58,6 +78,10 @@ struct _MEM_INSTANCE
     UINT16                              BlockSize;
     /// Number of allocated blocks
     UINT16                              NBlocks;
+    /// Ranges not written to the RPMB yet, in the order they were issued
+    RPMB_DIRTY_RANGE                    DirtyRanges[RPMB_MAX_DIRTY_RANGES];
+    /// Number of pending ranges
+    UINTN                               NDirtyRanges;
 };
 
 #endif
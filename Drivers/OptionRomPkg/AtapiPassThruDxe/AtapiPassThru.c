@@ -239,6 +239,7 @@ Returns:
                     );
   if (!EFI_ERROR (Status)) {
     Supports &= (EFI_PCI_DEVICE_ENABLE               |
+                 EFI_PCI_IO_ATTRIBUTE_BUS_MASTER     |
                  EFI_PCI_IO_ATTRIBUTE_IDE_PRIMARY_IO |
                  EFI_PCI_IO_ATTRIBUTE_IDE_SECONDARY_IO);
     Status = PciIo->Attributes (
@@ -369,6 +370,18 @@ Returns:
     return Status;
   }
 
+  DEBUG ((
+    EFI_D_INFO,
+    "AtapiScsiPassThru: DMA %Ld commands/%Ld bytes, PIO %Ld commands/%Ld bytes, %Ld DMA fallbacks\n",
+    AtapiScsiPrivate->Statistics.DmaCommands,
+    AtapiScsiPrivate->Statistics.DmaBytes,
+    AtapiScsiPrivate->Statistics.PioCommands,
+    AtapiScsiPrivate->Statistics.PioBytes,
+    AtapiScsiPrivate->Statistics.DmaFallbacks
+    ));
+
+  AtapiPassThruDmaFree (AtapiScsiPrivate);
+
   //
   // Restore original PCI attributes
   //
@@ -416,6 +429,7 @@ Returns:
   EFI_STATUS                Status;
   ATAPI_SCSI_PASS_THRU_DEV  *AtapiScsiPrivate;
   IDE_REGISTERS_BASE_ADDR   IdeRegsBaseAddr[ATAPI_MAX_CHANNEL];
+  UINT16                    BusMasterBaseAddr;
 
   AtapiScsiPrivate = AllocateZeroPool (sizeof (ATAPI_SCSI_PASS_THRU_DEV));
   if (AtapiScsiPrivate == NULL) {
@@ -435,12 +449,13 @@ Returns:
   //
   // Obtain IDE IO port registers' base addresses
   //
-  Status = GetIdeRegistersBaseAddr (PciIo, IdeRegsBaseAddr);
+  Status = GetIdeRegistersBaseAddr (PciIo, IdeRegsBaseAddr, &BusMasterBaseAddr);
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
   InitAtapiIoPortRegisters(AtapiScsiPrivate, IdeRegsBaseAddr);
+  AtapiPassThruDmaInit (AtapiScsiPrivate, BusMasterBaseAddr);
 
   //
   // Initialize the LatestTargetId to MAX_TARGET_ID.
@@ -449,6 +464,9 @@ Returns:
   AtapiScsiPrivate->LatestLun       = 0;
 
   Status = InstallScsiPassThruProtocols (&Controller, AtapiScsiPrivate);
+  if (EFI_ERROR (Status)) {
+    AtapiPassThruDmaFree (AtapiScsiPrivate);
+  }
 
   return Status;
 }
@@ -1546,7 +1564,8 @@ Returns:
 EFI_STATUS
 GetIdeRegistersBaseAddr (
   IN  EFI_PCI_IO_PROTOCOL         *PciIo,
-  OUT IDE_REGISTERS_BASE_ADDR     *IdeRegsBaseAddr
+  OUT IDE_REGISTERS_BASE_ADDR     *IdeRegsBaseAddr,
+  OUT UINT16                      *BusMasterBaseAddr
   )
 /*++
 
@@ -1559,6 +1578,8 @@ Arguments:
   PciIo             - Pointer to the EFI_PCI_IO_PROTOCOL instance
   IdeRegsBaseAddr   - Pointer to IDE_REGISTERS_BASE_ADDR to
                       receive IDE IO port registers' base addresses
+  BusMasterBaseAddr - Receives the Bus Master IDE base address from BAR4,
+                      or 0 if the controller is not bus master capable
 
 Returns:
 
@@ -1617,6 +1638,16 @@ Returns:
     (UINT16) ((PciData.Device.Bar[3] & 0x0000fffc) + 2);
   }
 
+  //
+  // The Bus Master IDE register block lives in BAR4, which is only
+  // meaningful when the programming interface advertises bus mastering.
+  //
+  *BusMasterBaseAddr = 0;
+  if ((PciData.Hdr.ClassCode[0] & IDE_BUS_MASTER_CAPABLE) != 0 &&
+      (PciData.Device.Bar[4] & BIT0) != 0) {
+    *BusMasterBaseAddr = (UINT16) (PciData.Device.Bar[4] & 0x0000fff0);
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -2125,52 +2156,31 @@ Arguments:
 }
 
 
-EFI_STATUS
-AtapiPacketCommand (
-  ATAPI_SCSI_PASS_THRU_DEV    *AtapiScsiPrivate,
-  UINT32                      Target,
-  UINT8                       *PacketCommand,
-  VOID                        *Buffer,
-  UINT32                      *ByteCount,
-  DATA_DIRECTION              Direction,
-  UINT64                      TimeoutInMicroSeconds
-  )
-/*++
-
-Routine Description:
-
-  Submits ATAPI command packet to the specified ATAPI device.
-
-Arguments:
-
-  AtapiScsiPrivate:   Private data structure for the specified channel.
-  Target:             The Target ID of the ATAPI device to send the SCSI
-                      Request Packet. To ATAPI devices attached on an IDE
-                      Channel, Target ID 0 indicates Master device;Target
-                      ID 1 indicates Slave device.
-  PacketCommand:      Points to the ATAPI command packet.
-  Buffer:             Points to the transferred data.
-  ByteCount:          When input,indicates the buffer size; when output,
-                      indicates the actually transferred data size.
-  Direction:          Indicates the data transfer direction.
-  TimeoutInMicroSeconds:
-                      The timeout, in micro second units, to use for the
-                      execution of this ATAPI command.
-                      A TimeoutInMicroSeconds value of 0 means that
-                      this function will wait indefinitely for the ATAPI
-                      command to execute.
-                      If TimeoutInMicroSeconds is greater than zero, then
-                      this function will return EFI_TIMEOUT if the time
-                      required to execute the ATAPI command is greater
-                      than TimeoutInMicroSeconds.
+/**
+  Selects the target, programs the task file and sends the ATAPI command
+  packet, leaving the device ready for its data phase.
 
-Returns:
+  @param AtapiScsiPrivate       Private data structure for the specified channel.
+  @param Target                 0 for the master device, 1 for the slave device.
+  @param PacketCommand          Points to the ATAPI command packet.
+  @param Feature                Value of the Feature register (OVL/DMA bits).
+  @param TimeoutInMicroSeconds  The timeout, 0 means wait indefinitely.
 
-  EFI_STATUS
+  @retval EFI_SUCCESS           The command packet was accepted.
+  @retval EFI_ABORTED           The device aborted the command.
+  @retval other                 The device did not become ready.
 
---*/
+**/
+STATIC
+EFI_STATUS
+AtapiPassThruIssuePacket (
+  IN ATAPI_SCSI_PASS_THRU_DEV    *AtapiScsiPrivate,
+  IN UINT32                      Target,
+  IN UINT8                       *PacketCommand,
+  IN UINT8                       Feature,
+  IN UINT64                      TimeoutInMicroSeconds
+  )
 {
-
   UINT16      *CommandIndex;
   UINT8       Count;
   EFI_STATUS  Status;
@@ -2200,22 +2210,17 @@ Returns:
   // Before write to all the following registers, BSY DRQ must be 0.
   //
   Status =  StatusDRQClear(AtapiScsiPrivate,  TimeoutInMicroSeconds);
-
   if (EFI_ERROR (Status)) {
-    if (Status == EFI_ABORTED) {
-      Status = EFI_DEVICE_ERROR;
-    }
-    *ByteCount = 0;
     return Status;
   }
 
   //
-  // No OVL; No DMA (by setting feature register)
+  // No OVL; DMA only when requested (by setting feature register)
   //
   WritePortB (
     AtapiScsiPrivate->PciIo,
     AtapiScsiPrivate->IoPort->Reg1.Feature,
-    0x00
+    Feature
     );
 
   //
@@ -2235,12 +2240,14 @@ Returns:
 
   //
   //  DEFAULT_CTL:0x0a (0000,1010)
-  //  Disable interrupt
+  //  Disable interrupt. A DMA command lets the device drive INTRQ, so the
+  //  bus master latches BMIS_INTERRUPT when the command completes; nothing
+  //  is hooked to the interrupt line itself.
   //
   WritePortB (
     AtapiScsiPrivate->PciIo,
     AtapiScsiPrivate->IoPort->Alt.DeviceControl,
-    DEFAULT_CTL
+    (UINT8) (((Feature & DMA) != 0) ? (DEFAULT_CTL & ~IEN_L) : DEFAULT_CTL)
     );
 
   //
@@ -2260,11 +2267,6 @@ Returns:
   //
   Status = StatusDRQReady (AtapiScsiPrivate, TimeoutInMicroSeconds);
   if (EFI_ERROR (Status)) {
-    if (Status == EFI_ABORTED) {
-      Status = EFI_DEVICE_ERROR;
-    }
-
-    *ByteCount = 0;
     return Status;
   }
 
@@ -2276,17 +2278,260 @@ Returns:
     WritePortW (AtapiScsiPrivate->PciIo, AtapiScsiPrivate->IoPort->Data, *CommandIndex);
   }
 
+  return EFI_SUCCESS;
+}
+
+/**
+  Checks whether a command can be moved by the bus master of the current
+  channel.
+
+  ATAPI DMA does not report a residual byte count, so only the block
+  read/write commands are eligible, and only when the transfer length of
+  the CDB, in CD or disk blocks, covers the whole buffer. The byte count
+  returned for a DMA transfer is then exact. Everything else (INQUIRY,
+  REQUEST SENSE, MODE SENSE, READ CD, ...) stays in PIO.
+
+  @param AtapiScsiPrivate   Private data structure for the specified channel.
+  @param Target             0 for the master device, 1 for the slave device.
+  @param PacketCommand      Points to the ATAPI command packet.
+  @param Buffer             Points to the transferred data.
+  @param ByteCount          Size of the transfer in bytes.
+
+  @retval TRUE              The command should be tried in DMA mode.
+  @retval FALSE             The command must use PIO.
+
+**/
+STATIC
+BOOLEAN
+AtapiPassThruUseDma (
+  IN ATAPI_SCSI_PASS_THRU_DEV    *AtapiScsiPrivate,
+  IN UINT32                      Target,
+  IN UINT8                       *PacketCommand,
+  IN VOID                        *Buffer,
+  IN UINT32                      ByteCount
+  )
+{
+  ATAPI_DMA_CHANNEL *Channel;
+  UINT32            Blocks;
+
+  Channel = &AtapiScsiPrivate->DmaChannel[ATAPI_CURRENT_CHANNEL (AtapiScsiPrivate)];
+  if (Channel->PrdTable == NULL || Channel->DmaDisabled[Target]) {
+    return FALSE;
+  }
+
+  if (Buffer == NULL || ByteCount == 0 || (ByteCount & 1) != 0 ||
+      ByteCount > ATAPI_DMA_MAX_TRANSFER) {
+    return FALSE;
+  }
+
+  switch (PacketCommand[0]) {
+  case OP_READ_10:
+  case OP_WRITE_10:
+  case OP_WRITE_AND_VERIFY:
+    Blocks = ((UINT32) PacketCommand[7] << 8) | PacketCommand[8];
+    break;
+
+  case OP_READ_12:
+  case OP_WRITE_12:
+    Blocks = ((UINT32) PacketCommand[6] << 24) | ((UINT32) PacketCommand[7] << 16) |
+             ((UINT32) PacketCommand[8] << 8) | PacketCommand[9];
+    break;
+
+  default:
+    return FALSE;
+  }
+
+  return (BOOLEAN) (Blocks != 0 &&
+                    (ByteCount == MultU64x32 (Blocks, ATAPI_CD_BLOCK_SIZE) ||
+                     ByteCount == MultU64x32 (Blocks, ATAPI_DISK_BLOCK_SIZE)));
+}
+
+/**
+  Resets a device of the current channel with the ATAPI DEVICE RESET
+  command, so a DMA transfer the device or the bus master gave up on does
+  not leave it in the middle of a data phase.
+
+  @param AtapiScsiPrivate   Private data structure for the specified channel.
+  @param Target             0 for the master device, 1 for the slave device.
+
+  @retval EFI_SUCCESS       The device completed the reset.
+  @retval EFI_TIMEOUT       The device did not clear BSY.
+
+**/
+STATIC
+EFI_STATUS
+AtapiPassThruResetDevice (
+  IN ATAPI_SCSI_PASS_THRU_DEV    *AtapiScsiPrivate,
+  IN UINT32                      Target
+  )
+{
+  WritePortB (
+    AtapiScsiPrivate->PciIo,
+    AtapiScsiPrivate->IoPort->Head,
+    (UINT8) ((Target << 4) | DEFAULT_CMD)
+    );
+  WritePortB (
+    AtapiScsiPrivate->PciIo,
+    AtapiScsiPrivate->IoPort->Reg.Command,
+    ATAPI_SOFT_RESET_CMD
+    );
+
+  //
+  // slave device needs at most 31s to clear BSY
+  //
+  if (EFI_ERROR (StatusWaitForBSYClear (AtapiScsiPrivate, 31000000))) {
+    return EFI_TIMEOUT;
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+AtapiPacketCommand (
+  ATAPI_SCSI_PASS_THRU_DEV    *AtapiScsiPrivate,
+  UINT32                      Target,
+  UINT8                       *PacketCommand,
+  VOID                        *Buffer,
+  UINT32                      *ByteCount,
+  DATA_DIRECTION              Direction,
+  UINT64                      TimeoutInMicroSeconds
+  )
+/*++
+
+Routine Description:
+
+  Submits ATAPI command packet to the specified ATAPI device.
+  Block read/write commands use the Bus Master IDE engine when the channel
+  and the device support it, anything else or a rejected DMA transfer is
+  carried out in PIO mode.
+
+Arguments:
+
+  AtapiScsiPrivate:   Private data structure for the specified channel.
+  Target:             The Target ID of the ATAPI device to send the SCSI
+                      Request Packet. To ATAPI devices attached on an IDE
+                      Channel, Target ID 0 indicates Master device;Target
+                      ID 1 indicates Slave device.
+  PacketCommand:      Points to the ATAPI command packet.
+  Buffer:             Points to the transferred data.
+  ByteCount:          When input,indicates the buffer size; when output,
+                      indicates the actually transferred data size.
+  Direction:          Indicates the data transfer direction.
+  TimeoutInMicroSeconds:
+                      The timeout, in micro second units, to use for the
+                      execution of this ATAPI command.
+                      A TimeoutInMicroSeconds value of 0 means that
+                      this function will wait indefinitely for the ATAPI
+                      command to execute.
+                      If TimeoutInMicroSeconds is greater than zero, then
+                      this function will return EFI_TIMEOUT if the time
+                      required to execute the ATAPI command is greater
+                      than TimeoutInMicroSeconds.
+
+Returns:
+
+  EFI_STATUS
+
+--*/
+{
+  ATAPI_DMA_CHANNEL *Channel;
+  UINT32            TransferLength;
+  BOOLEAN           DmaAborted;
+  EFI_STATUS        Status;
+
+  DmaAborted = FALSE;
+
+  if (AtapiPassThruUseDma (AtapiScsiPrivate, Target, PacketCommand, Buffer, *ByteCount)) {
+    TransferLength = *ByteCount;
+    Status = AtapiPassThruDmaPacketCommand (
+               AtapiScsiPrivate,
+               Target,
+               PacketCommand,
+               Buffer,
+               &TransferLength,
+               Direction,
+               TimeoutInMicroSeconds
+               );
+    if (Status != EFI_UNSUPPORTED && Status != EFI_ABORTED) {
+      if (!EFI_ERROR (Status)) {
+        AtapiScsiPrivate->Statistics.DmaCommands++;
+        AtapiScsiPrivate->Statistics.DmaBytes += TransferLength;
+      }
+      *ByteCount = TransferLength;
+      return Status;
+    }
+
+    DmaAborted = (BOOLEAN) (Status == EFI_ABORTED);
+    if (DmaAborted) {
+      Status = AtapiPassThruResetDevice (AtapiScsiPrivate, Target);
+      if (EFI_ERROR (Status)) {
+        *ByteCount = 0;
+        return EFI_DEVICE_ERROR;
+      }
+
+      if (Direction != DataIn) {
+        //
+        // Part of the data may already be on the medium, do not write it a
+        // second time. Later commands use PIO on this device.
+        //
+        Channel = &AtapiScsiPrivate->DmaChannel[ATAPI_CURRENT_CHANNEL (AtapiScsiPrivate)];
+        Channel->DmaDisabled[Target] = TRUE;
+        AtapiScsiPrivate->Statistics.DmaFallbacks++;
+        *ByteCount = 0;
+        return EFI_DEVICE_ERROR;
+      }
+    }
+  }
+
+  Status = AtapiPassThruIssuePacket (
+             AtapiScsiPrivate,
+             Target,
+             PacketCommand,
+             0,
+             TimeoutInMicroSeconds
+             );
+  if (EFI_ERROR (Status)) {
+    if (Status == EFI_ABORTED) {
+      Status = EFI_DEVICE_ERROR;
+    }
+    *ByteCount = 0;
+    return Status;
+  }
+
   //
   // call AtapiPassThruPioReadWriteData() function to get
   // requested transfer data form device.
   //
-  return AtapiPassThruPioReadWriteData (
-          AtapiScsiPrivate,
-          Buffer,
-          ByteCount,
-          Direction,
-          TimeoutInMicroSeconds
-          );
+  Status = AtapiPassThruPioReadWriteData (
+             AtapiScsiPrivate,
+             Buffer,
+             ByteCount,
+             Direction,
+             TimeoutInMicroSeconds
+             );
+
+  AtapiScsiPrivate->Statistics.PioCommands++;
+  AtapiScsiPrivate->Statistics.PioBytes += *ByteCount;
+
+  if (DmaAborted) {
+    AtapiScsiPrivate->Statistics.DmaFallbacks++;
+    if (!EFI_ERROR (Status)) {
+      //
+      // The device handles the command in PIO but not in DMA mode,
+      // so stop trying DMA on it.
+      //
+      Channel = &AtapiScsiPrivate->DmaChannel[ATAPI_CURRENT_CHANNEL (AtapiScsiPrivate)];
+      Channel->DmaDisabled[Target] = TRUE;
+      DEBUG ((
+        EFI_D_WARN,
+        "AtapiPacketCommand: DMA rejected on channel %d target %d, using PIO\n",
+        (UINT32) ATAPI_CURRENT_CHANNEL (AtapiScsiPrivate),
+        Target
+        ));
+    }
+  }
+
+  return Status;
 }
 
 EFI_STATUS
@@ -2415,6 +2660,343 @@ Arguments:
   return Status;
 }
 
+/**
+  Set up the bus master DMA resources of each channel.
+
+  Channels without a Bus Master IDE register block, or whose PRD table cannot
+  be allocated, are left in PIO mode.
+
+  @param AtapiScsiPrivate   A pointer to the protocol private data structure.
+  @param BusMasterBaseAddr  Bus Master IDE base address, or 0 if none.
+
+**/
+VOID
+AtapiPassThruDmaInit (
+  IN ATAPI_SCSI_PASS_THRU_DEV   *AtapiScsiPrivate,
+  IN UINT16                     BusMasterBaseAddr
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PCI_IO_PROTOCOL   *PciIo;
+  ATAPI_DMA_CHANNEL     *Channel;
+  UINTN                 Index;
+  UINT8                 BmStatus;
+  VOID                  *PrdTable;
+  UINTN                 Bytes;
+
+  PciIo = AtapiScsiPrivate->PciIo;
+
+  for (Index = 0; Index < ATAPI_MAX_CHANNEL; Index++) {
+    Channel           = &AtapiScsiPrivate->DmaChannel[Index];
+    Channel->PrdTable = NULL;
+
+    if (BusMasterBaseAddr == 0) {
+      continue;
+    }
+
+    Channel->BusMasterBaseAddr = (UINT16) (BusMasterBaseAddr + Index * BMIDE_CHANNEL_STRIDE);
+
+    //
+    // The drive DMA capable bits are set by whoever programmed the drive
+    // timings and transfer mode; without them the drive is left in PIO.
+    //
+    BmStatus = ReadPortB (PciIo, (UINT16) (Channel->BusMasterBaseAddr + BMIDE_REG_BMIS));
+    Channel->DmaDisabled[0] = (BOOLEAN) ((BmStatus & BMIS_DRV0_DMA_CAPABLE) == 0);
+    Channel->DmaDisabled[1] = (BOOLEAN) ((BmStatus & BMIS_DRV1_DMA_CAPABLE) == 0);
+    if (Channel->DmaDisabled[0] && Channel->DmaDisabled[1]) {
+      continue;
+    }
+
+    //
+    // One page is naturally aligned, so the table never crosses the 64KB
+    // boundary the bus master cannot cross, and PciIo keeps it below 4GB.
+    //
+    Status = PciIo->AllocateBuffer (
+                      PciIo,
+                      AllocateAnyPages,
+                      EfiBootServicesData,
+                      ATAPI_PRD_TABLE_PAGES,
+                      &PrdTable,
+                      0
+                      );
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+
+    Bytes  = EFI_PAGES_TO_SIZE (ATAPI_PRD_TABLE_PAGES);
+    Status = PciIo->Map (
+                      PciIo,
+                      EfiPciIoOperationBusMasterCommonBuffer,
+                      PrdTable,
+                      &Bytes,
+                      &Channel->PrdTableDeviceAddr,
+                      &Channel->PrdTableMapping
+                      );
+    if (EFI_ERROR (Status) || Bytes < EFI_PAGES_TO_SIZE (ATAPI_PRD_TABLE_PAGES)) {
+      if (!EFI_ERROR (Status)) {
+        PciIo->Unmap (PciIo, Channel->PrdTableMapping);
+      }
+      PciIo->FreeBuffer (PciIo, ATAPI_PRD_TABLE_PAGES, PrdTable);
+      continue;
+    }
+
+    Channel->PrdTable = PrdTable;
+
+    DEBUG ((
+      EFI_D_INFO,
+      "AtapiPassThruDmaInit: channel %d bus master at 0x%x, DMA drives 0x%x\n",
+      (UINT32) Index,
+      Channel->BusMasterBaseAddr,
+      (BmStatus & (BMIS_DRV0_DMA_CAPABLE | BMIS_DRV1_DMA_CAPABLE)) >> 5
+      ));
+  }
+}
+
+/**
+  Release the bus master DMA resources of each channel.
+
+  @param AtapiScsiPrivate   A pointer to the protocol private data structure.
+
+**/
+VOID
+AtapiPassThruDmaFree (
+  IN ATAPI_SCSI_PASS_THRU_DEV   *AtapiScsiPrivate
+  )
+{
+  EFI_PCI_IO_PROTOCOL   *PciIo;
+  ATAPI_DMA_CHANNEL     *Channel;
+  UINTN                 Index;
+
+  PciIo = AtapiScsiPrivate->PciIo;
+
+  for (Index = 0; Index < ATAPI_MAX_CHANNEL; Index++) {
+    Channel = &AtapiScsiPrivate->DmaChannel[Index];
+    if (Channel->PrdTable == NULL) {
+      continue;
+    }
+
+    PciIo->Unmap (PciIo, Channel->PrdTableMapping);
+    PciIo->FreeBuffer (PciIo, ATAPI_PRD_TABLE_PAGES, Channel->PrdTable);
+    Channel->PrdTable = NULL;
+  }
+}
+
+/**
+  Submits an ATAPI command packet whose data phase is carried out by the
+  Bus Master IDE engine of the current channel.
+
+  @param AtapiScsiPrivate       Private data structure for the specified channel.
+  @param Target                 0 for the master device, 1 for the slave device.
+  @param PacketCommand          Points to the ATAPI command packet.
+  @param Buffer                 Points to the transferred data.
+  @param ByteCount              On input, the buffer size; on output the number
+                                of bytes transferred.
+  @param Direction              Indicates the data transfer direction.
+  @param TimeoutInMicroSeconds  The timeout, 0 means wait indefinitely.
+
+  @retval EFI_SUCCESS           The command completed and moved the whole buffer.
+  @retval EFI_BAD_BUFFER_SIZE   The device ended the transfer before the end
+                                of the buffer; ByteCount is set to 0.
+  @retval EFI_UNSUPPORTED       The buffer cannot be described to the bus
+                                master; nothing was sent to the device.
+  @retval EFI_ABORTED           The device or the bus master rejected the DMA
+                                transfer; the command may be retried in PIO.
+  @retval other                 The command failed.
+
+**/
+EFI_STATUS
+AtapiPassThruDmaPacketCommand (
+  IN     ATAPI_SCSI_PASS_THRU_DEV  *AtapiScsiPrivate,
+  IN     UINT32                    Target,
+  IN     UINT8                     *PacketCommand,
+  IN     VOID                      *Buffer,
+  IN OUT UINT32                    *ByteCount,
+  IN     DATA_DIRECTION            Direction,
+  IN     UINT64                    TimeoutInMicroSeconds
+  )
+{
+  EFI_STATUS                     Status;
+  EFI_PCI_IO_PROTOCOL            *PciIo;
+  EFI_PCI_IO_PROTOCOL_OPERATION  Operation;
+  ATAPI_DMA_CHANNEL              *Channel;
+  EFI_PHYSICAL_ADDRESS           DeviceAddress;
+  VOID                           *Mapping;
+  UINTN                          MapLength;
+  UINTN                          Remaining;
+  UINTN                          PrdIndex;
+  UINT32                         RegionLength;
+  UINT32                         PrdTablePtr;
+  UINT16                         BmBase;
+  UINT8                          BmCommand;
+  UINT8                          BmStatus;
+  UINT8                          DevStatus;
+  UINT64                         Delay;
+
+  PciIo   = AtapiScsiPrivate->PciIo;
+  Channel = &AtapiScsiPrivate->DmaChannel[ATAPI_CURRENT_CHANNEL (AtapiScsiPrivate)];
+  BmBase  = Channel->BusMasterBaseAddr;
+
+  if (Direction == DataIn) {
+    Operation = EfiPciIoOperationBusMasterWrite;
+    BmCommand = BMIC_READ_TO_MEMORY;
+  } else {
+    Operation = EfiPciIoOperationBusMasterRead;
+    BmCommand = 0;
+  }
+
+  MapLength = *ByteCount;
+  Status    = PciIo->Map (PciIo, Operation, Buffer, &MapLength, &DeviceAddress, &Mapping);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (MapLength < *ByteCount || (DeviceAddress & BIT0) != 0 ||
+      DeviceAddress + *ByteCount > SIZE_4GB) {
+    PciIo->Unmap (PciIo, Mapping);
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Describe the buffer, splitting it at every 64KB boundary. A 64KB region
+  // truncates to a byte count of 0, which is how the PRD encodes it.
+  //
+  Remaining = *ByteCount;
+  PrdIndex  = 0;
+  while (Remaining > 0) {
+    RegionLength = ATAPI_PRD_MAX_REGION - (UINT32) (DeviceAddress & (ATAPI_PRD_MAX_REGION - 1));
+    if (RegionLength > Remaining) {
+      RegionLength = (UINT32) Remaining;
+    }
+
+    Channel->PrdTable[PrdIndex].RegionBaseAddr = (UINT32) DeviceAddress;
+    Channel->PrdTable[PrdIndex].ByteCount      = (UINT16) RegionLength;
+    Channel->PrdTable[PrdIndex].EndOfTable     = 0;
+
+    DeviceAddress += RegionLength;
+    Remaining     -= RegionLength;
+    PrdIndex++;
+  }
+  Channel->PrdTable[PrdIndex - 1].EndOfTable = ATAPI_PRD_EOT;
+  MemoryFence ();
+
+  //
+  // Stop the engine, point it at the table, set the direction and clear
+  // the sticky interrupt/error bits (write 1 to clear).
+  //
+  WritePortB (PciIo, (UINT16) (BmBase + BMIDE_REG_BMIC), BmCommand);
+  PrdTablePtr = (UINT32) Channel->PrdTableDeviceAddr;
+  PciIo->Io.Write (
+              PciIo,
+              EfiPciIoWidthUint32,
+              EFI_PCI_IO_PASS_THROUGH_BAR,
+              (UINT64) (BmBase + BMIDE_REG_BMIDTP),
+              1,
+              &PrdTablePtr
+              );
+  BmStatus = ReadPortB (PciIo, (UINT16) (BmBase + BMIDE_REG_BMIS));
+  WritePortB (
+    PciIo,
+    (UINT16) (BmBase + BMIDE_REG_BMIS),
+    (UINT8) (BmStatus | BMIS_ERROR | BMIS_INTERRUPT)
+    );
+
+  Status = AtapiPassThruIssuePacket (
+             AtapiScsiPrivate,
+             Target,
+             PacketCommand,
+             DMA,
+             TimeoutInMicroSeconds
+             );
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  WritePortB (PciIo, (UINT16) (BmBase + BMIDE_REG_BMIC), (UINT8) (BmCommand | BMIC_START));
+
+  //
+  // Completion is the device dropping BSY once the engine either ran out of
+  // descriptors or latched the device interrupt. The buffer matches the
+  // transfer length of the CDB, so a device interrupt with descriptors left
+  // means the device ended early, after an unknown number of bytes.
+  //
+  if (TimeoutInMicroSeconds == 0) {
+    Delay = 2;
+  } else {
+    Delay = DivU64x32 (TimeoutInMicroSeconds, (UINT32) 30) + 1;
+  }
+
+  Status = EFI_TIMEOUT;
+  do {
+    BmStatus  = ReadPortB (PciIo, (UINT16) (BmBase + BMIDE_REG_BMIS));
+    DevStatus = ReadPortB (PciIo, AtapiScsiPrivate->IoPort->Alt.AltStatus);
+
+    if ((BmStatus & BMIS_ERROR) != 0) {
+      Status = EFI_ABORTED;
+      break;
+    }
+
+    if ((DevStatus & BSY) == 0) {
+      if ((DevStatus & ERR) != 0) {
+        Status = EFI_DEVICE_ERROR;
+        break;
+      }
+      if ((BmStatus & BMIS_ACTIVE) == 0) {
+        Status = EFI_SUCCESS;
+        break;
+      }
+      if ((BmStatus & BMIS_INTERRUPT) != 0) {
+        Status = EFI_BAD_BUFFER_SIZE;
+        break;
+      }
+    }
+
+    //
+    // Stall for 30 us
+    //
+    gBS->Stall (30);
+
+    //
+    // Loop infinitely if not meeting expected condition
+    //
+    if (TimeoutInMicroSeconds == 0) {
+      Delay = 2;
+    }
+
+    Delay--;
+  } while (Delay);
+
+  WritePortB (PciIo, (UINT16) (BmBase + BMIDE_REG_BMIC), BmCommand);
+  WritePortB (PciIo, AtapiScsiPrivate->IoPort->Alt.DeviceControl, DEFAULT_CTL);
+  BmStatus = ReadPortB (PciIo, (UINT16) (BmBase + BMIDE_REG_BMIS));
+  WritePortB (
+    PciIo,
+    (UINT16) (BmBase + BMIDE_REG_BMIS),
+    (UINT8) (BmStatus | BMIS_ERROR | BMIS_INTERRUPT)
+    );
+
+  if (Status == EFI_DEVICE_ERROR &&
+      (ReadPortB (PciIo, AtapiScsiPrivate->IoPort->Reg1.Error) & ABRT_ERR) != 0) {
+    Status = EFI_ABORTED;
+  }
+
+  if (!EFI_ERROR (Status) || Status == EFI_BAD_BUFFER_SIZE) {
+    //
+    // reading the status register also acknowledges the device
+    //
+    if (EFI_ERROR (AtapiPassThruCheckErrorStatus (AtapiScsiPrivate))) {
+      Status = EFI_DEVICE_ERROR;
+    }
+  }
+
+Exit:
+  PciIo->Unmap (PciIo, Mapping);
+  if (EFI_ERROR (Status)) {
+    *ByteCount = 0;
+  }
+
+  return Status;
+}
+
 
 UINT8
 ReadPortB (
@@ -68,10 +68,80 @@ typedef enum {
 #define IDE_PRIMARY_PROGRAMMABLE_INDICATOR    BIT1
 #define IDE_SECONDARY_OPERATING_MODE          BIT2
 #define IDE_SECONDARY_PROGRAMMABLE_INDICATOR  BIT3
+#define IDE_BUS_MASTER_CAPABLE                BIT7
 
 
 #define ATAPI_MAX_CHANNEL 2
 
+//
+// Bus Master IDE registers, relative to the channel base in BAR4
+// (the secondary channel block starts 8 bytes after the primary one)
+//
+#define BMIDE_CHANNEL_STRIDE  0x08
+#define BMIDE_REG_BMIC        0x00  ///< Bus Master IDE Command register
+#define BMIDE_REG_BMIS        0x02  ///< Bus Master IDE Status register
+#define BMIDE_REG_BMIDTP      0x04  ///< Descriptor Table Pointer register
+
+#define BMIC_START            BIT0
+#define BMIC_READ_TO_MEMORY   BIT3
+
+#define BMIS_ACTIVE           BIT0
+#define BMIS_ERROR            BIT1
+#define BMIS_INTERRUPT        BIT2
+#define BMIS_DRV0_DMA_CAPABLE BIT5
+#define BMIS_DRV1_DMA_CAPABLE BIT6
+
+//
+// Physical Region Descriptor, see the Bus Master IDE programming interface.
+// A region may not cross a 64KB boundary and a byte count of 0 means 64KB.
+//
+#pragma pack(1)
+typedef struct {
+  UINT32  RegionBaseAddr;
+  UINT16  ByteCount;
+  UINT16  EndOfTable;
+} ATAPI_DMA_PRD;
+#pragma pack()
+
+#define ATAPI_PRD_EOT             BIT15
+#define ATAPI_PRD_MAX_REGION      SIZE_64KB
+#define ATAPI_PRD_TABLE_PAGES     1
+#define ATAPI_PRD_TABLE_ENTRIES   \
+  (EFI_PAGES_TO_SIZE (ATAPI_PRD_TABLE_PAGES) / sizeof (ATAPI_DMA_PRD))
+//
+// Largest transfer that is guaranteed to fit in the PRD table regardless of
+// how the buffer is aligned with respect to 64KB boundaries.
+//
+#define ATAPI_DMA_MAX_TRANSFER    \
+  ((ATAPI_PRD_TABLE_ENTRIES - 1) * ATAPI_PRD_MAX_REGION)
+//
+// Logical block sizes of ATAPI devices: CD/DVD media and removable disks
+//
+#define ATAPI_CD_BLOCK_SIZE       2048
+#define ATAPI_DISK_BLOCK_SIZE     512
+
+///
+/// Per channel bus master DMA resources
+///
+typedef struct {
+  UINT16                          BusMasterBaseAddr;
+  BOOLEAN                         DmaDisabled[2];
+  ATAPI_DMA_PRD                   *PrdTable;
+  EFI_PHYSICAL_ADDRESS            PrdTableDeviceAddr;
+  VOID                            *PrdTableMapping;
+} ATAPI_DMA_CHANNEL;
+
+///
+/// Transfer mode statistics, reported when the driver is stopped
+///
+typedef struct {
+  UINT64                          DmaCommands;
+  UINT64                          DmaBytes;
+  UINT64                          PioCommands;
+  UINT64                          PioBytes;
+  UINT64                          DmaFallbacks;
+} ATAPI_TRANSFER_STATISTICS;
+
 ///
 /// IDE registers set
 ///
@@ -104,6 +174,8 @@ typedef struct {
   IDE_BASE_REGISTERS               AtapiIoPortRegisters[2];
   UINT32                           LatestTargetId;
   UINT64                           LatestLun;
+  ATAPI_DMA_CHANNEL                DmaChannel[2];
+  ATAPI_TRANSFER_STATISTICS        Statistics;
 } ATAPI_SCSI_PASS_THRU_DEV;
 
 //
@@ -128,6 +200,12 @@ typedef struct {
       ATAPI_SCSI_PASS_THRU_DEV_SIGNATURE \
       )
 
+//
+// Index of the channel selected through IoPort
+//
+#define ATAPI_CURRENT_CHANNEL(a) \
+  ((UINTN) ((a)->IoPort - (a)->AtapiIoPortRegisters))
+
 //
 // Global Variables
 //
@@ -1551,7 +1629,8 @@ Returns:
 EFI_STATUS
 GetIdeRegistersBaseAddr (
   IN  EFI_PCI_IO_PROTOCOL         *PciIo,
-  OUT IDE_REGISTERS_BASE_ADDR     *IdeRegsBaseAddr
+  OUT IDE_REGISTERS_BASE_ADDR     *IdeRegsBaseAddr,
+  OUT UINT16                      *BusMasterBaseAddr
   )
 /*++
 
@@ -1564,6 +1643,8 @@ Arguments:
   PciIo             - Pointer to the EFI_PCI_IO_PROTOCOL instance
   IdeRegsBaseAddr   - Pointer to IDE_REGISTERS_BASE_ADDR to 
                       receive IDE IO port registers' base addresses
+  BusMasterBaseAddr - Receives the Bus Master IDE base address from BAR4,
+                      or 0 if the controller is not bus master capable
                       
 Returns:
 
@@ -1596,6 +1677,65 @@ Returns:
 --*/  
 ;
 
+/**
+  Set up the bus master DMA resources of each channel.
+
+  Channels without a Bus Master IDE register block, or whose PRD table cannot
+  be allocated, are left in PIO mode.
+
+  @param AtapiScsiPrivate   A pointer to the protocol private data structure.
+  @param BusMasterBaseAddr  Bus Master IDE base address, or 0 if none.
+
+**/
+VOID
+AtapiPassThruDmaInit (
+  IN ATAPI_SCSI_PASS_THRU_DEV   *AtapiScsiPrivate,
+  IN UINT16                     BusMasterBaseAddr
+  );
+
+/**
+  Release the bus master DMA resources of each channel.
+
+  @param AtapiScsiPrivate   A pointer to the protocol private data structure.
+
+**/
+VOID
+AtapiPassThruDmaFree (
+  IN ATAPI_SCSI_PASS_THRU_DEV   *AtapiScsiPrivate
+  );
+
+/**
+  Submits an ATAPI command packet whose data phase is carried out by the
+  Bus Master IDE engine of the current channel.
+
+  @param AtapiScsiPrivate       Private data structure for the specified channel.
+  @param Target                 0 for the master device, 1 for the slave device.
+  @param PacketCommand          Points to the ATAPI command packet.
+  @param Buffer                 Points to the transferred data.
+  @param ByteCount              On input, the buffer size; on output the number
+                                of bytes transferred.
+  @param Direction              Indicates the data transfer direction.
+  @param TimeoutInMicroSeconds  The timeout, 0 means wait indefinitely.
+
+  @retval EFI_SUCCESS           The command completed.
+  @retval EFI_UNSUPPORTED       The buffer cannot be described to the bus
+                                master; nothing was sent to the device.
+  @retval EFI_ABORTED           The device or the bus master rejected the DMA
+                                transfer; the command may be retried in PIO.
+  @retval other                 The command failed.
+
+**/
+EFI_STATUS
+AtapiPassThruDmaPacketCommand (
+  IN     ATAPI_SCSI_PASS_THRU_DEV  *AtapiScsiPrivate,
+  IN     UINT32                    Target,
+  IN     UINT8                     *PacketCommand,
+  IN     VOID                      *Buffer,
+  IN OUT UINT32                    *ByteCount,
+  IN     DATA_DIRECTION            Direction,
+  IN     UINT64                    TimeoutInMicroSeconds
+  );
+
 /**
   Installs Scsi Pass Thru and/or Ext Scsi Pass Thru 
   protocols based on feature flags. 
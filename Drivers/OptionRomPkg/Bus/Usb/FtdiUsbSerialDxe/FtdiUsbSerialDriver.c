@@ -203,9 +203,106 @@ SetStatusInternal (
   return EFI_SUCCESS;
 }
 
+/**
+  Returns the number of bytes held in the receive FIFO.
+
+  @param  UsbSerialDevice[in]  Handle to the Usb Serial Device
+
+  @return The number of bytes in the receive FIFO
+
+**/
+UINT32
+FifoCount (
+  IN USB_SER_DEV  *UsbSerialDevice
+  )
+{
+  return (UsbSerialDevice->DataBufferTail + UsbSerialDevice->DataBufferSize -
+          UsbSerialDevice->DataBufferHead) % UsbSerialDevice->DataBufferSize;
+}
+
+/**
+  Returns the number of bytes which can still be stored in the receive FIFO.
+  One slot is always kept free to tell a full FIFO from an empty one.
+
+  @param  UsbSerialDevice[in]  Handle to the Usb Serial Device
+
+  @return The number of free bytes in the receive FIFO
+
+**/
+UINT32
+FifoFree (
+  IN USB_SER_DEV  *UsbSerialDevice
+  )
+{
+  return UsbSerialDevice->DataBufferSize - 1 - FifoCount (UsbSerialDevice);
+}
+
+/**
+  Appends data to the receive FIFO. Data which does not fit is dropped.
+
+  @param  UsbSerialDevice[in]  Handle to the Usb Serial Device
+  @param  Data[in]             The data to append
+  @param  Length[in]           The number of bytes in Data
+
+**/
+VOID
+FifoPut (
+  IN USB_SER_DEV  *UsbSerialDevice,
+  IN UINT8        *Data,
+  IN UINTN        Length
+  )
+{
+  UINTN  Chunk;
+
+  Length = MIN (Length, FifoFree (UsbSerialDevice));
+  while (Length > 0) {
+    Chunk = MIN (Length, UsbSerialDevice->DataBufferSize - UsbSerialDevice->DataBufferTail);
+    CopyMem (&UsbSerialDevice->DataBuffer[UsbSerialDevice->DataBufferTail], Data, Chunk);
+    UsbSerialDevice->DataBufferTail = (UINT32)((UsbSerialDevice->DataBufferTail + Chunk) % UsbSerialDevice->DataBufferSize);
+    Data   += Chunk;
+    Length -= Chunk;
+  }
+}
+
+/**
+  Removes data from the receive FIFO.
+
+  @param  UsbSerialDevice[in]  Handle to the Usb Serial Device
+  @param  Buffer[out]          The buffer to return the data into
+  @param  Length[in]           The size of Buffer
+
+  @return The number of bytes returned in Buffer
+
+**/
+UINTN
+FifoGet (
+  IN  USB_SER_DEV  *UsbSerialDevice,
+  OUT UINT8        *Buffer,
+  IN  UINTN        Length
+  )
+{
+  UINTN  Chunk;
+  UINTN  Count;
+
+  Count  = MIN (Length, FifoCount (UsbSerialDevice));
+  Length = Count;
+  while (Length > 0) {
+    Chunk = MIN (Length, UsbSerialDevice->DataBufferSize - UsbSerialDevice->DataBufferHead);
+    CopyMem (Buffer, &UsbSerialDevice->DataBuffer[UsbSerialDevice->DataBufferHead], Chunk);
+    UsbSerialDevice->DataBufferHead = (UINT32)((UsbSerialDevice->DataBufferHead + Chunk) % UsbSerialDevice->DataBufferSize);
+    Buffer += Chunk;
+    Length -= Chunk;
+  }
+  return Count;
+}
+
 /**
   Initiates a read operation on the Usb Serial Device.
 
+  The device prepends two status bytes to every bulk in packet. The data is
+  split on packet boundaries, the status of the last packet is used to
+  update the status values and the payloads are appended to the receive FIFO.
+
   @param  UsbSerialDevice[in]        Handle to the USB device to read
   @param  BufferSize[in, out]        On input, the size of the Buffer. On output,
                                      the amount of data returned in Buffer.
@@ -230,11 +327,12 @@ ReadDataFromUsb (
   EFI_STATUS  Status;
   UINTN       ReadBufferSize;
   UINT8       *ReadBuffer;
-  UINTN       Index;
+  UINTN       PacketSize;
+  UINTN       Offset;
+  UINTN       Length;
   EFI_TPL     Tpl;
-  UINT8       StatusBuffer[2]; // buffer to store the status bytes
 
-  ReadBufferSize = 512;
+  ReadBufferSize = sizeof (UsbSerialDevice->ReadBuffer);
   ReadBuffer     = &(UsbSerialDevice->ReadBuffer[0]);
 
   if (UsbSerialDevice->Shutdown) {
@@ -260,52 +358,28 @@ ReadDataFromUsb (
   }
 
   //
-  // Store the status bytes in the status buffer
+  // Strip the status bytes from every packet and store the payloads
   //
-  for (Index = 0; Index < 2; Index++) {//only the first 2 bytes are status bytes
-    StatusBuffer[Index] = ReadBuffer[Index];
+  PacketSize = UsbSerialDevice->InEndpointDescriptor.MaxPacketSize;
+  if (PacketSize <= FTDI_STATUS_SIZE) {
+    PacketSize = ReadBufferSize;
   }
-  //
-  // update the statusvalue field of the usbserialdevice
-  //
-  Status = SetStatusInternal (UsbSerialDevice, StatusBuffer);
-  if (Status != EFI_SUCCESS) {
-  }
-
-  //
-  // Store the read data in the read buffer, start at 2 to ignore status bytes
-  //
-  for (Index = 2; Index < ReadBufferSize; Index++) {
-    if (((UsbSerialDevice->DataBufferTail + 1) % SW_FIFO_DEPTH) == UsbSerialDevice->DataBufferHead) {
-      break;
-    }
-    if (ReadBuffer[Index] == 0x00) {
-      //
-      // This is null, do not add
-      //
-    } else {
-      UsbSerialDevice->DataBuffer[UsbSerialDevice->DataBufferTail] = ReadBuffer[Index];
-      UsbSerialDevice->DataBufferTail = (UsbSerialDevice->DataBufferTail + 1) % SW_FIFO_DEPTH;
-    }
+  for (Offset = 0; Offset + FTDI_STATUS_SIZE <= ReadBufferSize; Offset += PacketSize) {
+    Length = MIN (PacketSize, ReadBufferSize - Offset);
+    SetStatusInternal (UsbSerialDevice, &ReadBuffer[Offset]);
+    FifoPut (
+      UsbSerialDevice,
+      &ReadBuffer[Offset + FTDI_STATUS_SIZE],
+      Length - FTDI_STATUS_SIZE
+      );
   }
 
   //
   // Read characters out of the buffer to satisfy caller's request.
   //
-  for (Index = 0; Index < *BufferSize; Index++) {
-    if (UsbSerialDevice->DataBufferHead == UsbSerialDevice->DataBufferTail) {
-      break;
-    }
-    //
-    // Still have characters in the buffer to return
-    //
-    ((UINT8 *)Buffer)[Index]        = UsbSerialDevice->DataBuffer[UsbSerialDevice->DataBufferHead];
-    UsbSerialDevice->DataBufferHead = (UsbSerialDevice->DataBufferHead + 1) % SW_FIFO_DEPTH;
+  if (*BufferSize > 0) {
+    *BufferSize = FifoGet (UsbSerialDevice, Buffer, *BufferSize);
   }
-  //
-  // Return actual number of bytes returned.
-  //
-  *BufferSize = Index;
   gBS->RestoreTPL (Tpl);
   return EFI_SUCCESS;
 }
@@ -360,10 +434,56 @@ SetInitialStatus (
   return Status;
 }
 
+/**
+  Returns the background receive poll period in ms used while the port is
+  idle.
+
+  The device FIFO must not overflow before the first poll of a burst, so
+  the period is bounded by the time FTDI_MAX_RECEIVE_FIFO_DEPTH characters
+  take at the current settings, about 33 ms at 115200 baud 8N1.
+  PcdFtdiUsbSerialPollPeriod caps it at low baud rates.
+
+  @param  UsbSerialDevice[in]  The current instance of the USB serial device
+
+  @return The idle poll period in ms
+
+**/
+STATIC
+UINT32
+FtdiIdlePollPeriod (
+  IN USB_SER_DEV  *UsbSerialDevice
+  )
+{
+  UINT64  FillTime;
+
+  FillTime = PcdGet32 (PcdFtdiUsbSerialPollPeriod);
+  if (UsbSerialDevice->LastSettings.BaudRate != 0) {
+    //
+    // Start bit, data bits and one stop bit, leaving out parity and extra
+    // stop bits errs on the short side
+    //
+    FillTime = DivU64x64Remainder (
+                 MultU64x32 (
+                   FTDI_MAX_RECEIVE_FIFO_DEPTH * 1000,
+                   UsbSerialDevice->LastSettings.DataBits + 2
+                   ),
+                 UsbSerialDevice->LastSettings.BaudRate,
+                 NULL
+                 );
+  }
+
+  return (UINT32)MAX (
+                   MIN (FillTime, PcdGet32 (PcdFtdiUsbSerialPollPeriod)),
+                   FTDI_ACTIVE_POLL_PERIOD
+                   );
+}
+
 /**
   UsbSerialDriverCheckInput.
   attempts to read data in from the device periodically, stores any read data
-  and updates the control attributes.
+  and updates the control attributes. The poll runs every
+  FTDI_ACTIVE_POLL_PERIOD ms while data is arriving and falls back to the
+  idle period of FtdiIdlePollPeriod once a poll returns nothing.
 
   @param  Event[in]
   @param  Context[in]....The current instance of the USB serial device
@@ -377,32 +497,43 @@ UsbSerialDriverCheckInput (
   )
 {
   UINTN        BufferSize;
+  UINT32       Count;
+  BOOLEAN      Active;
   USB_SER_DEV  *UsbSerialDevice;
 
   UsbSerialDevice = (USB_SER_DEV*)Context;
 
-  if (UsbSerialDevice->DataBufferHead == UsbSerialDevice->DataBufferTail) {
-    //
-    // Data buffer is empty, try to read from device
-    //
+  //
+  // Keep draining the device into the data buffer as long as a whole
+  // transfer fits, so no input is lost between two Read calls
+  //
+  Active = UsbSerialDevice->ActivePoll;
+  if (FifoFree (UsbSerialDevice) >= sizeof (UsbSerialDevice->ReadBuffer)) {
+    Count = FifoCount (UsbSerialDevice);
     BufferSize = 0;
     ReadDataFromUsb (UsbSerialDevice, &BufferSize, NULL);
-    if (UsbSerialDevice->DataBufferHead == UsbSerialDevice->DataBufferTail) {
-      //
-      // Data buffer still has no data, set the EFI_SERIAL_INPUT_BUFFER_EMPTY
-      // flag
-      //
-      UsbSerialDevice->ControlBits |= EFI_SERIAL_INPUT_BUFFER_EMPTY;
-    } else {
-      //
-      // Read has returned some data, clear the EFI_SERIAL_INPUT_BUFFER_EMPTY
-      // flag
-      //
-      UsbSerialDevice->ControlBits &= ~(EFI_SERIAL_INPUT_BUFFER_EMPTY);
-    }
+    Active = (BOOLEAN)(FifoCount (UsbSerialDevice) != Count);
+  }
+
+  if (Active != UsbSerialDevice->ActivePoll) {
+    UsbSerialDevice->ActivePoll = Active;
+    gBS->SetTimer (
+           UsbSerialDevice->PollingLoop,
+           TimerPeriodic,
+           EFI_TIMER_PERIOD_MILLISECONDS (
+             Active ? FTDI_ACTIVE_POLL_PERIOD : FtdiIdlePollPeriod (UsbSerialDevice)
+             )
+           );
+  }
+
+  if (FifoCount (UsbSerialDevice) == 0) {
+    //
+    // Data buffer has no data, set the EFI_SERIAL_INPUT_BUFFER_EMPTY flag
+    //
+    UsbSerialDevice->ControlBits |= EFI_SERIAL_INPUT_BUFFER_EMPTY;
   } else {
     //
-    // Data buffer has data, no read attempt required
+    // Data buffer has data, clear the EFI_SERIAL_INPUT_BUFFER_EMPTY flag
     //
     UsbSerialDevice->ControlBits &= ~(EFI_SERIAL_INPUT_BUFFER_EMPTY);
   }
@@ -920,6 +1051,17 @@ SetAttributesInternal (
     UsbSerialDevice->SerialIo.Mode->StopBits = StopBits;
   }
 
+  //
+  // The idle poll period depends on the baud rate and the data bits
+  //
+  if (UsbSerialDevice->PollingLoop != NULL && !UsbSerialDevice->ActivePoll) {
+    gBS->SetTimer (
+           UsbSerialDevice->PollingLoop,
+           TimerPeriodic,
+           EFI_TIMER_PERIOD_MILLISECONDS (FtdiIdlePollPeriod (UsbSerialDevice))
+           );
+  }
+
   //
   // See if the device path node has changed
   //
@@ -1361,6 +1503,51 @@ GetControlBitsInternal (
   return EFI_SUCCESS;
 }
 
+/**
+  Internal function that performs a Usb Control Transfer to set the latency
+  timer of the Usb Serial Device.
+
+  @param  UsbIo[in]                  Usb Io Protocol instance pointer
+  @param  Latency[in]                The latency timer value in milliseconds
+
+  @retval EFI_SUCCESS                The latency timer was set on the Usb Serial
+                                     Device
+  @retval EFI_DEVICE_ERROR           The device is not functioning correctly
+
+**/
+EFI_STATUS
+EFIAPI
+SetLatencyTimerInternal (
+  IN EFI_USB_IO_PROTOCOL  *UsbIo,
+  IN UINT8                Latency
+  )
+{
+  EFI_STATUS              Status;
+  EFI_USB_DEVICE_REQUEST  DevReq;
+  UINT32                  ReturnValue;
+  UINT8                   ConfigurationValue;
+
+  DevReq.Request     = FTDI_COMMAND_SET_LATENCY_TIMER;
+  DevReq.RequestType = USB_REQ_TYPE_VENDOR;
+  DevReq.Value       = Latency;
+  DevReq.Index       = FTDI_PORT_IDENTIFIER;
+  DevReq.Length      = 0; // indicates that there is no data phase in this transfer
+
+  Status = UsbIo->UsbControlTransfer (
+                    UsbIo,
+                    &DevReq,
+                    EfiUsbDataOut,
+                    WDR_TIMEOUT,
+                    &ConfigurationValue,
+                    1,
+                    &ReturnValue
+                    );
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+  return Status;
+}
+
 /**
   Resets the USB Serial Device
 
@@ -1966,7 +2153,11 @@ UsbSerialDriverBindingStart (
   //
   // Allocate space for the receive buffer
   //
-  UsbSerialDevice->DataBuffer = AllocateZeroPool (SW_FIFO_DEPTH);
+  UsbSerialDevice->DataBufferSize = MAX (
+                                      PcdGet32 (PcdFtdiUsbSerialRxFifoSize),
+                                      2 * sizeof (UsbSerialDevice->ReadBuffer)
+                                      );
+  UsbSerialDevice->DataBuffer = AllocateZeroPool (UsbSerialDevice->DataBufferSize);
 
   //
   // Initialize data buffer pointers.
@@ -1994,6 +2185,15 @@ UsbSerialDriverBindingStart (
   Status = SetInitialStatus (UsbSerialDevice);
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Have the device return short packets quickly, the background poll below
+  // waits for the bulk in transfer to complete
+  //
+  Status = SetLatencyTimerInternal (UsbIo, FTDI_LATENCY_TIMER);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_WARN, "FtdiUsbSerial: failed to set latency timer - %r\n", Status));
+  }
+
   //
   // Create a polling loop to check for input
   //
@@ -2006,13 +2206,14 @@ UsbSerialDriverBindingStart (
          &(UsbSerialDevice->PollingLoop)
          );
   //
-  // add code to set trigger time based on baud rate
-  // setting to 0.5s for now
+  // Start with the idle period, UsbSerialDriverCheckInput switches to
+  // FTDI_ACTIVE_POLL_PERIOD as soon as data arrives
   //
+  UsbSerialDevice->ActivePoll = FALSE;
   gBS->SetTimer (
          UsbSerialDevice->PollingLoop,
          TimerPeriodic,
-         EFI_TIMER_PERIOD_MILLISECONDS (500)
+         EFI_TIMER_PERIOD_MILLISECONDS (FtdiIdlePollPeriod (UsbSerialDevice))
          );
 
   //
@@ -2481,17 +2682,7 @@ ReadSerialIo (
   //
   // Clear out any data that we already have in our internal buffer
   //
-  for (Index = 0; Index < *BufferSize; Index++) {
-    if (UsbSerialDevice->DataBufferHead == UsbSerialDevice->DataBufferTail) {
-      break;
-    }
-
-    //
-    // Still have characters in the buffer to return
-    //
-    ((UINT8 *)Buffer)[Index] = UsbSerialDevice->DataBuffer[UsbSerialDevice->DataBufferHead];
-    UsbSerialDevice->DataBufferHead = (UsbSerialDevice->DataBufferHead + 1) % SW_FIFO_DEPTH;
-  }
+  Index = FifoGet (UsbSerialDevice, Buffer, *BufferSize);
 
   //
   // If we haven't filled the caller's buffer using data that we already had on
@@ -2512,7 +2703,7 @@ ReadSerialIo (
     }
   }
 
-  if (UsbSerialDevice->DataBufferHead == UsbSerialDevice->DataBufferTail) {
+  if (FifoCount (UsbSerialDevice) == 0) {
     //
     // Data buffer has no data, set the EFI_SERIAL_INPUT_BUFFER_EMPTY flag
     //
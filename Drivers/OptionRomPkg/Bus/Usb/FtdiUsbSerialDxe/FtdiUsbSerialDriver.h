@@ -10,9 +10,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef _FTDI_USB_SERIAL_DRIVER_H_
 #define _FTDI_USB_SERIAL_DRIVER_H_
 
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
 #include <Library/DevicePathLib.h>
@@ -156,6 +158,26 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 #define FTDI_TIMEOUT       16
 
+//
+// FTDI latency timer in ms, the time after which the device returns a
+// partially filled bulk in packet. Kept short, so the background poller
+// does not stall in the transfer when there is little data.
+//
+#define FTDI_LATENCY_TIMER 2
+
+//
+// Background receive poll period in ms while data is arriving. The idle
+// period follows the baud rate, capped by PcdFtdiUsbSerialPollPeriod. Each
+// poll is a synchronous transfer, so the short period is only used while
+// needed.
+//
+#define FTDI_ACTIVE_POLL_PERIOD 4
+
+//
+// Size of the status bytes the device prepends to every bulk in packet
+//
+#define FTDI_STATUS_SIZE   2
+
 //
 // FTDI FIFO depth
 //
@@ -167,11 +189,6 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define FTDI_ENDPOINT_ADDRESS_IN   0x81 //the endpoint address for the in enpoint generated by the device
 #define FTDI_ENDPOINT_ADDRESS_OUT  0x02 //the endpoint address for the out endpoint generated by the device
 
-//
-// Max buffer size for USB transfers
-//
-#define SW_FIFO_DEPTH 1024
-
 //
 // struct to define a usb device as a vendor and product id pair
 //
@@ -236,10 +253,12 @@ typedef struct {
   EFI_UNICODE_STRING_TABLE      *ControllerNameTable;
   UINT32                        DataBufferHead;
   UINT32                        DataBufferTail;
+  UINT32                        DataBufferSize;
   UINT8                         *DataBuffer;
   EFI_SERIAL_IO_PROTOCOL        SerialIo;
   BOOLEAN                       Shutdown;
   EFI_EVENT                     PollingLoop;
+  BOOLEAN                       ActivePoll;
   UINT32                        ControlBits;
   PREVIOUS_ATTRIBUTES           LastSettings;
   CONTROL_BITS                  ControlValues;
@@ -318,7 +318,15 @@ BltLibVideoFill (
       Offset = mBltLibBytesPerPixel * Offset;
       BltMemDst = (VOID*) (mBltLibFrameBuffer + Offset);
 
-      if (UseWideFill && (((UINTN) BltMemDst & 7) == 0)) {
+      if ((mBltLibBytesPerPixel == sizeof (UINT32)) && (((UINTN) BltMemDst & 3) == 0)) {
+        //
+        // 32bpp is the common case, any color can be filled with SetMem32
+        // which the BaseMemoryLib instance may implement with wide and
+        // non-temporal stores.
+        //
+        VDEBUG ((EFI_D_INFO, "VideoFill (32bpp)\n"));
+        SetMem32 (BltMemDst, WidthInBytes, (UINT32) WideFill);
+      } else if (UseWideFill && (((UINTN) BltMemDst & 7) == 0)) {
         VDEBUG ((EFI_D_INFO, "VideoFill (wide)\n"));
         SizeInBytes = WidthInBytes;
         if (SizeInBytes >= 8) {
@@ -455,6 +463,23 @@ BltLibVideoToBltBufferEx (
 
   WidthInBytes = Width * mBltLibBytesPerPixel;
 
+  //
+  // If the frame buffer uses the Blt pixel format and both rectangles span
+  // whole rows of their buffers, all rows are contiguous in memory on both
+  // sides and can be moved with a single copy.
+  //
+  if ((mPixelFormat == PixelBlueGreenRedReserved8BitPerColor) &&
+      (SourceX == 0) && (Width == mBltLibWidthInPixels) &&
+      (DestinationX == 0) && (Delta == WidthInBytes)) {
+    VDEBUG ((EFI_D_INFO, "VideoToBltBuffer (one-shot)\n"));
+    CopyMem (
+      (UINT8 *) BltBuffer + (DestinationY * Delta),
+      mBltLibFrameBuffer + (SourceY * mBltLibWidthInBytes),
+      WidthInBytes * Height
+      );
+    return EFI_SUCCESS;
+  }
+
   //
   // Video to BltBuffer: Source is Video, destination is BltBuffer
   //
@@ -599,6 +624,23 @@ BltLibBufferToVideoEx (
 
   WidthInBytes = Width * mBltLibBytesPerPixel;
 
+  //
+  // If the frame buffer uses the Blt pixel format and both rectangles span
+  // whole rows of their buffers, all rows are contiguous in memory on both
+  // sides and can be moved with a single copy.
+  //
+  if ((mPixelFormat == PixelBlueGreenRedReserved8BitPerColor) &&
+      (DestinationX == 0) && (Width == mBltLibWidthInPixels) &&
+      (SourceX == 0) && (Delta == WidthInBytes)) {
+    VDEBUG ((EFI_D_INFO, "BufferToVideo (one-shot)\n"));
+    CopyMem (
+      mBltLibFrameBuffer + (DestinationY * mBltLibWidthInBytes),
+      (UINT8 *) BltBuffer + (SourceY * Delta),
+      WidthInBytes * Height
+      );
+    return EFI_SUCCESS;
+  }
+
   for (SrcY = SourceY, DstY = DestinationY; SrcY < (Height + SourceY); SrcY++, DstY++) {
 
     Offset = (DstY * mBltLibWidthInPixels) + DestinationX;
@@ -606,7 +648,24 @@ BltLibBufferToVideoEx (
     BltMemDst = (VOID*) (mBltLibFrameBuffer + Offset);
 
     if (mPixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
-      BltMemSrc = (VOID *) ((UINT8 *) BltBuffer + (SrcY * Delta));
+      BltMemSrc =
+        (VOID *) (
+            (UINT8 *) BltBuffer +
+            (SrcY * Delta) +
+            (SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL))
+          );
+    } else if (mPixelFormat == PixelRedGreenBlueReserved8BitPerColor) {
+      //
+      // Only the red and blue bytes need to be swapped, avoid the generic
+      // mask and shift conversion.
+      //
+      for (X = 0; X < Width; X++) {
+        Uint32 = *(UINT32 *) ((UINT8 *) BltBuffer + (SrcY * Delta) +
+                   ((SourceX + X) * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)));
+        ((UINT32 *) mBltLibLineBuffer)[X] =
+          ((Uint32 & 0x000000ff) << 16) | (Uint32 & 0x0000ff00) | ((Uint32 >> 16) & 0x000000ff);
+      }
+      BltMemSrc = (VOID *) mBltLibLineBuffer;
     } else {
       for (X = 0; X < Width; X++) {
         Blt =
@@ -698,8 +757,25 @@ BltLibVideoToVideo (
   Offset = mBltLibBytesPerPixel * Offset;
   BltMemDst = (VOID *) (mBltLibFrameBuffer + Offset);
 
+  //
+  // Rectangles spanning whole rows are contiguous in the frame buffer, this
+  // is the common case of scrolling the console. CopyMem handles the
+  // overlap of the source and destination regions.
+  //
+  if (Width == mBltLibWidthInPixels) {
+    VDEBUG ((EFI_D_INFO, "VideoToVideo (one-shot)\n"));
+    CopyMem (BltMemDst, BltMemSrc, WidthInBytes * Height);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // When moving down, copy the rows bottom up so that a source row is not
+  // overwritten before it is copied.
+  //
   LineStride = mBltLibWidthInBytes;
   if ((UINTN) BltMemDst > (UINTN) BltMemSrc) {
+    BltMemSrc = (VOID*) ((UINT8*) BltMemSrc + (Height - 1) * mBltLibWidthInBytes);
+    BltMemDst = (VOID*) ((UINT8*) BltMemDst + (Height - 1) * mBltLibWidthInBytes);
     LineStride = -LineStride;
   }
 
@@ -39,6 +39,12 @@ typedef union {
 
 #pragma pack()
 
+//
+// Prefix of the per-table performance records logged while calculating the
+// FACS HardwareSignature. The table signature is appended to it.
+//
+#define ACPI_TABLE_CRC_PERF_PREFIX  "AcpiCrc:"
+
 extern EFI_ACPI_6_5_FIRMWARE_ACPI_CONTROL_STRUCTURE     Facs;
 extern EFI_ACPI_6_5_FIXED_ACPI_DESCRIPTION_TABLE        Fadt;
 extern EFI_ACPI_HIGH_PRECISION_EVENT_TIMER_TABLE_HEADER Hpet;
@@ -1425,6 +1431,7 @@ CalculateAcpiTableCrc (
   )
 {
   UINT32  *TableCrcRecord;
+  CHAR8   MeasurementString[sizeof (ACPI_TABLE_CRC_PERF_PREFIX) + sizeof (UINT32)];
 
   TableCrcRecord = (UINT32 *)Context;
 
@@ -1433,6 +1440,13 @@ CalculateAcpiTableCrc (
     return;
   }
 
+  //
+  // Name the performance record after the table signature, e.g. "AcpiCrc:SSDT".
+  //
+  CopyMem (MeasurementString, ACPI_TABLE_CRC_PERF_PREFIX, sizeof (ACPI_TABLE_CRC_PERF_PREFIX) - 1);
+  CopyMem (&MeasurementString[sizeof (ACPI_TABLE_CRC_PERF_PREFIX) - 1], &Table->Signature, sizeof (UINT32));
+  MeasurementString[sizeof (MeasurementString) - 1] = '\0';
+
   //
   // Calculate CRC value.
   //
@@ -1443,7 +1457,15 @@ CalculateAcpiTableCrc (
     ((EFI_ACPI_6_5_FIRMWARE_ACPI_CONTROL_STRUCTURE *)Table)->HardwareSignature = 0;
   }
 
+  //
+  // Each table gets its own record in the boot performance table (FPDT), so
+  // the cost of CRCing large tables can be attributed and checked against the
+  // boot performance test points.
+  //
+  PERF_INMODULE_BEGIN (MeasurementString);
   gBS->CalculateCrc32 ((UINT8 *)Table, (UINTN)Table->Length, &TableCrcRecord[TableIndex]);
+  PERF_INMODULE_END (MeasurementString);
+  DEBUG ((DEBUG_VERBOSE, "%a: Length 0x%x, CRC 0x%08x\n", MeasurementString, Table->Length, TableCrcRecord[TableIndex]));
 }
 
 /**
@@ -1514,11 +1536,13 @@ IsAcpiTableChange (
   //
   // Calculate CRC for each ACPI table and set record.
   //
+  PERF_INMODULE_BEGIN ("AcpiTableCrc");
   if (IsRsdt) {
     EnumerateAllAcpiTables (Rsdt, sizeof (UINT32), CalculateAcpiTableCrc, (VOID *)TableCrcRecord);
   } else {
     EnumerateAllAcpiTables (Xsdt, sizeof (UINT64), CalculateAcpiTableCrc, (VOID *)TableCrcRecord);
   }
+  PERF_INMODULE_END ("AcpiTableCrc");
 
   //
   // Calculate and set HardwareSignature data.
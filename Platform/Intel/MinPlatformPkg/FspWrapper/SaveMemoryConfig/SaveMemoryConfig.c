@@ -22,9 +22,145 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/LargeVariableReadLib.h>
 #include <Library/LargeVariableWriteLib.h>
 #include <Library/PcdLib.h>
+#include <Library/VariableReadLib.h>
 #include <Library/VariableWriteLib.h>
+#include <Library/BaseCryptLib.h>
 #include <Guid/FspNonVolatileStorageHob2.h>
 
+//
+// SHA-256 of the uncompressed FSP NVS data last saved to FspNvsBuffer, and
+// of the bytes FspNvsBuffer holds for it. When the first matches the data
+// of this boot and the second what FspNvsBuffer reads back, FspNvsBuffer
+// is only locked, without compressing the data or rewriting the variable.
+//
+#define FSP_NVS_BUFFER_HASH_VARIABLE_NAME  L"FspNvsBufferHash"
+#define FSP_NVS_BUFFER_HASH_VERSION        2
+
+typedef struct {
+  UINT32  Version;
+  UINT32  Compressed;
+  UINT64  DataSize;
+  UINT8   Digest[SHA256_DIGEST_SIZE];
+  UINT64  StoredSize;
+  UINT8   StoredDigest[SHA256_DIGEST_SIZE];
+} FSP_NVS_BUFFER_HASH;
+
+/**
+  Check whether FspNvsBuffer holds the FSP NVS data of this boot.
+
+  The saved FspNvsBufferHash has to match the hash of this boot's data,
+  and FspNvsBuffer has to read back with the size and hash recorded in it,
+  so a damaged or partially written FspNvsBuffer is saved again.
+
+  @param[in] Hash    Hash of the FSP NVS data of this boot.
+
+  @retval TRUE       FspNvsBuffer is current.
+  @retval FALSE      The hash is not saved, is different, or FspNvsBuffer
+                     does not match it.
+**/
+BOOLEAN
+IsFspNvsBufferCurrent (
+  IN FSP_NVS_BUFFER_HASH  *Hash
+  )
+{
+  EFI_STATUS           Status;
+  FSP_NVS_BUFFER_HASH  SavedHash;
+  UINTN                Size;
+  VOID                 *VariableData;
+  UINT8                Digest[SHA256_DIGEST_SIZE];
+  BOOLEAN              Current;
+
+  Size   = sizeof (SavedHash);
+  Status = VarLibGetVariable (
+             FSP_NVS_BUFFER_HASH_VARIABLE_NAME,
+             &gFspNvsBufferVariableGuid,
+             NULL,
+             &Size,
+             &SavedHash
+             );
+  if (EFI_ERROR (Status) || (Size != sizeof (SavedHash))) {
+    return FALSE;
+  }
+
+  if (CompareMem (&SavedHash, Hash, OFFSET_OF (FSP_NVS_BUFFER_HASH, StoredSize)) != 0) {
+    return FALSE;
+  }
+
+  Size   = 0;
+  Status = GetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, &Size, NULL);
+  if ((Status != EFI_BUFFER_TOO_SMALL) || (Size != SavedHash.StoredSize)) {
+    return FALSE;
+  }
+
+  VariableData = AllocatePool (Size);
+  if (VariableData == NULL) {
+    return FALSE;
+  }
+
+  Current = FALSE;
+  Status  = GetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, &Size, VariableData);
+  if (!EFI_ERROR (Status) && (Size == SavedHash.StoredSize) &&
+      Sha256HashAll (VariableData, Size, Digest) &&
+      (CompareMem (Digest, SavedHash.StoredDigest, sizeof (Digest)) == 0)) {
+    Current = TRUE;
+  }
+
+  FreePool (VariableData);
+  return Current;
+}
+
+/**
+  Lock FspNvsBufferHash, delete it if it can not be locked.
+**/
+VOID
+LockFspNvsBufferHash (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = VarLibVariableRequestToLock (FSP_NVS_BUFFER_HASH_VARIABLE_NAME, &gFspNvsBufferVariableGuid);
+  if (EFI_ERROR (Status)) {
+    //
+    // An unlocked hash could make a stale FspNvsBuffer look current
+    //
+    DEBUG ((DEBUG_ERROR, "Failed to lock FspNvsBufferHash, Status = %r. Delete it!\n", Status));
+    VarLibSetVariable (FSP_NVS_BUFFER_HASH_VARIABLE_NAME, &gFspNvsBufferVariableGuid, 0, 0, NULL);
+  }
+}
+
+/**
+  Save and lock FspNvsBufferHash, or delete it.
+
+  @param[in] Hash    Hash of the FSP NVS data just saved, NULL to delete it.
+**/
+VOID
+SaveFspNvsBufferHash (
+  IN FSP_NVS_BUFFER_HASH  *Hash  OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Hash == NULL) {
+    VarLibSetVariable (FSP_NVS_BUFFER_HASH_VARIABLE_NAME, &gFspNvsBufferVariableGuid, 0, 0, NULL);
+    return;
+  }
+
+  Status = VarLibSetVariable (
+             FSP_NVS_BUFFER_HASH_VARIABLE_NAME,
+             &gFspNvsBufferVariableGuid,
+             EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+             sizeof (*Hash),
+             Hash
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "Failed to save FspNvsBufferHash, Status = %r\n", Status));
+    return;
+  }
+
+  LockFspNvsBufferHash ();
+}
+
 /**
   This is the standard EFI driver point that detects whether there is a
   MemoryConfigurationData HOB and, if so, saves its data to nvRAM.
@@ -41,16 +177,18 @@ SaveMemoryConfigEntryPoint (
   IN EFI_SYSTEM_TABLE   *SystemTable
   )
 {
-  EFI_STATUS         Status;
-  EFI_HOB_GUID_TYPE  *GuidHob;
-  VOID               *HobData;
-  VOID               *VariableData;
-  UINTN              DataSize;
-  UINTN              BufferSize;
-  BOOLEAN            DataIsIdentical;
-  VOID               *CompressedData;
-  UINT64             CompressedSize;
-  UINTN              CompressedAllocationPages;
+  EFI_STATUS           Status;
+  EFI_HOB_GUID_TYPE    *GuidHob;
+  VOID                 *HobData;
+  VOID                 *VariableData;
+  UINTN                DataSize;
+  UINTN                BufferSize;
+  BOOLEAN              DataIsIdentical;
+  VOID                 *CompressedData;
+  UINT64               CompressedSize;
+  UINTN                CompressedAllocationPages;
+  FSP_NVS_BUFFER_HASH  NvsHash;
+  BOOLEAN              NvsHashValid;
 
   DataSize                  = 0;
   BufferSize                = 0;
@@ -61,6 +199,7 @@ SaveMemoryConfigEntryPoint (
   CompressedData            = NULL;
   CompressedSize            = 0;
   CompressedAllocationPages = 0;
+  NvsHashValid              = FALSE;
 
   //
   // Search for the Memory Configuration GUID HOB.  If it is not present, then
@@ -82,6 +221,41 @@ SaveMemoryConfigEntryPoint (
     }
   }
 
+  //
+  // On most boots the data is what was saved last time, this is detected
+  // from the saved hash and a read back of FspNvsBuffer, without compressing
+  // the data.
+  //
+  if ((HobData != NULL) && (DataSize > 0)) {
+    ZeroMem (&NvsHash, sizeof (NvsHash));
+    NvsHash.Version    = FSP_NVS_BUFFER_HASH_VERSION;
+    NvsHash.Compressed = PcdGetBool (PcdEnableCompressedFspNvsBuffer) ? 1 : 0;
+    NvsHash.DataSize   = DataSize;
+    NvsHashValid       = Sha256HashAll (HobData, DataSize, NvsHash.Digest);
+
+    if (NvsHashValid && IsFspNvsBufferCurrent (&NvsHash)) {
+      Status = LockLargeVariable (L"FspNvsBuffer",  &gFspNvsBufferVariableGuid);
+      if (EFI_ERROR (Status)) {
+        //
+        // Fail to lock variable is security vulnerability and should not happen.
+        //
+        ASSERT_EFI_ERROR (Status);
+        //
+        // When building without ASSERT_EFI_ERROR hang, delete the variable so it will not be consumed.
+        //
+        DEBUG ((DEBUG_ERROR, "Delete variable!\n"));
+        Status = SetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, FALSE, 0, HobData);
+        ASSERT_EFI_ERROR (Status);
+        SaveFspNvsBufferHash (NULL);
+      } else {
+        LockFspNvsBufferHash ();
+        DEBUG ((DEBUG_INFO, "FSP / MRC Training Data hash is identical to last boot, no need to save.\n"));
+      }
+
+      return EFI_REQUEST_UNLOAD_IMAGE;
+    }
+  }
+
   if (PcdGetBool (PcdEnableCompressedFspNvsBuffer)) {
     if (DataSize > 0) {
       CompressedAllocationPages = EFI_SIZE_TO_PAGES (DataSize);
@@ -136,6 +310,7 @@ SaveMemoryConfigEntryPoint (
                 DataSize = 0;
                 Status = SetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, FALSE, DataSize, HobData);
                 ASSERT_EFI_ERROR (Status);
+                NvsHashValid = FALSE;
               }
             }
             FreePool (VariableData);
@@ -157,12 +332,24 @@ SaveMemoryConfigEntryPoint (
           DEBUG ((DEBUG_ERROR, "Delete variable!\n"));
           DataSize = 0;
           Status = SetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, FALSE, DataSize, HobData);
+          NvsHashValid = FALSE;
+        } else if (EFI_ERROR (Status)) {
+          NvsHashValid = FALSE;
         }
         ASSERT_EFI_ERROR (Status);
         DEBUG ((DEBUG_INFO, "Saved size of FSP / MRC Training Data: 0x%x\n", DataSize));
       } else {
         DEBUG ((DEBUG_INFO, "FSP / MRC Training Data is identical to data from last boot, no need to save.\n"));
       }
+
+      //
+      // Record what FspNvsBuffer now holds for the next boot
+      //
+      if (NvsHashValid) {
+        NvsHash.StoredSize = DataSize;
+        NvsHashValid       = Sha256HashAll (HobData, DataSize, NvsHash.StoredDigest);
+      }
+      SaveFspNvsBufferHash (NvsHashValid ? &NvsHash : NULL);
     }
   } else {
     DEBUG((DEBUG_ERROR, "Memory S3 Data HOB was not found\n"));
@@ -126,6 +126,23 @@ TestPointMemoryDiscoveredDmaProtectionEnabled (
   VOID
   );
 
+/**
+  This service verifies the boot time and memory budget after memory is discovered.
+
+  Test subject: Boot time and PEI memory usage after memory is discovered.
+  Test overview: Verify the time since the FPDT reset end and the PEI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointMemoryDiscoveredPerformanceBudget (
+  VOID
+  );
+
 /**
   This service verifies system resources at the end of PEI.
 
@@ -179,6 +196,23 @@ TestPointEndOfPeiPciBusMasterDisabled (
   VOID
   );
 
+/**
+  This service verifies the boot time and memory budget at the end of PEI.
+
+  Test subject: Boot time and PEI memory usage at the end of PEI.
+  Test overview: Verify the time since the FPDT reset end and the PEI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfPeiPerformanceBudget (
+  VOID
+  );
+
 /**
   This service verifies bus master enable (BME) is disabled after PCI enumeration.
 
@@ -264,6 +298,23 @@ TestPointEndOfDxeDmaProtectionEnabled (
   VOID
   );
 
+/**
+  This service verifies the boot time and memory budget at the End of DXE.
+
+  Test subject: Boot time and UEFI memory usage at the End of DXE.
+  Test overview: Verify the time since the FPDT reset end and the UEFI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfDxePerformanceBudget (
+  VOID
+  );
+
 /**
   This service verifies the validity of System Management RAM (SMRAM) alignment at SMM Ready To Lock.
 
@@ -521,6 +572,23 @@ TestPointReadyToBootTcgMorEnabled (
   VOID
   );
 
+/**
+  This service verifies the boot time and memory budget at Ready To Boot.
+
+  Test subject: Boot time and UEFI memory usage at Ready To Boot.
+  Test overview: Verify the time since the FPDT reset end and the UEFI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointReadyToBootPerformanceBudget (
+  VOID
+  );
+
 /**
   This service verifies SMI handler profiling.
 
@@ -770,6 +838,20 @@ TestPointSmmExitBootServices (
 #define   TEST_POINT_BYTE8_READY_TO_BOOT_HSTI_TABLE_FUNCTIONAL_ERROR_CODE                        L"0x08010000"
 #define   TEST_POINT_BYTE8_READY_TO_BOOT_HSTI_TABLE_FUNCTIONAL_ERROR_STRING                      L"No HSTI\r\n"
 
+// Byte 9 - Performance
+#define TEST_POINT_BYTE9_MEMORY_DISCOVERED_PERFORMANCE_BUDGET                               BIT0
+#define TEST_POINT_BYTE9_END_OF_PEI_PERFORMANCE_BUDGET                                      BIT1
+#define TEST_POINT_BYTE9_END_OF_DXE_PERFORMANCE_BUDGET                                      BIT2
+#define TEST_POINT_BYTE9_READY_TO_BOOT_PERFORMANCE_BUDGET                                   BIT3
+#define   TEST_POINT_BYTE9_MEMORY_DISCOVERED_PERFORMANCE_BUDGET_ERROR_CODE                       L"0x09000000"
+#define   TEST_POINT_BYTE9_MEMORY_DISCOVERED_PERFORMANCE_BUDGET_ERROR_STRING                     L"Performance budget exceeded\r\n"
+#define   TEST_POINT_BYTE9_END_OF_PEI_PERFORMANCE_BUDGET_ERROR_CODE                              L"0x09010000"
+#define   TEST_POINT_BYTE9_END_OF_PEI_PERFORMANCE_BUDGET_ERROR_STRING                            L"Performance budget exceeded\r\n"
+#define   TEST_POINT_BYTE9_END_OF_DXE_PERFORMANCE_BUDGET_ERROR_CODE                              L"0x09020000"
+#define   TEST_POINT_BYTE9_END_OF_DXE_PERFORMANCE_BUDGET_ERROR_STRING                            L"Performance budget exceeded\r\n"
+#define   TEST_POINT_BYTE9_READY_TO_BOOT_PERFORMANCE_BUDGET_ERROR_CODE                           L"0x09030000"
+#define   TEST_POINT_BYTE9_READY_TO_BOOT_PERFORMANCE_BUDGET_ERROR_STRING                         L"Performance budget exceeded\r\n"
+
 #pragma pack (1)
 
 typedef struct {
@@ -51,4 +51,41 @@
 //
 #define MAX_VARIABLE_NAME_PAD_SIZE  3
 
+//
+// When data is split across multiple variables, an index variable named
+// "<VariableName>Index" records the number of variables, the size and CRC32 of
+// each of them, and the CRC32 of the complete data set. GetLargeVariable() uses
+// it to read the variables directly instead of probing each one for its size,
+// and SetLargeVariable() uses it to skip writing variables whose contents have
+// not changed. The index is optional; if it is missing or does not match the
+// variables, both libraries fall back to probing the variables one by one.
+//
+#define LARGE_VARIABLE_INDEX_NAME_FORMAT  L"%sIndex"
+#define LARGE_VARIABLE_INDEX_SIGNATURE    SIGNATURE_32 ('L', 'V', 'I', 'X')
+
+//
+// Data sets split across more variables than this are stored without an index.
+//
+#define LARGE_VARIABLE_INDEX_MAX_CHUNKS   128
+
+typedef struct {
+  UINT32    Size;
+  UINT32    Crc;
+} LARGE_VARIABLE_INDEX_CHUNK;
+
+typedef struct {
+  UINT32                        Signature;
+  UINT32                        ChunkCount;
+  UINT64                        TotalSize;
+  UINT32                        DataCrc;
+  UINT32                        Reserved;
+  LARGE_VARIABLE_INDEX_CHUNK    Chunk[LARGE_VARIABLE_INDEX_MAX_CHUNKS];
+} LARGE_VARIABLE_INDEX;
+
+//
+// Only the first ChunkCount entries of Chunk[] are stored in the variable.
+//
+#define LARGE_VARIABLE_INDEX_SIZE(ChunkCount) \
+  (OFFSET_OF (LARGE_VARIABLE_INDEX, Chunk) + (ChunkCount) * sizeof (LARGE_VARIABLE_INDEX_CHUNK))
+
 #endif  // _LARGE_VARIABLE_COMMON_H_
@@ -24,6 +24,109 @@
 
 #include "LargeVariableCommon.h"
 
+/**
+  Reads a large variable that is split across multiple variables using its
+  index variable, without probing each variable for its size first.
+
+  @param[in]       VariableName      A Null-terminated string that is the name of the vendor's
+                                     variable.
+  @param[in]       VendorGuid        A unique identifier for the vendor.
+  @param[in, out]  DataSize          On input, the size in bytes of the return Data buffer.
+                                     On output the size of data returned in Data.
+  @param[out]      Data              The buffer to return the contents of the variable. May be NULL
+                                     with a zero DataSize in order to determine the size buffer needed.
+  @param[in]       TempVariableName  Scratch buffer of MAX_VARIABLE_NAME_SIZE bytes.
+
+  @retval EFI_SUCCESS            The data was read and matches the index.
+  @retval EFI_BUFFER_TOO_SMALL   The DataSize is too small for the result.
+  @retval EFI_INVALID_PARAMETER  The DataSize is not too small and Data is NULL.
+  @retval EFI_NOT_FOUND          There is no index, or it does not match the variables.
+
+**/
+STATIC
+EFI_STATUS
+GetLargeVariableFromIndex (
+  IN     CHAR16                      *VariableName,
+  IN     EFI_GUID                    *VendorGuid,
+  IN OUT UINTN                       *DataSize,
+  OUT    VOID                        *Data,           OPTIONAL
+  IN     CHAR16                      *TempVariableName
+  )
+{
+  LARGE_VARIABLE_INDEX  LargeIndex;
+  EFI_STATUS            Status;
+  UINT64                TotalSize;
+  UINTN                 IndexSize;
+  UINTN                 VariableSize;
+  UINTN                 Index;
+  UINT8                 *OffsetPtr;
+
+  ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, LARGE_VARIABLE_INDEX_NAME_FORMAT, VariableName);
+  IndexSize = sizeof (LargeIndex);
+  Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &IndexSize, &LargeIndex);
+  if (EFI_ERROR (Status) ||
+      (IndexSize < OFFSET_OF (LARGE_VARIABLE_INDEX, Chunk)) ||
+      (LargeIndex.Signature != LARGE_VARIABLE_INDEX_SIGNATURE) ||
+      (LargeIndex.ChunkCount == 0) ||
+      (LargeIndex.ChunkCount > LARGE_VARIABLE_INDEX_MAX_CHUNKS) ||
+      (IndexSize != LARGE_VARIABLE_INDEX_SIZE (LargeIndex.ChunkCount))) {
+    return EFI_NOT_FOUND;
+  }
+
+  TotalSize = 0;
+  for (Index = 0; Index < LargeIndex.ChunkCount; Index++) {
+    TotalSize += LargeIndex.Chunk[Index].Size;
+  }
+  if ((TotalSize != LargeIndex.TotalSize) || (TotalSize > MAX_UINTN)) {
+    DEBUG ((DEBUG_WARN, "GetLargeVariable: Ignoring inconsistent index\n"));
+    return EFI_NOT_FOUND;
+  }
+
+  if (*DataSize < (UINTN) TotalSize) {
+    *DataSize = (UINTN) TotalSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+  if (Data == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Read each variable straight into place. Every variable must have exactly
+  // the size recorded in the index.
+  //
+  DEBUG ((DEBUG_VERBOSE, "GetLargeVariable: Index Found, TotalSize = %ld, NumVariables = %d\n", TotalSize, LargeIndex.ChunkCount));
+  OffsetPtr = (UINT8 *) Data;
+  for (Index = 0; Index < LargeIndex.ChunkCount; Index++) {
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+    VariableSize = LargeIndex.Chunk[Index].Size;
+    Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VariableSize, (VOID *) OffsetPtr);
+    if (EFI_ERROR (Status) || (VariableSize != LargeIndex.Chunk[Index].Size)) {
+      DEBUG ((DEBUG_WARN, "GetLargeVariable: Index does not match %s\n", TempVariableName));
+      return EFI_NOT_FOUND;
+    }
+    OffsetPtr += VariableSize;
+  }
+
+  //
+  // The index is stale if the data set was rewritten with more variables or
+  // different contents without updating it.
+  //
+  ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+  VariableSize = 0;
+  Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VariableSize, NULL);
+  if ((Status != EFI_NOT_FOUND) ||
+      (CalculateCrc32 (Data, (UINTN) TotalSize) != LargeIndex.DataCrc)) {
+    DEBUG ((DEBUG_WARN, "GetLargeVariable: Ignoring stale index\n"));
+    return EFI_NOT_FOUND;
+  }
+
+  *DataSize = (UINTN) TotalSize;
+  return EFI_SUCCESS;
+}
+
 /**
   Returns the value of a large variable.
 
@@ -95,6 +198,14 @@ GetLargeVariable (
       goto Done;
     }
 
+    //
+    // Use the index of the multi-variable set if it is present and current
+    //
+    Status = GetLargeVariableFromIndex (VariableName, VendorGuid, DataSize, Data, TempVariableName);
+    if (Status != EFI_NOT_FOUND) {
+      goto Done;
+    }
+
     VarDataSize = 0;
     Index       = 0;
     ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
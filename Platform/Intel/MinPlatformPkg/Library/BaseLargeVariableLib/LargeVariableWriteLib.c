@@ -19,6 +19,7 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/PrintLib.h>
 #include <Library/VariableReadLib.h>
 #include <Library/VariableWriteLib.h>
@@ -118,6 +119,112 @@ GetVariableSplitSize (
   return VariableSplitSize;
 }
 
+/**
+  Deletes the index variable of a multi-variable set.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+  @param[in]  TempVariableName   Scratch buffer of MAX_VARIABLE_NAME_SIZE bytes.
+
+  @retval EFI_SUCCESS            The index variable was deleted.
+  @retval EFI_NOT_FOUND          There is no index variable.
+  @retval Others                 The index variable could not be deleted.
+
+**/
+STATIC
+EFI_STATUS
+DeleteLargeVariableIndex (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid,
+  IN  CHAR16                       *TempVariableName
+  )
+{
+  ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, LARGE_VARIABLE_INDEX_NAME_FORMAT, VariableName);
+  return VarLibSetVariable (
+           TempVariableName,
+           VendorGuid,
+           EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+           0,
+           NULL
+           );
+}
+
+/**
+  Locks the index variable of a multi-variable set, if there is one.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+  @param[in]  TempVariableName   Scratch buffer of MAX_VARIABLE_NAME_SIZE bytes.
+
+  @retval EFI_SUCCESS            The index variable was locked, or there is no index variable.
+  @retval EFI_ABORTED            Fail to lock variable.
+
+**/
+STATIC
+EFI_STATUS
+LockLargeVariableIndex (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid,
+  IN  CHAR16                       *TempVariableName
+  )
+{
+  EFI_STATUS    Status;
+  UINTN         VariableSize;
+
+  ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, LARGE_VARIABLE_INDEX_NAME_FORMAT, VariableName);
+  VariableSize = 0;
+  Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VariableSize, NULL);
+  if (Status != EFI_BUFFER_TOO_SMALL) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "Locking %s, Guid = %g\n", TempVariableName, VendorGuid));
+  Status = VarLibVariableRequestToLock (TempVariableName, VendorGuid);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "LockLargeVariableIndex: Failed! Satus = %r\n", Status));
+    return EFI_ABORTED;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Checks whether a variable already holds the given data, so that writing it
+  again can be skipped.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the variable.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+  @param[in]  DataSize           The size in bytes of the Data buffer.
+  @param[in]  Data               The data that is about to be written.
+  @param[in]  Buffer             Scratch buffer of at least DataSize bytes.
+
+  @retval TRUE                   The variable exists and its contents are identical to Data.
+  @retval FALSE                  The variable needs to be written.
+
+**/
+STATIC
+BOOLEAN
+IsVariableDataCurrent (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid,
+  IN  UINTN                        DataSize,
+  IN  VOID                         *Data,
+  IN  VOID                         *Buffer
+  )
+{
+  EFI_STATUS    Status;
+  UINT32        Attributes;
+  UINTN         VariableSize;
+
+  VariableSize = DataSize;
+  Status = VarLibGetVariable (VariableName, VendorGuid, &Attributes, &VariableSize, Buffer);
+  return (BOOLEAN) (!EFI_ERROR (Status) &&
+                    (Attributes == (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS)) &&
+                    (VariableSize == DataSize) &&
+                    (CompareMem (Buffer, Data, DataSize) == 0));
+}
+
 /**
   Deletes a large variable.
 
@@ -210,6 +317,12 @@ DeleteLargeVariableInternal (
           Status = Status2;
         }
       }   // End of for loop
+
+      Status2 = DeleteLargeVariableIndex (VariableName, VendorGuid, TempVariableName);
+      if (EFI_ERROR (Status2) && (Status2 != EFI_NOT_FOUND)) {
+        DEBUG ((DEBUG_ERROR, "DeleteLargeVariableInternal: Error deleting index: Status = %r\n", Status2));
+        Status = Status2;
+      }
     } else {
       Status = EFI_NOT_FOUND;
     }
@@ -271,6 +384,14 @@ SetLargeVariable (
   UINTN         BytesRemaining;
   UINTN         SizeToSave;
   UINTN         BufferSize = 0;
+  UINTN         SplitNameLength;
+  UINTN         IndexSize;
+  UINT32        ChunkCrc;
+  BOOLEAN       HaveOldIndex;
+  BOOLEAN       IndexDeleted;
+  VOID          *ChunkBuffer;
+  LARGE_VARIABLE_INDEX  OldIndex;
+  LARGE_VARIABLE_INDEX  NewIndex;
 
   //
   // Check input parameters.
@@ -289,6 +410,8 @@ SetLargeVariable (
   }
 
   VariablesSaved = 0;
+  IndexDeleted   = FALSE;
+  ChunkBuffer    = NULL;
   if (LockVariable && !VarLibIsVariableRequestToLockSupported ()) {
       Status = EFI_INVALID_PARAMETER;
       DEBUG ((DEBUG_ERROR, "SetLargeVariable: Variable locking is not currently supported\n"));
@@ -383,6 +506,28 @@ SetLargeVariable (
     OffsetPtr         = (UINT8 *) Data;
     BytesRemaining    = DataSize;
     VariablesSaved    = 0;
+    SplitNameLength   = VariableNameLength;
+
+    //
+    // The index of the current data tells which variables may already hold
+    // the new contents; those are read back and compared instead of written.
+    // Without an index every variable is compared. A matching CRC is only a
+    // hint, the contents are always compared before a write is skipped.
+    //
+    ZeroMem (&OldIndex, sizeof (OldIndex));
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, LARGE_VARIABLE_INDEX_NAME_FORMAT, VariableName);
+    IndexSize = sizeof (OldIndex);
+    Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &IndexSize, &OldIndex);
+    HaveOldIndex = (BOOLEAN) (!EFI_ERROR (Status) &&
+                              (IndexSize >= OFFSET_OF (LARGE_VARIABLE_INDEX, Chunk)) &&
+                              (OldIndex.Signature == LARGE_VARIABLE_INDEX_SIGNATURE) &&
+                              (OldIndex.ChunkCount <= LARGE_VARIABLE_INDEX_MAX_CHUNKS) &&
+                              (IndexSize == LARGE_VARIABLE_INDEX_SIZE (OldIndex.ChunkCount)));
+    if (!VarLibAtOsRuntime ()) {
+      ChunkBuffer = AllocatePool ((UINTN) VariableSplitSize);
+    }
+    ZeroMem (&NewIndex, sizeof (NewIndex));
 
     //
     // Store chunks of data in UEFI variables until all data is stored
@@ -391,9 +536,16 @@ SetLargeVariable (
       ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
       UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
 
+      //
+      // The split size only changes when the number of digits appended to
+      // the name grows, so only query it again when that happens.
+      //
       SizeToSave          = 0;
       VariableNameLength  = StrLen (TempVariableName);
-      VariableSplitSize   = GetVariableSplitSize (VariableNameLength);
+      if (VariableNameLength != SplitNameLength) {
+        VariableSplitSize = GetVariableSplitSize (VariableNameLength);
+        SplitNameLength   = VariableNameLength;
+      }
       if (VariableSplitSize == 0) {
         DEBUG ((DEBUG_ERROR, "Unable to save variable, out of NV storage space\n"));
         Status = EFI_OUT_OF_RESOURCES;
@@ -405,23 +557,106 @@ SetLargeVariable (
       } else {
         SizeToSave = BytesRemaining;
       }
-      DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, Size %d\n", TempVariableName, VendorGuid, SizeToSave));
-      Status = VarLibSetVariable (
-                TempVariableName,
-                VendorGuid,
-                EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
-                SizeToSave,
-                (VOID *) OffsetPtr
-                );
-      if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error writting variable: Status = %r\n", Status));
-        goto Done;
+
+      ChunkCrc = CalculateCrc32 (OffsetPtr, SizeToSave);
+      if (Index < LARGE_VARIABLE_INDEX_MAX_CHUNKS) {
+        NewIndex.Chunk[Index].Size = (UINT32) SizeToSave;
+        NewIndex.Chunk[Index].Crc  = ChunkCrc;
+      }
+      if ((ChunkBuffer != NULL) &&
+          (!HaveOldIndex ||
+           ((Index < OldIndex.ChunkCount) &&
+            (OldIndex.Chunk[Index].Size == SizeToSave) &&
+            (OldIndex.Chunk[Index].Crc == ChunkCrc))) &&
+          IsVariableDataCurrent (TempVariableName, VendorGuid, SizeToSave, OffsetPtr, ChunkBuffer)) {
+        DEBUG ((DEBUG_INFO, "Unchanged %s, Guid = %g, Size %d\n", TempVariableName, VendorGuid, SizeToSave));
+      } else {
+        //
+        // Remove the index before the first write, so that an interrupted
+        // update is never described by an index of the old data.
+        //
+        if (HaveOldIndex && !IndexDeleted) {
+          Status = DeleteLargeVariableIndex (VariableName, VendorGuid, TempVariableName);
+          if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+            DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error deleting index: Status = %r\n", Status));
+            goto Done;
+          }
+          IndexDeleted = TRUE;
+          ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+          UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+        }
+        DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, Size %d\n", TempVariableName, VendorGuid, SizeToSave));
+        Status = VarLibSetVariable (
+                  TempVariableName,
+                  VendorGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+                  SizeToSave,
+                  (VOID *) OffsetPtr
+                  );
+        if (EFI_ERROR (Status)) {
+          DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error writting variable: Status = %r\n", Status));
+          goto Done;
+        }
       }
       VariablesSaved++;
       BytesRemaining -= SizeToSave;
       OffsetPtr += SizeToSave;
     }   // End of for loop
 
+    //
+    // Remove any variables left over from a previous, larger data set. They
+    // would otherwise be read back as part of this one.
+    //
+    for (Index = VariablesSaved; Index < MAX_VARIABLE_SPLIT; Index++) {
+      ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+      UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+      Status = VarLibSetVariable (
+                 TempVariableName,
+                 VendorGuid,
+                 EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+                 0,
+                 NULL
+                 );
+      if (Status == EFI_NOT_FOUND) {
+        break;
+      } else if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error deleting stale variable: Status = %r\n", Status));
+        goto Done;
+      }
+      DEBUG ((DEBUG_INFO, "Deleted stale %s, Guid = %g\n", TempVariableName, VendorGuid));
+    }
+
+    //
+    // Record the new index. It is optional, so failing to store it is not an
+    // error; readers fall back to probing each variable.
+    //
+    if (VariablesSaved <= LARGE_VARIABLE_INDEX_MAX_CHUNKS) {
+      NewIndex.Signature  = LARGE_VARIABLE_INDEX_SIGNATURE;
+      NewIndex.ChunkCount = (UINT32) VariablesSaved;
+      NewIndex.TotalSize  = DataSize;
+      NewIndex.DataCrc    = CalculateCrc32 (Data, DataSize);
+      IndexSize           = LARGE_VARIABLE_INDEX_SIZE (VariablesSaved);
+      if (!HaveOldIndex || IndexDeleted || (CompareMem (&OldIndex, &NewIndex, IndexSize) != 0)) {
+        ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+        UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, LARGE_VARIABLE_INDEX_NAME_FORMAT, VariableName);
+        DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, Size %d\n", TempVariableName, VendorGuid, IndexSize));
+        Status = VarLibSetVariable (
+                   TempVariableName,
+                   VendorGuid,
+                   EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+                   IndexSize,
+                   &NewIndex
+                   );
+        if (EFI_ERROR (Status)) {
+          DEBUG ((DEBUG_WARN, "SetLargeVariable: Index not saved: Status = %r\n", Status));
+          DeleteLargeVariableIndex (VariableName, VendorGuid, TempVariableName);
+        }
+      }
+    } else if (HaveOldIndex && !IndexDeleted) {
+      DeleteLargeVariableIndex (VariableName, VendorGuid, TempVariableName);
+    }
+    Status = EFI_SUCCESS;
+
     //
     // If the user requested that the variables be locked, lock them now that
     // all data is saved.
@@ -443,10 +678,18 @@ SetLargeVariable (
           goto Done;
         }
       }
+      Status = LockLargeVariableIndex (VariableName, VendorGuid, TempVariableName);
+      if (EFI_ERROR (Status)) {
+        VariablesSaved = 0;
+        goto Done;
+      }
     }
   }
 
 Done:
+  if (ChunkBuffer != NULL) {
+    FreePool (ChunkBuffer);
+  }
   if (EFI_ERROR (Status) && VariablesSaved > 0) {
     DEBUG ((DEBUG_ERROR, "SetLargeVariable: An error was encountered, deleting variables with partially stored data\n"));
     for (Index = 0; Index < VariablesSaved; Index++) {
@@ -465,6 +708,7 @@ Done:
         DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error deleting variable: Status = %r\n", Status2));
       }
     }
+    DeleteLargeVariableIndex (VariableName, VendorGuid, TempVariableName);
   }
   DEBUG ((DEBUG_ERROR, "SetLargeVariable: Status = %r\n", Status));
   return Status;
@@ -576,9 +820,9 @@ LockLargeVariable (
           }
         } else if (Status == EFI_NOT_FOUND) {
           //
-          // No more variables need to lock.
+          // No more variables need to lock, except for the index.
           //
-          return EFI_SUCCESS;
+          return LockLargeVariableIndex (VariableName, VendorGuid, TempVariableName);
         }
       }   // End of for loop
     }
@@ -7,6 +7,12 @@
   This sequence is further divided into Blocks and Huffman codings
   are applied to each Block.
 
+  Two LZ77 match finders produce the same bitstream format.
+  PcdCompressLibLevel selects between them:
+    - Level 0 (the default) uses the PATRICIA tree. It gives the best ratio.
+    - Levels 1 - 9 use hash chains bounded to 2^(Level + 1) candidates.
+      They trade some ratio for speed.
+
   Copyright (c) 2007 - 2020, Intel Corporation. All rights reserved.<BR>
   SPDX-License-Identifier: BSD-2-Clause-Patent
 
@@ -15,6 +21,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/PcdLib.h>
 #include <Uefi/UefiBaseType.h>
 
 #define SHELL_FREE_NON_NULL(Pointer)  \
@@ -46,6 +53,16 @@ typedef INT16             NODE;
 #define CRCPOLY           0xA001
 #define UPDATE_CRC(LoopVar5)     mCrc = mCrcTable[(mCrc ^ (LoopVar5)) & 0xFF] ^ (mCrc >> UINT8_BIT)
 
+//
+// Hash chain match finder. mHashHead holds the most recent position of each
+// 3 byte hash, mHashPrev the previous position with the same hash, both as
+// stream offsets plus 1 so 0 ends a chain.
+//
+#define MAX_COMPRESS_LEVEL  9
+#define HC_HASH_BITS        15
+#define HC_HASH_SIZE        (1U << HC_HASH_BITS)
+#define HC_HASH(Text)       ((((UINT32) (Text)[0] << 10) ^ ((UINT32) (Text)[1] << 5) ^ (UINT32) (Text)[2]) & (HC_HASH_SIZE - 1))
+
 //
 // C: the Char&Len Set; P: the Position Set; T: the exTra Set
 //
@@ -125,6 +142,11 @@ STATIC NODE   *mPrev;
 STATIC NODE   *mNext = NULL;
 INT32         mHuffmanDepth = 0;
 
+STATIC UINT32 *mHashHead = NULL;
+STATIC UINT32 *mHashPrev = NULL;
+STATIC UINT32 mHashPos;
+STATIC UINT32 mMaxChain;
+
 /**
   Make a CRC table.
 
@@ -196,12 +218,28 @@ AllocateMemory (
   )
 {
   mText       = AllocateZeroPool (WNDSIZ * 2 + MAXMATCH);
-  mLevel      = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mLevel));
-  mChildCount = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mChildCount));
-  mPosition   = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mPosition));
-  mParent     = AllocateZeroPool (WNDSIZ * 2 * sizeof (*mParent));
-  mPrev       = AllocateZeroPool (WNDSIZ * 2 * sizeof (*mPrev));
-  mNext       = AllocateZeroPool ((MAX_HASH_VAL + 1) * sizeof (*mNext));
+  if (mText == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (mMaxChain != 0) {
+    mHashHead = AllocateZeroPool (HC_HASH_SIZE * sizeof (*mHashHead));
+    mHashPrev = AllocateZeroPool (WNDSIZ * sizeof (*mHashPrev));
+    if ((mHashHead == NULL) || (mHashPrev == NULL)) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  } else {
+    mLevel      = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mLevel));
+    mChildCount = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mChildCount));
+    mPosition   = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mPosition));
+    mParent     = AllocateZeroPool (WNDSIZ * 2 * sizeof (*mParent));
+    mPrev       = AllocateZeroPool (WNDSIZ * 2 * sizeof (*mPrev));
+    mNext       = AllocateZeroPool ((MAX_HASH_VAL + 1) * sizeof (*mNext));
+    if ((mLevel == NULL) || (mChildCount == NULL) || (mPosition == NULL) ||
+        (mParent == NULL) || (mPrev == NULL) || (mNext == NULL)) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
 
   mBufSiz     = BLKSIZ;
   mBuf        = AllocateZeroPool (mBufSiz);
@@ -236,6 +274,8 @@ FreeMemory (
   SHELL_FREE_NON_NULL (mParent);
   SHELL_FREE_NON_NULL (mPrev);
   SHELL_FREE_NON_NULL (mNext);
+  SHELL_FREE_NON_NULL (mHashHead);
+  SHELL_FREE_NON_NULL (mHashPrev);
   SHELL_FREE_NON_NULL (mBuf);
 }
 
@@ -250,6 +290,11 @@ InitSlide (
 {
   NODE  LoopVar1;
 
+  if (mMaxChain != 0) {
+    mHashPos = 0;
+    return;
+  }
+
   SetMem (mLevel + WNDSIZ, (MAX_UINT8 + 1) * sizeof (UINT8), 1);
   SetMem (mPosition + WNDSIZ, (MAX_UINT8 + 1) * sizeof (NODE), 0);
 
@@ -574,6 +619,97 @@ DeleteNode (
   mAvail              = LoopVar4;
 }
 
+/**
+  Insert the current position into the hash chains and find the longest
+  match for it among the most recent mMaxChain candidates.
+
+  The match is returned the way InsertNode() returns it, in mMatchLen and
+  mMatchPos, so Encode() is the same for both match finders.
+
+  @param[in] Search   FALSE to only insert the position, for positions
+                      inside a match that is already being output.
+
+**/
+VOID
+EFIAPI
+HashChainInsert (
+  IN BOOLEAN  Search
+  )
+{
+  UINT8   *Current;
+  UINT8   *Match;
+  UINT32  Hash;
+  UINT32  Candidate;
+  UINT32  Next;
+  UINT32  Distance;
+  UINT32  Chain;
+  INT32   Length;
+
+  mHashPos++;
+  Current   = &mText[mPos];
+  Hash      = HC_HASH (Current);
+  Candidate = mHashHead[Hash];
+  mHashPrev[mHashPos & (WNDSIZ - 1)] = Candidate;
+  mHashHead[Hash] = mHashPos;
+
+  mMatchLen = 0;
+  if (!Search) {
+    return;
+  }
+
+  for (Chain = mMaxChain; (Candidate != 0) && (Chain > 0); Chain--) {
+    //
+    // Positions out of the window, or overwritten in mHashPrev by a newer
+    // one, end the chain
+    //
+    Distance = mHashPos - Candidate;
+    if ((Distance == 0) || (Distance >= WNDSIZ)) {
+      break;
+    }
+
+    Match = Current - Distance;
+    if (Match[mMatchLen] == Current[mMatchLen]) {
+      for (Length = 0; Length < MAXMATCH && Match[Length] == Current[Length]; Length++) {
+      }
+
+      if (Length > mMatchLen) {
+        mMatchLen = Length;
+        mMatchPos = (NODE) (mPos - Distance);
+        if (Length >= MAXMATCH) {
+          break;
+        }
+      }
+    }
+
+    Next = mHashPrev[Candidate & (WNDSIZ - 1)];
+    if (Next >= Candidate) {
+      break;
+    }
+
+    Candidate = Next;
+  }
+}
+
+/**
+  Find a match for the current position with the selected match finder.
+
+  @param[in] Search   FALSE if the match is not needed.
+
+**/
+VOID
+EFIAPI
+FindMatch (
+  IN BOOLEAN  Search
+  )
+{
+  if (mMaxChain != 0) {
+    HashChainInsert (Search);
+  } else {
+    DeleteNode ();
+    InsertNode ();
+  }
+}
+
 /**
   Read in source data
 
@@ -613,6 +749,8 @@ FreadCrc (
   Advance the current position (read in new data if needed).
   Delete outdated string info. Find a match string for current position.
 
+  @param[in] Search   FALSE if the match is not needed.
+
   @retval TRUE      The operation was successful.
   @retval FALSE     The operation failed due to insufficient memory.
 
@@ -620,7 +758,7 @@ FreadCrc (
 BOOLEAN
 EFIAPI
 GetNextMatch (
-  VOID
+  IN BOOLEAN  Search
   )
 {
   INT32 LoopVar8;
@@ -641,8 +779,7 @@ GetNextMatch (
     mPos = WNDSIZ;
   }
 
-  DeleteNode ();
-  InsertNode ();
+  FindMatch (Search);
 
   return (TRUE);
 }
@@ -1304,7 +1441,11 @@ Encode (
 
   mMatchLen   = 0;
   mPos        = WNDSIZ;
-  InsertNode ();
+  if (mMaxChain != 0) {
+    HashChainInsert (TRUE);
+  } else {
+    InsertNode ();
+  }
   if (mMatchLen > mRemainder) {
     mMatchLen = mRemainder;
   }
@@ -1312,7 +1453,7 @@ Encode (
   while (mRemainder > 0) {
     LastMatchLen = mMatchLen;
     LastMatchPos = mMatchPos;
-    if (!GetNextMatch ()) {
+    if (!GetNextMatch (TRUE)) {
       Status = EFI_OUT_OF_RESOURCES;
     }
     if (mMatchLen > mRemainder) {
@@ -1334,7 +1475,10 @@ Encode (
         (mPos - LastMatchPos - 2) & (WNDSIZ - 1));
       LastMatchLen--;
       while (LastMatchLen > 0) {
-        if (!GetNextMatch ()) {
+        //
+        // Only the match of the last position of the pointer is used
+        //
+        if (!GetNextMatch (LastMatchLen == 1)) {
           Status = EFI_OUT_OF_RESOURCES;
         }
         LastMatchLen--;
@@ -1373,6 +1517,7 @@ Compress (
   )
 {
   EFI_STATUS  Status;
+  UINT8       Level;
 
   //
   // Initializations
@@ -1386,6 +1531,14 @@ Compress (
   mParent         = NULL;
   mPrev           = NULL;
   mNext           = NULL;
+  mHashHead       = NULL;
+  mHashPrev       = NULL;
+
+  Level = PcdGet8 (PcdCompressLibLevel);
+  if (Level > MAX_COMPRESS_LEVEL) {
+    Level = MAX_COMPRESS_LEVEL;
+  }
+  mMaxChain = (Level == 0) ? 0 : (1U << (Level + 1));
 
   mSrc            = SrcBuffer;
   mSrcUpperLimit  = mSrc + SrcSize;
@@ -0,0 +1,257 @@
+/** @file
+  Host based unit tests and benchmark of CompressLib.
+
+  Every PcdCompressLibLevel is run over the same generated buffer. The output
+  has to round-trip through UefiDecompressLib, and the throughput and ratio of
+  each level are logged so the match finders can be compared.
+
+  Copyright (c) 2007 - 2020, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/PrintLib.h>
+#include <Library/CompressLib.h>
+#include <Library/UefiDecompressLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "CompressLib Unit Tests"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define TEST_DATA_SIZE      SIZE_256KB
+#define MAX_COMPRESS_LEVEL  9
+
+STATIC UINT8  mLevels[MAX_COMPRESS_LEVEL + 1] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+STATIC UINT8  *mSource       = NULL;
+STATIC UINT8  *mCompressed   = NULL;
+STATIC UINT8  *mDecompressed = NULL;
+
+/**
+  Fill a buffer with data that compresses roughly like a configuration blob:
+  zero runs, repeats of earlier data and short runs of a small alphabet.
+
+  @param[out] Buffer     The buffer to fill.
+  @param[in]  Size       The size of Buffer in bytes.
+**/
+STATIC
+VOID
+FillTestData (
+  OUT UINT8  *Buffer,
+  IN  UINTN  Size
+  )
+{
+  UINT32  Seed;
+  UINTN   Index;
+  UINTN   Length;
+  UINTN   Distance;
+
+  Seed  = 0x12345678;
+  Index = 0;
+  while (Index < Size) {
+    Seed = Seed * 1103515245 + 12345;
+    switch (Seed >> 30) {
+      case 0:
+        Length = 16 + ((Seed >> 8) & 0xFF);
+        Length = MIN (Length, Size - Index);
+        ZeroMem (Buffer + Index, Length);
+        break;
+
+      case 1:
+        Distance = 1 + ((Seed >> 4) & 0x1FFF);
+        Length   = 8 + ((Seed >> 20) & 0x3F);
+        Length   = MIN (Length, Size - Index);
+        if (Distance > Index) {
+          Length = MIN (Length, 8);
+          ZeroMem (Buffer + Index, Length);
+          break;
+        }
+
+        for (Distance = Index - Distance; Length > 0; Length--) {
+          Buffer[Index++] = Buffer[Distance++];
+        }
+
+        continue;
+
+      default:
+        Length = 8 + ((Seed >> 8) & 0x1F);
+        Length = MIN (Length, Size - Index);
+        for (Distance = 0; Distance < Length; Distance++) {
+          Seed                     = Seed * 1103515245 + 12345;
+          Buffer[Index + Distance] = (UINT8)(0x40 + ((Seed >> 16) & 0x1F));
+        }
+
+        break;
+    }
+
+    Index += Length;
+  }
+}
+
+/**
+  Compress the test data at the level given by Context, decompress it again
+  and log the throughput and ratio of the level.
+
+  @param[in]  Context    Points to the UINT8 level to test.
+
+  @retval  UNIT_TEST_PASSED             The data round-tripped.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CompressRoundTrip (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8          Level;
+  UINT64         CompressedSize;
+  UINT32         DestinationSize;
+  UINT32         ScratchSize;
+  VOID           *Scratch;
+  EFI_STATUS     Status;
+  RETURN_STATUS  DecompressStatus;
+  clock_t        Start;
+  clock_t        Elapsed;
+
+  Level = *(UINT8 *)Context;
+  PatchPcdSet8 (PcdCompressLibLevel, Level);
+
+  CompressedSize = 2 * TEST_DATA_SIZE;
+  Start          = clock ();
+  Status         = Compress (mSource, TEST_DATA_SIZE, mCompressed, &CompressedSize);
+  Elapsed        = clock () - Start;
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (CompressedSize < TEST_DATA_SIZE);
+
+  DecompressStatus = UefiDecompressGetInfo (mCompressed, (UINT32)CompressedSize, &DestinationSize, &ScratchSize);
+  UT_ASSERT_NOT_EFI_ERROR (DecompressStatus);
+  UT_ASSERT_EQUAL (DestinationSize, TEST_DATA_SIZE);
+
+  Scratch = AllocatePool (ScratchSize);
+  UT_ASSERT_NOT_NULL (Scratch);
+  SetMem (mDecompressed, TEST_DATA_SIZE, 0xAA);
+  DecompressStatus = UefiDecompress (mCompressed, mDecompressed, Scratch);
+  FreePool (Scratch);
+  UT_ASSERT_NOT_EFI_ERROR (DecompressStatus);
+  UT_ASSERT_MEM_EQUAL (mDecompressed, mSource, TEST_DATA_SIZE);
+
+  if (Elapsed == 0) {
+    Elapsed = 1;
+  }
+
+  UT_LOG_INFO (
+    "Level %d: %d -> %Lu bytes (%Lu%%), %Lu KB/s\n",
+    Level,
+    TEST_DATA_SIZE,
+    CompressedSize,
+    DivU64x32 (MultU64x32 (CompressedSize, 100), TEST_DATA_SIZE),
+    DivU64x64Remainder (MultU64x32 (TEST_DATA_SIZE / SIZE_1KB, CLOCKS_PER_SEC), (UINT64)Elapsed, NULL)
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for CompressLib
+  and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SetupAndRunUnitTests (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      CompressTests;
+  CHAR8                       Description[32];
+  CHAR8                       ClassName[32];
+  UINTN                       Index;
+
+  Framework = NULL;
+  DEBUG ((DEBUG_INFO, "%a: v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  mSource       = AllocatePool (TEST_DATA_SIZE);
+  mCompressed   = AllocatePool (2 * TEST_DATA_SIZE);
+  mDecompressed = AllocatePool (TEST_DATA_SIZE);
+  if ((mSource == NULL) || (mCompressed == NULL) || (mDecompressed == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  FillTestData (mSource, TEST_DATA_SIZE);
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&CompressTests, Framework, "CompressLib Round Trip Tests", "CompressLib.RoundTrip", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CompressLib Round Trip Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mLevels); Index++) {
+    AsciiSPrint (Description, sizeof (Description), "Round trip at level %d", mLevels[Index]);
+    AsciiSPrint (ClassName, sizeof (ClassName), "CompressRoundTrip.Level%d", mLevels[Index]);
+    AddTestCase (CompressTests, Description, ClassName, CompressRoundTrip, NULL, NULL, &mLevels[Index]);
+  }
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  if (mSource != NULL) {
+    FreePool (mSource);
+  }
+
+  if (mCompressed != NULL) {
+    FreePool (mCompressed);
+  }
+
+  if (mDecompressed != NULL) {
+    FreePool (mDecompressed);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return SetupAndRunUnitTests ();
+}
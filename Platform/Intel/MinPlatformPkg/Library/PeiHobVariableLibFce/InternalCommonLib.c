@@ -406,6 +406,266 @@ EFI_PEI_NOTIFY_DESCRIPTOR mMemoryNotifyList = {
   BuildDefaultDataHobForRecoveryVariable 
 };
 
+//
+// FNV-1a parameters used to hash the vendor GUID and name of a variable.
+//
+#define HOB_VARIABLE_INDEX_HASH_BASIS  0x811C9DC5
+#define HOB_VARIABLE_INDEX_HASH_PRIME  0x01000193
+
+//
+// The index HOB, including its EFI_HOB_GUID_TYPE header, must fit in the
+// 16-bit HOB length.
+//
+#define HOB_VARIABLE_INDEX_MAX_ENTRIES  4096
+
+/**
+  Computes the hash used to index a variable in the default variable HOB.
+
+  @param[in]  VariableName      A Null-terminated string that is the name of the variable.
+  @param[in]  NameLength        Maximum number of characters of VariableName to hash.
+  @param[in]  VendorGuid        A unique identifier for the vendor.
+
+  @return Hash of the vendor GUID and name.
+
+**/
+STATIC
+UINT32
+HashVariable (
+  IN CHAR16                     *VariableName,
+  IN UINTN                      NameLength,
+  IN EFI_GUID                   *VendorGuid
+  )
+{
+  UINT32  Hash;
+  UINT8   *Guid;
+  UINTN   Index;
+
+  Hash = HOB_VARIABLE_INDEX_HASH_BASIS;
+  Guid = (UINT8 *) VendorGuid;
+  for (Index = 0; Index < sizeof (EFI_GUID); Index++) {
+    Hash = (Hash ^ Guid[Index]) * HOB_VARIABLE_INDEX_HASH_PRIME;
+  }
+  for (Index = 0; (Index < NameLength) && (VariableName[Index] != 0); Index++) {
+    Hash = (Hash ^ (UINT8) VariableName[Index]) * HOB_VARIABLE_INDEX_HASH_PRIME;
+    Hash = (Hash ^ (UINT8) (VariableName[Index] >> 8)) * HOB_VARIABLE_INDEX_HASH_PRIME;
+  }
+
+  return Hash;
+}
+
+/**
+  Checks whether a variable has the given name and vendor GUID.
+
+  @param[in]  Variable          Pointer to the Variable Header.
+  @param[in]  AuthFlag          Authenticated variable flag.
+  @param[in]  VariableName      A Null-terminated string that is the name of the vendor's
+                                variable.
+  @param[in]  VendorGuid        A unique identifier for the vendor.
+
+  @retval TRUE                  The variable matches.
+  @retval FALSE                 The variable does not match.
+
+**/
+STATIC
+BOOLEAN
+IsVariableMatch (
+  IN AUTHENTICATED_VARIABLE_HEADER  *Variable,
+  IN BOOLEAN                        AuthFlag,
+  IN CHAR16                         *VariableName,
+  IN EFI_GUID                       *VendorGuid
+  )
+{
+  if (!CompareGuid (VendorGuid, GetVendorGuidPtr (Variable, AuthFlag))) {
+    return FALSE;
+  }
+
+  ASSERT (NameSizeOfVariable (Variable, AuthFlag) != 0);
+  return (BOOLEAN) (CompareMem (
+                      VariableName,
+                      GetVariableNamePtr (Variable, AuthFlag),
+                      NameSizeOfVariable (Variable, AuthFlag)
+                      ) == 0);
+}
+
+/**
+  Builds the hash index over a variable store and stores it in a new GUID HOB.
+
+  The HOB is created through the PEI Services directly rather than HobLib, so
+  that running out of HOB space only means lookups fall back to walking the
+  variable store. A store that can not be indexed, because it holds too many
+  variables or the index does not fit in the HOB list, gets an index with no
+  entries so that the attempt is made only once.
+
+  @param[in]  VariableStoreHeader  Pointer to the Variable Store Header.
+  @param[in]  AuthFlag             Authenticated variable flag.
+
+  @return Pointer to the new index, NULL if not even an empty one could be created.
+
+**/
+STATIC
+HOB_VARIABLE_INDEX *
+BuildVariableIndexHob (
+  IN VARIABLE_STORE_HEADER      *VariableStoreHeader,
+  IN BOOLEAN                    AuthFlag
+  )
+{
+  CONST EFI_PEI_SERVICES        **PeiServices;
+  EFI_STATUS                    Status;
+  EFI_HOB_GUID_TYPE             *GuidHob;
+  HOB_VARIABLE_INDEX            *VariableIndex;
+  HOB_VARIABLE_INDEX_ENTRY      *Entry;
+  AUTHENTICATED_VARIABLE_HEADER *StartPtr;
+  AUTHENTICATED_VARIABLE_HEADER *EndPtr;
+  AUTHENTICATED_VARIABLE_HEADER *CurrPtr;
+  AUTHENTICATED_VARIABLE_HEADER *Variable;
+  UINTN                         VariableCount;
+  UINT32                        EntryCount;
+  UINT32                        Hash;
+  UINT32                        Slot;
+
+  StartPtr = GetStartPointer (VariableStoreHeader);
+  EndPtr   = GetEndPointer (VariableStoreHeader);
+
+  VariableCount = 0;
+  for ( CurrPtr = StartPtr
+      ; (CurrPtr < EndPtr) && IsValidVariableHeader (CurrPtr)
+      ; CurrPtr = GetNextVariablePtr (CurrPtr, AuthFlag)
+      ) {
+    if (CurrPtr->State == VAR_ADDED) {
+      VariableCount++;
+    }
+  }
+
+  //
+  // Keep the table at most half full so that probe sequences stay short.
+  //
+  EntryCount = 16;
+  while (EntryCount < VariableCount * 2) {
+    EntryCount *= 2;
+  }
+  if (EntryCount > HOB_VARIABLE_INDEX_MAX_ENTRIES) {
+    DEBUG ((DEBUG_INFO, "HobVariableLib: %Lu variables are too many to index\n", (UINT64) VariableCount));
+    EntryCount = 0;
+  }
+
+  PeiServices = GetPeiServicesTablePointer ();
+  Status = (*PeiServices)->CreateHob (
+                             PeiServices,
+                             EFI_HOB_TYPE_GUID_EXTENSION,
+                             (UINT16) (sizeof (EFI_HOB_GUID_TYPE) + sizeof (HOB_VARIABLE_INDEX) + EntryCount * sizeof (HOB_VARIABLE_INDEX_ENTRY)),
+                             (VOID **) &GuidHob
+                             );
+  if (EFI_ERROR (Status) && (EntryCount != 0)) {
+    DEBUG ((DEBUG_INFO, "HobVariableLib: No HOB space for the variable index - %r\n", Status));
+    EntryCount = 0;
+    Status = (*PeiServices)->CreateHob (
+                               PeiServices,
+                               EFI_HOB_TYPE_GUID_EXTENSION,
+                               (UINT16) (sizeof (EFI_HOB_GUID_TYPE) + sizeof (HOB_VARIABLE_INDEX)),
+                               (VOID **) &GuidHob
+                               );
+  }
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+  CopyGuid (&GuidHob->Name, &gHobVariableIndexGuid);
+
+  VariableIndex = (HOB_VARIABLE_INDEX *) GET_GUID_HOB_DATA (GuidHob);
+  CopyGuid (&VariableIndex->StoreSignature, &VariableStoreHeader->Signature);
+  VariableIndex->StoreSize  = VariableStoreHeader->Size;
+  VariableIndex->EntryCount = EntryCount;
+  if (EntryCount == 0) {
+    return VariableIndex;
+  }
+  Entry = (HOB_VARIABLE_INDEX_ENTRY *) (VariableIndex + 1);
+  ZeroMem (Entry, EntryCount * sizeof (HOB_VARIABLE_INDEX_ENTRY));
+
+  for ( CurrPtr = StartPtr
+      ; (CurrPtr < EndPtr) && IsValidVariableHeader (CurrPtr)
+      ; CurrPtr = GetNextVariablePtr (CurrPtr, AuthFlag)
+      ) {
+    if (CurrPtr->State != VAR_ADDED) {
+      continue;
+    }
+    Hash = HashVariable (
+             GetVariableNamePtr (CurrPtr, AuthFlag),
+             NameSizeOfVariable (CurrPtr, AuthFlag) / sizeof (CHAR16),
+             GetVendorGuidPtr (CurrPtr, AuthFlag)
+             );
+    for (Slot = Hash & (EntryCount - 1); Entry[Slot].Offset != 0; Slot = (Slot + 1) & (EntryCount - 1)) {
+      //
+      // Like the linear search, the first instance of a duplicate variable wins.
+      //
+      Variable = (AUTHENTICATED_VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + Entry[Slot].Offset);
+      if ((Entry[Slot].Hash == Hash) &&
+          IsVariableMatch (Variable, AuthFlag, GetVariableNamePtr (CurrPtr, AuthFlag), GetVendorGuidPtr (CurrPtr, AuthFlag))) {
+        break;
+      }
+    }
+    if (Entry[Slot].Offset == 0) {
+      Entry[Slot].Hash   = Hash;
+      Entry[Slot].Offset = (UINT32) ((UINTN) CurrPtr - (UINTN) VariableStoreHeader);
+    }
+  }
+
+  return VariableIndex;
+}
+
+/**
+  Gets the hash index over the default variable HOB, building it on first use.
+
+  The index is only built once permanent memory is installed. Before that the
+  HOB list lives in temporary RAM, which is too small to spend on the index.
+
+  @param[in]  StoreGuidHob         The GUID HOB holding the variable store.
+  @param[in]  VariableStoreHeader  Pointer to the Variable Store Header.
+  @param[in]  AuthFlag             Authenticated variable flag.
+
+  @return Pointer to the index, NULL if there is none yet.
+
+**/
+STATIC
+HOB_VARIABLE_INDEX *
+GetVariableIndex (
+  IN EFI_HOB_GUID_TYPE          *StoreGuidHob,
+  IN VARIABLE_STORE_HEADER      *VariableStoreHeader,
+  IN BOOLEAN                    AuthFlag
+  )
+{
+  CONST EFI_PEI_SERVICES        **PeiServices;
+  EFI_STATUS                    Status;
+  EFI_HOB_GUID_TYPE             *GuidHob;
+  HOB_VARIABLE_INDEX            *VariableIndex;
+
+  //
+  // The index is always built after the store it indexes, so only the HOBs
+  // following the store need to be searched.
+  //
+  GuidHob = GetNextGuidHob (&gHobVariableIndexGuid, GET_NEXT_HOB (StoreGuidHob));
+  while (GuidHob != NULL) {
+    VariableIndex = (HOB_VARIABLE_INDEX *) GET_GUID_HOB_DATA (GuidHob);
+    if (CompareGuid (&VariableIndex->StoreSignature, &VariableStoreHeader->Signature) &&
+        (VariableIndex->StoreSize == VariableStoreHeader->Size)) {
+      return VariableIndex;
+    }
+    GuidHob = GetNextGuidHob (&gHobVariableIndexGuid, GET_NEXT_HOB (GuidHob));
+  }
+
+  PeiServices = GetPeiServicesTablePointer ();
+  Status = (*PeiServices)->LocatePpi (
+                             PeiServices,
+                             &gEfiPeiMemoryDiscoveredPpiGuid,
+                             0,
+                             NULL,
+                             NULL
+                             );
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+
+  return BuildVariableIndexHob (VariableStoreHeader, AuthFlag);
+}
+
 /**
   Find variable from default variable HOB.
 
@@ -429,7 +689,10 @@ FindVariableFromHob (
   AUTHENTICATED_VARIABLE_HEADER *StartPtr;
   AUTHENTICATED_VARIABLE_HEADER *EndPtr;
   AUTHENTICATED_VARIABLE_HEADER *CurrPtr;
-  VOID                          *Point;
+  HOB_VARIABLE_INDEX            *VariableIndex;
+  HOB_VARIABLE_INDEX_ENTRY      *Entry;
+  UINT32                        Hash;
+  UINT32                        Slot;
 
   VariableStoreHeader = NULL;
 
@@ -449,6 +712,28 @@ FindVariableFromHob (
     return NULL;
   }
 
+  //
+  // Look the variable up in the hash index when there is one. An index
+  // without entries marks a store that could not be indexed.
+  //
+  VariableIndex = GetVariableIndex (GuidHob, VariableStoreHeader, *AuthFlag);
+  if ((VariableIndex != NULL) && (VariableIndex->EntryCount != 0)) {
+    Entry = (HOB_VARIABLE_INDEX_ENTRY *) (VariableIndex + 1);
+    Hash  = HashVariable (VariableName, MAX_UINTN, VendorGuid);
+    for ( Slot = Hash & (VariableIndex->EntryCount - 1)
+        ; Entry[Slot].Offset != 0
+        ; Slot = (Slot + 1) & (VariableIndex->EntryCount - 1)
+        ) {
+      if (Entry[Slot].Hash == Hash) {
+        CurrPtr = (AUTHENTICATED_VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + Entry[Slot].Offset);
+        if (IsVariableMatch (CurrPtr, *AuthFlag, VariableName, VendorGuid)) {
+          return CurrPtr;
+        }
+      }
+    }
+    return NULL;
+  }
+
   StartPtr = GetStartPointer (VariableStoreHeader);
   EndPtr   = GetEndPointer (VariableStoreHeader);
   for ( CurrPtr = StartPtr
@@ -456,13 +741,8 @@ FindVariableFromHob (
       ; CurrPtr = GetNextVariablePtr (CurrPtr, *AuthFlag)
       ) {
     if (CurrPtr->State == VAR_ADDED) {
-      if (CompareGuid (VendorGuid, GetVendorGuidPtr (CurrPtr, *AuthFlag))) {
-        Point = (VOID *) GetVariableNamePtr (CurrPtr, *AuthFlag);
-
-        ASSERT (NameSizeOfVariable (CurrPtr, *AuthFlag) != 0);
-        if (CompareMem (VariableName, Point, NameSizeOfVariable (CurrPtr, *AuthFlag)) == 0) {
-          return CurrPtr;
-        }
+      if (IsVariableMatch (CurrPtr, *AuthFlag, VariableName, VendorGuid)) {
+        return CurrPtr;
       }
     }
   }
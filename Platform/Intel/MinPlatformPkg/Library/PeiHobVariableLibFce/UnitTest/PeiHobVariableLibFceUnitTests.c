@@ -0,0 +1,642 @@
+/** @file
+  Host based unit tests and benchmark of the PeiHobVariableLibFce lookups.
+
+  InternalCommonLib.c is built against a HOB list kept in host memory. The
+  HobLib and PeiServicesTablePointerLib functions it uses are provided here,
+  so the tests can control whether memory is installed and how much HOB
+  space is left.
+
+  Copyright (c) 2017-2019, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include <PiPei.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/HobVariableLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PeiServicesTablePointerLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UnitTestLib.h>
+#include <Ppi/MemoryDiscovered.h>
+#include "../Variable.h"
+
+#define UNIT_TEST_NAME     "PeiHobVariableLibFce Unit Tests"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define TEST_HOB_LIST_SIZE       SIZE_256KB
+#define TEST_VARIABLE_COUNT      200
+#define TEST_VARIABLE_DATA_SIZE  16
+
+//
+// The largest store a GUID HOB can hold, the HOB length is 16 bits.
+//
+#define BENCHMARK_STORE_SIZE          ((MAX_UINT16 & ~0x7) - sizeof (EFI_HOB_GUID_TYPE))
+#define BENCHMARK_VARIABLE_DATA_SIZE  128
+#define BENCHMARK_ROUNDS              100
+
+STATIC EFI_GUID  mTestVendorGuid[] = {
+  { 0x5faa5920, 0xea30, 0x4a4a, { 0xb1, 0x93, 0xd5, 0x7a, 0x0f, 0x5b, 0x98, 0x74 }
+  },
+  { 0x5faa5920, 0xea30, 0x4a4a, { 0xb1, 0x93, 0xd5, 0x7a, 0x0f, 0x5b, 0x98, 0x75 }
+  }
+};
+
+STATIC UINT64            *mHobList;
+STATIC UINTN             mHobLimit;
+STATIC BOOLEAN           mMemoryDiscovered;
+STATIC EFI_PEI_SERVICES  mPeiServices;
+STATIC EFI_PEI_SERVICES  *mPeiServicesPointer = &mPeiServices;
+
+/**
+  Returns the end of HOB list marker of the host HOB list.
+
+  @return The EFI_HOB_TYPE_END_OF_HOB_LIST HOB.
+**/
+STATIC
+EFI_PEI_HOB_POINTERS
+GetEndOfHobList (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+
+  for (Hob.Raw = (UINT8 *)mHobList; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+  }
+
+  return Hob;
+}
+
+/**
+  CreateHob PEI service over the host HOB list. It fails once the list would
+  grow beyond mHobLimit bytes.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+TestCreateHob (
+  IN CONST EFI_PEI_SERVICES  **PeiServices,
+  IN UINT16                  Type,
+  IN UINT16                  Length,
+  IN OUT VOID                **Hob
+  )
+{
+  EFI_PEI_HOB_POINTERS    End;
+  EFI_HOB_GENERIC_HEADER  *NewEnd;
+
+  Length = (UINT16)((Length + 0x7) & (~0x7));
+  End    = GetEndOfHobList ();
+  if ((UINTN)(End.Raw - (UINT8 *)mHobList) + Length + sizeof (EFI_HOB_GENERIC_HEADER) > mHobLimit) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NewEnd            = (EFI_HOB_GENERIC_HEADER *)(End.Raw + Length);
+  NewEnd->HobType   = EFI_HOB_TYPE_END_OF_HOB_LIST;
+  NewEnd->HobLength = sizeof (EFI_HOB_GENERIC_HEADER);
+  NewEnd->Reserved  = 0;
+
+  End.Header->HobType   = Type;
+  End.Header->HobLength = Length;
+  End.Header->Reserved  = 0;
+  *Hob                  = End.Raw;
+  return EFI_SUCCESS;
+}
+
+/**
+  LocatePPI PEI service, only gEfiPeiMemoryDiscoveredPpiGuid is installed,
+  and only once mMemoryDiscovered is set.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+TestLocatePpi (
+  IN CONST EFI_PEI_SERVICES     **PeiServices,
+  IN CONST EFI_GUID             *Guid,
+  IN UINTN                      Instance,
+  IN OUT EFI_PEI_PPI_DESCRIPTOR **PpiDescriptor OPTIONAL,
+  IN OUT VOID                   **Ppi
+  )
+{
+  if (mMemoryDiscovered && (Instance == 0) && CompareGuid (Guid, &gEfiPeiMemoryDiscoveredPpiGuid)) {
+    return EFI_SUCCESS;
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+CONST EFI_PEI_SERVICES **
+EFIAPI
+GetPeiServicesTablePointer (
+  VOID
+  )
+{
+  return (CONST EFI_PEI_SERVICES **)&mPeiServicesPointer;
+}
+
+VOID *
+EFIAPI
+GetNextGuidHob (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST VOID      *HobStart
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+
+  for (Hob.Raw = (UINT8 *)HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if ((GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) && CompareGuid (Guid, &Hob.Guid->Name)) {
+      return Hob.Raw;
+    }
+  }
+
+  return NULL;
+}
+
+VOID *
+EFIAPI
+GetFirstGuidHob (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  return GetNextGuidHob (Guid, mHobList);
+}
+
+VOID *
+EFIAPI
+BuildGuidHob (
+  IN CONST EFI_GUID  *Guid,
+  IN UINTN           DataLength
+  )
+{
+  EFI_HOB_GUID_TYPE  *Hob;
+
+  if (EFI_ERROR (TestCreateHob (NULL, EFI_HOB_TYPE_GUID_EXTENSION, (UINT16)(sizeof (EFI_HOB_GUID_TYPE) + DataLength), (VOID **)&Hob))) {
+    return NULL;
+  }
+
+  CopyGuid (&Hob->Name, Guid);
+  return Hob + 1;
+}
+
+EFI_STATUS
+EFIAPI
+CreateDefaultVariableHob (
+  IN UINT16  StoreId,
+  IN UINT16  SkuId
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Returns the size of the host HOB list in use, end of HOB list marker included.
+**/
+STATIC
+UINTN
+GetHobListSize (
+  VOID
+  )
+{
+  return (UINTN)(GetEndOfHobList ().Raw - (UINT8 *)mHobList) + sizeof (EFI_HOB_GENERIC_HEADER);
+}
+
+/**
+  Returns the variable index HOBs in the host HOB list.
+
+  @param[out] VariableIndex  The last index found, NULL if there is none.
+
+  @return Number of index HOBs.
+**/
+STATIC
+UINTN
+CountVariableIndexHobs (
+  OUT HOB_VARIABLE_INDEX  **VariableIndex
+  )
+{
+  EFI_HOB_GUID_TYPE  *GuidHob;
+  UINTN              Count;
+
+  *VariableIndex = NULL;
+  Count          = 0;
+  for (GuidHob = GetFirstGuidHob (&gHobVariableIndexGuid); GuidHob != NULL; GuidHob = GetNextGuidHob (&gHobVariableIndexGuid, GET_NEXT_HOB (GuidHob))) {
+    *VariableIndex = (HOB_VARIABLE_INDEX *)GET_GUID_HOB_DATA (GuidHob);
+    Count++;
+  }
+
+  return Count;
+}
+
+/**
+  Appends a variable whose data starts with Tag and is filled with its low byte.
+
+  @return The next variable header position.
+**/
+STATIC
+UINT8 *
+AppendVariable (
+  IN UINT8     *Ptr,
+  IN CHAR16    *Name,
+  IN EFI_GUID  *VendorGuid,
+  IN UINT8     State,
+  IN UINT32    Tag,
+  IN UINTN     DataSize
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  UINT8            *Data;
+
+  Variable             = (VARIABLE_HEADER *)HEADER_ALIGN (Ptr);
+  Variable->StartId    = VARIABLE_DATA;
+  Variable->State      = State;
+  Variable->Reserved   = 0;
+  Variable->Attributes = EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS;
+  Variable->NameSize   = (UINT32)StrSize (Name);
+  Variable->DataSize   = (UINT32)DataSize;
+  CopyGuid (&Variable->VendorGuid, VendorGuid);
+  CopyMem (Variable + 1, Name, Variable->NameSize);
+
+  Data = (UINT8 *)(Variable + 1) + Variable->NameSize;
+  SetMem (Data, DataSize, (UINT8)Tag);
+  CopyMem (Data, &Tag, MIN (sizeof (Tag), DataSize));
+  return Data + DataSize;
+}
+
+/**
+  Returns the name of the Index-th test variable.
+**/
+STATIC
+VOID
+GetTestVariableName (
+  IN  UINTN   Index,
+  OUT CHAR16  *Name,
+  IN  UINTN   NameSize
+  )
+{
+  UnicodeSPrint (Name, NameSize, L"TestVariable%04d", (INT32)Index);
+}
+
+/**
+  Builds the default variable HOB with VariableCount variables alternating
+  between the two test vendor GUIDs. The data of variable Index is tagged with
+  Index. A deleted copy precedes variable 0, and variable 1 is followed by a
+  second added copy tagged MAX_UINT32.
+
+  @param[in] VariableCount  Number of variables, or 0 to fill MaxStoreSize.
+  @param[in] DataSize       Data size of each variable.
+  @param[in] MaxStoreSize   Maximum size of the store.
+
+  @return Number of distinct variables in the store.
+**/
+STATIC
+UINTN
+BuildTestVariableHob (
+  IN UINTN  VariableCount,
+  IN UINTN  DataSize,
+  IN UINTN  MaxStoreSize
+  )
+{
+  VARIABLE_STORE_HEADER  *Store;
+  VARIABLE_STORE_HEADER  *StoreHob;
+  UINT8                  *Ptr;
+  UINT8                  *Next;
+  UINTN                  Index;
+  CHAR16                 Name[32];
+
+  Store = AllocateZeroPool (MaxStoreSize + SIZE_1KB);
+  ASSERT (Store != NULL);
+
+  Ptr = (UINT8 *)(Store + 1);
+  GetTestVariableName (0, Name, sizeof (Name));
+  Ptr = AppendVariable (Ptr, Name, &mTestVendorGuid[0], VAR_DELETED, MAX_UINT32, DataSize);
+  for (Index = 0; (VariableCount == 0) || (Index < VariableCount); Index++) {
+    GetTestVariableName (Index, Name, sizeof (Name));
+    Next = AppendVariable (Ptr, Name, &mTestVendorGuid[Index % 2], VAR_ADDED, (UINT32)Index, DataSize);
+    if ((UINTN)(Next - (UINT8 *)Store) > MaxStoreSize) {
+      break;
+    }
+
+    Ptr = Next;
+    if (Index == 1) {
+      Ptr = AppendVariable (Ptr, Name, &mTestVendorGuid[1], VAR_ADDED, MAX_UINT32, DataSize);
+    }
+  }
+
+  CopyGuid (&Store->Signature, &gEfiVariableGuid);
+  Store->Size   = (UINT32)(Ptr - (UINT8 *)Store);
+  Store->Format = VARIABLE_STORE_FORMATTED;
+  Store->State  = VARIABLE_STORE_HEALTHY;
+
+  StoreHob = BuildGuidHob (&gEfiVariableGuid, Store->Size);
+  ASSERT (StoreHob != NULL);
+  CopyMem (StoreHob, Store, Store->Size);
+  FreePool (Store);
+  return Index;
+}
+
+/**
+  Looks up every test variable and checks its data, then checks that unknown
+  names and vendor GUIDs are not found.
+
+  @param[in] VariableCount  Number of variables in the store.
+  @param[in] DataSize       Data size of each variable.
+
+  @retval TRUE   All lookups returned the expected result.
+  @retval FALSE  A lookup failed.
+**/
+STATIC
+BOOLEAN
+CheckTestVariables (
+  IN UINTN  VariableCount,
+  IN UINTN  DataSize
+  )
+{
+  UINT8       Data[BENCHMARK_VARIABLE_DATA_SIZE];
+  UINTN       Size;
+  UINTN       Index;
+  UINT32      Tag;
+  CHAR16      Name[32];
+  EFI_STATUS  Status;
+
+  for (Index = 0; Index < VariableCount; Index++) {
+    GetTestVariableName (Index, Name, sizeof (Name));
+    Size   = sizeof (Data);
+    Status = GetVariableFromHob (Name, &mTestVendorGuid[Index % 2], NULL, &Size, Data);
+    CopyMem (&Tag, Data, sizeof (Tag));
+    if (EFI_ERROR (Status) || (Size != DataSize) || (Tag != Index)) {
+      return FALSE;
+    }
+
+    Size = sizeof (Data);
+    if (GetVariableFromHob (Name, &mTestVendorGuid[(Index + 1) % 2], NULL, &Size, Data) != EFI_NOT_FOUND) {
+      return FALSE;
+    }
+  }
+
+  GetTestVariableName (VariableCount, Name, sizeof (Name));
+  Size = sizeof (Data);
+  return (BOOLEAN)(GetVariableFromHob (Name, &mTestVendorGuid[VariableCount % 2], NULL, &Size, Data) == EFI_NOT_FOUND);
+}
+
+/**
+  Starts every test with an empty HOB list with room to spare, and with
+  memory installed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ResetHobList (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_HOB_GENERIC_HEADER  *End;
+
+  ZeroMem (mHobList, TEST_HOB_LIST_SIZE);
+  End            = (EFI_HOB_GENERIC_HEADER *)mHobList;
+  End->HobType   = EFI_HOB_TYPE_END_OF_HOB_LIST;
+  End->HobLength = sizeof (EFI_HOB_GENERIC_HEADER);
+
+  mHobLimit         = TEST_HOB_LIST_SIZE;
+  mMemoryDiscovered = TRUE;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Lookups through the index find the same variables as the linear walk, and
+  the index is built once.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexedLookup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HOB_VARIABLE_INDEX  *VariableIndex;
+  UINT8               Data[TEST_VARIABLE_DATA_SIZE];
+  UINTN               DataSize;
+  UINTN               VariableCount;
+  UINT32              Tag;
+  CHAR16              Name[32];
+
+  VariableCount = BuildTestVariableHob (TEST_VARIABLE_COUNT, TEST_VARIABLE_DATA_SIZE, BENCHMARK_STORE_SIZE);
+  UT_ASSERT_EQUAL (VariableCount, TEST_VARIABLE_COUNT);
+  UT_ASSERT_TRUE (CheckTestVariables (VariableCount, TEST_VARIABLE_DATA_SIZE));
+  UT_ASSERT_TRUE (CheckTestVariables (VariableCount, TEST_VARIABLE_DATA_SIZE));
+
+  UT_ASSERT_EQUAL (CountVariableIndexHobs (&VariableIndex), 1);
+  UT_ASSERT_TRUE (VariableIndex->EntryCount >= 2 * VariableCount);
+
+  //
+  // Updates go to the variable found through the index
+  //
+  Tag = 0x5A5A5A5A;
+  SetMem (Data, sizeof (Data), 0x5A);
+  GetTestVariableName (7, Name, sizeof (Name));
+  UT_ASSERT_NOT_EFI_ERROR (SetVariableToHob (Name, &mTestVendorGuid[1], NULL, sizeof (Data), Data));
+  ZeroMem (Data, sizeof (Data));
+  DataSize = sizeof (Data);
+  UT_ASSERT_NOT_EFI_ERROR (GetVariableFromHob (Name, &mTestVendorGuid[1], NULL, &DataSize, Data));
+  UT_ASSERT_MEM_EQUAL (Data, &Tag, sizeof (Tag));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  No index is built in temporary RAM, the first lookup after memory is
+  installed builds it.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+NoIndexBeforeMemory (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HOB_VARIABLE_INDEX  *VariableIndex;
+  UINTN               VariableCount;
+
+  mMemoryDiscovered = FALSE;
+  VariableCount     = BuildTestVariableHob (TEST_VARIABLE_COUNT, TEST_VARIABLE_DATA_SIZE, BENCHMARK_STORE_SIZE);
+  UT_ASSERT_TRUE (CheckTestVariables (VariableCount, TEST_VARIABLE_DATA_SIZE));
+  UT_ASSERT_EQUAL (CountVariableIndexHobs (&VariableIndex), 0);
+
+  mMemoryDiscovered = TRUE;
+  UT_ASSERT_TRUE (CheckTestVariables (VariableCount, TEST_VARIABLE_DATA_SIZE));
+  UT_ASSERT_EQUAL (CountVariableIndexHobs (&VariableIndex), 1);
+  UT_ASSERT_TRUE (VariableIndex->EntryCount != 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  When the index does not fit in the HOB list, an empty index records the
+  failure once and the lookups walk the store.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexOutOfHobSpace (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HOB_VARIABLE_INDEX  *VariableIndex;
+  UINTN               VariableCount;
+  UINTN               HobListSize;
+
+  VariableCount = BuildTestVariableHob (TEST_VARIABLE_COUNT, TEST_VARIABLE_DATA_SIZE, BENCHMARK_STORE_SIZE);
+  mHobLimit     = GetHobListSize () + sizeof (EFI_HOB_GUID_TYPE) + sizeof (HOB_VARIABLE_INDEX) + sizeof (HOB_VARIABLE_INDEX_ENTRY);
+  UT_ASSERT_TRUE (CheckTestVariables (VariableCount, TEST_VARIABLE_DATA_SIZE));
+  UT_ASSERT_EQUAL (CountVariableIndexHobs (&VariableIndex), 1);
+  UT_ASSERT_EQUAL (VariableIndex->EntryCount, 0);
+
+  HobListSize = GetHobListSize ();
+  UT_ASSERT_TRUE (CheckTestVariables (VariableCount, TEST_VARIABLE_DATA_SIZE));
+  UT_ASSERT_EQUAL (GetHobListSize (), HobListSize);
+
+  //
+  // Without room for even the empty index the lookups still work
+  //
+  ResetHobList (NULL);
+  VariableCount = BuildTestVariableHob (TEST_VARIABLE_COUNT, TEST_VARIABLE_DATA_SIZE, BENCHMARK_STORE_SIZE);
+  mHobLimit     = GetHobListSize ();
+  UT_ASSERT_TRUE (CheckTestVariables (VariableCount, TEST_VARIABLE_DATA_SIZE));
+  UT_ASSERT_EQUAL (CountVariableIndexHobs (&VariableIndex), 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Times lookups of every variable of a store filling a whole GUID HOB, with
+  the linear walk and with the index.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LookupBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HOB_VARIABLE_INDEX  *VariableIndex;
+  UINTN               VariableCount;
+  UINTN               Round;
+  BOOLEAN             Found;
+  clock_t             Linear;
+  clock_t             Indexed;
+
+  mMemoryDiscovered = FALSE;
+  VariableCount     = BuildTestVariableHob (0, BENCHMARK_VARIABLE_DATA_SIZE, BENCHMARK_STORE_SIZE);
+
+  Found  = TRUE;
+  Linear = clock ();
+  for (Round = 0; Round < BENCHMARK_ROUNDS; Round++) {
+    Found &= CheckTestVariables (VariableCount, BENCHMARK_VARIABLE_DATA_SIZE);
+  }
+
+  Linear = clock () - Linear;
+  UT_ASSERT_TRUE (Found);
+  UT_ASSERT_EQUAL (CountVariableIndexHobs (&VariableIndex), 0);
+
+  mMemoryDiscovered = TRUE;
+  Indexed           = clock ();
+  for (Round = 0; Round < BENCHMARK_ROUNDS; Round++) {
+    Found &= CheckTestVariables (VariableCount, BENCHMARK_VARIABLE_DATA_SIZE);
+  }
+
+  Indexed = clock () - Indexed;
+  UT_ASSERT_TRUE (Found);
+  UT_ASSERT_EQUAL (CountVariableIndexHobs (&VariableIndex), 1);
+  UT_ASSERT_TRUE (VariableIndex->EntryCount != 0);
+
+  //
+  // Each CheckTestVariables () round makes 2 * VariableCount + 1 lookups
+  //
+  UT_LOG_INFO (
+    "%Lu variables in %Lu bytes: %Lu ns per lookup linear, %Lu ns indexed\n",
+    (UINT64)VariableCount,
+    (UINT64)BENCHMARK_STORE_SIZE,
+    DivU64x64Remainder (MultU64x32 ((UINT64)Linear, 1000000000 / CLOCKS_PER_SEC), BENCHMARK_ROUNDS * (2 * VariableCount + 1), NULL),
+    DivU64x64Remainder (MultU64x32 ((UINT64)Indexed, 1000000000 / CLOCKS_PER_SEC), BENCHMARK_ROUNDS * (2 * VariableCount + 1), NULL)
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  PeiHobVariableLibFce lookups and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SetupAndRunUnitTests (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      LookupTests;
+
+  Framework = NULL;
+  DEBUG ((DEBUG_INFO, "%a: v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  mHobList = AllocatePool (TEST_HOB_LIST_SIZE);
+  if (mHobList == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mPeiServices.CreateHob = TestCreateHob;
+  mPeiServices.LocatePpi = TestLocatePpi;
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&LookupTests, Framework, "HOB Variable Lookup Tests", "PeiHobVariableLibFce.Lookup", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for HOB Variable Lookup Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (LookupTests, "Lookups through the index match the store", "IndexedLookup", IndexedLookup, ResetHobList, NULL, NULL);
+  AddTestCase (LookupTests, "No index is built before memory is installed", "NoIndexBeforeMemory", NoIndexBeforeMemory, ResetHobList, NULL, NULL);
+  AddTestCase (LookupTests, "An index that does not fit is recorded once", "IndexOutOfHobSpace", IndexOutOfHobSpace, ResetHobList, NULL, NULL);
+  AddTestCase (LookupTests, "Lookup benchmark over a 64 KB store", "LookupBenchmark", LookupBenchmark, ResetHobList, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  FreePool (mHobList);
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return SetupAndRunUnitTests ();
+}
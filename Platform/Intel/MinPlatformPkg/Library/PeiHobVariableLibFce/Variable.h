@@ -10,6 +10,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 extern EFI_GUID gEfiVariableGuid;
 extern EFI_GUID gEfiAuthenticatedVariableGuid;
+extern EFI_GUID gHobVariableIndexGuid;
 
 ///
 /// Alignment of variable name and data, according to the architecture:
@@ -169,4 +170,40 @@ typedef struct {
 
 #pragma pack()
 
+///
+/// One slot of the hash index over the default variable HOB.
+///
+typedef struct {
+  ///
+  /// Hash of the vendor GUID and name of the variable.
+  ///
+  UINT32      Hash;
+  ///
+  /// Offset of the variable header from the variable store header, 0 if the slot is empty.
+  ///
+  UINT32      Offset;
+} HOB_VARIABLE_INDEX_ENTRY;
+
+///
+/// Hash index over the variables of the default variable HOB. It is kept in
+/// its own GUID HOB (gHobVariableIndexGuid), built by the first lookup after
+/// memory is installed, and followed by EntryCount HOB_VARIABLE_INDEX_ENTRY
+/// slots.
+///
+typedef struct {
+  ///
+  /// Signature of the variable store that is indexed.
+  ///
+  EFI_GUID    StoreSignature;
+  ///
+  /// Size of the variable store that is indexed.
+  ///
+  UINT32      StoreSize;
+  ///
+  /// Number of slots, a power of two. 0 when the store could not be indexed
+  /// and lookups walk it instead.
+  ///
+  UINT32      EntryCount;
+} HOB_VARIABLE_INDEX;
+
 #endif
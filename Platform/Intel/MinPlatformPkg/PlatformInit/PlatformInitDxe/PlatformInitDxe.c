@@ -74,6 +74,8 @@ OnEndOfDxe (
 {
   gBS->CloseEvent (Event);
 
+  TestPointEndOfDxePerformanceBudget ();
+
   TestPointEndOfDxeNoThirdPartyPciOptionRom ();
 
   TestPointEndOfDxeDmaAcpiTableFunctional ();
@@ -138,6 +140,8 @@ OnReadyToBootLater (
 
   gBS->CloseEvent (Event);
 
+  TestPointReadyToBootPerformanceBudget ();
+
   TestPointReadyToBootMemoryTypeInformationFunctional ();
   TestPointReadyToBootUefiMemoryAttributeTableFunctional ();
   TestPointReadyToBootUefiBootVariableFunctional ();
@@ -60,6 +60,8 @@ PlatformInitEndOfPei (
   Status = BoardInitAfterSiliconInit ();
   ASSERT_EFI_ERROR (Status);
 
+  TestPointEndOfPeiPerformanceBudget ();
+
   TestPointEndOfPeiSystemResourceFunctional ();
 
   TestPointEndOfPeiPciBusMasterDisabled ();
@@ -409,6 +409,8 @@ MemoryDiscoveredPpiNotifyCallback (
 
   ReportCpuHob ();
 
+  TestPointMemoryDiscoveredPerformanceBudget ();
+
   TestPointMemoryDiscoveredMtrrFunctional ();
 
   TestPointMemoryDiscoveredMemoryResourceFunctional ();
@@ -0,0 +1,115 @@
+/** @file
+
+Copyright (c) 2017 - 2018, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <PiDxe.h>
+#include <Library/TestPointCheckLib.h>
+#include <Library/TestPointLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+UINT64
+TestPointGetBootTime (
+  VOID
+  );
+
+EFI_STATUS
+TestPointCheckPerformanceBudget (
+  IN UINT64  BootTime,
+  IN UINT32  TimeBudget,
+  IN UINT64  MemoryUsage,
+  IN UINT32  MemoryBudget
+  );
+
+VOID
+TestPointDumpUefiMemoryMap (
+  OUT EFI_MEMORY_DESCRIPTOR **UefiMemoryMap, OPTIONAL
+  OUT UINTN                 *UefiMemoryMapSize, OPTIONAL
+  OUT UINTN                 *UefiDescriptorSize, OPTIONAL
+  IN  BOOLEAN               DumpPrint
+  );
+
+/**
+  Get the memory allocated by the firmware in the UEFI memory map.
+
+  Only the loader, boot services and runtime services types are counted, the
+  reserved, ACPI and MMIO ranges are platform resources rather than allocations.
+
+  @return The allocated memory in bytes.
+**/
+UINT64
+TestPointGetUefiMemoryUsage (
+  VOID
+  )
+{
+  EFI_MEMORY_DESCRIPTOR  *MemoryMap;
+  EFI_MEMORY_DESCRIPTOR  *Entry;
+  UINTN                  MemoryMapSize;
+  UINTN                  DescriptorSize;
+  UINTN                  NumberOfEntries;
+  UINTN                  Index;
+  UINT64                 Pages;
+
+  TestPointDumpUefiMemoryMap (&MemoryMap, &MemoryMapSize, &DescriptorSize, FALSE);
+  if (MemoryMap == NULL) {
+    return 0;
+  }
+
+  Pages = 0;
+  Entry = MemoryMap;
+  NumberOfEntries = MemoryMapSize / DescriptorSize;
+  for (Index = 0; Index < NumberOfEntries; Index++) {
+    switch (Entry->Type) {
+    case EfiLoaderCode:
+    case EfiLoaderData:
+    case EfiBootServicesCode:
+    case EfiBootServicesData:
+    case EfiRuntimeServicesCode:
+    case EfiRuntimeServicesData:
+      Pages += Entry->NumberOfPages;
+      break;
+    default:
+      break;
+    }
+    Entry = NEXT_MEMORY_DESCRIPTOR (Entry, DescriptorSize);
+  }
+
+  FreePool (MemoryMap);
+
+  return LShiftU64 (Pages, EFI_PAGE_SHIFT);
+}
+
+/**
+  Check the boot time and UEFI memory usage against the budget.
+
+  @param[in]  TimeBudget    The boot time budget in milliseconds, 0 means no budget.
+  @param[in]  MemoryBudget  The memory budget in KB, 0 means no budget.
+
+  @retval EFI_SUCCESS  The stage is within budget.
+  @retval others       The budget is exceeded.
+**/
+EFI_STATUS
+TestPointCheckPerformanceDxe (
+  IN UINT32  TimeBudget,
+  IN UINT32  MemoryBudget
+  )
+{
+  UINT64  BootTime;
+
+  //
+  // Sample the time first, the memory map walk should not be accounted to the stage.
+  //
+  BootTime = TestPointGetBootTime ();
+
+  return TestPointCheckPerformanceBudget (
+           BootTime,
+           TimeBudget,
+           TestPointGetUefiMemoryUsage (),
+           MemoryBudget
+           );
+}
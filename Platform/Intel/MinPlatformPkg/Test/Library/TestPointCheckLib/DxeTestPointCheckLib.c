@@ -153,6 +153,12 @@ TestPointGetAcpi (
   IN UINT32  Signature
   );
 
+EFI_STATUS
+TestPointCheckPerformanceDxe (
+  IN UINT32  TimeBudget,
+  IN UINT32  MemoryBudget
+  );
+
 GLOBAL_REMOVE_IF_UNREFERENCED ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT  mTestPointStruct = {
   PLATFORM_TEST_POINT_VERSION,
   PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
@@ -351,6 +357,61 @@ TestPointEndOfDxeDmaProtectionEnabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the boot time and memory budget at the End of DXE.
+
+  Test subject: Boot time and UEFI memory usage at the End of DXE.
+  Test overview: Verify the time since the FPDT reset end and the UEFI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfDxePerformanceBudget (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  BOOLEAN     Result;
+
+  if ((mFeatureImplemented[9] & TEST_POINT_BYTE9_END_OF_DXE_PERFORMANCE_BUDGET) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointEndOfDxePerformanceBudget - Enter\n"));
+
+  Result = TRUE;
+  Status = TestPointCheckPerformanceDxe (
+             PcdGet32 (PcdTestPointTimeBudgetEndOfDxe),
+             PcdGet32 (PcdTestPointMemoryBudgetEndOfDxe)
+             );
+  if (EFI_ERROR(Status)) {
+    TestPointLibAppendErrorString (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      TEST_POINT_BYTE9_END_OF_DXE_PERFORMANCE_BUDGET_ERROR_CODE \
+        TEST_POINT_END_OF_DXE \
+        TEST_POINT_BYTE9_END_OF_DXE_PERFORMANCE_BUDGET_ERROR_STRING
+      );
+    Result = FALSE;
+  }
+
+  if (Result) {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_END_OF_DXE_PERFORMANCE_BUDGET
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointEndOfDxePerformanceBudget - Exit\n"));
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies no 3rd party PCI option ROMs (OPROMs) were dispatched prior to the end of DXE.
 
@@ -1017,6 +1078,61 @@ TestPointReadyToBootHstiTableFunctional (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the boot time and memory budget at Ready To Boot.
+
+  Test subject: Boot time and UEFI memory usage at Ready To Boot.
+  Test overview: Verify the time since the FPDT reset end and the UEFI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointReadyToBootPerformanceBudget (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  BOOLEAN     Result;
+
+  if ((mFeatureImplemented[9] & TEST_POINT_BYTE9_READY_TO_BOOT_PERFORMANCE_BUDGET) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointReadyToBootPerformanceBudget - Enter\n"));
+
+  Result = TRUE;
+  Status = TestPointCheckPerformanceDxe (
+             PcdGet32 (PcdTestPointTimeBudgetReadyToBoot),
+             PcdGet32 (PcdTestPointMemoryBudgetReadyToBoot)
+             );
+  if (EFI_ERROR(Status)) {
+    TestPointLibAppendErrorString (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      TEST_POINT_BYTE9_READY_TO_BOOT_PERFORMANCE_BUDGET_ERROR_CODE \
+        TEST_POINT_READY_TO_BOOT \
+        TEST_POINT_BYTE9_READY_TO_BOOT_PERFORMANCE_BUDGET_ERROR_STRING
+      );
+    Result = FALSE;
+  }
+
+  if (Result) {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_READY_TO_BOOT_PERFORMANCE_BUDGET
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointReadyToBootPerformanceBudget - Exit\n"));
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies the ESRT table.
 
@@ -0,0 +1,84 @@
+/** @file
+
+Copyright (c) 2017 - 2018, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include <Library/TestPointCheckLib.h>
+#include <Library/TestPointLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+
+UINT64
+TestPointGetBootTime (
+  VOID
+  );
+
+EFI_STATUS
+TestPointCheckPerformanceBudget (
+  IN UINT64  BootTime,
+  IN UINT32  TimeBudget,
+  IN UINT64  MemoryUsage,
+  IN UINT32  MemoryBudget
+  );
+
+/**
+  Get the permanent memory used in PEI.
+
+  The PHIT HOB describes the PEI memory, everything outside of the free
+  range is used by the HOB list and the PEI memory allocations.
+
+  @return The used PEI memory in bytes.
+**/
+UINT64
+TestPointGetPeiMemoryUsage (
+  VOID
+  )
+{
+  EFI_HOB_HANDOFF_INFO_TABLE  *PhitHob;
+
+  PhitHob = GetHobList ();
+  ASSERT (PhitHob->Header.HobType == EFI_HOB_TYPE_HANDOFF);
+
+  return (PhitHob->EfiMemoryTop - PhitHob->EfiFreeMemoryTop) +
+         (PhitHob->EfiFreeMemoryBottom - PhitHob->EfiMemoryBottom);
+}
+
+/**
+  Check the boot time and PEI memory usage against the budget.
+
+  The check is skipped for S3 resume, the budgets describe the normal boot path.
+
+  @param[in]  TimeBudget    The boot time budget in milliseconds, 0 means no budget.
+  @param[in]  MemoryBudget  The memory budget in KB, 0 means no budget.
+
+  @retval EFI_SUCCESS  The stage is within budget.
+  @retval others       The budget is exceeded.
+**/
+EFI_STATUS
+TestPointCheckPerformancePei (
+  IN UINT32  TimeBudget,
+  IN UINT32  MemoryBudget
+  )
+{
+  UINT64  BootTime;
+
+  //
+  // Sample the time first, the checks below should not be accounted to the stage.
+  //
+  BootTime = TestPointGetBootTime ();
+
+  if (GetBootModeHob () == BOOT_ON_S3_RESUME) {
+    DEBUG ((DEBUG_INFO, "Skip performance budget on S3 resume\n"));
+    return EFI_SUCCESS;
+  }
+
+  return TestPointCheckPerformanceBudget (
+           BootTime,
+           TimeBudget,
+           TestPointGetPeiMemoryUsage (),
+           MemoryBudget
+           );
+}
@@ -52,6 +52,12 @@ TestPointVtdEngine (
   VOID
   );
 
+EFI_STATUS
+TestPointCheckPerformancePei (
+  IN UINT32  TimeBudget,
+  IN UINT32  MemoryBudget
+  );
+
 GLOBAL_REMOVE_IF_UNREFERENCED ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT  mTestPointStruct = {
   PLATFORM_TEST_POINT_VERSION,
   PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
@@ -323,6 +329,64 @@ TestPointMemoryDiscoveredDmaProtectionEnabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the boot time and memory budget after memory is discovered.
+
+  Test subject: Boot time and PEI memory usage after memory is discovered.
+  Test overview: Verify the time since the FPDT reset end and the PEI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointMemoryDiscoveredPerformanceBudget (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  BOOLEAN     Result;
+  UINT8       *FeatureImplemented;
+
+  FeatureImplemented = GetFeatureImplemented ();
+
+  if ((FeatureImplemented[9] & TEST_POINT_BYTE9_MEMORY_DISCOVERED_PERFORMANCE_BUDGET) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointMemoryDiscoveredPerformanceBudget - Enter\n"));
+
+  Result = TRUE;
+  Status = TestPointCheckPerformancePei (
+             PcdGet32 (PcdTestPointTimeBudgetMemoryDiscovered),
+             PcdGet32 (PcdTestPointMemoryBudgetMemoryDiscovered)
+             );
+  if (EFI_ERROR(Status)) {
+    TestPointLibAppendErrorString (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      TEST_POINT_BYTE9_MEMORY_DISCOVERED_PERFORMANCE_BUDGET_ERROR_CODE \
+        TEST_POINT_MEMORY_DISCOVERED \
+        TEST_POINT_BYTE9_MEMORY_DISCOVERED_PERFORMANCE_BUDGET_ERROR_STRING
+      );
+    Result = FALSE;
+  }
+
+  if (Result) {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_MEMORY_DISCOVERED_PERFORMANCE_BUDGET
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointMemoryDiscoveredPerformanceBudget - Exit\n"));
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies system resources at the end of PEI.
 
@@ -469,6 +533,64 @@ TestPointEndOfPeiPciBusMasterDisabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the boot time and memory budget at the end of PEI.
+
+  Test subject: Boot time and PEI memory usage at the end of PEI.
+  Test overview: Verify the time since the FPDT reset end and the PEI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfPeiPerformanceBudget (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  BOOLEAN     Result;
+  UINT8       *FeatureImplemented;
+
+  FeatureImplemented = GetFeatureImplemented ();
+
+  if ((FeatureImplemented[9] & TEST_POINT_BYTE9_END_OF_PEI_PERFORMANCE_BUDGET) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointEndOfPeiPerformanceBudget - Enter\n"));
+
+  Result = TRUE;
+  Status = TestPointCheckPerformancePei (
+             PcdGet32 (PcdTestPointTimeBudgetEndOfPei),
+             PcdGet32 (PcdTestPointMemoryBudgetEndOfPei)
+             );
+  if (EFI_ERROR(Status)) {
+    TestPointLibAppendErrorString (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      TEST_POINT_BYTE9_END_OF_PEI_PERFORMANCE_BUDGET_ERROR_CODE \
+        TEST_POINT_END_OF_PEI \
+        TEST_POINT_BYTE9_END_OF_PEI_PERFORMANCE_BUDGET_ERROR_STRING
+      );
+    Result = FALSE;
+  }
+
+  if (Result) {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_END_OF_PEI_PERFORMANCE_BUDGET
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointEndOfPeiPerformanceBudget - Exit\n"));
+  return EFI_SUCCESS;
+}
+
 /**
   Initialize feature data.
 
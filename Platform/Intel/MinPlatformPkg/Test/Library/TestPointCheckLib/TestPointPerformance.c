@@ -0,0 +1,100 @@
+/** @file
+
+Copyright (c) 2017 - 2018, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include <Library/TestPointCheckLib.h>
+#include <Library/TestPointLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseLib.h>
+#include <Library/HobLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Guid/FirmwarePerformance.h>
+
+/**
+  Get the time elapsed since the firmware image started execution.
+
+  The start point is the ResetEnd of the FPDT Firmware Basic Boot Performance Record,
+  which SEC reports in the gEfiFirmwarePerformanceGuid HOB. If SEC does not report it,
+  the start point is the start value of the performance counter.
+
+  @return The elapsed time in nanoseconds.
+**/
+UINT64
+TestPointGetBootTime (
+  VOID
+  )
+{
+  UINT64                    Ticker;
+  UINT64                    StartValue;
+  UINT64                    EndValue;
+  UINT64                    Time;
+  EFI_HOB_GUID_TYPE         *GuidHob;
+  FIRMWARE_SEC_PERFORMANCE  *Performance;
+
+  Ticker = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  if (EndValue >= StartValue) {
+    Ticker = Ticker - StartValue;
+  } else {
+    Ticker = StartValue - Ticker;
+  }
+  Time = GetTimeInNanoSecond (Ticker);
+
+  GuidHob = GetFirstGuidHob (&gEfiFirmwarePerformanceGuid);
+  if (GuidHob != NULL) {
+    Performance = GET_GUID_HOB_DATA (GuidHob);
+    if (Performance->ResetEnd <= Time) {
+      Time = Time - Performance->ResetEnd;
+    }
+  }
+
+  return Time;
+}
+
+/**
+  Check the boot time and memory usage against the budget of a stage.
+
+  @param[in]  BootTime      The time elapsed since reset end, in nanoseconds.
+  @param[in]  TimeBudget    The boot time budget in milliseconds, 0 means no budget.
+  @param[in]  MemoryUsage   The memory used by the firmware, in bytes.
+  @param[in]  MemoryBudget  The memory budget in KB, 0 means no budget.
+
+  @retval EFI_SUCCESS           The stage is within budget.
+  @retval EFI_TIMEOUT           The boot time budget is exceeded.
+  @retval EFI_OUT_OF_RESOURCES  The memory budget is exceeded.
+**/
+EFI_STATUS
+TestPointCheckPerformanceBudget (
+  IN UINT64  BootTime,
+  IN UINT32  TimeBudget,
+  IN UINT64  MemoryUsage,
+  IN UINT32  MemoryBudget
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = EFI_SUCCESS;
+
+  DEBUG ((DEBUG_INFO, "  BootTime    - %ld ms (Budget - %d ms)\n", DivU64x32 (BootTime, 1000000), TimeBudget));
+  DEBUG ((DEBUG_INFO, "  MemoryUsage - %ld KB (Budget - %d KB)\n", RShiftU64 (MemoryUsage, 10), MemoryBudget));
+
+  if ((TimeBudget != 0) && (BootTime > MultU64x32 (1000000, TimeBudget))) {
+    DEBUG ((DEBUG_ERROR, "Boot time budget exceeded\n"));
+    Status = EFI_TIMEOUT;
+  }
+  if ((MemoryBudget != 0) && (MemoryUsage > LShiftU64 (MemoryBudget, 10))) {
+    DEBUG ((DEBUG_ERROR, "Memory budget exceeded\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+  }
+
+  if (EFI_ERROR (Status) && PcdGetBool (PcdTestPointPerformanceBudgetAssert)) {
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  return Status;
+}
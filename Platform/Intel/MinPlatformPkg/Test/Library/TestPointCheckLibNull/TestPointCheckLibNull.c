@@ -131,6 +131,26 @@ TestPointMemoryDiscoveredDmaProtectionEnabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the boot time and memory budget after memory is discovered.
+
+  Test subject: Boot time and PEI memory usage after memory is discovered.
+  Test overview: Verify the time since the FPDT reset end and the PEI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointMemoryDiscoveredPerformanceBudget (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies system resources at the end of PEI.
 
@@ -193,6 +213,26 @@ TestPointEndOfPeiPciBusMasterDisabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the boot time and memory budget at the end of PEI.
+
+  Test subject: Boot time and PEI memory usage at the end of PEI.
+  Test overview: Verify the time since the FPDT reset end and the PEI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfPeiPerformanceBudget (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies bus master enable (BME) is disabled after PCI enumeration.
 
@@ -293,6 +333,26 @@ TestPointEndOfDxeDmaProtectionEnabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the boot time and memory budget at the End of DXE.
+
+  Test subject: Boot time and UEFI memory usage at the End of DXE.
+  Test overview: Verify the time since the FPDT reset end and the UEFI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfDxePerformanceBudget (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies the validity of System Management RAM (SMRAM) alignment at SMM Ready To Lock.
 
@@ -595,6 +655,26 @@ TestPointReadyToBootTcgMorEnabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the boot time and memory budget at Ready To Boot.
+
+  Test subject: Boot time and UEFI memory usage at Ready To Boot.
+  Test overview: Verify the time since the FPDT reset end and the UEFI memory usage are within budget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the boot time and memory usage to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointReadyToBootPerformanceBudget (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies SMI handler profiling.
 
@@ -826,7 +826,9 @@ EFI_MMC_HOST_PROTOCOL gMMCHost =
   MMCReadBlockData,
   MMCWriteBlockData,
   NULL,
-  MMCIsMultiBlock
+  MMCIsMultiBlock,
+  NULL,
+  NULL
 };
 
 EFI_STATUS
@@ -23,6 +23,18 @@
    */
 #define TimerForTransfer TimerRelative
 
+/*
+ * Complete-splits are retried once per microframe on NYET, this
+ * many times, before the start-split is reissued.
+ */
+#define DW_HC_CSPLIT_TRIES (3)
+
+/*
+ * A NAKed split transaction is retried from the start-split once
+ * the next full-speed frame (8 microframes) has begun.
+ */
+#define DW_HC_SPLIT_NAK_BACKOFF (8)
+
 /*
  * https://www.quicklogic.com/assets/pdf/data-sheets/QL-Hi-Speed-USB-2.0-OTG-Controller-Data-Sheet.pdf
  */
@@ -94,14 +106,12 @@ Wait4Chhltd (
   UINT32  Hcint, Hctsiz;
   UINT32  HcintCompHltAck = DWC2_HCINT_XFERCOMP;
 
-  MicroSecondDelay (100);
   Status = Wait4Bit (Timeout, DwHc->DwUsbBase + HCINT (Channel),
                      DWC2_HCINT_CHHLTD, 1);
   if (EFI_ERROR (Status)) {
     return XFER_NOT_HALTED;
   }
 
-  MicroSecondDelay (100);
   Hcint = MmioRead32 (DwHc->DwUsbBase + HCINT (Channel));
 
   ASSERT ((Hcint & DWC2_HCINT_CHHLTD) != 0);
@@ -223,6 +233,86 @@ DwCoreReset (
   return EFI_SUCCESS;
 }
 
+/*
+ * Waits for the frame counter to advance by MicroFrames. Used to
+ * space out split transaction retries instead of hammering the
+ * transaction translator back to back.
+ */
+STATIC
+EFI_STATUS
+DwHcWaitMicroFrames (
+  IN  DWUSB_OTGHC_DEV *DwHc,
+  IN  EFI_EVENT       Timeout,
+  IN  UINT32          MicroFrames
+  )
+{
+  UINT32 Start;
+  UINT32 Now;
+
+  Start = MmioRead32 (DwHc->DwUsbBase + HFNUM) & DWC2_HFNUM_FRNUM_MASK;
+
+  do {
+    Now = MmioRead32 (DwHc->DwUsbBase + HFNUM) & DWC2_HFNUM_FRNUM_MASK;
+    if (((Now - Start) & DWC2_HFNUM_FRNUM_MASK) >= MicroFrames) {
+      return EFI_SUCCESS;
+    }
+  } while (EFI_ERROR (gBS->CheckEvent (Timeout)));
+
+  return EFI_TIMEOUT;
+}
+
+STATIC
+DWUSB_EP_STATS *
+DwHcEndpointStats (
+  IN  DWUSB_OTGHC_DEV *DwHc,
+  IN  UINT8           DeviceAddress,
+  IN  UINT32          EpAddress,
+  IN  UINT32          TransferDirection
+  )
+{
+  if (DeviceAddress >= MAX_DEVICE || EpAddress >= MAX_ENDPOINT) {
+    return NULL;
+  }
+
+  return &DwHc->EpStats[DeviceAddress][EpAddress][TransferDirection ? 1 : 0];
+}
+
+STATIC
+VOID
+DwHcReportEndpointStats (
+  IN  DWUSB_OTGHC_DEV *DwHc
+  )
+{
+  UINT32         Dev;
+  UINT32         Ep;
+  UINT32         Dir;
+  UINT64         Ns;
+  UINT64         KBps;
+  DWUSB_EP_STATS *Stats;
+
+  for (Dev = 0; Dev < MAX_DEVICE; Dev++) {
+    for (Ep = 0; Ep < MAX_ENDPOINT; Ep++) {
+      for (Dir = 0; Dir < 2; Dir++) {
+        Stats = &DwHc->EpStats[Dev][Ep][Dir];
+        if (Stats->Transfers == 0) {
+          continue;
+        }
+
+        Ns = GetTimeInNanoSecond (Stats->Ticks);
+        KBps = 0;
+        if (Ns != 0) {
+          KBps = DivU64x64Remainder (MultU64x32 (Stats->Bytes, 1000000),
+                   Ns, NULL);
+        }
+
+        DEBUG ((DEBUG_INFO, "DwUsb: %u:%u %a: %Lu xfers %Lu bytes %Lu KB/s "
+          "%Lu NAKs %Lu errors\n", Dev, Ep, Dir ? "in" : "out",
+          Stats->Transfers, Stats->Bytes, KBps, Stats->Naks, Stats->Errors));
+      }
+    }
+  }
+}
+
 STATIC
 EFI_STATUS
 DwHcTransfer (
@@ -249,12 +339,49 @@ DwHcTransfer (
   UINT32                          Sub;
   UINT32                          Ret = 0;
   UINT32                          StopTransfer = 0;
+  UINT32                          Hcchar;
   EFI_STATUS                      Status = EFI_SUCCESS;
   SPLIT_CONTROL                   Split = { 0 };
+  BOOLEAN                         Direct = FALSE;
+  EFI_PHYSICAL_ADDRESS            DirectBusAddress = 0;
+  VOID                            *DirectMapping = NULL;
+  UINTN                           MapLength;
+  UINTN                           DmaAddress;
+  DWUSB_EP_STATS                  *Stats;
+  UINT64                          StartTicks;
 
   EFI_TPL Tpl = gBS->RaiseTPL (TPL_NOTIFY);
 
   *TransferResult = EFI_USB_NOERROR;
+  Stats = DwHcEndpointStats (DwHc, DeviceAddress, EpAddress, TransferDirection);
+  StartTicks = GetPerformanceCounter ();
+
+  /*
+   * High-speed bulk transfers DMA straight to and from the caller's
+   * buffer when it is suitably aligned, so that every chunk moves up
+   * to DWC2_MAX_PACKET_COUNT packets without going through the
+   * uncached bounce buffer. IN transfers also need a whole number of
+   * packets, as the controller always writes full packets.
+   */
+  if (EpType == DWC2_HCCHAR_EPTYPE_BULK &&
+      DeviceSpeed == EFI_USB_SPEED_HIGH &&
+      ((UINTN)Data & (DWC2_DMA_ALIGNMENT - 1)) == 0 &&
+      (!TransferDirection || (*DataLength % MaximumPacketLength) == 0)) {
+    MapLength = *DataLength;
+    Status = DmaMap (TransferDirection ? MapOperationBusMasterWrite :
+                       MapOperationBusMasterRead,
+               Data, &MapLength, &DirectBusAddress, &DirectMapping);
+    if (!EFI_ERROR (Status)) {
+      if (MapLength == *DataLength &&
+          DirectBusAddress + MapLength <= MAX_UINT32) {
+        Direct = TRUE;
+      } else {
+        DmaUnmap (DirectMapping);
+        DirectMapping = NULL;
+      }
+    }
+    Status = EFI_SUCCESS;
+  }
 
   do {
   RestartXfer:
@@ -271,7 +398,7 @@ DwHcTransfer (
       TxferLen = DWC2_MAX_TRANSFER_SIZE - MaximumPacketLength + 1;
     }
 
-    if (TxferLen > DWC2_DATA_BUF_SIZE) {
+    if (!Direct && TxferLen > DWC2_DATA_BUF_SIZE) {
       TxferLen = DWC2_DATA_BUF_SIZE - MaximumPacketLength + 1;
     }
 
@@ -287,14 +414,19 @@ DwHcTransfer (
 
     if (TransferDirection) { // in
       TxferLen = NumPackets * MaximumPacketLength;
-    } else {
+    } else if (!Direct) {
       CopyMem (DwHc->AlignedBuffer, Data + Done, TxferLen);
       ArmDataSynchronizationBarrier ();
     }
 
+    if (Direct) {
+      DmaAddress = (UINTN)DirectBusAddress + Done;
+    } else {
+      DmaAddress = DwHc->AlignedBufferBusAddress;
+    }
+
   RestartChannel:
-    MmioWrite32 (DwHc->DwUsbBase + HCDMA (Channel),
-      (UINTN)DwHc->AlignedBufferBusAddress);
+    MmioWrite32 (DwHc->DwUsbBase + HCDMA (Channel), (UINT32)DmaAddress);
 
     DwOtgHcInit (DwHc, Channel, Translator, DeviceSpeed,
       DeviceAddress, EpAddress,
@@ -306,12 +438,22 @@ DwHcTransfer (
       (NumPackets << DWC2_HCTSIZ_PKTCNT_OFFSET) |
       (*Pid << DWC2_HCTSIZ_PID_OFFSET));
 
+    Hcchar = (1 << DWC2_HCCHAR_MULTICNT_OFFSET) | DWC2_HCCHAR_CHEN;
+    if (EpType == DWC2_HCCHAR_EPTYPE_INTR &&
+        (MmioRead32 (DwHc->DwUsbBase + HFNUM) & 1) == 0) {
+      /*
+       * Periodic transfers go out in the next (odd) frame,
+       * rather than overrunning the current one.
+       */
+      Hcchar |= DWC2_HCCHAR_ODDFRM;
+    }
+
     MmioAndThenOr32 (DwHc->DwUsbBase + HCCHAR (Channel),
       ~(DWC2_HCCHAR_MULTICNT_MASK |
+        DWC2_HCCHAR_ODDFRM |
         DWC2_HCCHAR_CHEN |
         DWC2_HCCHAR_CHDIS),
-        ((1 << DWC2_HCCHAR_MULTICNT_OFFSET) |
-          DWC2_HCCHAR_CHEN));
+      Hcchar);
 
     Ret = Wait4Chhltd (DwHc, Timeout, Channel, &Sub, Pid, IgnoreAck, &Split);
 
@@ -340,7 +482,17 @@ DwHcTransfer (
     } else if (Ret == XFER_CSPLIT) {
       ASSERT (Split.Splitting);
 
-      if (Split.Tries++ < 3) {
+      /*
+       * Give the transaction translator a microframe to
+       * complete the full-speed transaction before asking.
+       */
+      Status = DwHcWaitMicroFrames (DwHc, Timeout, 1);
+      if (EFI_ERROR (Status)) {
+        *TransferResult = EFI_USB_ERR_TIMEOUT;
+        break;
+      }
+
+      if (Split.Tries++ < DW_HC_CSPLIT_TRIES) {
         goto RestartChannel;
       }
 
@@ -356,8 +508,25 @@ DwHcTransfer (
     } else if (Ret == XFER_FRMOVRUN) {
       goto RestartChannel;
     } else if (Ret == XFER_NAK) {
+      if (Stats != NULL) {
+        Stats->Naks++;
+      }
+
+      /*
+       * Non-split bulk and control NAKs are retried by the
+       * controller itself. Split ones are retried here, but
+       * only once the next frame starts, as the device is
+       * unlikely to be ready any sooner.
+       */
       if (Split.Splitting &&
-          (EpType == DWC2_HCCHAR_EPTYPE_CONTROL)) {
+          (EpType == DWC2_HCCHAR_EPTYPE_CONTROL ||
+           EpType == DWC2_HCCHAR_EPTYPE_BULK)) {
+        Status = DwHcWaitMicroFrames (DwHc, Timeout, DW_HC_SPLIT_NAK_BACKOFF);
+        if (EFI_ERROR (Status)) {
+          *TransferResult = EFI_USB_ERR_NAK | EFI_USB_ERR_TIMEOUT;
+          break;
+        }
+
         goto RestartXfer;
       }
 
@@ -369,7 +538,9 @@ DwHcTransfer (
     if (TransferDirection) { // in
       ArmDataSynchronizationBarrier ();
       TxferLen -= Sub;
-      CopyMem (Data + Done, DwHc->AlignedBuffer, TxferLen);
+      if (!Direct) {
+        CopyMem (Data + Done, DwHc->AlignedBuffer, TxferLen);
+      }
       if (Sub) {
         StopTransfer = 1;
       }
@@ -381,8 +552,21 @@ DwHcTransfer (
   MmioWrite32 (DwHc->DwUsbBase + HCINTMSK (Channel), 0);
   MmioWrite32 (DwHc->DwUsbBase + HCINT (Channel), 0xFFFFFFFF);
 
+  if (DirectMapping != NULL) {
+    DmaUnmap (DirectMapping);
+  }
+
   *DataLength = Done;
 
+  if (Stats != NULL) {
+    Stats->Transfers++;
+    Stats->Bytes += Done;
+    Stats->Ticks += GetPerformanceCounter () - StartTicks;
+    if (EFI_ERROR (Status) && *TransferResult != EFI_USB_ERR_NAK) {
+      Stats->Errors++;
+    }
+  }
+
   gBS->RestoreTPL (Tpl);
 
   ASSERT (!EFI_ERROR (Status) || *TransferResult != EFI_USB_NOERROR);
@@ -1494,6 +1678,7 @@ DwUsbHcExitBootService (
   DWUSB_OTGHC_DEV *DwHc;
 
   DwHc = (DWUSB_OTGHC_DEV*)Context;
+  DwHcReportEndpointStats (DwHc);
   DwHcQuiesce (DwHc);
 }
 
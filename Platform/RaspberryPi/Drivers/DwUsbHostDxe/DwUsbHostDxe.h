@@ -94,6 +94,14 @@ typedef struct _DWUSB_DEFERRED_REQ {
   IN     UINTN                              TimeOut;
 } DWUSB_DEFERRED_REQ;
 
+typedef struct {
+  UINT64                          Transfers;
+  UINT64                          Bytes;
+  UINT64                          Naks;
+  UINT64                          Errors;
+  UINT64                          Ticks;
+} DWUSB_EP_STATS;
+
 typedef struct _DWUSB_OTGHC_DEV {
   UINTN                           Signature;
 
@@ -120,6 +128,11 @@ typedef struct _DWUSB_OTGHC_DEV {
    * 125us frames;
    */
   UINT16                          LastMicroFrame;
+  /*
+   * Per-endpoint counters, indexed by device address,
+   * endpoint number and direction (1 = in).
+   */
+  DWUSB_EP_STATS                  EpStats[MAX_DEVICE][MAX_ENDPOINT][2];
 } DWUSB_OTGHC_DEV;
 
 extern EFI_COMPONENT_NAME_PROTOCOL  gComponentName;
@@ -760,6 +760,7 @@
 
 #define DWC2_STATUS_BUF_SIZE            64
 #define DWC2_DATA_BUF_SIZE              (64 * 1024)
+#define DWC2_DMA_ALIGNMENT              64      /* direct DMA buffer alignment */
 
 
 #define USB_PORT_FEAT_CONNECTION     0
@@ -71,6 +71,11 @@
 
 #define BUSWIDTH_4                          4
 
+#define SD_SCR_CMD23_SUPPORT                (1 << 1)  // SCR bit 33
+
+// CMD23 only carries a 16-bit block count on (e)MMC
+#define MMC_CMD23_MAX_BLOCK_COUNT           0xFFFF
+
 typedef enum {
   UNKNOWN_CARD,
   MMC_CARD,              //MMC card
@@ -328,6 +333,7 @@ typedef struct {
   CID       CIDData;
   CSD       CSDData;
   ECSD      *ECSDData;                         // MMC V4 extended card specific
+  BOOLEAN   Cmd23Supported;                    // Card takes SET_BLOCK_COUNT
 } CARD_INFO;
 
 typedef struct _MMC_HOST_INSTANCE {
@@ -342,6 +348,13 @@ typedef struct _MMC_HOST_INSTANCE {
   EFI_MMC_HOST_PROTOCOL     *MmcHost;
 
   BOOLEAN                   Initialized;
+
+  // Use pre-defined (CMD23) multi-block transfers
+  BOOLEAN                   SetBlockCount;
+  // Largest number of blocks moved by a single command
+  UINTN                     MaxBlockCount;
+  // The card is known to be in TRAN state, no need to poll it before I/O
+  BOOLEAN                   CardInTran;
 } MMC_HOST_INSTANCE;
 
 #define MMC_HOST_INSTANCE_SIGNATURE                 SIGNATURE_32('m', 'm', 'c', 'h')
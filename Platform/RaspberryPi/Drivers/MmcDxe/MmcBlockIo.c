@@ -230,9 +230,13 @@ MmcTransferBlock (
   MMC_HOST_INSTANCE       *MmcHostInstance;
   EFI_MMC_HOST_PROTOCOL   *MmcHost;
   UINTN                   CmdArg;
+  UINTN                   BlockCount;
+  UINTN                   BlocksWritten;
+  BOOLEAN                 IsPreDefined;
 
   MmcHostInstance = MMC_HOST_INSTANCE_FROM_BLOCK_IO_THIS (This);
   MmcHost = MmcHostInstance->MmcHost;
+  BlockCount = BufferSize / This->Media->BlockSize;
 
   //Set command argument based on the card access mode (Byte mode or Block mode)
   if ((MmcHostInstance->CardInfo.OCRData.AccessMode & MMC_OCR_ACCESS_MASK) ==
@@ -242,6 +246,22 @@ MmcTransferBlock (
     CmdArg = Lba * This->Media->BlockSize;
   }
 
+  //
+  // A pre-defined multi-block transfer ends by itself once BlockCount
+  // blocks have been moved, so it does not need to be stopped with CMD12.
+  //
+  IsPreDefined = BlockCount > 1 && MmcHostInstance->SetBlockCount;
+  if (IsPreDefined) {
+    Status = MmcHost->SendCommand (MmcHost, MMC_CMD23, BlockCount);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a(MMC_CMD23): Error %r\n", __func__, Status));
+      return Status;
+    }
+  }
+
+  // The card leaves TRAN until the transfer below has completed
+  MmcHostInstance->CardInTran = FALSE;
+
   Status = MmcHost->SendCommand (MmcHost, Cmd, CmdArg);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a(MMC_CMD%d): Error %r\n", __func__, MMC_INDX (Cmd), Status));
@@ -262,10 +282,10 @@ MmcTransferBlock (
   }
 
   if (EFI_ERROR (Status) ||
-      BufferSize > This->Media->BlockSize) {
+      (BlockCount > 1 && !IsPreDefined)) {
     /*
-     * CMD12 needs to be set for multiblock (to transition from
-     * RECV to PROG) or for errors.
+     * CMD12 needs to be set for open-ended multiblock (to transition
+     * from RECV to PROG) or for errors.
      */
     EFI_STATUS Status2 = MmcStopTransmission (MmcHost);
     if (EFI_ERROR (Status2)) {
@@ -284,8 +304,18 @@ MmcTransferBlock (
   }
 
   //
-  // For reads, should be already in TRAN. For writes, wait
-  // until programming finishes.
+  // For reads, the card is back in TRAN as soon as the last block
+  // has been sent (or CMD12 has completed), so there is no need to
+  // poll it or to notify the host of the state change.
+  //
+  if (Transfer == MMC_IOBLOCKS_READ) {
+    MmcHostInstance->CardInTran = TRUE;
+    *TransferredSize = BufferSize;
+    return EFI_SUCCESS;
+  }
+
+  //
+  // For writes, wait until programming finishes.
   //
   Status = WaitUntilTran (MmcHostInstance);
   if (EFI_ERROR (Status)) {
@@ -299,17 +329,12 @@ MmcTransferBlock (
     return Status;
   }
 
-  if (Transfer != MMC_IOBLOCKS_READ) {
-    UINTN BlocksWritten = 0;
+  MmcHostInstance->CardInTran = TRUE;
 
-    Status = ValidateWrittenBlockCount (MmcHostInstance,
-               BufferSize /
-               This->Media->BlockSize,
-               &BlocksWritten);
-    *TransferredSize = BlocksWritten * This->Media->BlockSize;
-  } else {
-    *TransferredSize = BufferSize;
-  }
+  BlocksWritten = 0;
+  Status = ValidateWrittenBlockCount (MmcHostInstance, BlockCount,
+             &BlocksWritten);
+  *TransferredSize = BlocksWritten * This->Media->BlockSize;
 
   return Status;
 }
@@ -330,9 +355,10 @@ MmcIoBlocks (
   EFI_MMC_HOST_PROTOCOL   *MmcHost;
   UINTN                   BytesRemainingToBeTransfered;
   UINTN                   BlockCount;
+  UINTN                   MaxBlockCount;
   UINTN                   ConsumeSize;
 
-  BlockCount = 1;
+  MaxBlockCount = 1;
   MmcHostInstance = MMC_HOST_INSTANCE_FROM_BLOCK_IO_THIS (This);
   ASSERT (MmcHostInstance != NULL);
   MmcHost = MmcHostInstance->MmcHost;
@@ -354,7 +380,7 @@ MmcIoBlocks (
   if (PcdGet32 (PcdMmcDisableMulti) == 0 &&
       MMC_HOST_HAS_ISMULTIBLOCK (MmcHost) &&
       MmcHost->IsMultiBlock (MmcHost)) {
-    BlockCount = (BufferSize + This->Media->BlockSize - 1) / This->Media->BlockSize;
+    MaxBlockCount = MAX (MmcHostInstance->MaxBlockCount, 1);
   }
 
   // All blocks must be within the device
@@ -383,12 +409,18 @@ MmcIoBlocks (
 
   BytesRemainingToBeTransfered = BufferSize;
   while (BytesRemainingToBeTransfered > 0) {
-    Status = WaitUntilTran (MmcHostInstance);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "WaitUntilTran before IO failed"));
-      return Status;
+    if (!MmcHostInstance->CardInTran) {
+      Status = WaitUntilTran (MmcHostInstance);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "WaitUntilTran before IO failed"));
+        return Status;
+      }
     }
 
+    // Split the request into what the host can move with one command
+    BlockCount = MIN (BytesRemainingToBeTransfered / This->Media->BlockSize,
+                   MaxBlockCount);
+
     if (Transfer == MMC_IOBLOCKS_READ) {
       if (BlockCount == 1) {
         // Read a single block
@@ -408,9 +440,6 @@ MmcIoBlocks (
     }
 
     ConsumeSize = BlockCount * This->Media->BlockSize;
-    if (BytesRemainingToBeTransfered < ConsumeSize) {
-      ConsumeSize = BytesRemainingToBeTransfered;
-    }
 
     Status = MmcTransferBlock (This, Cmd, Transfer, MediaId, Lba, ConsumeSize, Buffer, &ConsumeSize);
     if (EFI_ERROR (Status)) {
@@ -418,9 +447,10 @@ MmcIoBlocks (
       return Status;
     }
 
+    // A write may have been cut short, carry on from where it stopped
     BytesRemainingToBeTransfered -= ConsumeSize;
     if (BytesRemainingToBeTransfered > 0) {
-      Lba += BlockCount;
+      Lba += ConsumeSize / This->Media->BlockSize;
       Buffer = (UINT8*)Buffer + ConsumeSize;
     }
   }
@@ -670,11 +670,16 @@ InitializeSdMmcDevice (
     return Status;
   }
 
+  ZeroMem (&Scr, sizeof (Scr));
   Status = SdExecuteScr (MmcHostInstance, &Scr);
   if (EFI_ERROR (Status)) {
      return Status;
   }
 
+  if (Scr.CMD_SUPPORT & SD_SCR_CMD23_SUPPORT) {
+    MmcHostInstance->CardInfo.Cmd23Supported = TRUE;
+  }
+
   if (Scr.SD_SPEC == 2) {
     if (Scr.SD_SPEC3 == 1) {
       if (Scr.SD_SPEC4 == 1) {
@@ -956,6 +961,8 @@ InitializeMmcDevice (
 
   BlockCount = 1;
   MmcHost = MmcHostInstance->MmcHost;
+  MmcHostInstance->CardInfo.Cmd23Supported = FALSE;
+  MmcHostInstance->CardInTran = FALSE;
 
   Status = MmcIdentificationMode (MmcHostInstance);
   if (EFI_ERROR (Status)) {
@@ -973,6 +980,9 @@ InitializeMmcDevice (
     Status = InitializeSdMmcDevice (MmcHostInstance);
   } else {
     Status = InitializeEmmcDevice (MmcHostInstance);
+    // SET_BLOCK_COUNT is mandatory since MMC 3.1, CSD SPEC_VERS 3
+    MmcHostInstance->CardInfo.Cmd23Supported =
+      (BOOLEAN)(MmcHostInstance->CardInfo.CSDData.SPEC_VERS >= 3);
   }
   if (EFI_ERROR (Status)) {
     return Status;
@@ -996,5 +1006,28 @@ InitializeMmcDevice (
     }
   }
 
+  //
+  // Use pre-defined multi-block transfers if both the card and the host
+  // support them, and split requests into what the host can move with a
+  // single command.
+  //
+  MmcHostInstance->SetBlockCount = MmcHostInstance->CardInfo.Cmd23Supported &&
+                                   MMC_HOST_HAS_ISSETBLOCKCOUNT (MmcHost) &&
+                                   MmcHost->IsSetBlockCount (MmcHost);
+
+  MmcHostInstance->MaxBlockCount = MAX_UINTN;
+  if (MMC_HOST_HAS_GETMAXBLOCKCOUNT (MmcHost) &&
+      MmcHost->GetMaxBlockCount (MmcHost) != 0) {
+    MmcHostInstance->MaxBlockCount = MmcHost->GetMaxBlockCount (MmcHost);
+  }
+  if (MmcHostInstance->SetBlockCount) {
+    MmcHostInstance->MaxBlockCount = MIN (MmcHostInstance->MaxBlockCount,
+                                          MMC_CMD23_MAX_BLOCK_COUNT);
+  }
+
+  DEBUG ((DEBUG_INFO, "InitializeMmcDevice(): CMD23 %a, up to %Lu blocks per command\n",
+    MmcHostInstance->SetBlockCount ? "enabled" : "disabled",
+    (UINT64)MmcHostInstance->MaxBlockCount));
+
   return EFI_SUCCESS;
 }
@@ -37,6 +37,27 @@ STATIC UINTN mDmaBufferBusAddress;
 
 STATIC SPIN_LOCK mMailboxLock;
 
+//
+// Board properties that cannot change while the firmware is running.
+// They are fetched in a single batched transaction the first time any
+// of them is asked for, and served from here afterwards.
+//
+#define CACHED_MODEL              BIT0
+#define CACHED_MODEL_REVISION     BIT1
+#define CACHED_FIRMWARE_REVISION  BIT2
+#define CACHED_SERIAL             BIT3
+#define CACHED_MAC_ADDRESS        BIT4
+#define CACHED_ARM_MEMORY         BIT5
+
+STATIC BOOLEAN mCachePopulated;
+STATIC UINT32  mCacheValid;
+STATIC UINT32  mModel;
+STATIC UINT32  mModelRevision;
+STATIC UINT32  mFirmwareRevision;
+STATIC UINT64  mSerial;
+STATIC UINT8   mMacAddress[6];
+STATIC UINT32  mArmMemory[2];
+
 STATIC
 BOOLEAN
 DrainMailbox (
@@ -161,7 +182,206 @@ typedef struct {
   UINT32                    DeviceId;
   UINT32                    PowerState;
 } RPI_FW_POWER_STATE_TAG;
+#pragma pack()
+
+STATIC
+EFI_STATUS
+EFIAPI
+RpiFirmwareQueryProperties (
+  IN OUT  RPI_FIRMWARE_PROPERTY *Properties,
+  IN      UINTN                 Count
+  )
+{
+  RPI_FW_BUFFER_HEAD          *Head;
+  RPI_FW_TAG_HEAD             *Tag;
+  UINT8                       *Ptr;
+  UINTN                       Index;
+  UINTN                       Size;
+  UINTN                       ValueSize;
+  EFI_STATUS                  Status;
+  UINT32                      Result;
+
+  if (Properties == NULL || Count == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Size = sizeof (RPI_FW_BUFFER_HEAD) + sizeof (UINT32);
+  for (Index = 0; Index < Count; Index++) {
+    if (Properties[Index].ValueSize != 0 && Properties[Index].Value == NULL) {
+      return EFI_INVALID_PARAMETER;
+    }
+    Size += sizeof (RPI_FW_TAG_HEAD) +
+            ALIGN_VALUE (Properties[Index].ValueSize, sizeof (UINT32));
+  }
+
+  if (Size > EFI_PAGES_TO_SIZE (NUM_PAGES)) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  if (!AcquireSpinLockOrFail (&mMailboxLock)) {
+    DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
+    return EFI_DEVICE_ERROR;
+  }
+
+  Head = mDmaBuffer;
+  ZeroMem (Head, Size);
+
+  Head->BufferSize = (UINT32)Size;
+  Head->Response   = 0;
+
+  //
+  // Tags are packed back to back, each value padded to 32 bits.
+  // The zeroed word after the last one is the end tag.
+  //
+  Ptr = (UINT8 *)(Head + 1);
+  for (Index = 0; Index < Count; Index++) {
+    ValueSize = ALIGN_VALUE (Properties[Index].ValueSize, sizeof (UINT32));
+    Tag = (RPI_FW_TAG_HEAD *)Ptr;
+    Tag->TagId        = Properties[Index].TagId;
+    Tag->TagSize      = (UINT32)ValueSize;
+    Tag->TagValueSize = 0;
+    CopyMem (Tag + 1, Properties[Index].Value, Properties[Index].ValueSize);
+    Ptr += sizeof (*Tag) + ValueSize;
+  }
+
+  Status = MailboxTransaction (Head->BufferSize, RPI_MBOX_VC_CHANNEL, &Result);
+
+  if (EFI_ERROR (Status) ||
+      Head->Response != RPI_MBOX_RESP_SUCCESS) {
+    DEBUG ((DEBUG_ERROR,
+      "%a: mailbox transaction error: Status == %r, Response == 0x%x\n",
+      __FUNCTION__, Status, Head->Response));
+    ReleaseSpinLock (&mMailboxLock);
+    return EFI_DEVICE_ERROR;
+  }
+
+  Ptr = (UINT8 *)(Head + 1);
+  for (Index = 0; Index < Count; Index++) {
+    ValueSize = ALIGN_VALUE (Properties[Index].ValueSize, sizeof (UINT32));
+    Tag = (RPI_FW_TAG_HEAD *)Ptr;
+    if ((Tag->TagValueSize & RPI_MBOX_VALUE_SIZE_RESPONSE_MASK) == 0) {
+      DEBUG ((DEBUG_ERROR, "%a: no response for tag 0x%x\n",
+        __FUNCTION__, Properties[Index].TagId));
+      Properties[Index].ResponseSize = 0;
+      Status = EFI_DEVICE_ERROR;
+    } else {
+      Properties[Index].ResponseSize =
+        Tag->TagValueSize & ~RPI_MBOX_VALUE_SIZE_RESPONSE_MASK;
+      CopyMem (Properties[Index].Value, Tag + 1,
+        MIN (Properties[Index].ResponseSize, Properties[Index].ValueSize));
+    }
+    Ptr += sizeof (*Tag) + ValueSize;
+  }
+  ReleaseSpinLock (&mMailboxLock);
+
+  return Status;
+}
+
+STATIC
+VOID
+RpiFirmwarePopulateCache (
+  VOID
+  )
+{
+  RPI_FIRMWARE_PROPERTY       Properties[6];
+  UINT32                      Model;
+  UINT32                      ModelRevision;
+  UINT32                      FirmwareRevision;
+  UINT64                      Serial;
+  UINT8                       MacAddress[8];
+  UINT32                      ArmMemory[2];
+  UINTN                       Index;
+
+  Model = 0;
+  ModelRevision = 0;
+  FirmwareRevision = 0;
+  Serial = 0;
+  ZeroMem (MacAddress, sizeof (MacAddress));
+  ZeroMem (ArmMemory, sizeof (ArmMemory));
+
+  Properties[0].TagId = RPI_MBOX_GET_BOARD_MODEL;
+  Properties[0].ValueSize = sizeof (Model);
+  Properties[0].Value = &Model;
+  Properties[1].TagId = RPI_MBOX_GET_BOARD_REVISION;
+  Properties[1].ValueSize = sizeof (ModelRevision);
+  Properties[1].Value = &ModelRevision;
+  Properties[2].TagId = RPI_MBOX_GET_REVISION;
+  Properties[2].ValueSize = sizeof (FirmwareRevision);
+  Properties[2].Value = &FirmwareRevision;
+  Properties[3].TagId = RPI_MBOX_GET_BOARD_SERIAL;
+  Properties[3].ValueSize = sizeof (Serial);
+  Properties[3].Value = &Serial;
+  Properties[4].TagId = RPI_MBOX_GET_MAC_ADDRESS;
+  Properties[4].ValueSize = sizeof (MacAddress);
+  Properties[4].Value = MacAddress;
+  Properties[5].TagId = RPI_MBOX_GET_ARM_MEMSIZE;
+  Properties[5].ValueSize = sizeof (ArmMemory);
+  Properties[5].Value = ArmMemory;
+
+  for (Index = 0; Index < ARRAY_SIZE (Properties); Index++) {
+    Properties[Index].ResponseSize = 0;
+  }
+
+  //
+  // A partial answer is still worth keeping: tags the firmware did
+  // not respond to are simply left to the individual getters.
+  //
+  RpiFirmwareQueryProperties (Properties, ARRAY_SIZE (Properties));
 
+  if (Properties[0].ResponseSize != 0) {
+    mModel = Model;
+    mCacheValid |= CACHED_MODEL;
+  }
+  if (Properties[1].ResponseSize != 0) {
+    mModelRevision = ModelRevision;
+    mCacheValid |= CACHED_MODEL_REVISION;
+  }
+  if (Properties[2].ResponseSize != 0) {
+    mFirmwareRevision = FirmwareRevision;
+    mCacheValid |= CACHED_FIRMWARE_REVISION;
+  }
+  if (Properties[4].ResponseSize != 0) {
+    CopyMem (mMacAddress, MacAddress, sizeof (mMacAddress));
+    mCacheValid |= CACHED_MAC_ADDRESS;
+  }
+  if (Properties[3].ResponseSize != 0) {
+    //
+    // Same fallback as RpiFirmwareGetSerial (), which can be
+    // resolved here without a further round-trip.
+    //
+    if ((Serial == 0) || ((Serial & 0xFFFFFFFF0FFFFFFFULL) == 0)) {
+      if ((mCacheValid & CACHED_MAC_ADDRESS) != 0) {
+        Serial = 0;
+        CopyMem (&Serial, mMacAddress, sizeof (mMacAddress));
+        mSerial = SwapBytes64 (Serial << 16);
+        mCacheValid |= CACHED_SERIAL;
+      }
+    } else {
+      mSerial = Serial;
+      mCacheValid |= CACHED_SERIAL;
+    }
+  }
+  if (Properties[5].ResponseSize != 0) {
+    CopyMem (mArmMemory, ArmMemory, sizeof (mArmMemory));
+    mCacheValid |= CACHED_ARM_MEMORY;
+  }
+}
+
+STATIC
+BOOLEAN
+RpiFirmwareCacheLookup (
+  IN  UINT32  Property
+  )
+{
+  if (!mCachePopulated) {
+    mCachePopulated = TRUE;
+    RpiFirmwarePopulateCache ();
+  }
+
+  return (mCacheValid & Property) != 0;
+}
+
+#pragma pack(1)
 typedef struct {
   RPI_FW_BUFFER_HEAD        BufferHead;
   RPI_FW_TAG_HEAD           TagHead;
@@ -249,6 +469,12 @@ RpiFirmwareGetArmMemory (
   EFI_STATUS                  Status;
   UINT32                      Result;
 
+  if (RpiFirmwareCacheLookup (CACHED_ARM_MEMORY)) {
+    *Base = mArmMemory[0];
+    *Size = mArmMemory[1];
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -278,6 +504,9 @@ RpiFirmwareGetArmMemory (
 
   *Base = Cmd->TagBody.Base;
   *Size = Cmd->TagBody.Size;
+  mArmMemory[0] = *Base;
+  mArmMemory[1] = *Size;
+  mCacheValid |= CACHED_ARM_MEMORY;
   ReleaseSpinLock (&mMailboxLock);
 
   return EFI_SUCCESS;
@@ -308,6 +537,11 @@ RpiFirmwareGetMacAddress (
   EFI_STATUS                  Status;
   UINT32                      Result;
 
+  if (RpiFirmwareCacheLookup (CACHED_MAC_ADDRESS)) {
+    CopyMem (MacAddress, mMacAddress, sizeof (mMacAddress));
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -335,6 +569,8 @@ RpiFirmwareGetMacAddress (
   }
 
   CopyMem (MacAddress, Cmd->TagBody.MacAddress, sizeof (Cmd->TagBody.MacAddress));
+  CopyMem (mMacAddress, MacAddress, sizeof (mMacAddress));
+  mCacheValid |= CACHED_MAC_ADDRESS;
   ReleaseSpinLock (&mMailboxLock);
 
   return EFI_SUCCESS;
@@ -364,6 +600,11 @@ RpiFirmwareGetSerial (
   EFI_STATUS                  Status;
   UINT32                      Result;
 
+  if (RpiFirmwareCacheLookup (CACHED_SERIAL)) {
+    *Serial = mSerial;
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -400,6 +641,11 @@ RpiFirmwareGetSerial (
     *Serial = SwapBytes64 (*Serial << 16);
   }
 
+  if (!EFI_ERROR (Status)) {
+    mSerial = *Serial;
+    mCacheValid |= CACHED_SERIAL;
+  }
+
   return Status;
 }
 
@@ -427,6 +673,11 @@ RpiFirmwareGetModel (
   EFI_STATUS                  Status;
   UINT32                      Result;
 
+  if (RpiFirmwareCacheLookup (CACHED_MODEL)) {
+    *Model = mModel;
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -454,6 +705,8 @@ RpiFirmwareGetModel (
   }
 
   *Model = Cmd->TagBody.Model;
+  mModel = *Model;
+  mCacheValid |= CACHED_MODEL;
   ReleaseSpinLock (&mMailboxLock);
 
   return EFI_SUCCESS;
@@ -483,6 +736,11 @@ RpiFirmwareGetModelRevision (
   EFI_STATUS                    Status;
   UINT32                        Result;
 
+  if (RpiFirmwareCacheLookup (CACHED_MODEL_REVISION)) {
+    *Revision = mModelRevision;
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -510,6 +768,8 @@ RpiFirmwareGetModelRevision (
   }
 
   *Revision = Cmd->TagBody.Revision;
+  mModelRevision = *Revision;
+  mCacheValid |= CACHED_MODEL_REVISION;
   ReleaseSpinLock (&mMailboxLock);
 
   return EFI_SUCCESS;
@@ -526,6 +786,11 @@ RpiFirmwareGetFirmwareRevision (
   EFI_STATUS                    Status;
   UINT32                        Result;
 
+  if (RpiFirmwareCacheLookup (CACHED_FIRMWARE_REVISION)) {
+    *Revision = mFirmwareRevision;
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -553,6 +818,8 @@ RpiFirmwareGetFirmwareRevision (
   }
 
   *Revision = Cmd->TagBody.Revision;
+  mFirmwareRevision = *Revision;
+  mCacheValid |= CACHED_FIRMWARE_REVISION;
   ReleaseSpinLock (&mMailboxLock);
 
   return EFI_SUCCESS;
@@ -1557,7 +1824,8 @@ STATIC RASPBERRY_PI_FIRMWARE_PROTOCOL mRpiFirmwareProtocol = {
   RpiFirmwareNotifyXhciReset,
   RpiFirmwareGetCurrentClockState,
   RpiFirmwareSetClockState,
-  RpiFirmwareNotifyGpioSetCfg
+  RpiFirmwareNotifyGpioSetCfg,
+  RpiFirmwareQueryProperties
 };
 
 /**
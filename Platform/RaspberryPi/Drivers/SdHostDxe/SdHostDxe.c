@@ -18,6 +18,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DmaLib.h>
 #include <Library/TimerLib.h>
+#include <Library/UefiLib.h>
 
 #include <Protocol/EmbeddedExternalDevice.h>
 #include <Protocol/BlockIo.h>
@@ -28,8 +29,10 @@
 #include <IndustryStandard/Bcm2836.h>
 #include <IndustryStandard/RpiMbox.h>
 #include <IndustryStandard/Bcm2836SdHost.h>
+#include <IndustryStandard/Bcm2836Dma.h>
 
 #define SDHOST_BLOCK_BYTE_LENGTH            512
+#define SDHOST_MAX_BLOCK_COUNT              0xFFFF
 
 // Driver Timing Parameters
 #define CMD_STALL_AFTER_POLL_US             1
@@ -39,6 +42,13 @@
 #define CMD_STALL_AFTER_RETRY_US            20 // 20us
 #define FIFO_MAX_POLL_COUNT                 1000000
 #define STALL_TO_STABILIZE_US               10000 // 10ms
+#define FIFO_STALL_AFTER_POLL_US            1
+#define DMA_STALL_AFTER_POLL_US             1
+#define DMA_MIN_POLL_TOTAL_TIME_US          100000 // 100ms, plus 1us per byte
+
+// FIFO fill levels at which the SDHOST raises its DMA request
+#define FIFO_READ_THRESHOLD                 4
+#define FIFO_WRITE_THRESHOLD                4
 
 #define IDENT_MODE_SD_CLOCK_FREQ_HZ         400000 // 400KHz
 
@@ -67,6 +77,19 @@ STATIC CONST CHAR8 *mFsmState[] = { "identmode", "datamode", "readdata",
 STATIC BOOLEAN mCardIsPresent = FALSE;
 STATIC CARD_DETECT_STATE mCardDetectState = CardDetectRequired;
 STATIC UINT32 mLastGoodCmd = MMC_GET_INDX (MMC_CMD0);
+// Block count set by the last CMD23, for the transfer that follows it
+STATIC UINT32 mSetBlockCount;
+
+// DMA channel registers, or 0 if block transfers are done using PIO
+STATIC UINTN mDmaChannelBase;
+STATIC BCM2836_DMA_CONTROL_BLOCK *mDmaControlBlock;
+STATIC EFI_PHYSICAL_ADDRESS mDmaControlBlockBusAddress;
+STATIC VOID *mDmaControlBlockMapping;
+
+// Multi-block read throughput, when PcdSdHostBenchmark is set
+STATIC UINT64 mBenchmarkReadCount;
+STATIC UINT64 mBenchmarkReadBytes;
+STATIC UINT64 mBenchmarkReadNs;
 
 STATIC inline BOOLEAN
 IsAppCmd (
@@ -359,7 +382,18 @@ SdSendCommand (
     } else {
       MmioWrite32 (SDHOST_HBCT, SDHOST_BLOCK_BYTE_LENGTH);
     }
+
+    //
+    // Have the SDHOST stop on its own after a pre-defined multi-block
+    // transfer. A count of 0 keeps the transfer open-ended until CMD12.
+    //
+    if (!IsAppCmd () && (MmcCmd == MMC_CMD18 || MmcCmd == MMC_CMD25)) {
+      MmioWrite32 (SDHOST_HBLC, mSetBlockCount);
+    } else {
+      MmioWrite32 (SDHOST_HBLC, 0);
+    }
   }
+  mSetBlockCount = 0;
 
   DEBUG ((DEBUG_MMCHOST_SD,
     "SdHost: SdSendCommand(CMD%d, Argument: %08x): BUSY=%d, RESP=%d, WRITE=%d, READ=%d\n",
@@ -454,6 +488,9 @@ SdSendCommand (
 
   if (IsCmdExecuted && !EFI_ERROR (Status)) {
     ASSERT (!(MmioRead32 (SDHOST_HSTS) & SDHOST_HSTS_ERROR));
+    if (MmcCmd == MMC_CMD23 && !IsAppCmd ()) {
+      mSetBlockCount = Argument & SDHOST_MAX_BLOCK_COUNT;
+    }
     mLastGoodCmd = MmcCmd;
   }
 
@@ -495,6 +532,164 @@ SdReceiveResponse (
   return EFI_SUCCESS;
 }
 
+/*
+ * Move NumWords words through the data FIFO, as many at a time as the
+ * FIFO fill level allows.
+ */
+STATIC EFI_STATUS
+SdHostPioTransfer (
+  IN      BOOLEAN   IsRead,
+  IN OUT  UINT32    *Buffer,
+  IN      UINTN     NumWords
+  )
+{
+  UINT32 PollCount = 0;
+
+  while (NumWords > 0) {
+    UINT32 FifoWords = (MmioRead32 (SDHOST_EDM) >> SDHOST_EDM_FIFO_COUNT_SHIFT) &
+                       SDHOST_EDM_FIFO_COUNT_MASK;
+    UINTN Words = IsRead ? FifoWords : (SDHOST_FIFO_WORDS - FifoWords);
+
+    if (Words == 0) {
+      if (++PollCount == FIFO_MAX_POLL_COUNT) {
+        DEBUG ((DEBUG_MMCHOST_SD_ERROR,
+          "SdHost: SdHostPioTransfer(): %a poll timed-out with %d words left\n",
+          IsRead ? "Read" : "Write", NumWords));
+        SdHostDumpStatus ();
+        MmioWrite32 (SDHOST_HSTS, SDHOST_HSTS_CLEAR);
+        return EFI_TIMEOUT;
+      }
+
+      gBS->Stall (FIFO_STALL_AFTER_POLL_US);
+      continue;
+    }
+
+    PollCount = 0;
+    Words = MIN (Words, NumWords);
+    NumWords -= Words;
+
+    if (IsRead) {
+      while (Words-- > 0) {
+        *Buffer++ = MmioRead32 (SDHOST_DATA);
+      }
+    } else {
+      while (Words-- > 0) {
+        MmioWrite32 (SDHOST_DATA, *Buffer++);
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/*
+ * Move the first TransferLength bytes of the Length byte buffer through the
+ * data FIFO using the DMA engine, paced by the SDHOST DREQ. Returns
+ * EFI_UNSUPPORTED if the transfer could not be started, in which case the
+ * caller can still fall back to PIO.
+ */
+STATIC EFI_STATUS
+SdHostDmaTransfer (
+  IN      BOOLEAN   IsRead,
+  IN OUT  UINT32    *Buffer,
+  IN      UINTN     Length,
+  IN      UINTN     TransferLength
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  BusAddress;
+  UINTN                 MapLength;
+  VOID                  *Mapping;
+  UINT32                Cs;
+  UINTN                 PollCount;
+  UINTN                 MaxPollCount;
+
+  ASSERT (mDmaChannelBase != 0);
+  ASSERT (TransferLength <= Length);
+
+  MapLength = Length;
+  Status = DmaMap (IsRead ? MapOperationBusMasterWrite : MapOperationBusMasterRead,
+             Buffer, &MapLength, &BusAddress, &Mapping);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (MapLength != Length || BusAddress + Length > MAX_UINT32) {
+    DmaUnmap (Mapping);
+    return EFI_UNSUPPORTED;
+  }
+
+  mDmaControlBlock->TransferInfo = BCM2836_DMA_TI_WAIT_RESP |
+                                   BCM2836_DMA_TI_PERMAP (BCM2836_DMA_DREQ_SDHOST);
+  if (IsRead) {
+    mDmaControlBlock->TransferInfo |= BCM2836_DMA_TI_SRC_DREQ | BCM2836_DMA_TI_DEST_INC;
+    mDmaControlBlock->SourceAddress = SDHOST_DATA_BUS_ADDRESS;
+    mDmaControlBlock->DestinationAddress = (UINT32)BusAddress;
+  } else {
+    mDmaControlBlock->TransferInfo |= BCM2836_DMA_TI_DEST_DREQ | BCM2836_DMA_TI_SRC_INC;
+    mDmaControlBlock->SourceAddress = (UINT32)BusAddress;
+    mDmaControlBlock->DestinationAddress = SDHOST_DATA_BUS_ADDRESS;
+  }
+  mDmaControlBlock->TransferLength = (UINT32)TransferLength;
+  mDmaControlBlock->Stride = 0;
+  mDmaControlBlock->NextControlBlock = 0;
+  MemoryFence ();
+
+  MmioWrite32 (mDmaChannelBase + BCM2836_DMA_CS, BCM2836_DMA_CS_END | BCM2836_DMA_CS_INT);
+  MmioWrite32 (mDmaChannelBase + BCM2836_DMA_CONBLK_AD, (UINT32)mDmaControlBlockBusAddress);
+  MmioWrite32 (mDmaChannelBase + BCM2836_DMA_CS,
+    BCM2836_DMA_CS_ACTIVE | BCM2836_DMA_CS_WAIT_FOR_WRITES);
+
+  //
+  // The channel drops ACTIVE once the (only) control block completes. Keep an
+  // eye on the SDHOST too, as the DREQ stops if the transfer fails there.
+  //
+  Status = EFI_SUCCESS;
+  MaxPollCount = (DMA_MIN_POLL_TOTAL_TIME_US + TransferLength) / DMA_STALL_AFTER_POLL_US;
+  for (PollCount = 0; ; PollCount++) {
+    Cs = MmioRead32 (mDmaChannelBase + BCM2836_DMA_CS);
+    if ((Cs & BCM2836_DMA_CS_ERROR) != 0) {
+      Status = EFI_DEVICE_ERROR;
+      break;
+    }
+
+    if ((Cs & BCM2836_DMA_CS_ACTIVE) == 0) {
+      break;
+    }
+
+    if ((MmioRead32 (SDHOST_HSTS) & SDHOST_HSTS_ERROR) != 0) {
+      Status = EFI_DEVICE_ERROR;
+      break;
+    }
+
+    if (PollCount == MaxPollCount) {
+      Status = EFI_TIMEOUT;
+      break;
+    }
+
+    gBS->Stall (DMA_STALL_AFTER_POLL_US);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_MMCHOST_SD_ERROR,
+      "SdHost: SdHostDmaTransfer(): %a of %d bytes failed, CS 0x%8.8X, %d bytes left, Status=%r\n",
+      IsRead ? "Read" : "Write", TransferLength, Cs,
+      MmioRead32 (mDmaChannelBase + BCM2836_DMA_TXFR_LEN), Status));
+    SdHostDumpStatus ();
+
+    // Pause the channel, then reset it to drop the rest of the transfer
+    MmioWrite32 (mDmaChannelBase + BCM2836_DMA_CS, 0);
+    MmioWrite32 (mDmaChannelBase + BCM2836_DMA_CS, BCM2836_DMA_CS_RESET);
+    MmioWrite32 (SDHOST_HSTS, SDHOST_HSTS_CLEAR);
+  } else {
+    MmioWrite32 (mDmaChannelBase + BCM2836_DMA_CS, BCM2836_DMA_CS_END);
+  }
+
+  DmaUnmap (Mapping);
+
+  return Status;
+}
+
 STATIC EFI_STATUS
 SdReadBlockData (
   IN EFI_MMC_HOST_PROTOCOL    *This,
@@ -509,39 +704,41 @@ SdReadBlockData (
   ASSERT (Buffer != NULL);
   ASSERT (Length % 4 == 0);
 
-  EFI_STATUS Status = EFI_SUCCESS;
+  EFI_STATUS Status = EFI_UNSUPPORTED;
+  UINT64 StartTicks = 0;
+  UINTN NumWords = Length / 4;
 
-  mFwProtocol->SetLed (TRUE);
-  {
-    UINT32 NumWords = Length / 4;
-    UINT32 WordIdx;
-
-    for (WordIdx = 0; WordIdx < NumWords; ++WordIdx) {
-      UINT32 PollCount = 0;
-      while (PollCount < FIFO_MAX_POLL_COUNT) {
-        UINT32 Hsts = MmioRead32 (SDHOST_HSTS);
-        if ((Hsts & SDHOST_HSTS_DATA_FLAG) != 0) {
-          MmioWrite32 (SDHOST_HSTS, SDHOST_HSTS_DATA_FLAG);
-          Buffer[WordIdx] = MmioRead32 (SDHOST_DATA);
-          break;
-        }
-
-        ++PollCount;
-        gBS->Stall (CMD_STALL_AFTER_RETRY_US);
-      }
+  if (FixedPcdGetBool (PcdSdHostBenchmark)) {
+    StartTicks = GetPerformanceCounter ();
+  }
 
-      if (PollCount == FIFO_MAX_POLL_COUNT) {
-        DEBUG ((DEBUG_MMCHOST_SD_ERROR,
-            "SdHost: SdReadBlockData(): Block Word%d read poll timed-out\n", WordIdx));
-        SdHostDumpStatus ();
-        MmioWrite32 (SDHOST_HSTS, SDHOST_HSTS_CLEAR);
-        Status = EFI_TIMEOUT;
-        break;
-      }
+  mFwProtocol->SetLed (TRUE);
+  if (mDmaChannelBase != 0 && Length >= SDHOST_BLOCK_BYTE_LENGTH) {
+    //
+    // The SDHOST only raises its DREQ while the FIFO holds at least
+    // FIFO_READ_THRESHOLD words, so the last few words of the transfer
+    // have to be drained by hand.
+    //
+    UINTN DmaWords = NumWords - (FIFO_READ_THRESHOLD - 1);
+
+    Status = SdHostDmaTransfer (TRUE, Buffer, Length, DmaWords * 4);
+    if (!EFI_ERROR (Status)) {
+      Status = SdHostPioTransfer (TRUE, Buffer + DmaWords, NumWords - DmaWords);
     }
   }
+
+  if (Status == EFI_UNSUPPORTED) {
+    Status = SdHostPioTransfer (TRUE, Buffer, NumWords);
+  }
   mFwProtocol->SetLed (FALSE);
 
+  if (FixedPcdGetBool (PcdSdHostBenchmark) &&
+      Length > SDHOST_BLOCK_BYTE_LENGTH && !EFI_ERROR (Status)) {
+    mBenchmarkReadCount++;
+    mBenchmarkReadBytes += Length;
+    mBenchmarkReadNs += GetTimeInNanoSecond (GetPerformanceCounter () - StartTicks);
+  }
+
   return Status;
 }
 
@@ -560,35 +757,15 @@ SdWriteBlockData (
   ASSERT (Buffer != NULL);
   ASSERT (Length % SDHOST_BLOCK_BYTE_LENGTH == 0);
 
-  EFI_STATUS Status = EFI_SUCCESS;
+  EFI_STATUS Status = EFI_UNSUPPORTED;
 
   mFwProtocol->SetLed (TRUE);
-  {
-    UINT32 NumWords = Length / 4;
-    UINT32 WordIdx;
-
-    for (WordIdx = 0; WordIdx < NumWords; ++WordIdx) {
-      UINT32 PollCount = 0;
-      while (PollCount < FIFO_MAX_POLL_COUNT) {
-        if (MmioRead32 (SDHOST_HSTS) & SDHOST_HSTS_DATA_FLAG) {
-          MmioWrite32 (SDHOST_HSTS, SDHOST_HSTS_DATA_FLAG);
-          MmioWrite32 (SDHOST_DATA, Buffer[WordIdx]);
-          break;
-        }
-
-        ++PollCount;
-        gBS->Stall (CMD_STALL_AFTER_RETRY_US);
-      }
+  if (mDmaChannelBase != 0) {
+    Status = SdHostDmaTransfer (FALSE, Buffer, Length, Length);
+  }
 
-      if (PollCount == FIFO_MAX_POLL_COUNT) {
-        DEBUG ((DEBUG_MMCHOST_SD_ERROR,
-          "SdHost: SdWriteBlockData(): Block Word%d write poll timed-out\n", WordIdx));
-        SdHostDumpStatus ();
-        MmioWrite32 (SDHOST_HSTS, SDHOST_HSTS_CLEAR);
-        Status = EFI_TIMEOUT;
-        break;
-      }
-    }
+  if (Status == EFI_UNSUPPORTED) {
+    Status = SdHostPioTransfer (FALSE, Buffer, Length / 4);
   }
   mFwProtocol->SetLed (FALSE);
 
@@ -672,6 +849,14 @@ SdNotifyState (
     Hcfg |= SDHOST_HCFG_SLOW_CARD; // Use all bits of CDIV in DataMode
     MmioWrite32 (SDHOST_HCFG, Hcfg);
 
+    // Set the FIFO levels that pace DMA transfers
+    UINT32 Edm = MmioRead32 (SDHOST_EDM);
+    Edm &= ~(SDHOST_EDM_READ_THRESHOLD (SDHOST_EDM_THRESHOLD_MASK) |
+             SDHOST_EDM_WRITE_THRESHOLD (SDHOST_EDM_THRESHOLD_MASK));
+    Edm |= SDHOST_EDM_READ_THRESHOLD (FIFO_READ_THRESHOLD) |
+           SDHOST_EDM_WRITE_THRESHOLD (FIFO_WRITE_THRESHOLD);
+    MmioWrite32 (SDHOST_EDM, Edm);
+
     // Set default clock frequency
     EFI_STATUS Status = SdHostSetClockFrequency (IDENT_MODE_SD_CLOCK_FREQ_HZ);
     if (EFI_ERROR (Status)) {
@@ -787,6 +972,22 @@ SdIsMultiBlock (
   return TRUE;
 }
 
+STATIC BOOLEAN
+SdIsSetBlockCount (
+  IN EFI_MMC_HOST_PROTOCOL *This
+  )
+{
+  return TRUE;
+}
+
+STATIC UINTN
+SdGetMaxBlockCount (
+  IN EFI_MMC_HOST_PROTOCOL *This
+  )
+{
+  return SDHOST_MAX_BLOCK_COUNT;
+}
+
 EFI_MMC_HOST_PROTOCOL gMmcHost =
   {
     MMC_HOST_PROTOCOL_REVISION,
@@ -799,9 +1000,80 @@ EFI_MMC_HOST_PROTOCOL gMmcHost =
     SdReadBlockData,
     SdWriteBlockData,
     SdSetIos,
-    SdIsMultiBlock
+    SdIsMultiBlock,
+    SdIsSetBlockCount,
+    SdGetMaxBlockCount
   };
 
+STATIC VOID
+SdHostDmaInitialize (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+  UINTN Channel = FixedPcdGet8 (PcdSdHostDmaChannel);
+  UINTN Size;
+
+  if (Channel > BCM2836_DMA_MAX_FULL_CHANNEL) {
+    DEBUG ((DEBUG_MMCHOST_SD_INFO, "SdHost: No DMA channel configured, using PIO\n"));
+    return;
+  }
+
+  Status = DmaAllocateBuffer (EfiBootServicesData, 1, (VOID **)&mDmaControlBlock);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_MMCHOST_SD_ERROR,
+      "SdHost: Failed to allocate DMA control block, using PIO: %r\n", Status));
+    return;
+  }
+
+  Size = EFI_PAGE_SIZE;
+  Status = DmaMap (MapOperationBusMasterCommonBuffer, mDmaControlBlock, &Size,
+             &mDmaControlBlockBusAddress, &mDmaControlBlockMapping);
+  if (EFI_ERROR (Status) || Size != EFI_PAGE_SIZE ||
+      mDmaControlBlockBusAddress > MAX_UINT32) {
+    DEBUG ((DEBUG_MMCHOST_SD_ERROR,
+      "SdHost: Failed to map DMA control block, using PIO: %r\n", Status));
+    if (!EFI_ERROR (Status)) {
+      DmaUnmap (mDmaControlBlockMapping);
+    }
+    DmaFreeBuffer (1, mDmaControlBlock);
+    mDmaControlBlock = NULL;
+    return;
+  }
+
+  ASSERT ((mDmaControlBlockBusAddress % BCM2836_DMA_CONTROL_BLOCK_ALIGNMENT) == 0);
+
+  mDmaChannelBase = BCM2836_DMA_CHANNEL_BASE_ADDRESS (Channel);
+  MmioOr32 (BCM2836_DMA_CTRL_BASE_ADDRESS + BCM2836_DMA_ENABLE, 1U << Channel);
+  MmioWrite32 (mDmaChannelBase + BCM2836_DMA_CS, BCM2836_DMA_CS_RESET);
+
+  DEBUG ((DEBUG_MMCHOST_SD_INFO, "SdHost: Using DMA channel %d\n", Channel));
+}
+
+STATIC VOID
+EFIAPI
+SdHostBenchmarkReport (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINT64 Rate;
+
+  if (mBenchmarkReadNs == 0) {
+    return;
+  }
+
+  // Bytes per microsecond is MB/s, keep two decimals
+  Rate = DivU64x64Remainder (MultU64x32 (mBenchmarkReadBytes, 100000),
+           mBenchmarkReadNs, NULL);
+
+  DEBUG ((DEBUG_INFO,
+    "SdHost: %Lu multi-block reads, %Lu bytes in %Lu us using %a: %Lu.%02Lu MB/s\n",
+    mBenchmarkReadCount, mBenchmarkReadBytes, DivU64x32 (mBenchmarkReadNs, 1000),
+    mDmaChannelBase != 0 ? "DMA" : "PIO", DivU64x32 (Rate, 100),
+    ModU64x32 (Rate, 100)));
+}
+
 EFI_STATUS
 SdHostInitialize (
   IN EFI_HANDLE          ImageHandle,
@@ -810,6 +1082,7 @@ SdHostInitialize (
 {
   EFI_STATUS Status;
   EFI_HANDLE Handle = NULL;
+  EFI_EVENT Event;
 
   if (PcdGet32 (PcdSdIsArasan)) {
     DEBUG ((DEBUG_INFO, "SD is not routed to SdHost\n"));
@@ -831,6 +1104,14 @@ SdHostInitialize (
   DEBUG ((DEBUG_MMCHOST_SD, " - CMD_MAX_RETRY_COUNT=%d\n", CMD_MAX_RETRY_COUNT));
   DEBUG ((DEBUG_MMCHOST_SD, " - CMD_STALL_AFTER_RETRY_US=%dus\n", CMD_STALL_AFTER_RETRY_US));
 
+  SdHostDmaInitialize ();
+
+  if (FixedPcdGetBool (PcdSdHostBenchmark)) {
+    Status = EfiCreateEventReadyToBootEx (TPL_CALLBACK, SdHostBenchmarkReport,
+               NULL, &Event);
+    ASSERT_EFI_ERROR (Status);
+  }
+
   Status = gBS->InstallMultipleProtocolInterfaces (
     &Handle,
     &gRaspberryPiMmcHostProtocolGuid,
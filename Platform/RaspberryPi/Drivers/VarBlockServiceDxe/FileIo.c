@@ -111,7 +111,8 @@ FileOpen (
 EFI_STATUS
 CheckStore (
   IN  EFI_HANDLE SimpleFileSystemHandle,
-  OUT EFI_DEVICE_PATH_PROTOCOL **Device
+  OUT EFI_DEVICE_PATH_PROTOCOL **Device,
+  OUT UINT32 *BlockSize
   )
 {
   EFI_STATUS Status;
@@ -150,6 +151,7 @@ CheckStore (
 
   FileClose (File);
   *Device = DuplicateDevicePath (DevicePathFromHandle (SimpleFileSystemHandle));
+  *BlockSize = BlkIo->Media->BlockSize;
 
   ASSERT (*Device != NULL);
 
@@ -86,6 +86,64 @@ EFI_FW_VOL_BLOCK_DEVICE mFvbDeviceTemplate = {
 };
 
 
+/*
+ * Records [Offset, Offset + Length) of the store as needing to be
+ * written back. Ranges touching an existing one are merged into it,
+ * and once all slots are in use everything is folded into a single
+ * covering range. Must be called at TPL_NOTIFY, the TPL SetVariable
+ * writes the store at.
+ */
+VOID
+VarStoreMarkDirty (
+  IN UINTN Offset,
+  IN UINTN Length
+  )
+{
+  VAR_STORE_RANGE *Range;
+  UINTN           Start;
+  UINTN           End;
+  UINTN           Index;
+
+  mFvInstance->Dirty = TRUE;
+  if (Length == 0) {
+    return;
+  }
+
+  Start = Offset;
+  End = Offset + Length;
+
+  for (Index = 0; Index < mFvInstance->DirtyCount; Index++) {
+    Range = &mFvInstance->DirtyRanges[Index];
+    if (Start <= Range->End && End >= Range->Start) {
+      Range->Start = MIN (Range->Start, Start);
+      Range->End = MAX (Range->End, End);
+      goto Armed;
+    }
+  }
+
+  if (mFvInstance->DirtyCount == VAR_STORE_MAX_DIRTY_RANGES) {
+    for (Index = 0; Index < mFvInstance->DirtyCount; Index++) {
+      Start = MIN (Start, mFvInstance->DirtyRanges[Index].Start);
+      End = MAX (End, mFvInstance->DirtyRanges[Index].End);
+    }
+    mFvInstance->DirtyCount = 0;
+  }
+
+  Range = &mFvInstance->DirtyRanges[mFvInstance->DirtyCount++];
+  Range->Start = Start;
+  Range->End = End;
+
+Armed:
+  //
+  // Push the deferred flush back while writes keep coming in.
+  //
+  if (mFvInstance->FlushEvent != NULL && !EfiAtRuntime ()) {
+    gBS->SetTimer (mFvInstance->FlushEvent, TimerRelative,
+           EFI_TIMER_PERIOD_MILLISECONDS (VAR_STORE_FLUSH_DELAY_MS));
+  }
+}
+
+
 EFI_STATUS
 VarStoreWrite (
   IN     UINTN Address,
@@ -94,7 +152,7 @@ VarStoreWrite (
   )
 {
   CopyMem ((VOID*)Address, Buffer, *NumBytes);
-  mFvInstance->Dirty = TRUE;
+  VarStoreMarkDirty (Address - mFvInstance->FvBase, *NumBytes);
 
   return EFI_SUCCESS;
 }
@@ -107,7 +165,7 @@ VarStoreErase (
   )
 {
   SetMem ((VOID*)Address, LbaLength, 0xff);
-  mFvInstance->Dirty = TRUE;
+  VarStoreMarkDirty (Address - mFvInstance->FvBase, LbaLength);
 
   return EFI_SUCCESS;
 }
@@ -22,6 +22,23 @@
 #include <Protocol/BlockIo.h>
 #include <Protocol/LoadedImage.h>
 
+//
+// Writes to the store are tracked as up to this many byte ranges,
+// so that only those have to be written back to the file.
+//
+#define VAR_STORE_MAX_DIRTY_RANGES  16
+
+//
+// After ReadyToBoot, dirty ranges are flushed once the store has
+// not been written to for this long.
+//
+#define VAR_STORE_FLUSH_DELAY_MS    2000
+
+typedef struct {
+  UINTN                      Start;
+  UINTN                      End;
+} VAR_STORE_RANGE;
+
 typedef struct {
   union {
     UINTN                      FvBase;
@@ -33,6 +50,10 @@ typedef struct {
   EFI_DEVICE_PATH_PROTOCOL   *Device;
   CHAR16                     *MappedFile;
   BOOLEAN                    Dirty;
+  UINT32                     FlushAlignment;
+  UINTN                      DirtyCount;
+  VAR_STORE_RANGE            DirtyRanges[VAR_STORE_MAX_DIRTY_RANGES];
+  EFI_EVENT                  FlushEvent;
 } EFI_FW_VOL_INSTANCE;
 
 extern EFI_FW_VOL_INSTANCE *mFvInstance;
@@ -156,6 +177,12 @@ FvbProtocolEraseBlocks (
   ...
   );
 
+VOID
+VarStoreMarkDirty (
+  IN UINTN Offset,
+  IN UINTN Length
+  );
+
 VOID
 InstallProtocolInterfaces (
   IN EFI_FW_VOL_BLOCK_DEVICE *FvbDevice
@@ -187,7 +214,8 @@ FileWrite (
 EFI_STATUS
 CheckStore (
   IN  EFI_HANDLE SimpleFileSystemHandle,
-  OUT EFI_DEVICE_PATH_PROTOCOL **Device
+  OUT EFI_DEVICE_PATH_PROTOCOL **Device,
+  OUT UINT32 *BlockSize
   );
 
 EFI_STATUS
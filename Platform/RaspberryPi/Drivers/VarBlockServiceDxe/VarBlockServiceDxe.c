@@ -161,6 +161,108 @@ DoDump (
 }
 
 
+/*
+ * Writes back only the parts of the store that changed since the last
+ * flush, rounded out to whole media blocks and coalesced so that each
+ * block is written at most once.
+ */
+STATIC
+EFI_STATUS
+DoFlush (
+  IN EFI_DEVICE_PATH_PROTOCOL *Device
+  )
+{
+  EFI_STATUS      Status;
+  EFI_FILE_PROTOCOL *File;
+  EFI_TPL         OldTpl;
+  VAR_STORE_RANGE Ranges[VAR_STORE_MAX_DIRTY_RANGES];
+  VAR_STORE_RANGE Range;
+  UINTN           Count;
+  UINTN           Index;
+  UINTN           Next;
+  UINTN           Align;
+  UINTN           Written;
+
+  //
+  // Take the ranges over atomically with respect to SetVariable,
+  // anything written from here on is picked up by the next flush.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Count = mFvInstance->DirtyCount;
+  CopyMem (Ranges, mFvInstance->DirtyRanges, Count * sizeof (Ranges[0]));
+  mFvInstance->DirtyCount = 0;
+  mFvInstance->Dirty = FALSE;
+  gBS->RestoreTPL (OldTpl);
+
+  if (Count == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Align = MAX (mFvInstance->FlushAlignment, 1);
+  for (Index = 0; Index < Count; Index++) {
+    Ranges[Index].Start &= ~(Align - 1);
+    Ranges[Index].End = MIN (ALIGN_VALUE (Ranges[Index].End, Align),
+                          mFvInstance->FvLength);
+  }
+
+  for (Index = 1; Index < Count; Index++) {
+    Range = Ranges[Index];
+    for (Next = Index; Next > 0 && Ranges[Next - 1].Start > Range.Start; Next--) {
+      Ranges[Next] = Ranges[Next - 1];
+    }
+    Ranges[Next] = Range;
+  }
+
+  Next = 0;
+  for (Index = 1; Index < Count; Index++) {
+    if (Ranges[Index].Start <= Ranges[Next].End) {
+      Ranges[Next].End = MAX (Ranges[Next].End, Ranges[Index].End);
+    } else {
+      Ranges[++Next] = Ranges[Index];
+    }
+  }
+  Count = Next + 1;
+
+  Status = FileOpen (Device,
+             mFvInstance->MappedFile,
+             &File,
+             EFI_FILE_MODE_WRITE |
+             EFI_FILE_MODE_READ);
+  if (!EFI_ERROR (Status)) {
+    Written = 0;
+    for (Index = 0; Index < Count; Index++) {
+      Status = FileWrite (File,
+                 mFvInstance->Offset + Ranges[Index].Start,
+                 mFvInstance->FvBase + Ranges[Index].Start,
+                 Ranges[Index].End - Ranges[Index].Start);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+      Written += Ranges[Index].End - Ranges[Index].Start;
+    }
+    FileClose (File);
+
+    DEBUG ((DEBUG_INFO, "Flushed %Lu bytes in %Lu ranges\n",
+      (UINT64)Written, (UINT64)Count));
+  }
+
+  if (EFI_ERROR (Status)) {
+    //
+    // Keep everything that did not make it for the next attempt, at the
+    // same TPL as SetVariable updates the ranges.
+    //
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    for (Index = 0; Index < Count; Index++) {
+      VarStoreMarkDirty (Ranges[Index].Start,
+        Ranges[Index].End - Ranges[Index].Start);
+    }
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  return Status;
+}
+
+
 STATIC
 VOID
 DumpVars (
@@ -180,7 +282,7 @@ DumpVars (
     return;
   }
 
-  Status = DoDump (mFvInstance->Device);
+  Status = DoFlush (mFvInstance->Device);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Couldn't dump '%s'\n", mFvInstance->MappedFile));
     ASSERT_EFI_ERROR (Status);
@@ -198,8 +300,6 @@ DumpVars (
     PcdStatus = PcdSet32S (PcdPlatformResetDelay, PLATFORM_RESET_DELAY);
     ASSERT_RETURN_ERROR (PcdStatus);
   }
-
-  mFvInstance->Dirty = FALSE;
 }
 
 STATIC
@@ -252,6 +352,19 @@ ReadyToBootHandler (
                 );
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // From here on, also flush a little while after the last write,
+  // rather than only when the next image is loaded or on reset.
+  //
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  DumpVarsOnEvent,
+                  NULL,
+                  &mFvInstance->FlushEvent
+                );
+  ASSERT_EFI_ERROR (Status);
+
   DumpVars ();
   Status = gBS->CloseEvent (Event);
   ASSERT_EFI_ERROR (Status);
@@ -304,6 +417,7 @@ OnSimpleFileSystemInstall (
   UINTN HandleSize;
   EFI_HANDLE Handle;
   EFI_DEVICE_PATH_PROTOCOL *Device;
+  UINT32 BlockSize;
 
   if ((mFvInstance->Device != NULL) &&
       !EFI_ERROR (CheckStoreExists (mFvInstance->Device))) {
@@ -329,7 +443,7 @@ OnSimpleFileSystemInstall (
 
     ASSERT_EFI_ERROR (Status);
 
-    Status = CheckStore (Handle, &Device);
+    Status = CheckStore (Handle, &Device, &BlockSize);
     if (EFI_ERROR (Status)) {
       continue;
     }
@@ -347,6 +461,7 @@ OnSimpleFileSystemInstall (
 
     DEBUG ((DEBUG_INFO, "Found variable store!\n"));
     mFvInstance->Device = Device;
+    mFvInstance->FlushAlignment = BlockSize;
     break;
   }
 }
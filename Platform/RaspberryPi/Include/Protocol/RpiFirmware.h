@@ -171,6 +171,25 @@ EFI_STATUS
   UINTN State
   );
 
+//
+// One property tag of a batched mailbox query. Value holds the request
+// data on input and the response on output; ResponseSize is the length
+// the firmware reported, or 0 if it did not answer the tag.
+//
+typedef struct {
+  UINT32    TagId;
+  UINT32    ValueSize;
+  VOID      *Value;
+  UINT32    ResponseSize;
+} RPI_FIRMWARE_PROPERTY;
+
+typedef
+EFI_STATUS
+(EFIAPI *QUERY_PROPERTIES) (
+  IN OUT RPI_FIRMWARE_PROPERTY *Properties,
+  IN     UINTN                 Count
+  );
+
 typedef struct {
   SET_POWER_STATE        SetPowerState;
   GET_MAC_ADDRESS        GetMacAddress;
@@ -197,6 +216,7 @@ typedef struct {
   GET_CLOCK_STATE        GetClockState;
   SET_CLOCK_STATE        SetClockState;
   GPIO_SET_CFG           SetGpioConfig;
+  QUERY_PROPERTIES       QueryProperties;
 } RASPBERRY_PI_FIRMWARE_PROTOCOL;
 
 extern EFI_GUID gRaspberryPiFirmwareProtocolGuid;
@@ -178,6 +178,26 @@ BOOLEAN
   IN  EFI_MMC_HOST_PROTOCOL     *This
   );
 
+/*
+ * Whether the host can run pre-defined multi-block transfers, i.e. ones
+ * whose length was set by a preceding CMD23 and that need no CMD12.
+ */
+typedef
+BOOLEAN
+(EFIAPI *MMC_ISSETBLOCKCOUNT) (
+  IN  EFI_MMC_HOST_PROTOCOL     *This
+  );
+
+/*
+ * Maximum number of blocks the host can move with a single read or write
+ * command.
+ */
+typedef
+UINTN
+(EFIAPI *MMC_GETMAXBLOCKCOUNT) (
+  IN  EFI_MMC_HOST_PROTOCOL     *This
+  );
+
 struct _EFI_MMC_HOST_PROTOCOL {
   UINT32                  Revision;
   MMC_ISCARDPRESENT       IsCardPresent;
@@ -194,13 +214,21 @@ struct _EFI_MMC_HOST_PROTOCOL {
 
   MMC_SETIOS              SetIos;
   MMC_ISMULTIBLOCK        IsMultiBlock;
-};
 
-#define MMC_HOST_PROTOCOL_REVISION    0x00010002    // 1.2
+  MMC_ISSETBLOCKCOUNT     IsSetBlockCount;
+  MMC_GETMAXBLOCKCOUNT    GetMaxBlockCount;
+};
 
-#define MMC_HOST_HAS_SETIOS(Host)       (Host->Revision >= MMC_HOST_PROTOCOL_REVISION && \
-                                         Host->SetIos != NULL)
-#define MMC_HOST_HAS_ISMULTIBLOCK(Host) (Host->Revision >= MMC_HOST_PROTOCOL_REVISION && \
-                                         Host->IsMultiBlock != NULL)
+#define MMC_HOST_PROTOCOL_REVISION_1_2  0x00010002    // 1.2
+#define MMC_HOST_PROTOCOL_REVISION      0x00010003    // 1.3
+
+#define MMC_HOST_HAS_SETIOS(Host)           (Host->Revision >= MMC_HOST_PROTOCOL_REVISION_1_2 && \
+                                             Host->SetIos != NULL)
+#define MMC_HOST_HAS_ISMULTIBLOCK(Host)     (Host->Revision >= MMC_HOST_PROTOCOL_REVISION_1_2 && \
+                                             Host->IsMultiBlock != NULL)
+#define MMC_HOST_HAS_ISSETBLOCKCOUNT(Host)  (Host->Revision >= MMC_HOST_PROTOCOL_REVISION && \
+                                             Host->IsSetBlockCount != NULL)
+#define MMC_HOST_HAS_GETMAXBLOCKCOUNT(Host) (Host->Revision >= MMC_HOST_PROTOCOL_REVISION && \
+                                             Host->GetMaxBlockCount != NULL)
 
 #endif /* __RASPBERRY_PI_MMC_HOST_PROTOCOL_H__ */
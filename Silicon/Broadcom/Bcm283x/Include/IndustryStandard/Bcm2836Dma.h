@@ -0,0 +1,86 @@
+/** @file
+ *
+ *  Copyright (c) 2019, ARM Limited. All rights reserved.
+ *  Copyright (c) 2017, Andrei Warkentin <andrey.warkentin@gmail.com>
+ *  Copyright (c) 2016, Linaro Limited. All rights reserved.
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#ifndef __BCM2836_DMA_H__
+#define __BCM2836_DMA_H__
+
+#include <IndustryStandard/Bcm2836.h>
+
+/*
+ * Channels 0-14 are spaced 0x100 apart starting at DMA0, channel 15 lives
+ * elsewhere. Channels 7 and up are "lite" channels, limited to 64KB
+ * transfers.
+ */
+#define BCM2836_DMA_CHANNEL_BASE_ADDRESS(Chan)  (BCM2836_DMA0_BASE_ADDRESS + ((Chan) * BCM2836_DMA_CHANNEL_LENGTH))
+#define BCM2836_DMA_MAX_FULL_CHANNEL            6
+
+/* per-channel registers */
+#define BCM2836_DMA_CS                          0x00000000
+#define BCM2836_DMA_CONBLK_AD                   0x00000004
+#define BCM2836_DMA_TI                          0x00000008
+#define BCM2836_DMA_SOURCE_AD                   0x0000000c
+#define BCM2836_DMA_DEST_AD                     0x00000010
+#define BCM2836_DMA_TXFR_LEN                    0x00000014
+#define BCM2836_DMA_STRIDE                      0x00000018
+#define BCM2836_DMA_NEXTCONBK                   0x0000001c
+#define BCM2836_DMA_DEBUG                       0x00000020
+
+/* global registers, relative to BCM2836_DMA_CTRL_BASE_ADDRESS */
+#define BCM2836_DMA_INT_STATUS                  0x00000000
+#define BCM2836_DMA_ENABLE                      0x00000010
+
+/* CS */
+#define BCM2836_DMA_CS_ACTIVE                   BIT0
+#define BCM2836_DMA_CS_END                      BIT1
+#define BCM2836_DMA_CS_INT                      BIT2
+#define BCM2836_DMA_CS_DREQ                     BIT3
+#define BCM2836_DMA_CS_PAUSED                   BIT4
+#define BCM2836_DMA_CS_ERROR                    BIT8
+#define BCM2836_DMA_CS_PRIORITY(X)              (((X) & 0xF) << 16)
+#define BCM2836_DMA_CS_PANIC_PRIORITY(X)        (((X) & 0xF) << 20)
+#define BCM2836_DMA_CS_WAIT_FOR_WRITES          BIT28
+#define BCM2836_DMA_CS_DISDEBUG                 BIT29
+#define BCM2836_DMA_CS_ABORT                    BIT30
+#define BCM2836_DMA_CS_RESET                    BIT31
+
+/* TI */
+#define BCM2836_DMA_TI_INTEN                    BIT0
+#define BCM2836_DMA_TI_WAIT_RESP                BIT3
+#define BCM2836_DMA_TI_DEST_INC                 BIT4
+#define BCM2836_DMA_TI_DEST_WIDTH               BIT5
+#define BCM2836_DMA_TI_DEST_DREQ                BIT6
+#define BCM2836_DMA_TI_SRC_INC                  BIT8
+#define BCM2836_DMA_TI_SRC_WIDTH                BIT9
+#define BCM2836_DMA_TI_SRC_DREQ                 BIT10
+#define BCM2836_DMA_TI_BURST_LENGTH(X)          (((X) & 0xF) << 12)
+#define BCM2836_DMA_TI_PERMAP(X)                (((X) & 0x1F) << 16)
+#define BCM2836_DMA_TI_WAITS(X)                 (((X) & 0x1F) << 21)
+#define BCM2836_DMA_TI_NO_WIDE_BURSTS           BIT26
+
+/* DREQ peripheral mappings */
+#define BCM2836_DMA_DREQ_SDHOST                 13
+
+/*
+ * Control blocks must be 256-bit aligned, and all addresses in them are
+ * VC bus addresses.
+ */
+#define BCM2836_DMA_CONTROL_BLOCK_ALIGNMENT     32
+
+typedef struct {
+  UINT32  TransferInfo;
+  UINT32  SourceAddress;
+  UINT32  DestinationAddress;
+  UINT32  TransferLength;
+  UINT32  Stride;
+  UINT32  NextControlBlock;
+  UINT32  Reserved[2];
+} BCM2836_DMA_CONTROL_BLOCK;
+
+#endif /* __BCM2836_DMA_H__ */
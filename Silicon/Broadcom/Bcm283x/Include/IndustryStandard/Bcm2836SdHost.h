@@ -32,6 +32,13 @@
 #define SDHOST_DATA                 SDHOST_REG(0x40)
 #define SDHOST_HBLC                 SDHOST_REG(0x50)
 
+// VC bus view of the data port, for use by the DMA engine
+#define SDHOST_BUS_BASE_ADDRESS     0x7E202000
+#define SDHOST_DATA_BUS_ADDRESS     (SDHOST_BUS_BASE_ADDRESS + 0x40)
+
+// Number of 32-bit words held by the data FIFO
+#define SDHOST_FIFO_WORDS           16
+
 //
 // CMD
 //
@@ -78,6 +85,8 @@
 // EDM
 //
 #define SDHOST_EDM_FIFO_CLEAR               BIT21
+#define SDHOST_EDM_FIFO_COUNT_SHIFT         4
+#define SDHOST_EDM_FIFO_COUNT_MASK          0x1F
 #define SDHOST_EDM_WRITE_THRESHOLD_SHIFT    9
 #define SDHOST_EDM_READ_THRESHOLD_SHIFT     14
 #define SDHOST_EDM_THRESHOLD_MASK           0x1F
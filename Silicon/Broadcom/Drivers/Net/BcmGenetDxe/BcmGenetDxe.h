@@ -114,6 +114,13 @@
 #define GENET_DMA_DESC_COUNT                    256
 #define GENET_DMA_DESC_SIZE                     12
 #define GENET_DMA_DEFAULT_QUEUE                 16
+#define GENET_DMA_BUFFER_SIZE                   (GENET_MAX_PACKET_SIZE * GENET_DMA_DESC_COUNT)
+
+//
+// Number of received frames after which the RX consumer index is written
+// back to the hardware. Pending updates are also posted when the ring is idle.
+//
+#define GENET_RX_CONS_INDEX_BATCH               8
 
 #define GENET_DMA_RING_SIZE                     0x40
 #define GENET_DMA_RINGS_SIZE                    (GENET_DMA_RING_SIZE * (GENET_DMA_DEFAULT_QUEUE + 1))
@@ -217,17 +224,23 @@ typedef struct {
   GENERIC_PHY_PRIVATE_DATA            Phy;
 
   UINT8                               *TxBuffer[GENET_DMA_DESC_COUNT];
-  VOID                                *TxBufferMap[GENET_DMA_DESC_COUNT];
+  VOID                                *TxBounceBuffer;
+  GENET_MAP_INFO                      TxBounceBufferMap;
   UINT8                               TxQueued;
   UINT16                              TxNext;
   UINT16                              TxConsIndex;
   UINT16                              TxProdIndex;
 
-  EFI_PHYSICAL_ADDRESS                RxBuffer;
-  GENET_MAP_INFO                      RxBufferMap[GENET_DMA_DESC_COUNT];
+  VOID                                *RxBuffer;
+  GENET_MAP_INFO                      RxBufferMap;
   UINT16                              RxConsIndex;
+  UINT16                              RxConsIndexPosted;
   UINT16                              RxProdIndex;
 
+  EFI_NETWORK_STATISTICS              Stats;
+  UINT64                              TxTicks;
+  UINT64                              RxTicks;
+
   GENET_PHY_MODE                      PhyMode;
 
   UINTN                               RegBase;
@@ -244,7 +257,10 @@ extern CONST EFI_ADAPTER_INFORMATION_PROTOCOL gGenetAdapterInfoTemplate;
 #define GENET_PRIVATE_DATA_FROM_SNP_THIS(a)   CR(a, GENET_PRIVATE_DATA, Snp, GENET_DRIVER_SIGNATURE)
 #define GENET_PRIVATE_DATA_FROM_AIP_THIS(a)   CR(a, GENET_PRIVATE_DATA, Aip, GENET_DRIVER_SIGNATURE)
 
-#define GENET_RX_BUFFER(g, idx)               ((UINT8 *)(UINTN)(g)->RxBuffer + GENET_MAX_PACKET_SIZE * (idx))
+#define GENET_RX_BUFFER(g, idx)               ((UINT8 *)(g)->RxBuffer + GENET_MAX_PACKET_SIZE * (idx))
+#define GENET_RX_BUFFER_DMA(g, idx)           ((g)->RxBufferMap.PhysAddress + GENET_MAX_PACKET_SIZE * (idx))
+#define GENET_TX_BUFFER(g, idx)               ((UINT8 *)(g)->TxBounceBuffer + GENET_MAX_PACKET_SIZE * (idx))
+#define GENET_TX_BUFFER_DMA(g, idx)           ((g)->TxBounceBufferMap.PhysAddress + GENET_MAX_PACKET_SIZE * (idx))
 
 EFI_STATUS
 EFIAPI
@@ -341,18 +357,6 @@ GenetDmaTriggerTx (
   IN UINTN                NumberOfBytes
   );
 
-EFI_STATUS
-GenetDmaMapRxDescriptor (
-  IN GENET_PRIVATE_DATA *Genet,
-  IN UINT8              DescIndex
-  );
-
-VOID
-GenetDmaUnmapRxDescriptor (
-  IN GENET_PRIVATE_DATA *Genet,
-  IN UINT8               DescIndex
-  );
-
 VOID
 GenetTxIntr (
   IN GENET_PRIVATE_DATA *Genet,
@@ -381,4 +385,9 @@ GenetRxComplete (
   IN GENET_PRIVATE_DATA *Genet
   );
 
+VOID
+GenetResetStatistics (
+  IN GENET_PRIVATE_DATA *Genet
+  );
+
 #endif /* GENET_UTIL_H__ */
@@ -161,6 +161,8 @@ GenetDriverBindingStart (
   Genet->Phy.ResetAction               = GenetPhyResetAction;
   Genet->PhyMode                       = GENET_PHY_MODE_RGMII_RXID;
 
+  GenetResetStatistics (Genet);
+
   EfiInitializeLock (&Genet->Lock, TPL_CALLBACK);
   CopyMem (&Genet->Snp, &gGenetSimpleNetworkTemplate, sizeof Genet->Snp);
   CopyMem (&Genet->Aip, &gGenetAdapterInfoTemplate, sizeof Genet->Aip);
@@ -200,7 +202,7 @@ GenetDriverBindingStart (
     DEBUG ((DEBUG_WARN,
       "GenetDriverBindingStart: failed to register for ExitBootServices event - %r\n",
       Status));
-    goto FreeDevice;
+    goto FreeDma;
   }
 
   Status = gBS->InstallMultipleProtocolInterfaces (&ControllerHandle,
@@ -223,6 +225,8 @@ GenetDriverBindingStart (
 
 FreeEvent:
   gBS->CloseEvent (Genet->ExitBootServicesEvent);
+FreeDma:
+  GenetDmaFree (Genet);
 FreeDevice:
   DEBUG ((DEBUG_WARN, "%a: Returning %r\n", __FUNCTION__, Status));
   FreePool (Genet);
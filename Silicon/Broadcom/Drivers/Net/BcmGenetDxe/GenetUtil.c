@@ -7,6 +7,7 @@
 **/
 
 #include <Uefi.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/DmaLib.h>
 #include <Library/IoLib.h>
@@ -16,10 +17,6 @@
 
 #define GENET_PHY_RETRY     1000
 
-STATIC CONST
-EFI_PHYSICAL_ADDRESS   mDmaAddressLimit = FixedPcdGet64 (PcdDmaDeviceLimit) -
-                                          FixedPcdGet64 (PcdDmaDeviceOffset);
-
 /**
   Read a memory-mapped device CSR.
 
@@ -540,6 +537,7 @@ GenetDmaInitRings (
   )
 {
   UINT8 Qid;
+  UINTN Idx;
 
   Qid = GENET_DMA_DEFAULT_QUEUE;
 
@@ -549,8 +547,18 @@ GenetDmaInitRings (
   Genet->TxProdIndex = 0;
 
   Genet->RxConsIndex = 0;
+  Genet->RxConsIndexPosted = 0;
   Genet->RxProdIndex = 0;
 
+  // The RX buffers stay mapped, each descriptor owns a fixed slot
+  for (Idx = 0; Idx < GENET_DMA_DESC_COUNT; Idx++) {
+    GenetMmioWrite (Genet, GENET_RX_DESC_ADDRESS_LO (Idx),
+      GENET_RX_BUFFER_DMA (Genet, Idx) & 0xFFFFFFFF);
+    GenetMmioWrite (Genet, GENET_RX_DESC_ADDRESS_HI (Idx),
+      (GENET_RX_BUFFER_DMA (Genet, Idx) >> 32) & 0xFFFFFFFF);
+    GenetMmioWrite (Genet, GENET_RX_DESC_STATUS (Idx), 0);
+  }
+
   // Configure TX queue
   GenetMmioWrite (Genet, GENET_TX_SCB_BURST_SIZE, 0x08);
   GenetMmioWrite (Genet, GENET_TX_DMA_READ_PTR_LO (Qid), 0);
@@ -598,98 +606,114 @@ GenetDmaInitRings (
 }
 
 /**
-  Allocate DMA buffers for RX.
+  Allocate and map a DMA buffer shared with the controller for the lifetime
+  of the driver.
 
-  @param  Genet[in]  Pointer to GENET_PRIVATE_DATA.
+  @param  Buffer[out]   Location to store the host address of the buffer.
+  @param  MapInfo[out]  Location to store the device address and mapping.
 
-  @retval EFI_SUCCESS           DMA buffers allocated.
-  @retval EFI_OUT_OF_RESOURCES  DMA buffers could not be allocated.
+  @retval EFI_SUCCESS           DMA buffer allocated and mapped.
+  @retval EFI_OUT_OF_RESOURCES  DMA buffer could not be allocated.
+  @retval Others                DMA buffer could not be mapped.
 **/
+STATIC
 EFI_STATUS
-GenetDmaAlloc (
-  IN GENET_PRIVATE_DATA   *Genet
+GenetDmaAllocCommonBuffer (
+  OUT VOID                **Buffer,
+  OUT GENET_MAP_INFO      *MapInfo
   )
 {
   EFI_STATUS              Status;
+  UINTN                   DmaNumberOfBytes;
 
-  Genet->RxBuffer = mDmaAddressLimit;
-  Status = gBS->AllocatePages (AllocateMaxAddress, EfiBootServicesData,
-                  EFI_SIZE_TO_PAGES (GENET_MAX_PACKET_SIZE * GENET_DMA_DESC_COUNT),
-                  &Genet->RxBuffer);
+  Status = DmaAllocateBuffer (EfiBootServicesData,
+             EFI_SIZE_TO_PAGES (GENET_DMA_BUFFER_SIZE), Buffer);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR,
-      "%a: Failed to allocate RX buffer: %r\n", __FUNCTION__, Status));
+    return Status;
+  }
+
+  DmaNumberOfBytes = GENET_DMA_BUFFER_SIZE;
+  Status = DmaMap (MapOperationBusMasterCommonBuffer, *Buffer,
+             &DmaNumberOfBytes, &MapInfo->PhysAddress, &MapInfo->Mapping);
+  if (!EFI_ERROR (Status) &&
+      (DmaNumberOfBytes != GENET_DMA_BUFFER_SIZE ||
+       MapInfo->PhysAddress + GENET_DMA_BUFFER_SIZE - 1 >
+       FixedPcdGet64 (PcdDmaDeviceLimit))) {
+    DmaUnmap (MapInfo->Mapping);
+    Status = EFI_UNSUPPORTED;
+  }
+  if (EFI_ERROR (Status)) {
+    DmaFreeBuffer (EFI_SIZE_TO_PAGES (GENET_DMA_BUFFER_SIZE), *Buffer);
+    *Buffer = NULL;
+    MapInfo->Mapping = NULL;
   }
   return Status;
 }
 
 /**
-  Given an RX buffer descriptor index, program the IO address of the buffer into the hardware.
+  Undo GenetDmaAllocCommonBuffer.
 
-  @param  Genet[in]      Pointer to GENET_PRIVATE_DATA.
-  @param  DescIndex[in]  Index of RX buffer descriptor.
+  @param  Buffer[in,out]   Location of the host address of the buffer.
+  @param  MapInfo[in,out]  Device address and mapping of the buffer.
 
-  @retval EFI_SUCCESS  DMA buffers allocated.
-  @retval Others       Programmatic errors, as buffers come from DmaAllocateBuffer, and thus
-                       cannot fail DmaMap (for the expected NonCoherentDmaLib).
 **/
-EFI_STATUS
-GenetDmaMapRxDescriptor (
-  IN GENET_PRIVATE_DATA * Genet,
-  IN UINT8                DescIndex
+STATIC
+VOID
+GenetDmaFreeCommonBuffer (
+  IN OUT VOID             **Buffer,
+  IN OUT GENET_MAP_INFO   *MapInfo
   )
 {
-  EFI_STATUS    Status;
-  UINTN         DmaNumberOfBytes;
-
-  ASSERT (Genet->RxBufferMap[DescIndex].Mapping == NULL);
-  ASSERT (Genet->RxBuffer != 0);
-
-  DmaNumberOfBytes = GENET_MAX_PACKET_SIZE;
-  Status = DmaMap (MapOperationBusMasterWrite,
-             GENET_RX_BUFFER (Genet, DescIndex),
-             &DmaNumberOfBytes,
-             &Genet->RxBufferMap[DescIndex].PhysAddress,
-             &Genet->RxBufferMap[DescIndex].Mapping);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: Failed to map RX buffer: %r\n",
-      __FUNCTION__, Status));
-    return Status;
+  if (MapInfo->Mapping != NULL) {
+    DmaUnmap (MapInfo->Mapping);
+    MapInfo->Mapping = NULL;
+  }
+  if (*Buffer != NULL) {
+    DmaFreeBuffer (EFI_SIZE_TO_PAGES (GENET_DMA_BUFFER_SIZE), *Buffer);
+    *Buffer = NULL;
   }
-
-  GenetMmioWrite (Genet, GENET_RX_DESC_ADDRESS_LO (DescIndex),
-    Genet->RxBufferMap[DescIndex].PhysAddress & 0xFFFFFFFF);
-  GenetMmioWrite (Genet, GENET_RX_DESC_ADDRESS_HI (DescIndex),
-    (Genet->RxBufferMap[DescIndex].PhysAddress >> 32) & 0xFFFFFFFF);
-  GenetMmioWrite (Genet, GENET_RX_DESC_STATUS (DescIndex), 0);
-
-  return EFI_SUCCESS;
 }
 
 /**
-  Given an RX buffer descriptor index, undo the DmaMap operation on the buffer.
+  Allocate DMA buffers for RX and TX.
 
-  @param  Genet[in]      Pointer to GENET_PRIVATE_DATA.
-  @param  DescIndex[in]  Index of RX buffer descriptor.
+  The RX ring and the TX bounce buffers are mapped once here and recycled
+  for every frame, so that the data path does no map/unmap or cache
+  maintenance.
+
+  @param  Genet[in]  Pointer to GENET_PRIVATE_DATA.
 
+  @retval EFI_SUCCESS           DMA buffers allocated.
+  @retval EFI_OUT_OF_RESOURCES  DMA buffers could not be allocated.
 **/
-VOID
-GenetDmaUnmapRxDescriptor (
-  IN GENET_PRIVATE_DATA * Genet,
-  IN UINT8                DescIndex
+EFI_STATUS
+GenetDmaAlloc (
+  IN GENET_PRIVATE_DATA   *Genet
   )
 {
-  if (Genet->RxBufferMap[DescIndex].Mapping != NULL) {
-    DmaUnmap (Genet->RxBufferMap[DescIndex].Mapping);
-    Genet->RxBufferMap[DescIndex].Mapping = NULL;
+  EFI_STATUS              Status;
+
+  Status = GenetDmaAllocCommonBuffer (&Genet->RxBuffer, &Genet->RxBufferMap);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR,
+      "%a: Failed to allocate RX buffer: %r\n", __FUNCTION__, Status));
+    return Status;
+  }
+
+  Status = GenetDmaAllocCommonBuffer (&Genet->TxBounceBuffer,
+             &Genet->TxBounceBufferMap);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR,
+      "%a: Failed to allocate TX buffer: %r\n", __FUNCTION__, Status));
+    GenetDmaFreeCommonBuffer (&Genet->RxBuffer, &Genet->RxBufferMap);
   }
+  return Status;
 }
 
 /**
-  Free DMA buffers for RX, undoing GenetDmaAlloc.
+  Free DMA buffers for RX and TX, undoing GenetDmaAlloc.
 
   @param  Genet[in]      Pointer to GENET_PRIVATE_DATA.
-  @param  DescIndex[in]  Index of RX buffer descriptor.
 
 **/
 VOID
@@ -697,13 +721,8 @@ GenetDmaFree (
   IN GENET_PRIVATE_DATA *Genet
   )
 {
-  UINTN Idx;
-
-  for (Idx = 0; Idx < GENET_DMA_DESC_COUNT; Idx++) {
-    GenetDmaUnmapRxDescriptor (Genet, Idx);
-  }
-  gBS->FreePages (Genet->RxBuffer,
-         EFI_SIZE_TO_PAGES (GENET_MAX_PACKET_SIZE * GENET_DMA_DESC_COUNT));
+  GenetDmaFreeCommonBuffer (&Genet->TxBounceBuffer, &Genet->TxBounceBufferMap);
+  GenetDmaFreeCommonBuffer (&Genet->RxBuffer, &Genet->RxBufferMap);
 }
 
 /**
@@ -758,7 +777,6 @@ GenetTxIntr (
 
   Total = GenetTxPending (Genet);
   if (Genet->TxQueued > 0 && Total > 0) {
-    DmaUnmap (Genet->TxBufferMap[Genet->TxNext]);
     *TxBuf = Genet->TxBuffer[Genet->TxNext];
     Genet->TxQueued--;
     Genet->TxNext = (Genet->TxNext + 1) % GENET_DMA_DESC_COUNT;
@@ -774,11 +792,6 @@ GenetRxPending (
   )
 {
   UINT32 ProdIndex;
-  UINT32 ConsIndex;
-
-  ConsIndex = GenetMmioRead (Genet,
-                GENET_RX_DMA_CONS_INDEX (GENET_DMA_DEFAULT_QUEUE)) & 0xFFFF;
-  ASSERT (ConsIndex == Genet->RxConsIndex);
 
   ProdIndex = GenetMmioRead (Genet,
                 GENET_RX_DMA_PROD_INDEX (GENET_DMA_DEFAULT_QUEUE)) & 0xFFFF;
@@ -798,14 +811,44 @@ GenetTxPending (
   return (ConsIndex - Genet->TxConsIndex) & 0xFFFF;
 }
 
+/**
+  Write the RX consumer index back to the hardware, returning the consumed
+  descriptors to the controller.
+
+  @param  Genet[in]  Pointer to GENET_PRIVATE_DATA.
+
+**/
+STATIC
+VOID
+GenetRxPostConsIndex (
+  IN GENET_PRIVATE_DATA *Genet
+  )
+{
+  if (Genet->RxConsIndexPosted != Genet->RxConsIndex) {
+    GenetMmioWrite (Genet, GENET_RX_DMA_CONS_INDEX (GENET_DMA_DEFAULT_QUEUE),
+                    Genet->RxConsIndex);
+    Genet->RxConsIndexPosted = Genet->RxConsIndex;
+  }
+}
+
+/**
+  Release the RX descriptor at the consumer index. The hardware consumer
+  index is updated every GENET_RX_CONS_INDEX_BATCH frames, or by GenetRxIntr
+  once the ring is drained.
+
+  @param  Genet[in]  Pointer to GENET_PRIVATE_DATA.
+
+**/
 VOID
 GenetRxComplete (
   IN GENET_PRIVATE_DATA *Genet
   )
 {
   Genet->RxConsIndex = (Genet->RxConsIndex + 1) & 0xFFFF;
-  GenetMmioWrite (Genet, GENET_RX_DMA_CONS_INDEX (GENET_DMA_DEFAULT_QUEUE),
-                  Genet->RxConsIndex);
+  if (((Genet->RxConsIndex - Genet->RxConsIndexPosted) & 0xFFFF) >=
+      GENET_RX_CONS_INDEX_BATCH) {
+    GenetRxPostConsIndex (Genet);
+  }
 }
 
 /**
@@ -838,8 +881,37 @@ GenetRxIntr (
     *FrameLength = SHIFTOUT (DescStatus, GENET_RX_DESC_STATUS_BUFLEN);
     Status = EFI_SUCCESS;
   } else {
+    GenetRxPostConsIndex (Genet);
     Status = EFI_NOT_READY;
   }
 
   return Status;
 }
+
+/**
+  Reset the SNP statistics, marking the counters the driver does not
+  maintain as unsupported.
+
+  @param  Genet[in]  Pointer to GENET_PRIVATE_DATA.
+
+**/
+VOID
+GenetResetStatistics (
+  IN GENET_PRIVATE_DATA *Genet
+  )
+{
+  SetMem (&Genet->Stats, sizeof (Genet->Stats), 0xFF);
+
+  Genet->Stats.RxTotalFrames     = 0;
+  Genet->Stats.RxGoodFrames      = 0;
+  Genet->Stats.RxUndersizeFrames = 0;
+  Genet->Stats.RxDroppedFrames   = 0;
+  Genet->Stats.RxTotalBytes      = 0;
+  Genet->Stats.TxTotalFrames     = 0;
+  Genet->Stats.TxGoodFrames      = 0;
+  Genet->Stats.TxDroppedFrames   = 0;
+  Genet->Stats.TxTotalBytes      = 0;
+
+  Genet->TxTicks = 0;
+  Genet->RxTicks = 0;
+}
@@ -9,10 +9,11 @@
 **/
 
 #include <Uefi.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
-#include <Library/DmaLib.h>
 #include <Library/NetLib.h>
+#include <Library/TimerLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Protocol/SimpleNetwork.h>
 
@@ -131,7 +132,6 @@ GenetSimpleNetworkInitialize (
 {
   GENET_PRIVATE_DATA  *Genet;
   EFI_STATUS          Status;
-  UINTN               Idx;
 
   if (This == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -156,14 +156,6 @@ GenetSimpleNetworkInitialize (
 
   GenetDmaInitRings (Genet);
 
-  // Map RX buffers
-  for (Idx = 0; Idx < GENET_DMA_DESC_COUNT; Idx++) {
-    Status = GenetDmaMapRxDescriptor (Genet, Idx);
-    if (EFI_ERROR (Status)) {
-      return Status;
-    }
-  }
-
   GenetEnableTxRx (Genet);
 
   Genet->SnpMode.State = EfiSimpleNetworkInitialized;
@@ -239,7 +231,6 @@ GenetSimpleNetworkShutdown (
   )
 {
   GENET_PRIVATE_DATA  *Genet;
-  UINTN               Idx;
 
   if (This == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -255,9 +246,16 @@ GenetSimpleNetworkShutdown (
 
   GenetDisableTxRx (Genet);
 
-  for (Idx = 0; Idx < GENET_DMA_DESC_COUNT; Idx++) {
-    GenetDmaUnmapRxDescriptor (Genet, Idx);
-  }
+  DEBUG ((DEBUG_INFO, "%a: TX %lu frames %lu bytes, %lu ns/frame\n", __FUNCTION__,
+    Genet->Stats.TxGoodFrames, Genet->Stats.TxTotalBytes,
+    Genet->Stats.TxGoodFrames == 0 ? 0 :
+      DivU64x64Remainder (GetTimeInNanoSecond (Genet->TxTicks),
+        Genet->Stats.TxGoodFrames, NULL)));
+  DEBUG ((DEBUG_INFO, "%a: RX %lu frames %lu bytes, %lu ns/frame\n", __FUNCTION__,
+    Genet->Stats.RxGoodFrames, Genet->Stats.RxTotalBytes,
+    Genet->Stats.RxGoodFrames == 0 ? 0 :
+      DivU64x64Remainder (GetTimeInNanoSecond (Genet->RxTicks),
+        Genet->Stats.RxGoodFrames, NULL)));
 
   Genet->SnpMode.State = EfiSimpleNetworkStarted;
 
@@ -413,7 +411,44 @@ GenetSimpleNetworkStatistics (
   OUT EFI_NETWORK_STATISTICS     *StatisticsTable OPTIONAL
   )
 {
-  return EFI_UNSUPPORTED;
+  GENET_PRIVATE_DATA  *Genet;
+  EFI_STATUS          Status;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (!Reset && StatisticsSize == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (StatisticsSize != NULL && *StatisticsSize != 0 && StatisticsTable == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Genet = GENET_PRIVATE_DATA_FROM_SNP_THIS (This);
+  if (Genet->SnpMode.State == EfiSimpleNetworkStopped) {
+    return EFI_NOT_STARTED;
+  }
+  if (Genet->SnpMode.State != EfiSimpleNetworkInitialized) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Status = EFI_SUCCESS;
+  if (StatisticsSize != NULL) {
+    if (*StatisticsSize < sizeof (EFI_NETWORK_STATISTICS)) {
+      Status = EFI_BUFFER_TOO_SMALL;
+    }
+    if (*StatisticsSize != 0) {
+      CopyMem (StatisticsTable, &Genet->Stats,
+        MIN (*StatisticsSize, sizeof (EFI_NETWORK_STATISTICS)));
+    }
+    *StatisticsSize = sizeof (EFI_NETWORK_STATISTICS);
+  }
+
+  if (Reset && !EFI_ERROR (Status)) {
+    GenetResetStatistics (Genet);
+  }
+
+  return Status;
 }
 
 /**
@@ -572,9 +607,8 @@ GenetSimpleNetworkTransmit (
   EFI_STATUS          Status;
   UINT8               *Frame = Buffer;
   UINT8               Desc;
-  PHYSICAL_ADDRESS    DmaDeviceAddress;
-  UINTN               DmaNumberOfBytes;
   INTN                Retries;
+  UINT64              StartTicks;
 
   if (This == NULL || Buffer == NULL) {
     DEBUG ((DEBUG_ERROR, "%a: Invalid parameter (missing handle or buffer)\n",
@@ -635,6 +669,11 @@ GenetSimpleNetworkTransmit (
     DEBUG ((DEBUG_ERROR, "%a: Buffer too small\n", __FUNCTION__));
     return EFI_BUFFER_TOO_SMALL;
   }
+  if (BufferSize > GENET_MAX_PACKET_SIZE) {
+    DEBUG ((DEBUG_ERROR, "%a: Buffer too large (0x%X)\n", __FUNCTION__,
+      BufferSize));
+    return EFI_INVALID_PARAMETER;
+  }
 
   Status = EfiAcquireLockOrFail (&Genet->Lock);
   if (EFI_ERROR (Status)) {
@@ -642,7 +681,11 @@ GenetSimpleNetworkTransmit (
     return EFI_ACCESS_DENIED;
   }
 
+  StartTicks = GetPerformanceCounter ();
+  Genet->Stats.TxTotalFrames++;
+
   if (Genet->TxQueued == GENET_DMA_DESC_COUNT - 1) {
+    Genet->Stats.TxDroppedFrames++;
     EfiReleaseLock (&Genet->Lock);
 
     DEBUG ((DEBUG_ERROR, "%a: Queue full\n", __FUNCTION__));
@@ -658,24 +701,21 @@ GenetSimpleNetworkTransmit (
 
   Desc = Genet->TxProdIndex % GENET_DMA_DESC_COUNT;
 
+  //
+  // The frame is copied to the pre-mapped bounce buffer of the descriptor,
+  // the caller's buffer is still only recycled once the descriptor completes.
+  //
   Genet->TxBuffer[Desc] = Frame;
-
-  DmaNumberOfBytes = BufferSize;
-  Status = DmaMap (MapOperationBusMasterRead,
-                   (VOID *)(UINTN)Frame,
-                   &DmaNumberOfBytes,
-                   &DmaDeviceAddress,
-                   &Genet->TxBufferMap[Desc]);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: DmaMap failed: %r\n", __FUNCTION__, Status));
-    EfiReleaseLock (&Genet->Lock);
-    return Status;
-  }
+  CopyMem (GENET_TX_BUFFER (Genet, Desc), Frame, BufferSize);
 
   Genet->TxProdIndex = (Genet->TxProdIndex + 1) & 0xFFFF;
-  GenetDmaTriggerTx (Genet, Desc, DmaDeviceAddress, DmaNumberOfBytes);
+  GenetDmaTriggerTx (Genet, Desc, GENET_TX_BUFFER_DMA (Genet, Desc), BufferSize);
   Genet->TxQueued++;
 
+  Genet->Stats.TxGoodFrames++;
+  Genet->Stats.TxTotalBytes += BufferSize;
+  Genet->TxTicks += GetPerformanceCounter () - StartTicks;
+
   EfiReleaseLock (&Genet->Lock);
 
   return EFI_SUCCESS;
@@ -730,6 +770,7 @@ GenetSimpleNetworkReceive (
   UINT8               DescIndex;
   UINT8               *Frame;
   UINTN               FrameLength;
+  UINT64              StartTicks;
 
   DescIndex   = 0;
   FrameLength = 0;
@@ -754,15 +795,15 @@ GenetSimpleNetworkReceive (
     return EFI_ACCESS_DENIED;
   }
 
+  StartTicks = GetPerformanceCounter ();
+
   Status = GenetRxIntr (Genet, &DescIndex, &FrameLength);
   if (EFI_ERROR (Status)) {
     EfiReleaseLock (&Genet->Lock);
     return Status;
   }
 
-  ASSERT (Genet->RxBufferMap[DescIndex].Mapping != NULL);
-
-  GenetDmaUnmapRxDescriptor (Genet, DescIndex);
+  Genet->Stats.RxTotalFrames++;
 
   Frame = GENET_RX_BUFFER (Genet, DescIndex);
 
@@ -775,6 +816,8 @@ GenetSimpleNetworkReceive (
       DEBUG ((DEBUG_ERROR,
         "%a: Buffer size (0x%X) is too small for frame (0x%X)\n",
         __FUNCTION__, *BufferSize, FrameLength));
+      Genet->Stats.RxDroppedFrames++;
+      *BufferSize = FrameLength;
       Status = EFI_BUFFER_TOO_SMALL;
       goto out;
     }
@@ -795,21 +838,26 @@ GenetSimpleNetworkReceive (
     CopyMem (Buffer, Frame, FrameLength);
     *BufferSize = FrameLength;
 
+    Genet->Stats.RxGoodFrames++;
+    Genet->Stats.RxTotalBytes += FrameLength;
     Status = EFI_SUCCESS;
   } else {
     DEBUG ((DEBUG_ERROR, "%a: Short packet (FrameLength 0x%X)",
       __FUNCTION__, FrameLength));
+    Genet->Stats.RxUndersizeFrames++;
     Status = EFI_NOT_READY;
   }
 
 out:
-  Status = GenetDmaMapRxDescriptor (Genet, DescIndex);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: Failed to remap RX descriptor!\n", __FUNCTION__));
-  }
-
+  //
+  // The RX buffer stays mapped, the descriptor is simply handed back.
+  //
   GenetRxComplete (Genet);
 
+  if (!EFI_ERROR (Status)) {
+    Genet->RxTicks += GetPerformanceCounter () - StartTicks;
+  }
+
   EfiReleaseLock (&Genet->Lock);
   return Status;
 }
@@ -127,6 +127,10 @@
 #define SLOT_ENTRIES                    8192
 #define PHY_CNT                         8
 #define MAX_ITCT_ENTRIES                1
+// Completion poll period while non-blocking commands are outstanding
+#define SAS_POLL_INTERVAL               EFI_TIMER_PERIOD_MILLISECONDS (1)
+// How long Stop waits for non-blocking commands before aborting them
+#define SAS_STOP_TIMEOUT_US             1000000
 
 // Completion header
 #define CMPLT_HDR_IPTT_OFF              0
@@ -257,6 +261,11 @@ UINT32 status[260];
 
 struct hisi_sas_slot {
     BOOLEAN used;
+    BOOLEAN sense;
+    EFI_STATUS status;
+    VOID *buffer_map;
+    EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET *packet;
+    EFI_EVENT event;
 };
 
 struct hisi_hba {
@@ -274,6 +283,7 @@ struct hisi_hba {
     int port_id;
     UINT32 LatestTargetId;
     UINT64 LatestLun;
+    UINT32 async_pending;
 };
 
 #pragma pack (1)
@@ -296,9 +306,199 @@ typedef struct {
 #define SAS_DEVICE_SIGNATURE SIGNATURE_32 ('S','A','S','0')
 #define SAS_FROM_PASS_THRU(a) CR (a, SAS_V1_INFO, ExtScsiPassThru, SAS_DEVICE_SIGNATURE)
 
+/*
+ * Release a slot once its command is over, and signal the caller's event for
+ * a non-blocking command.
+ */
+STATIC VOID sas_slot_finish (
+  struct hisi_hba *hba,
+  struct hisi_sas_slot *slot
+  )
+{
+  if (slot->buffer_map) {
+    DmaUnmap (slot->buffer_map);
+    slot->buffer_map = NULL;
+  }
+
+  slot->used = FALSE;
+  if (slot->event != NULL) {
+    hba->async_pending--;
+    gBS->SignalEvent (slot->event);
+    slot->event = NULL;
+  }
+}
+
+/*
+ * Retire one completion queue entry. The slot index is the IPTT the command
+ * was tagged with in prepare_cmd.
+ */
+STATIC VOID sas_slot_complete (
+  struct hisi_hba *hba,
+  UINT32 slot_idx,
+  UINT32 data
+  )
+{
+  struct hisi_sas_slot *slot;
+  struct hisi_sas_sts *sts;
+  EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET *Packet;
+  EFI_SCSI_SENSE_DATA *SensePtr;
+  UINT8 *p;
+
+  if (slot_idx >= QUEUE_CNT * QUEUE_SLOTS || !hba->slots[slot_idx].used) {
+    DEBUG ((EFI_D_ERROR, "sas stale completion iptt=0x%x\n", slot_idx));
+    return;
+  }
+
+  slot = &hba->slots[slot_idx];
+  sts = &hba->status_buf[slot_idx / QUEUE_SLOTS][slot_idx % QUEUE_SLOTS];
+  slot->status = EFI_SUCCESS;
+
+  // Check whether dma transfer error
+  if ((data & CMPLT_HDR_ERR_RCRD_XFRD_MSK) &&
+    !(data & CMPLT_HDR_RSPNS_XFRD_MSK)) {
+    DEBUG ((EFI_D_VERBOSE, "sas retry data=0x%x\n", data));
+    DEBUG ((EFI_D_VERBOSE, "sts[0]=0x%x\n", sts->status[0]));
+    DEBUG ((EFI_D_VERBOSE, "sts[1]=0x%x\n", sts->status[1]));
+    DEBUG ((EFI_D_VERBOSE, "sts[2]=0x%x\n", sts->status[2]));
+    slot->status = EFI_NOT_READY;
+  }
+
+  p = (UINT8 *)&sts->status[0];
+  slot->sense = (p[SENSE_DATA_PRES] != 0);
+  Packet = slot->packet;
+  SensePtr = Packet->SenseData;
+  if (slot->sense && SensePtr) {
+    // Disk not ready normal return for ScsiDiskTestUnitReady do next try
+    SensePtr->Sense_Key = EFI_SCSI_SK_NOT_READY;
+    SensePtr->Addnl_Sense_Code = EFI_SCSI_ASC_NOT_READY;
+    SensePtr->Addnl_Sense_Code_Qualifier = EFI_SCSI_ASCQ_IN_PROGRESS;
+  }
+
+  // Report the outcome in the packet, non-blocking callers only have this
+  Packet->HostAdapterStatus = EFI_ERROR (slot->status) ?
+                              EFI_EXT_SCSI_STATUS_HOST_ADAPTER_OTHER :
+                              EFI_EXT_SCSI_STATUS_HOST_ADAPTER_OK;
+  Packet->TargetStatus = slot->sense ?
+                         EFI_EXT_SCSI_STATUS_TARGET_CHECK_CONDITION :
+                         EFI_EXT_SCSI_STATUS_TARGET_GOOD;
+  if (slot->sense && SensePtr) {
+    Packet->SenseDataLength = (UINT8)MIN (Packet->SenseDataLength,
+                                          sizeof (EFI_SCSI_SENSE_DATA));
+  } else {
+    Packet->SenseDataLength = 0;
+  }
+  if (EFI_ERROR (slot->status) || slot->sense) {
+    Packet->InTransferLength = 0;
+    Packet->OutTransferLength = 0;
+  }
+
+  sas_slot_finish (hba, slot);
+}
+
+/*
+ * Drain every completion queue that has raised its interrupt source, so a
+ * single pass retires all commands finished since the last one. Must be
+ * called at TPL_NOTIFY.
+ */
+STATIC UINTN sas_poll_cq (
+  struct hisi_hba *hba
+  )
+{
+  UINT32 pending, rd, wr, data;
+  UINT32 base = hba->base;
+  UINTN retired = 0;
+  int queue;
+
+  pending = READ_REG32(base, OQ_INT_SRC);
+  if (pending == 0) {
+    return 0;
+  }
+
+  // Clear int before draining, a completion landing meanwhile raises it again
+  WRITE_REG32(base, OQ_INT_SRC, pending);
+
+  for (queue = 0; queue < QUEUE_CNT; queue++) {
+    if (!(pending & BIT(queue))) {
+      continue;
+    }
+
+    rd = READ_REG32(base, COMPL_Q_0_RD_PTR + (0x14 * queue));
+    wr = READ_REG32(base, COMPL_Q_0_WR_PTR + (0x14 * queue));
+    // Ensure entries are read after the write pointer
+    MemoryFence ();
+
+    while (rd != wr) {
+      data = hba->complete_hdr[queue][rd].data;
+      sas_slot_complete (hba, (data & CMPLT_HDR_IPTT_MSK) >> CMPLT_HDR_IPTT_OFF, data);
+      rd = (rd + 1) % QUEUE_SLOTS;
+      retired++;
+    }
+
+    // Update read point
+    WRITE_REG32(base, COMPL_Q_0_RD_PTR + (0x14 * queue), rd);
+  }
+
+  return retired;
+}
+
+/*
+ * Give outstanding non-blocking commands a bounded time to complete, then
+ * stop the controller and fail the rest, so no slot keeps a DMA mapping or
+ * an unsignalled event. Must be called at TPL_NOTIFY.
+ */
+STATIC VOID sas_drain (
+  struct hisi_hba *hba
+  )
+{
+  struct hisi_sas_slot *slot;
+  UINTN Timeout;
+  int i;
+
+  for (Timeout = SAS_STOP_TIMEOUT_US; Timeout > 0 && hba->async_pending != 0; Timeout--) {
+    sas_poll_cq (hba);
+    MicroSecondDelay (1);
+  }
+  if (hba->async_pending == 0) {
+    return;
+  }
+
+  DEBUG ((EFI_D_ERROR, "sas aborting %u pending command(s)\n", hba->async_pending));
+
+  // Stop accepting commands and reset the phys so nothing is in flight
+  WRITE_REG32(hba->base, DLVRY_QUEUE_ENABLE, 0);
+  for (i = 0; i < PHY_CNT; i++) {
+    UINT32 phy_ctrl = PHY_READ_REG32(hba->base, PHY_CTRL, i);
+
+    phy_ctrl |= PHY_CTRL_RESET;
+    PHY_WRITE_REG32(hba->base, PHY_CTRL, i, phy_ctrl);
+  }
+  // spec says safe to wait 50us after reset
+  MicroSecondDelay(50);
+
+  for (i = 0; i < SLOT_ENTRIES; i++) {
+    slot = &hba->slots[i];
+    if (!slot->used) {
+      continue;
+    }
+    slot->status = EFI_DEVICE_ERROR;
+    slot->packet->HostAdapterStatus = EFI_EXT_SCSI_STATUS_HOST_ADAPTER_TIMEOUT_COMMAND;
+    slot->packet->TargetStatus = EFI_EXT_SCSI_STATUS_TARGET_GOOD;
+    slot->packet->SenseDataLength = 0;
+    slot->packet->InTransferLength = 0;
+    slot->packet->OutTransferLength = 0;
+    sas_slot_finish (hba, slot);
+  }
+}
+
+/*
+ * Queue one command on the next delivery queue with a free slot and start
+ * it, without waiting for completion. Must be called at TPL_NOTIFY.
+ */
 STATIC EFI_STATUS prepare_cmd (
   struct hisi_hba *hba,
-  EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET    *Packet
+  EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET    *Packet,
+  EFI_EVENT                                     Event,
+  UINT32                                        *SlotIdx
   )
 {
   struct hisi_sas_slot *slot;
@@ -312,9 +512,8 @@ STATIC EFI_STATUS prepare_cmd (
   int queue = hba->queue;
   UINT32 r, w = 0, slot_idx = 0;
   UINT32 base = hba->base;
-  UINT8 *p;
   EFI_PHYSICAL_ADDRESS  BufferAddress;
-  EFI_STATUS            Status = EFI_SUCCESS;
+  EFI_STATUS            Status;
   VOID                  *BufferMap = NULL;
   DMA_MAP_OPERATION DmaOperation = MapOperationBusMasterCommonBuffer;
 
@@ -344,7 +543,6 @@ STATIC EFI_STATUS prepare_cmd (
   if (SensePtr)
     ZeroMem (SensePtr, sizeof (EFI_SCSI_SENSE_DATA));
 
-  slot->used = TRUE;
   hba->queue = (queue + 1) % QUEUE_CNT;
 
   // Only consider ssp
@@ -410,58 +608,21 @@ STATIC EFI_STATUS prepare_cmd (
     hdr->sg_len = i << CMD_HDR_DATA_SGL_LEN_OFF;
   }
 
+  slot->used = TRUE;
+  slot->sense = FALSE;
+  slot->status = EFI_SUCCESS;
+  slot->buffer_map = BufferMap;
+  slot->packet = Packet;
+  slot->event = Event;
+  *SlotIdx = slot_idx;
+
   // Ensure descriptor effective before start dma
   MemoryFence();
 
   // Start dma
   WRITE_REG32(base, DLVRY_Q_0_WR_PTR + queue * 0x14, ++w % QUEUE_SLOTS);
 
-  // Wait for dma complete
-  while (slot->used) {
-    if (READ_REG32(base, OQ_INT_SRC) & BIT(queue)) {
-      struct hisi_sas_complete_hdr *complete_hdr;
-      UINT32 data, rd;
-      rd = READ_REG32(base, COMPL_Q_0_RD_PTR + (0x14 * queue));
-
-      complete_hdr = &hba->complete_hdr[queue][rd];
-      data = complete_hdr->data;
-
-      // Check whether dma transfer error
-      if ((data & CMPLT_HDR_ERR_RCRD_XFRD_MSK) &&
-        !(data & CMPLT_HDR_RSPNS_XFRD_MSK)) {
-        DEBUG ((EFI_D_VERBOSE, "sas retry data=0x%x\n", data));
-        DEBUG ((EFI_D_VERBOSE, "sts[0]=0x%x\n", sts->status[0]));
-        DEBUG ((EFI_D_VERBOSE, "sts[1]=0x%x\n", sts->status[1]));
-        DEBUG ((EFI_D_VERBOSE, "sts[2]=0x%x\n", sts->status[2]));
-        Status = EFI_NOT_READY;
-        // wait 1 second and retry, some disk need long time to be ready
-        // and ScsiDisk treat retry over 3 times as error
-        MicroSecondDelay(1000000);
-      }
-       // Update read point
-       WRITE_REG32(base, COMPL_Q_0_RD_PTR + (0x14 * queue), w);
-       // Clear int
-       WRITE_REG32(base, OQ_INT_SRC, BIT(queue));
-       slot->used = FALSE;
-       break;
-    }
-    // Wait for status change in polling
-    NanoSecondDelay (100);
-  }
-
-  if (BufferMap)
-       DmaUnmap (BufferMap);
-
-  p = (UINT8 *)&sts->status[0];
-  if (p[SENSE_DATA_PRES]) {
-    // Disk not ready normal return for ScsiDiskTestUnitReady do next try
-    SensePtr->Sense_Key = EFI_SCSI_SK_NOT_READY;
-    SensePtr->Addnl_Sense_Code = EFI_SCSI_ASC_NOT_READY;
-    SensePtr->Addnl_Sense_Code_Qualifier = EFI_SCSI_ASCQ_IN_PROGRESS;
-    // wait 1 second for disk spin up, refer drivers/scsi/sd.c
-    MicroSecondDelay(1000000);
-  }
-  return Status;
+  return EFI_SUCCESS;
 }
 
 STATIC VOID hisi_sas_v1_init(struct hisi_hba *hba, PLATFORM_SAS_PROTOCOL *plat)
@@ -671,8 +832,70 @@ SasV1ExtScsiPassThruFunction (
 {
   SAS_V1_INFO *SasV1Info = SAS_FROM_PASS_THRU(This);
   struct hisi_hba *hba = SasV1Info->hba;
+  struct hisi_sas_slot *slot;
+  EFI_STATUS Status;
+  EFI_TPL OldTpl;
+  UINT32 slot_idx;
+  BOOLEAN sense = FALSE;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Status = prepare_cmd (hba, Packet, Event, &slot_idx);
+  if (!EFI_ERROR (Status) && Event != NULL) {
+    // Non-blocking: the poll timer retires the command and signals Event
+    if (hba->async_pending++ == 0) {
+      gBS->SetTimer (SasV1Info->TimerEvent, TimerPeriodic, SAS_POLL_INTERVAL);
+    }
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  if (EFI_ERROR (Status) || Event != NULL) {
+    return Status;
+  }
+
+  // Wait for dma complete, retiring any other finished commands on the way
+  slot = &hba->slots[slot_idx];
+  while (TRUE) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    sas_poll_cq (hba);
+    if (!slot->used) {
+      Status = slot->status;
+      sense = slot->sense;
+      gBS->RestoreTPL (OldTpl);
+      break;
+    }
+    gBS->RestoreTPL (OldTpl);
+
+    // Wait for status change in polling
+    NanoSecondDelay (100);
+  }
+
+  if (Status == EFI_NOT_READY) {
+    // wait 1 second and retry, some disk need long time to be ready
+    // and ScsiDisk treat retry over 3 times as error
+    MicroSecondDelay(1000000);
+  }
+  if (sense) {
+    // wait 1 second for disk spin up, refer drivers/scsi/sd.c
+    MicroSecondDelay(1000000);
+  }
+  return Status;
+}
 
-  return prepare_cmd(hba, Packet);
+STATIC
+VOID
+EFIAPI
+SasV1TimerHandler (
+  IN EFI_EVENT                          Event,
+  IN VOID                               *Context
+  )
+{
+  SAS_V1_INFO *SasV1Info = Context;
+  struct hisi_hba *hba = SasV1Info->hba;
+
+  sas_poll_cq (hba);
+  if (hba->async_pending == 0) {
+    gBS->SetTimer (SasV1Info->TimerEvent, TimerCancel, 0);
+  }
 }
 
 STATIC
@@ -877,6 +1100,15 @@ SasDriverBindingStart (
 
   sas_init(SasV1Info, plat);
 
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  SasV1TimerHandler,
+                  SasV1Info,
+                  &SasV1Info->TimerEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
   // Wait for sas controller phyup happen
   MicroSecondDelay(100000);
 
@@ -916,7 +1148,9 @@ SasDriverBindingStart (
 
   CopyMem (&SasV1Info->ExtScsiPassThru, &SasV1ExtScsiPassThruProtocolTemplate, sizeof (EFI_EXT_SCSI_PASS_THRU_PROTOCOL));
   SasV1Info->ExtScsiPassThruMode.AdapterId = 2;
-  SasV1Info->ExtScsiPassThruMode.Attributes = EFI_EXT_SCSI_PASS_THRU_ATTRIBUTES_PHYSICAL | EFI_EXT_SCSI_PASS_THRU_ATTRIBUTES_LOGICAL;
+  SasV1Info->ExtScsiPassThruMode.Attributes = EFI_EXT_SCSI_PASS_THRU_ATTRIBUTES_PHYSICAL |
+                                              EFI_EXT_SCSI_PASS_THRU_ATTRIBUTES_LOGICAL |
+                                              EFI_EXT_SCSI_PASS_THRU_ATTRIBUTES_NONBLOCKIO;
   SasV1Info->ExtScsiPassThruMode.IoAlign  = 64; //cache line align
   SasV1Info->ExtScsiPassThru.Mode = &SasV1Info->ExtScsiPassThruMode;
 
@@ -955,6 +1189,7 @@ SasDriverBindingStop (
   SAS_V1_INFO *SasV1Info;
   EFI_STATUS Status;
   EFI_EXT_SCSI_PASS_THRU_PROTOCOL *ExtScsi;
+  EFI_TPL OldTpl;
   int i, s;
 
   Status = gBS->OpenProtocol (
@@ -986,7 +1221,12 @@ SasDriverBindingStop (
            Controller
            );
 
+    // Non-blocking commands may still own DMA mappings into the queues
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    sas_drain (SasV1Info->hba);
+    gBS->SetTimer (SasV1Info->TimerEvent, TimerCancel, 0);
     gBS->CloseEvent (SasV1Info->TimerEvent);
+    gBS->RestoreTPL (OldTpl);
 
     for (i = 0; i < QUEUE_CNT; i++) {
       s = sizeof(struct hisi_sas_cmd_hdr) * QUEUE_SLOTS;
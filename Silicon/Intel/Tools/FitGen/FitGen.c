@@ -257,11 +257,10 @@ typedef struct {
 
 #pragma pack ()
 
-#define MAX_BIOS_MODULE_ENTRY  0x20
-#define MAX_MICROCODE_ENTRY    0x20
-#define MAX_STARTUP_ACM_ENTRY  0x20
-#define MAX_OPTIONAL_ENTRY     0x20
-#define MAX_PORT_ENTRY         0x20
+//
+// Initial number of entries of each growable FIT context array
+//
+#define FIT_CONTEXT_INITIAL_ENTRIES  0x20
 
 #define DEFAULT_FIT_TABLE_POINTER_OFFSET  0x40
 #define DEFAULT_FIT_ENTRY_VERSION         0x0100
@@ -323,24 +322,151 @@ typedef struct {
   UINT32                     PortModuleNumber;
   UINT32                     GlobalVersion;
   UINT32                     FitHeaderVersion;
-  FIT_TABLE_CONTEXT_ENTRY    StartupAcm[MAX_STARTUP_ACM_ENTRY];
+  FIT_TABLE_CONTEXT_ENTRY    *StartupAcm;
+  UINT32                     StartupAcmCapacity;
   UINT32                     StartupAcmFvSize;
   FIT_TABLE_CONTEXT_ENTRY    DiagnstAcm;
   UINT32                     DiagnstAcmVersion;
   FIT_TABLE_CONTEXT_ENTRY    ProtBootPolicy;
-  FIT_TABLE_CONTEXT_ENTRY    BiosModule[MAX_BIOS_MODULE_ENTRY];
+  FIT_TABLE_CONTEXT_ENTRY    *BiosModule;
+  UINT32                     BiosModuleCapacity;
   UINT32                     BiosModuleVersion;
-  FIT_TABLE_CONTEXT_ENTRY    Microcode[MAX_MICROCODE_ENTRY];
+  FIT_TABLE_CONTEXT_ENTRY    *Microcode;
+  UINT32                     MicrocodeCapacity;
   BOOLEAN                    MicrocodeIsAligned;
   UINT32                     MicrocodeAlignValue;
   UINT32                     MicrocodeVersion;
-  FIT_TABLE_CONTEXT_ENTRY    OptionalModule[MAX_OPTIONAL_ENTRY];
-  FIT_TABLE_CONTEXT_ENTRY    PortModule[MAX_PORT_ENTRY];
+  FIT_TABLE_CONTEXT_ENTRY    *OptionalModule;
+  UINT32                     OptionalModuleCapacity;
+  FIT_TABLE_CONTEXT_ENTRY    *PortModule;
+  UINT32                     PortModuleCapacity;
   UINT64                     TopFlashAddressRemapValue;
 } FIT_TABLE_CONTEXT;
 
 FIT_TABLE_CONTEXT   gFitTableContext = {0};
 
+//
+// Make sure the next entry of one of the FIT context arrays can be written,
+// e.g. RESERVE_FIT_CONTEXT_ENTRY (Microcode) before filling
+// gFitTableContext.Microcode[gFitTableContext.MicrocodeNumber].
+//
+#define RESERVE_FIT_CONTEXT_ENTRY(Field) \
+          ReserveFitContextEntry (&gFitTableContext.Field, &gFitTableContext.Field##Capacity, gFitTableContext.Field##Number)
+
+//
+// Index of the FVs and FFS files of the input image, built once after the
+// image is loaded. FindNextFvHeader and FindFileFromFvByGuid serve whole-FD
+// and whole-FV requests from it instead of rescanning the image for every
+// GUID given on the command line.
+//
+#define FFS_INDEX_NONE            0xFFFFFFFF
+#define FFS_INDEX_MIN_BUCKETS     0x10
+
+typedef struct {
+  UINT8     *FvHeader;
+  UINT32    FvLength;
+} FV_INDEX_ENTRY;
+
+typedef struct {
+  EFI_GUID  Name;
+  UINT8     *Data;       // File data, right after the FFS header
+  UINT32    DataSize;
+  UINT32    FvIndex;
+  UINT32    Next;        // Next file in the same hash bucket, in FD order
+} FFS_INDEX_ENTRY;
+
+typedef struct {
+  UINT8            *Buffer;
+  UINTN            Size;
+  FV_INDEX_ENTRY   *Fv;
+  UINT32           FvNumber;
+  FFS_INDEX_ENTRY  *File;
+  UINT32           FileNumber;
+  UINT32           *Bucket;
+  UINT32           BucketMask;
+} FD_INDEX;
+
+FD_INDEX            gFdIndex = {0};
+
+//
+// --profile support
+//
+BOOLEAN             gProfile = FALSE;
+UINT64              gProfileStart;
+UINT64              gProfileLast;
+
+//
+// Input files are mapped copy-on-write where the host supports it, so only
+// the pages FitGen modifies are ever copied. --no-mmap forces plain reads.
+//
+#define INPUT_FILE_ALIGNMENT      0x10000
+#define PATCH_CHUNK_SIZE          0x1000
+
+typedef struct _MAPPED_FILE {
+  struct _MAPPED_FILE  *Next;
+  VOID                 *Base;
+  UINTN                Length;
+  UINT64               Device;
+  UINT64               Inode;
+} MAPPED_FILE;
+
+MAPPED_FILE         *gMappedFiles = NULL;
+BOOLEAN             gNoMmap       = FALSE;
+//
+// --inplace: only the byte ranges that differ from the existing output file
+// are written back.
+//
+BOOLEAN             gInPlace      = FALSE;
+
+//
+// Microcode checksums are verified by up to --threads worker threads (one
+// per online CPU by default, 1 means sequential). --report writes the
+// microcode and StartupAcm validation results as JSON.
+//
+#define MAX_VALIDATION_THREADS             16
+
+#define MICROCODE_HEADER_SIZE              48
+#define MICROCODE_DEFAULT_DATA_SIZE        2000
+#define MICROCODE_DEFAULT_TOTAL_SIZE       2048
+#define MICROCODE_EXT_TABLE_HEADER_SIZE    20
+#define MICROCODE_EXT_SIGNATURE_SIZE       12
+
+typedef enum {
+  ValidationNotChecked,
+  ValidationPassed,
+  ValidationFailed,
+  ValidationOutOfRange
+} VALIDATION_STATUS;
+
+typedef struct {
+  UINT8              *Buffer;
+  UINT32             MaxSize;
+  UINT32             Address;
+  VALIDATION_STATUS  Status;
+  UINT32             Revision;
+  UINT32             ProcessorSignature;
+  UINT32             TotalSize;
+  UINT32             ExtendedSignatureCount;
+  CONST CHAR8        *Reason;
+} MICROCODE_VALIDATION;
+
+typedef struct {
+  UINT32             Address;
+  UINT32             Size;
+  VALIDATION_STATUS  Status;
+} ACM_VALIDATION;
+
+typedef struct {
+  UINT32                MicrocodeNumber;
+  MICROCODE_VALIDATION  *Microcode;
+  UINT32                AcmNumber;
+  ACM_VALIDATION        *Acm;
+} VALIDATION_RESULT;
+
+VALIDATION_RESULT   gValidation        = {0};
+UINT32              gValidationThreads = 0;
+CHAR8               *gReportFileName   = NULL;
+
 unsigned int
 xtoi (
   char  *str
@@ -468,6 +594,7 @@ PrintUsage (
           "\t[-P RecordType <IndexPort DataPort Width Bit Index> [-V <RecordVersion>]] [-P ... [-V ...]]\n"
           "\t[-BP <BootPolicySize>[-V <BootPolicyVersion>]\n"
           "\t[-T <FixedFitLocation>]\n"
+          "\t[--profile] [--no-mmap] [--inplace] [--threads <ThreadNumber>] [--report <ReportFile>]\n"
           , UTILITY_NAME);
   printf ("  Where:\n");
   printf ("\t-D                     - It is FD file instead of FV file. (The tool will search FV file)\n");
@@ -517,6 +644,11 @@ PrintUsage (
   printf ("\tBit                    - The Bit Number of the port.\n");
   printf ("\tIndex                  - The Index Number of the port.\n");
   printf ("\tFixedFitLocation       - Fixed FIT location in flash address. FIT table will be generated at this location and Option Modules will be directly put right before it.\n");
+  printf ("\t--profile              - Report the wall time spent in each phase.\n");
+  printf ("\t--no-mmap              - Read input files into memory instead of mapping them.\n");
+  printf ("\t--inplace              - Only write the byte ranges that differ from the existing output file.\n");
+  printf ("\t--threads              - Number of threads verifying the Microcode checksums. One per CPU as default, 1 is sequential.\n");
+  printf ("\t--report               - Write the Microcode and StartupAcm validation results to ReportFile as JSON.\n");
   printf ("\nUsage (view): %s [-view] InputFile -F <FitTablePointerOffset>\n", UTILITY_NAME);
   printf ("  Where:\n");
   printf ("\tInputFile              - Name of the input file.\n");
@@ -623,13 +755,141 @@ GetFixedFitLocation (
   return FitLocation;
 }
 
+/**
+  Map an open input file copy-on-write.
+
+  @param FpIn                        The open input file.
+  @param FileSize                    The input file size.
+  @param Alignment                   Required alignment of the data, 0 for none.
+  @param FileData                    The input file data.
+  @param FileBufferRaw               The start of the mapping, to be released
+                                     with FreeFileBuffer.
+
+  @return STATUS_SUCCESS             The file is mapped.
+  @return STATUS_WARNING             The file cannot be mapped, read it instead.
+**/
+STATUS
+MapInputFile (
+  IN FILE     *FpIn,
+  IN UINT32   FileSize,
+  IN UINTN    Alignment,
+  OUT UINT8   **FileData,
+  OUT UINT8   **FileBufferRaw
+  )
+{
+#ifndef _WIN32
+  MAPPED_FILE                 *Mapped;
+  UINT8                       *Reserve;
+  UINT8                       *Data;
+  UINTN                       Length;
+  struct stat                 Stat;
+
+  if (gNoMmap || (FileSize == 0) || (fstat (fileno (FpIn), &Stat) != 0)) {
+    return STATUS_WARNING;
+  }
+
+  //
+  // Reserve room for the alignment, then map the file over the aligned part
+  //
+  Length  = FileSize + Alignment;
+  Reserve = mmap (NULL, Length, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (Reserve == MAP_FAILED) {
+    return STATUS_WARNING;
+  }
+  Data = Reserve;
+  if (Alignment != 0) {
+    Data = (UINT8 *)(((UINTN)Reserve + Alignment - 1) & ~(Alignment - 1));
+  }
+  if (mmap (Data, FileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fileno (FpIn), 0) == MAP_FAILED) {
+    munmap (Reserve, Length);
+    return STATUS_WARNING;
+  }
+
+  Mapped = malloc (sizeof (MAPPED_FILE));
+  if (Mapped == NULL) {
+    munmap (Reserve, Length);
+    return STATUS_WARNING;
+  }
+  Mapped->Base   = Reserve;
+  Mapped->Length = Length;
+  Mapped->Device = (UINT64)Stat.st_dev;
+  Mapped->Inode  = (UINT64)Stat.st_ino;
+  Mapped->Next   = gMappedFiles;
+  gMappedFiles   = Mapped;
+
+  *FileData      = Data;
+  *FileBufferRaw = Reserve;
+  return STATUS_SUCCESS;
+#else
+  return STATUS_WARNING;
+#endif
+}
+
+/**
+  Check whether a file is one of the currently mapped input files.
+
+  @param FileName                    The file name.
+
+  @retval TRUE                       The file is mapped.
+  @retval FALSE                      The file is not mapped or does not exist.
+**/
+BOOLEAN
+IsMappedFile (
+  IN CHAR8    *FileName
+  )
+{
+#ifndef _WIN32
+  MAPPED_FILE                 *Mapped;
+  struct stat                 Stat;
+
+  if (stat (FileName, &Stat) != 0) {
+    return FALSE;
+  }
+
+  for (Mapped = gMappedFiles; Mapped != NULL; Mapped = Mapped->Next) {
+    if ((Mapped->Device == (UINT64)Stat.st_dev) && (Mapped->Inode == (UINT64)Stat.st_ino)) {
+      return TRUE;
+    }
+  }
+#endif
+  return FALSE;
+}
+
+/**
+  Release a buffer returned by ReadInputFile or allocated with malloc.
+
+  @param Buffer                      The buffer, may be NULL.
+**/
+VOID
+FreeFileBuffer (
+  IN VOID     *Buffer
+  )
+{
+#ifndef _WIN32
+  MAPPED_FILE                 **Link;
+  MAPPED_FILE                 *Mapped;
+
+  for (Link = &gMappedFiles; *Link != NULL; Link = &(*Link)->Next) {
+    Mapped = *Link;
+    if (Mapped->Base == Buffer) {
+      munmap (Mapped->Base, Mapped->Length);
+      *Link = Mapped->Next;
+      free (Mapped);
+      return;
+    }
+  }
+#endif
+  free (Buffer);
+}
+
 /**
   Read input file.
 
   @param FileName                    The input file name.
   @param FileData                    The input file data, the memory is aligned.
   @param FileSize                    The input file size.
-  @param FileBufferRaw               The memory to hold input file data. The caller must free the memory.
+  @param FileBufferRaw               The memory to hold input file data. The caller must free the memory
+                                     with FreeFileBuffer (FileData if FileBufferRaw is NULL).
 
   @return STATUS_SUCCESS             The file found and data read.
   @return STATUS_ERROR               The file data is not read.
@@ -645,6 +905,8 @@ ReadInputFile (
 {
   FILE                        *FpIn;
   UINT32                      TempResult;
+  STATUS                      Status;
+  UINT8                       *MappedRaw;
 
   //
   //Check the File Path
@@ -670,6 +932,20 @@ ReadInputFile (
   //
   fseek (FpIn, 0, SEEK_END);
   *FileSize = ftell (FpIn);
+
+  //
+  // Map the file when possible, the image is only touched where the FIT goes
+  //
+  if (FileBufferRaw != NULL) {
+    Status = MapInputFile (FpIn, *FileSize, INPUT_FILE_ALIGNMENT, FileData, FileBufferRaw);
+  } else {
+    Status = MapInputFile (FpIn, *FileSize, 0, FileData, &MappedRaw);
+  }
+  if (Status == STATUS_SUCCESS) {
+    fclose (FpIn);
+    return STATUS_SUCCESS;
+  }
+
   //
   // Read the contents of input file to memory buffer
   //
@@ -711,6 +987,294 @@ ReadInputFile (
   return STATUS_SUCCESS;
 }
 
+UINT8 *
+FindNextFvHeader (
+  IN UINT8 *FileBuffer,
+  IN UINTN  FileLength
+  );
+
+/**
+  Get the current wall clock time.
+
+  @return Time in microseconds.
+**/
+UINT64
+GetWallTimeUs (
+  VOID
+  )
+{
+  struct timespec  Now;
+
+  if (timespec_get (&Now, TIME_UTC) == 0) {
+    return 0;
+  }
+  return (UINT64)Now.tv_sec * 1000000 + (UINT64)Now.tv_nsec / 1000;
+}
+
+/**
+  Report the wall time spent since the previous profile point.
+
+  @param Phase    Name of the phase that just completed.
+**/
+VOID
+ProfilePoint (
+  IN CHAR8  *Phase
+  )
+{
+  UINT64  Now;
+
+  if (!gProfile) {
+    return;
+  }
+
+  Now = GetWallTimeUs ();
+  printf ("PROFILE: %-24s %10llu us\n", Phase, (unsigned long long)(Now - gProfileLast));
+  gProfileLast = Now;
+}
+
+/**
+  Hash a GUID for the FFS index.
+
+  @param Guid     The GUID.
+
+  @return The hash value.
+**/
+UINT32
+HashGuid (
+  IN EFI_GUID  *Guid
+  )
+{
+  UINT8   *Bytes;
+  UINT32  Hash;
+  UINTN   Index;
+
+  //
+  // FNV-1a
+  //
+  Bytes = (UINT8 *)Guid;
+  Hash  = 2166136261u;
+  for (Index = 0; Index < sizeof (EFI_GUID); Index++) {
+    Hash = (Hash ^ Bytes[Index]) * 16777619u;
+  }
+  return Hash;
+}
+
+/**
+  Find the first indexed FV whose header is at or above an address.
+
+  @param Address  The address.
+
+  @return Index of the FV, gFdIndex.FvNumber if there is none.
+**/
+UINT32
+FdIndexLowerBound (
+  IN UINT8  *Address
+  )
+{
+  UINT32  Low;
+  UINT32  High;
+  UINT32  Middle;
+
+  Low  = 0;
+  High = gFdIndex.FvNumber;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if ((UINTN)gFdIndex.Fv[Middle].FvHeader < (UINTN)Address) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+  return Low;
+}
+
+/**
+  Find the first file with a GUID in a range of indexed FVs.
+
+  @param FirstFv          Index of the first FV to search.
+  @param LastFv           Index of the last FV to search.
+  @param Guid             File GUID value to be searched.
+  @param FileSize         Guid File size.
+
+  @return FileLocation    Guid File location.
+  @return NULL            Guid File is not found.
+**/
+UINT8 *
+FdIndexFindFile (
+  IN UINT32    FirstFv,
+  IN UINT32    LastFv,
+  IN EFI_GUID  *Guid,
+  OUT UINT32   *FileSize
+  )
+{
+  UINT32           Entry;
+  FFS_INDEX_ENTRY  *File;
+
+  //
+  // Bucket chains are kept in FD order, so the first hit is the file a
+  // linear walk would have returned.
+  //
+  for (Entry = gFdIndex.Bucket[HashGuid (Guid) & gFdIndex.BucketMask];
+       Entry != FFS_INDEX_NONE;
+       Entry = File->Next) {
+    File = &gFdIndex.File[Entry];
+    if ((File->FvIndex >= FirstFv) && (File->FvIndex <= LastFv) &&
+        (CompareGuid (&File->Name, Guid) == 0)) {
+      *FileSize = File->DataSize;
+      return File->Data;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Release the FV/FFS index.
+**/
+VOID
+FreeFdIndex (
+  VOID
+  )
+{
+  free (gFdIndex.Fv);
+  free (gFdIndex.File);
+  free (gFdIndex.Bucket);
+  memset (&gFdIndex, 0, sizeof (gFdIndex));
+}
+
+/**
+  Index all FVs of the image and all FFS files inside them.
+
+  The FVs are located with the same walk FindFileFromFvByGuid does, and the
+  files with the same per-FV walk, so lookups served from the index return
+  what the linear search would have.
+
+  @param FdBuffer          FD binary buffer.
+  @param FdSize            FD size.
+
+  @retval STATUS_SUCCESS   The index is built.
+  @retval STATUS_ERROR     Out of memory, lookups keep scanning the image.
+**/
+STATUS
+BuildFdIndex (
+  IN UINT8   *FdBuffer,
+  IN UINT32  FdSize
+  )
+{
+  FD_INDEX                    Index;
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+  EFI_FFS_FILE_HEADER         *FileHeader;
+  UINT64                      FvLength;
+  UINTN                       Offset;
+  UINTN                       FileLength;
+  UINT32                      Capacity;
+  UINT32                      FvCapacity;
+  UINT32                      BucketNumber;
+  UINT32                      Bucket;
+  UINT32                      Entry;
+  VOID                        *NewBuffer;
+
+  memset (&Index, 0, sizeof (Index));
+  FvCapacity = 0;
+  Capacity   = 0;
+
+  FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)FindNextFvHeader (FdBuffer, FdSize);
+  while (FvHeader != NULL) {
+    FvLength = FvHeader->FvLength;
+    if (FvLength < FvHeader->HeaderLength) {
+      break;
+    }
+
+    if (Index.FvNumber == FvCapacity) {
+      FvCapacity = (FvCapacity == 0) ? 0x10 : FvCapacity * 2;
+      NewBuffer  = realloc (Index.Fv, FvCapacity * sizeof (FV_INDEX_ENTRY));
+      if (NewBuffer == NULL) {
+        goto OutOfResources;
+      }
+      Index.Fv = NewBuffer;
+    }
+    Index.Fv[Index.FvNumber].FvHeader = (UINT8 *)FvHeader;
+    Index.Fv[Index.FvNumber].FvLength = (UINT32)FvLength;
+
+    Offset = FvHeader->HeaderLength;
+    while (Offset + sizeof (EFI_FFS_FILE_HEADER) <= FvLength) {
+      FileHeader = (EFI_FFS_FILE_HEADER *)((UINTN)FvHeader + Offset);
+      FileLength = (*(UINT32 *)(FileHeader->Size)) & 0x00FFFFFF;
+      if (FileLength < sizeof (EFI_FFS_FILE_HEADER)) {
+        break;
+      }
+
+      if (Index.FileNumber == Capacity) {
+        Capacity  = (Capacity == 0) ? 0x100 : Capacity * 2;
+        NewBuffer = realloc (Index.File, Capacity * sizeof (FFS_INDEX_ENTRY));
+        if (NewBuffer == NULL) {
+          goto OutOfResources;
+        }
+        Index.File = NewBuffer;
+      }
+      memcpy (&Index.File[Index.FileNumber].Name, &FileHeader->Name, sizeof (EFI_GUID));
+      Index.File[Index.FileNumber].Data     = (UINT8 *)FileHeader + sizeof (EFI_FFS_FILE_HEADER);
+      Index.File[Index.FileNumber].DataSize = (UINT32)(FileLength - sizeof (EFI_FFS_FILE_HEADER));
+#if (PI_SPECIFICATION_VERSION < 0x00010000)
+      if (FileHeader->Attributes & FFS_ATTRIB_TAIL_PRESENT) {
+        Index.File[Index.FileNumber].DataSize -= sizeof (EFI_FFS_FILE_TAIL);
+      }
+#endif
+      Index.File[Index.FileNumber].FvIndex  = Index.FvNumber;
+      Index.FileNumber++;
+
+      Offset += GETOCCUPIEDSIZE (FileLength, 8);
+    }
+    Index.FvNumber++;
+
+    //
+    // Next FV
+    //
+    if ((UINTN)FdBuffer + FdSize <= (UINTN)FvHeader + FvLength) {
+      break;
+    }
+    FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)FindNextFvHeader (
+                                               (UINT8 *)FvHeader + (UINTN)FvLength,
+                                               (UINTN)FdBuffer + FdSize - ((UINTN)FvHeader + (UINTN)FvLength)
+                                               );
+  }
+
+  //
+  // Hash the files, inserting from the end so each chain stays in FD order
+  //
+  BucketNumber = FFS_INDEX_MIN_BUCKETS;
+  while (BucketNumber < Index.FileNumber * 2) {
+    BucketNumber *= 2;
+  }
+  Index.Bucket = malloc (BucketNumber * sizeof (UINT32));
+  if (Index.Bucket == NULL) {
+    goto OutOfResources;
+  }
+  memset (Index.Bucket, 0xFF, BucketNumber * sizeof (UINT32));
+  Index.BucketMask = BucketNumber - 1;
+
+  for (Entry = Index.FileNumber; Entry > 0; Entry--) {
+    Bucket = HashGuid (&Index.File[Entry - 1].Name) & Index.BucketMask;
+    Index.File[Entry - 1].Next = Index.Bucket[Bucket];
+    Index.Bucket[Bucket]       = Entry - 1;
+  }
+
+  Index.Buffer = FdBuffer;
+  Index.Size   = FdSize;
+  gFdIndex     = Index;
+
+  if (gProfile) {
+    printf ("PROFILE: indexed %u FVs, %u FFS files\n", (unsigned)Index.FvNumber, (unsigned)Index.FileNumber);
+  }
+  return STATUS_SUCCESS;
+
+OutOfResources:
+  free (Index.Fv);
+  free (Index.File);
+  Error (NULL, 0, 0, "No sufficient memory to index the image, falling back to linear search!", NULL);
+  return STATUS_ERROR;
+}
+
 /**
     Find next FvHeader in the FileBuffer.
 
@@ -729,6 +1293,21 @@ FindNextFvHeader (
   UINT8                       *FileHeader;
   EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
   UINT16                      FileChecksum;
+  UINT32                      FvIndex;
+
+  //
+  // The index was built with the same walk, so a search that starts at the
+  // beginning of the FD or right after an indexed FV has a known answer.
+  //
+  if ((gFdIndex.Buffer != NULL) &&
+      ((UINTN)FileBuffer + FileLength == (UINTN)gFdIndex.Buffer + gFdIndex.Size)) {
+    FvIndex = FdIndexLowerBound (FileBuffer);
+    if ((FileBuffer == gFdIndex.Buffer) ||
+        ((FvIndex > 0) &&
+         ((UINTN)gFdIndex.Fv[FvIndex - 1].FvHeader + gFdIndex.Fv[FvIndex - 1].FvLength == (UINTN)FileBuffer))) {
+      return (FvIndex < gFdIndex.FvNumber) ? gFdIndex.Fv[FvIndex].FvHeader : NULL;
+    }
+  }
 
   FileHeader = FileBuffer;
   for (; (UINTN)FileBuffer < (UINTN)FileHeader + FileLength; FileBuffer += 8) {
@@ -801,6 +1380,25 @@ FindFileFromFvByGuid (
   UINTN                       Offset;
   UINTN                       FileLength;
   UINTN                       FileOccupiedSize;
+  UINT32                      FvIndex;
+
+  //
+  // Serve whole-FD and whole-FV lookups from the index
+  //
+  if (gFdIndex.Buffer != NULL) {
+    if ((FvBuffer == gFdIndex.Buffer) && (FvSize == gFdIndex.Size)) {
+      if (gFdIndex.FvNumber == 0) {
+        return NULL;
+      }
+      return FdIndexFindFile (0, gFdIndex.FvNumber - 1, Guid, FileSize);
+    }
+    FvIndex = FdIndexLowerBound (FvBuffer);
+    if ((FvIndex < gFdIndex.FvNumber) &&
+        (gFdIndex.Fv[FvIndex].FvHeader == FvBuffer) &&
+        (gFdIndex.Fv[FvIndex].FvLength == FvSize)) {
+      return FdIndexFindFile (FvIndex, FvIndex, Guid, FileSize);
+    }
+  }
 
   //
   // Find the FFS file
@@ -900,6 +1498,74 @@ IsGuidData (
   return TRUE;
 }
 
+/**
+  Make sure Entries[Number] of a FIT context array is valid.
+
+  The array grows by doubling, and new entries are zeroed so they look the
+  same as the entries of the former fixed size arrays.
+
+  @param Entries          Pointer to the FIT context array.
+  @param Capacity         Number of entries allocated for the array.
+  @param Number           Index of the entry that is to be written.
+
+  @retval TRUE            Entries[Number] can be written.
+  @retval FALSE           Out of memory.
+**/
+BOOLEAN
+ReserveFitContextEntry (
+  IN OUT FIT_TABLE_CONTEXT_ENTRY  **Entries,
+  IN OUT UINT32                   *Capacity,
+  IN     UINT32                   Number
+  )
+{
+  FIT_TABLE_CONTEXT_ENTRY  *NewEntries;
+  UINT32                   NewCapacity;
+
+  if (Number < *Capacity) {
+    return TRUE;
+  }
+
+  NewCapacity = (*Capacity == 0) ? FIT_CONTEXT_INITIAL_ENTRIES : *Capacity;
+  while (NewCapacity <= Number) {
+    NewCapacity *= 2;
+  }
+
+  NewEntries = realloc (*Entries, NewCapacity * sizeof (FIT_TABLE_CONTEXT_ENTRY));
+  if (NewEntries == NULL) {
+    return FALSE;
+  }
+  memset (&NewEntries[*Capacity], 0, (NewCapacity - *Capacity) * sizeof (FIT_TABLE_CONTEXT_ENTRY));
+
+  *Entries  = NewEntries;
+  *Capacity = NewCapacity;
+  return TRUE;
+}
+
+/**
+  Release the FIT context arrays.
+**/
+VOID
+FreeFitTableContext (
+  VOID
+  )
+{
+  free (gFitTableContext.StartupAcm);
+  free (gFitTableContext.BiosModule);
+  free (gFitTableContext.Microcode);
+  free (gFitTableContext.OptionalModule);
+  free (gFitTableContext.PortModule);
+  gFitTableContext.StartupAcm             = NULL;
+  gFitTableContext.StartupAcmCapacity     = 0;
+  gFitTableContext.BiosModule             = NULL;
+  gFitTableContext.BiosModuleCapacity     = 0;
+  gFitTableContext.Microcode              = NULL;
+  gFitTableContext.MicrocodeCapacity      = 0;
+  gFitTableContext.OptionalModule         = NULL;
+  gFitTableContext.OptionalModuleCapacity = 0;
+  gFitTableContext.PortModule             = NULL;
+  gFitTableContext.PortModuleCapacity     = 0;
+}
+
 /**
   Get FIT entry number and fill global FIT table context, from argument.
 
@@ -920,7 +1586,12 @@ CheckOverlap (
   INTN  Index;
 
   for (Index = 0; Index < (INTN)gFitTableContext.BiosModuleNumber; Index ++) {
+    //
+    // The range has to fit in the module, a FIT larger than the module
+    // would otherwise wrap the size difference around
+    //
     if ((gFitTableContext.BiosModule[Index].Address <= Address) &&
+        (gFitTableContext.BiosModule[Index].Size >= Size) &&
         ((gFitTableContext.BiosModule[Index].Size - Size) >= (Address - gFitTableContext.BiosModule[Index].Address))) {
       UINT32  TempSize;
       INT32   SubIndex;
@@ -929,8 +1600,8 @@ CheckOverlap (
       // Found overlap, split BiosModuleEntry
       // Currently only support StartupAcm in 1 BiosModule. It does not support StartupAcm across 2 BiosModule or more.
       //
-      if (gFitTableContext.BiosModuleNumber >= MAX_BIOS_MODULE_ENTRY) {
-        Error (NULL, 0, 0, "Too many Bios Module!", NULL);
+      if (!RESERVE_FIT_CONTEXT_ENTRY (BiosModule)) {
+        Error (NULL, 0, 0, "Out of memory for Bios Module!", NULL);
         return ;
       }
 
@@ -1044,6 +1715,8 @@ GetFitEntryNumber (
   UINT32    MicrocodeRegionOffset;
   UINT32    MicrocodeRegionSize;
   UINT32    SlotSize;
+  UINT32    AcmAddress;
+  UINT32    AcmSize;
   STATUS    Status;
   EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
   UINTN                       FitEntryNumber;
@@ -1271,8 +1944,8 @@ GetFitEntryNumber (
           Error (NULL, 0, 0, "-I Parameter incorrect, Header Type unsupported!", NULL);
           return 0;
         case FIT_TABLE_TYPE_STARTUP_ACM:
-          if (gFitTableContext.StartupAcmNumber >= MAX_STARTUP_ACM_ENTRY) {
-            Error (NULL, 0, 0, "-I Parameter incorrect, too many StartupAcm!", NULL);
+          if (!RESERVE_FIT_CONTEXT_ENTRY (StartupAcm)) {
+            Error (NULL, 0, 0, "-I: Out of memory for StartupAcm!", NULL);
             return 0;
           }
           //
@@ -1307,8 +1980,8 @@ GetFitEntryNumber (
           if ((BiosInfoStruct[BiosInfoIndex].Attributes & BIOS_INFO_STRUCT_ATTRIBUTE_BIOS_POST_IBB) != 0) {
             continue;
           }
-          if (gFitTableContext.BiosModuleNumber >= MAX_BIOS_MODULE_ENTRY) {
-            Error (NULL, 0, 0, "-I Parameter incorrect, Too many Bios Module!", NULL);
+          if (!RESERVE_FIT_CONTEXT_ENTRY (BiosModule)) {
+            Error (NULL, 0, 0, "-I: Out of memory for Bios Module!", NULL);
             return 0;
           }
           gFitTableContext.BiosModule[gFitTableContext.BiosModuleNumber].Type    = FIT_TABLE_TYPE_BIOS_MODULE;
@@ -1320,8 +1993,8 @@ GetFitEntryNumber (
           break;
         case FIT_TABLE_TYPE_MICROCODE:
           if ((BiosInfoStruct[BiosInfoIndex].Attributes & BIOS_INFO_STRUCT_ATTRIBUTE_MICROCODE_WHOLE_REGION) == 0) {
-            if (gFitTableContext.MicrocodeNumber >= MAX_MICROCODE_ENTRY) {
-              Error (NULL, 0, 0, "-I Parameter incorrect, Too many Microcode!", NULL);
+            if (!RESERVE_FIT_CONTEXT_ENTRY (Microcode)) {
+              Error (NULL, 0, 0, "-I: Out of memory for Microcode!", NULL);
               return 0;
             }
             gFitTableContext.Microcode[gFitTableContext.MicrocodeNumber].Type    = FIT_TABLE_TYPE_MICROCODE;
@@ -1393,8 +2066,8 @@ GetFitEntryNumber (
               //
               // Add Microcode
               //
-              if (gFitTableContext.MicrocodeNumber >= MAX_MICROCODE_ENTRY) {
-                printf ("-I Parameter incorrect, Too many Microcode!\n");
+              if (!RESERVE_FIT_CONTEXT_ENTRY (Microcode)) {
+                printf ("-I: Out of memory for Microcode!\n");
                 return 0;
               }
               gFitTableContext.Microcode[gFitTableContext.MicrocodeNumber].Type = FIT_TABLE_TYPE_MICROCODE;
@@ -1429,6 +2102,10 @@ GetFitEntryNumber (
               /// Split the spare space as empty buffer for save uCode patch.
               ///
               while (MicrocodeBuffer + SlotSize <= MicrocodeFileBuffer + MicrocodeFileSize) {
+                if (!RESERVE_FIT_CONTEXT_ENTRY (Microcode)) {
+                  Error (NULL, 0, 0, "-I: Out of memory for Microcode!", NULL);
+                  return 0;
+                }
                 gFitTableContext.Microcode[gFitTableContext.MicrocodeNumber].Type = FIT_TABLE_TYPE_MICROCODE;
                 gFitTableContext.Microcode[gFitTableContext.MicrocodeNumber].Address = MicrocodeBase + (UINT32)((UINTN) MicrocodeBuffer - (UINTN) MicrocodeFileBuffer);
                 gFitTableContext.MicrocodeNumber++;
@@ -1448,8 +2125,8 @@ GetFitEntryNumber (
         case FIT_TABLE_TYPE_CSE_SECURE_BOOT:
         default :
           if (BiosInfoStruct[BiosInfoIndex].Version != 0) {
-            if (gFitTableContext.OptionalModuleNumber >= MAX_OPTIONAL_ENTRY) {
-              Error (NULL, 0, 0, "-I Parameter incorrect, Too many Optional Module!", NULL);
+            if (!RESERVE_FIT_CONTEXT_ENTRY (OptionalModule)) {
+              Error (NULL, 0, 0, "-I: Out of memory for Optional Module!", NULL);
               return 0;
             }
             gFitTableContext.OptionalModule[gFitTableContext.OptionalModuleNumber].Type    = BiosInfoStruct[BiosInfoIndex].Type;
@@ -1459,8 +2136,8 @@ GetFitEntryNumber (
             gFitTableContext.OptionalModuleNumber++;
             gFitTableContext.FitEntryNumber++;
           } else {
-            if (gFitTableContext.PortModuleNumber >= MAX_PORT_ENTRY) {
-              Error (NULL, 0, 0, "-I Parameter incorrect, Too many Port Module!", NULL);
+            if (!RESERVE_FIT_CONTEXT_ENTRY (PortModule)) {
+              Error (NULL, 0, 0, "-I: Out of memory for Port Module!", NULL);
               return 0;
             }
             gFitTableContext.PortModule[gFitTableContext.PortModuleNumber].Type    = BiosInfoStruct[BiosInfoIndex].Type;
@@ -1514,8 +2191,8 @@ GetFitEntryNumber (
       FileSize = xtoi (argv[Index + 2]);
       Index += 3;
     }
-    if (gFitTableContext.StartupAcmNumber >= MAX_STARTUP_ACM_ENTRY) {
-      Error (NULL, 0, 0, "-S Parameter incorrect, too many StartupAcm!", NULL);
+    if (!RESERVE_FIT_CONTEXT_ENTRY (StartupAcm)) {
+      Error (NULL, 0, 0, "-S: Out of memory for StartupAcm!", NULL);
       return 0;
     }
     gFitTableContext.StartupAcm[gFitTableContext.StartupAcmNumber].Type = FIT_TABLE_TYPE_STARTUP_ACM;
@@ -1624,6 +2301,10 @@ GetFitEntryNumber (
       break;
     }
 
+    if (!RESERVE_FIT_CONTEXT_ENTRY (BiosModule)) {
+      Error (NULL, 0, 0, "-B: Out of memory for Bios Module!", NULL);
+      return 0;
+    }
     FileBuffer = (UINT8 *) (UINTN) xtoi (argv[Index + 1]);
     FileSize = xtoi (argv[Index + 2]);
     gFitTableContext.BiosModule[gFitTableContext.BiosModuleNumber].Type = FIT_TABLE_TYPE_BIOS_MODULE;
@@ -1641,8 +2322,8 @@ GetFitEntryNumber (
           (strcmp (argv[Index], "-b") != 0) ) {
         break;
       }
-      if (gFitTableContext.BiosModuleNumber >= MAX_BIOS_MODULE_ENTRY) {
-        Error (NULL, 0, 0, "-B Parameter incorrect, Too many Bios Module!", NULL);
+      if (!RESERVE_FIT_CONTEXT_ENTRY (BiosModule)) {
+        Error (NULL, 0, 0, "-B: Out of memory for Bios Module!", NULL);
         return 0;
       }
       FileBuffer = (UINT8 *) (UINTN) xtoi (argv[Index + 1]);
@@ -1695,8 +2376,8 @@ GetFitEntryNumber (
       FileSize = xtoi (argv[Index + 2]);
       Index += 3;
     }
-    if (gFitTableContext.MicrocodeNumber >= MAX_MICROCODE_ENTRY) {
-      Error (NULL, 0, 0, "-M Parameter incorrect, Too many Microcode!", NULL);
+    if (!RESERVE_FIT_CONTEXT_ENTRY (Microcode)) {
+      Error (NULL, 0, 0, "-M: Out of memory for Microcode!", NULL);
       return 0;
     }
     gFitTableContext.Microcode[gFitTableContext.MicrocodeNumber].Type = FIT_TABLE_TYPE_MICROCODE;
@@ -1807,8 +2488,8 @@ GetFitEntryNumber (
       //
       // Add Microcode
       //
-      if (gFitTableContext.MicrocodeNumber >= MAX_MICROCODE_ENTRY) {
-        printf ("-U Parameter incorrect, Too many Microcode!\n");
+      if (!RESERVE_FIT_CONTEXT_ENTRY (Microcode)) {
+        printf ("-U: Out of memory for Microcode!\n");
         return 0;
       }
       gFitTableContext.Microcode[gFitTableContext.MicrocodeNumber].Type = FIT_TABLE_TYPE_MICROCODE;
@@ -1821,7 +2502,7 @@ GetFitEntryNumber (
     }
 
     if (MicrocodeFileBufferRaw != NULL) {
-      free ((VOID *)MicrocodeFileBufferRaw);
+      FreeFileBuffer ((VOID *)MicrocodeFileBufferRaw);
       MicrocodeFileBufferRaw = NULL;
     }
   }
@@ -1876,7 +2557,7 @@ GetFitEntryNumber (
       if (Status == STATUS_SUCCESS) {
         if (FileSize >= 0x80000000) {
           Error (NULL, 0, 0, "-O Parameter incorrect, FileSize too large!", NULL);
-          free (FileBuffer);
+          FreeFileBuffer (FileBuffer);
           return 0;
         }
         //
@@ -1917,7 +2598,7 @@ GetFitEntryNumber (
         if (Status == STATUS_SUCCESS) {
           if (FileSize >= 0x80000000) {
             Error (NULL, 0, 0, "-O Parameter incorrect, FileSize too large!", NULL);
-            free (FileBuffer);
+            FreeFileBuffer (FileBuffer);
             return 0;
           }
           //
@@ -1972,9 +2653,9 @@ GetFitEntryNumber (
         }
       }
     }
-    if (gFitTableContext.OptionalModuleNumber >= MAX_OPTIONAL_ENTRY) {
-      Error (NULL, 0, 0, "-O Parameter incorrect, Too many Optional Module!", NULL);
-      free (FileBuffer);
+    if (!RESERVE_FIT_CONTEXT_ENTRY (OptionalModule)) {
+      Error (NULL, 0, 0, "-O: Out of memory for Optional Module!", NULL);
+      FreeFileBuffer (FileBuffer);
       return 0;
     }
     gFitTableContext.OptionalModule[gFitTableContext.OptionalModuleNumber].Type = Type;
@@ -2020,8 +2701,8 @@ GetFitEntryNumber (
     }
 
     Type = xtoi (argv[Index + 1]);
-    if (gFitTableContext.PortModuleNumber >= MAX_PORT_ENTRY) {
-      printf ("-P Parameter incorrect, Too many Port Module!\n");
+    if (!RESERVE_FIT_CONTEXT_ENTRY (PortModule)) {
+      printf ("-P: Out of memory for Port Module!\n");
       return 0;
     }
 
@@ -2074,7 +2755,17 @@ GetFitEntryNumber (
     //
     FileSize = xtoi(argv[Index + 1]);
 
-    if (gFitTableContext.StartupAcm[0].Size + FileSize > gFitTableContext.StartupAcmFvSize) {
+    //
+    // Without -S the record starts at address 0, as it always did
+    //
+    AcmAddress = 0;
+    AcmSize    = 0;
+    if (gFitTableContext.StartupAcmNumber != 0) {
+      AcmAddress = gFitTableContext.StartupAcm[0].Address;
+      AcmSize    = gFitTableContext.StartupAcm[0].Size;
+    }
+
+    if (AcmSize + FileSize > gFitTableContext.StartupAcmFvSize) {
       Error(NULL, 0, 0, "Error: not enough FV_ACM room for FIT type 04 record!", NULL);
       FitEntryNumber = 0;
     }
@@ -2088,7 +2779,7 @@ GetFitEntryNumber (
     SetMem(FileBuffer, FileSize, 0xFF);
 
     gFitTableContext.ProtBootPolicy.Type = FIT_TABLE_TYPE_PROT_BOOT_POLICY;
-    gFitTableContext.ProtBootPolicy.Address = gFitTableContext.StartupAcm[0].Address + gFitTableContext.StartupAcm[0].Size;
+    gFitTableContext.ProtBootPolicy.Address = AcmAddress + AcmSize;
     gFitTableContext.ProtBootPolicy.Size = FileSize;
     gFitTableContext.ProtBootPolicy.Version = 0;
 
@@ -2355,7 +3046,7 @@ GetFreeSpaceForFit (
         }
       }
       memcpy (OptionalModuleAddress, gFitTableContext.OptionalModule[Index].Buffer, gFitTableContext.OptionalModule[Index].Size);
-      free (gFitTableContext.OptionalModule[Index].Buffer);
+      FreeFileBuffer (gFitTableContext.OptionalModule[Index].Buffer);
       gFitTableContext.OptionalModule[Index].Address = MEMORY_TO_FLASH (OptionalModuleAddress, FvBuffer, FvSize);
     }
     //
@@ -2873,120 +3564,637 @@ GetAcmFms(
     TmpFms &= ProcessorIdList->ProcessorID[Index].FMS;
   }
 
-  *AcmMask = ~TmpMask;
-  return;
+  *AcmMask = ~TmpMask;
+  return;
+}
+
+/**
+  Check Acm information.
+
+  @param Acm          ACM buffer.
+  @param AcmMaxSize   ACM max size.
+
+  @retval TRUE    ACM is valid.
+  @retval FALSE   ACM is invalid.
+**/
+BOOLEAN
+CheckAcm (
+  IN ACM_FORMAT                        *Acm,
+  IN UINTN                             AcmMaxSize
+  )
+{
+  CHIPSET_ACM_INFORMATION_TABLE *ChipsetAcmInformationTable;
+  CHIPSET_ID_LIST               *ChipsetIdList;
+  PROCESSOR_ID_LIST             *ProcessorIdList;
+  UINT8                         *Buffer;
+
+  if (Acm->ModuleType != ACM_MODULE_TYPE_CHIPSET_ACM) {
+    printf ("ACM invalid : ModuleType!\n");
+    return FALSE;
+  }
+  if (Acm->Size * 4 > AcmMaxSize) {
+    printf ("ACM invalid : Size!\n");
+    return FALSE;
+  }
+
+  //move buffer pointer to address past generic ACM header (post scratchsize)
+  Buffer = (UINT8 *)(Acm + 1);
+  Buffer += Acm->KeySize * 4;
+  if (Acm->HeaderVersion == ACM_HEADER_VERSION_3) {
+    Buffer += ACM_PKCS_1_5_RSA_SIGNATURE_SHA384_SIZE;
+  }
+  else if ((Acm->HeaderVersion == ACM_HEADER_VERSION_4) || (Acm->HeaderVersion == ACM_HEADER_VERSION_5)) {
+    Buffer += ACM_PKCS_1_5_RSA_SIGNATURE_SHA384_SIZE;
+    Buffer += ACM_XMSS_PUBLIC_KEY_SIZE;
+    Buffer += ACM_XMSS_SIGNATURE_SIZE;
+  }
+  else {
+    Buffer += 4;
+    Buffer += ACM_PKCS_1_5_RSA_SIGNATURE_SHA256_SIZE;
+  }
+  Buffer += Acm->ScratchSize * 4;
+
+  if ((Acm->HeaderVersion == ACM_HEADER_VERSION_4) || (Acm->HeaderVersion == ACM_HEADER_VERSION_5)) {
+    Buffer += 60;  //add reserved bytes.
+  }
+
+  if ((Acm->ModuleSubType & ACM_MODULE_SUBTYPE_ANC_MODULE) == 0) {
+    ChipsetAcmInformationTable = (CHIPSET_ACM_INFORMATION_TABLE *)Buffer;
+    if ((UINTN)ChipsetAcmInformationTable >= (UINTN)Acm + AcmMaxSize) {
+      printf ("ACM invalid : ChipsetAcmInformationTable!\n");
+      return FALSE;
+    }
+
+    if (CompareGuid ((EFI_GUID *)&ChipsetAcmInformationTable->Guid, (EFI_GUID *)&mChipsetAcmInformationTableGuid03) != 0) {
+      printf ("ACM invalid : ChipsetACMGuid!\n");
+      return FALSE;
+    }
+    if (ChipsetAcmInformationTable->ChipsetACMType != CHIPSET_ACM_TYPE_BIOS) {
+      printf ("ACM invalid : ChipsetACMType!\n");
+      return FALSE;
+    }
+    if (ChipsetAcmInformationTable->Version < CHIPSET_ACM_INFORMATION_TABLE_VERSION_3) {
+      printf ("ACM invalid : ChipsetACMVersion!\n");
+      return FALSE;
+    }
+    if ((UINTN)ChipsetAcmInformationTable + ChipsetAcmInformationTable->Length > (UINTN)Acm + AcmMaxSize) {
+      printf ("ACM invalid : ChipsetACMLength!\n");
+      return FALSE;
+    }
+
+    if (ChipsetAcmInformationTable->ChipsetIDList >= AcmMaxSize) {
+      printf ("ACM invalid : ChipsetACMChipsetIDList!\n");
+      return FALSE;
+    }
+    ChipsetIdList = (CHIPSET_ID_LIST *)((UINTN)Acm + ChipsetAcmInformationTable->ChipsetIDList);
+    if (ChipsetIdList->Count == 0) {
+      printf ("ACM invalid : ChipsetACMChipsetIDListCount!\n");
+      return FALSE;
+    }
+    if (ChipsetAcmInformationTable->ChipsetIDList + sizeof(CHIPSET_ID_LIST) + (ChipsetIdList->Count - 1) * sizeof(ACM_CHIPSET_ID) > AcmMaxSize) {
+      printf ("ACM invalid : ChipsetACMChipsetIDList!\n");
+      return FALSE;
+    }
+
+    if (ChipsetAcmInformationTable->Version < CHIPSET_ACM_INFORMATION_TABLE_VERSION_4) {
+      goto End;
+    }
+
+    if (ChipsetAcmInformationTable->ProcessorIDList >= AcmMaxSize) {
+      printf ("ACM invalid : ChipsetACMProcessorIDList!\n");
+      return FALSE;
+    }
+    ProcessorIdList = (PROCESSOR_ID_LIST *)((UINTN)Acm + ChipsetAcmInformationTable->ProcessorIDList);
+    if (ProcessorIdList->Count == 0) {
+      printf ("ACM invalid : ChipsetACMProcessorIdListCount!\n");
+      return FALSE;
+    }
+    if (ChipsetAcmInformationTable->ChipsetIDList + sizeof(PROCESSOR_ID_LIST) + (ChipsetIdList->Count - 1) * sizeof(ACM_PROCESSOR_ID) > AcmMaxSize) {
+      printf ("ACM invalid : ChipsetACMProcessorIdList!\n");
+      return FALSE;
+    }
+  }
+
+End:
+
+  return TRUE;
+}
+
+/**
+  Sum a buffer as 32 bit words.
+
+  Four independent accumulators let the compiler keep several additions in
+  flight (or vectorize the loop), this is most of the validation time.
+
+  @param Buffer           Buffer to sum.
+  @param Size             Size of the buffer, in bytes.
+
+  @return The 32 bit sum of all the words of the buffer.
+**/
+UINT32
+SumMicrocodeDwords (
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Size
+  )
+{
+  CONST UINT32  *Dword;
+  UINTN         Count;
+  UINTN         Index;
+  UINT32        Sum0;
+  UINT32        Sum1;
+  UINT32        Sum2;
+  UINT32        Sum3;
+
+  Dword = (CONST UINT32 *)Buffer;
+  Count = Size / sizeof (UINT32);
+  Sum0  = 0;
+  Sum1  = 0;
+  Sum2  = 0;
+  Sum3  = 0;
+  for (Index = 0; Index + 4 <= Count; Index += 4) {
+    Sum0 += Dword[Index];
+    Sum1 += Dword[Index + 1];
+    Sum2 += Dword[Index + 2];
+    Sum3 += Dword[Index + 3];
+  }
+  for (; Index < Count; Index++) {
+    Sum0 += Dword[Index];
+  }
+
+  return Sum0 + Sum1 + Sum2 + Sum3;
+}
+
+/**
+  Validate the header, checksum and extended signature table of a microcode
+  update.
+
+  Entries without a version 1 header (e.g. the empty slots of the slot mode)
+  are left as not checked.
+
+  @param Entry            The microcode entry, Buffer and MaxSize are input.
+**/
+VOID
+ValidateMicrocode (
+  IN OUT MICROCODE_VALIDATION  *Entry
+  )
+{
+  UINT8   *Header;
+  UINT8   *ExtTable;
+  UINT8   *ExtSignature;
+  UINT32  DataSize;
+  UINT32  TotalSize;
+  UINT32  ExtSize;
+  UINT32  ExtCount;
+  UINT32  Sum;
+  UINT32  Index;
+
+  Header = Entry->Buffer;
+  if (*(UINT32 *)Header != 0x1) { // HeaderVersion
+    Entry->Status = ValidationNotChecked;
+    Entry->Reason = "No microcode header";
+    return;
+  }
+
+  Entry->Revision           = *(UINT32 *)(Header + 4);
+  Entry->ProcessorSignature = *(UINT32 *)(Header + 12);
+  DataSize                  = *(UINT32 *)(Header + 28);
+  TotalSize                 = *(UINT32 *)(Header + 32);
+  if (DataSize == 0) {
+    DataSize  = MICROCODE_DEFAULT_DATA_SIZE;
+    TotalSize = MICROCODE_DEFAULT_TOTAL_SIZE;
+  }
+  Entry->TotalSize = TotalSize;
+  Entry->Status    = ValidationFailed;
+
+  if ((DataSize > TotalSize - MICROCODE_HEADER_SIZE) || (TotalSize < MICROCODE_HEADER_SIZE) ||
+      ((DataSize & 0x3) != 0) || ((TotalSize & 0x3) != 0)) {
+    Entry->Reason = "DataSize/TotalSize";
+    return;
+  }
+  if (TotalSize > Entry->MaxSize) {
+    Entry->Reason = "TotalSize beyond the image";
+    return;
+  }
+
+  //
+  // All the words of the update, extended signature table included, add up to 0
+  //
+  Sum = SumMicrocodeDwords (Header, MICROCODE_HEADER_SIZE + DataSize);
+  if (Sum + SumMicrocodeDwords (Header + MICROCODE_HEADER_SIZE + DataSize, TotalSize - MICROCODE_HEADER_SIZE - DataSize) != 0) {
+    Entry->Reason = "Checksum";
+    return;
+  }
+
+  ExtSize = TotalSize - MICROCODE_HEADER_SIZE - DataSize;
+  if (ExtSize != 0) {
+    ExtTable = Header + MICROCODE_HEADER_SIZE + DataSize;
+    if (ExtSize < MICROCODE_EXT_TABLE_HEADER_SIZE) {
+      Entry->Reason = "Extended signature table size";
+      return;
+    }
+    ExtCount = *(UINT32 *)ExtTable;
+    if (ExtCount > (ExtSize - MICROCODE_EXT_TABLE_HEADER_SIZE) / MICROCODE_EXT_SIGNATURE_SIZE) {
+      Entry->Reason = "Extended signature count";
+      return;
+    }
+    Entry->ExtendedSignatureCount = ExtCount;
+    if (SumMicrocodeDwords (ExtTable, MICROCODE_EXT_TABLE_HEADER_SIZE + ExtCount * MICROCODE_EXT_SIGNATURE_SIZE) != 0) {
+      Entry->Reason = "Extended signature table checksum";
+      return;
+    }
+
+    //
+    // Each extended signature carries the checksum the header and data would
+    // have with its processor signature and flags in place of the primary ones
+    //
+    Sum -= *(UINT32 *)(Header + 12) + *(UINT32 *)(Header + 24) + *(UINT32 *)(Header + 16);
+    for (Index = 0; Index < ExtCount; Index++) {
+      ExtSignature = ExtTable + MICROCODE_EXT_TABLE_HEADER_SIZE + Index * MICROCODE_EXT_SIGNATURE_SIZE;
+      if (Sum + *(UINT32 *)ExtSignature + *(UINT32 *)(ExtSignature + 4) + *(UINT32 *)(ExtSignature + 8) != 0) {
+        Entry->Reason = "Extended signature checksum";
+        return;
+      }
+    }
+  }
+
+  Entry->Status = ValidationPassed;
+  Entry->Reason = NULL;
+}
+
+typedef struct {
+  UINT32  First;
+  UINT32  Stride;
+} VALIDATION_WORKER;
+
+/**
+  Validate every Stride-th microcode entry starting at First.
+
+  @param Context          The VALIDATION_WORKER of this thread.
+
+  @return NULL
+**/
+VOID *
+ValidateMicrocodeWorker (
+  IN VOID  *Context
+  )
+{
+  VALIDATION_WORKER  *Worker;
+  UINT32             Index;
+
+  Worker = (VALIDATION_WORKER *)Context;
+  for (Index = Worker->First; Index < gValidation.MicrocodeNumber; Index += Worker->Stride) {
+    if (gValidation.Microcode[Index].Status != ValidationOutOfRange) {
+      ValidateMicrocode (&gValidation.Microcode[Index]);
+    }
+  }
+  return NULL;
+}
+
+/**
+  Validate all microcode entries of the FIT context.
+
+  The entries are independent, so they are spread over worker threads where
+  the host supports them. A failure is reported, but does not stop the FIT
+  generation.
+
+  @param FdBuffer         FD binary buffer.
+  @param FdSize           FD size.
+
+  @retval STATUS_SUCCESS  All checked microcode entries are valid.
+  @retval STATUS_WARNING  At least one microcode entry is invalid.
+  @retval STATUS_ERROR    Out of memory.
+**/
+STATUS
+ValidateMicrocodeEntries (
+  IN UINT8   *FdBuffer,
+  IN UINT32  FdSize
+  )
+{
+  MICROCODE_VALIDATION  *Entry;
+  VALIDATION_WORKER     Worker[MAX_VALIDATION_THREADS];
+  UINT32                ThreadNumber;
+  UINT32                Index;
+  STATUS                Status;
+#ifndef _WIN32
+  pthread_t             Thread[MAX_VALIDATION_THREADS];
+  BOOLEAN               Started[MAX_VALIDATION_THREADS];
+  long                  OnlineCpus;
+#endif
+
+  if (gFitTableContext.MicrocodeNumber == 0) {
+    return STATUS_SUCCESS;
+  }
+
+  gValidation.Microcode = calloc (gFitTableContext.MicrocodeNumber, sizeof (MICROCODE_VALIDATION));
+  if (gValidation.Microcode == NULL) {
+    Error (NULL, 0, 0, "Out of memory for Microcode validation!", NULL);
+    return STATUS_ERROR;
+  }
+  gValidation.MicrocodeNumber = gFitTableContext.MicrocodeNumber;
+
+  for (Index = 0; Index < gValidation.MicrocodeNumber; Index++) {
+    Entry          = &gValidation.Microcode[Index];
+    Entry->Address = gFitTableContext.Microcode[Index].Address;
+    Entry->Buffer  = FLASH_TO_MEMORY (Entry->Address, FdBuffer, FdSize);
+    if (((UINTN)Entry->Buffer < (UINTN)FdBuffer) ||
+        ((UINTN)Entry->Buffer + MICROCODE_HEADER_SIZE > (UINTN)FdBuffer + FdSize)) {
+      Entry->Status = ValidationOutOfRange;
+      Entry->Reason = "Not in the image";
+      continue;
+    }
+    Entry->MaxSize = (UINT32)((UINTN)FdBuffer + FdSize - (UINTN)Entry->Buffer);
+  }
+
+  ThreadNumber = gValidationThreads;
+#ifndef _WIN32
+  if (ThreadNumber == 0) {
+    OnlineCpus   = sysconf (_SC_NPROCESSORS_ONLN);
+    ThreadNumber = (OnlineCpus > 0) ? (UINT32)OnlineCpus : 1;
+  }
+#else
+  ThreadNumber = 1;
+#endif
+  if (ThreadNumber > MAX_VALIDATION_THREADS) {
+    ThreadNumber = MAX_VALIDATION_THREADS;
+  }
+  if (ThreadNumber > gValidation.MicrocodeNumber) {
+    ThreadNumber = gValidation.MicrocodeNumber;
+  }
+  if (ThreadNumber == 0) {
+    ThreadNumber = 1;
+  }
+
+  for (Index = 0; Index < ThreadNumber; Index++) {
+    Worker[Index].First  = Index;
+    Worker[Index].Stride = ThreadNumber;
+  }
+
+#ifndef _WIN32
+  //
+  // The calling thread takes the first share. A share whose thread can not
+  // be created is validated here as well.
+  //
+  for (Index = 1; Index < ThreadNumber; Index++) {
+    Started[Index] = (BOOLEAN)(pthread_create (&Thread[Index], NULL, ValidateMicrocodeWorker, &Worker[Index]) == 0);
+  }
+  ValidateMicrocodeWorker (&Worker[0]);
+  for (Index = 1; Index < ThreadNumber; Index++) {
+    if (Started[Index]) {
+      pthread_join (Thread[Index], NULL);
+    } else {
+      ValidateMicrocodeWorker (&Worker[Index]);
+    }
+  }
+#else
+  ValidateMicrocodeWorker (&Worker[0]);
+#endif
+
+  Status = STATUS_SUCCESS;
+  for (Index = 0; Index < gValidation.MicrocodeNumber; Index++) {
+    Entry = &gValidation.Microcode[Index];
+    if (Entry->Status == ValidationFailed) {
+      printf ("WARNING: Microcode 0x%08x invalid : %s!\n", (unsigned) Entry->Address, Entry->Reason);
+      Status = STATUS_WARNING;
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Get the JSON name of a validation status.
+**/
+CONST CHAR8 *
+ValidationStatusName (
+  IN VALIDATION_STATUS  Status
+  )
+{
+  switch (Status) {
+  case ValidationPassed:
+    return "passed";
+  case ValidationFailed:
+    return "failed";
+  case ValidationOutOfRange:
+    return "out_of_range";
+  default:
+    return "not_checked";
+  }
 }
 
 /**
-  Check Acm information.
+  Write the microcode and StartupAcm validation results as JSON.
 
-  @param Acm          ACM buffer.
-  @param AcmMaxSize   ACM max size.
+  @param FileName         The report file.
 
-  @retval TRUE    ACM is valid.
-  @retval FALSE   ACM is invalid.
+  @retval STATUS_SUCCESS  The report is written.
+  @retval STATUS_ERROR    The report file can not be written.
 **/
-BOOLEAN
-CheckAcm (
-  IN ACM_FORMAT                        *Acm,
-  IN UINTN                             AcmMaxSize
+STATUS
+WriteValidationReport (
+  IN CHAR8  *FileName
   )
 {
-  CHIPSET_ACM_INFORMATION_TABLE *ChipsetAcmInformationTable;
-  CHIPSET_ID_LIST               *ChipsetIdList;
-  PROCESSOR_ID_LIST             *ProcessorIdList;
-  UINT8                         *Buffer;
+  FILE                  *FpOut;
+  MICROCODE_VALIDATION  *Entry;
+  BOOLEAN               Passed;
+  UINT32                Index;
+
+  FpOut = fopen (FileName, "w");
+  if (FpOut == NULL) {
+    Error (NULL, 0, 0, "Unable to open the report file", "%s", FileName);
+    return STATUS_ERROR;
+  }
 
-  if (Acm->ModuleType != ACM_MODULE_TYPE_CHIPSET_ACM) {
-    printf ("ACM invalid : ModuleType!\n");
-    return FALSE;
+  Passed = TRUE;
+  for (Index = 0; Index < gValidation.MicrocodeNumber; Index++) {
+    Passed = (BOOLEAN)(Passed && (gValidation.Microcode[Index].Status != ValidationFailed));
   }
-  if (Acm->Size * 4 > AcmMaxSize) {
-    printf ("ACM invalid : Size!\n");
-    return FALSE;
+  for (Index = 0; Index < gValidation.AcmNumber; Index++) {
+    Passed = (BOOLEAN)(Passed && (gValidation.Acm[Index].Status != ValidationFailed));
   }
 
-  //move buffer pointer to address past generic ACM header (post scratchsize)
-  Buffer = (UINT8 *)(Acm + 1);
-  Buffer += Acm->KeySize * 4;
-  if (Acm->HeaderVersion == ACM_HEADER_VERSION_3) {
-    Buffer += ACM_PKCS_1_5_RSA_SIGNATURE_SHA384_SIZE;
-  }
-  else if ((Acm->HeaderVersion == ACM_HEADER_VERSION_4) || (Acm->HeaderVersion == ACM_HEADER_VERSION_5)) {
-    Buffer += ACM_PKCS_1_5_RSA_SIGNATURE_SHA384_SIZE;
-    Buffer += ACM_XMSS_PUBLIC_KEY_SIZE;
-    Buffer += ACM_XMSS_SIGNATURE_SIZE;
+  fprintf (FpOut, "{\n");
+  fprintf (FpOut, "  \"utility\": \"%s\",\n", UTILITY_NAME);
+  fprintf (FpOut, "  \"version\": \"%d.%d\",\n", UTILITY_MAJOR_VERSION, UTILITY_MINOR_VERSION);
+  fprintf (FpOut, "  \"result\": \"%s\",\n", Passed ? "passed" : "failed");
+  fprintf (FpOut, "  \"microcode\": [");
+  for (Index = 0; Index < gValidation.MicrocodeNumber; Index++) {
+    Entry = &gValidation.Microcode[Index];
+    fprintf (FpOut, "%s\n    {\"index\": %u, \"address\": \"0x%08x\", \"status\": \"%s\"", (Index == 0) ? "" : ",", (unsigned) Index, (unsigned) Entry->Address, ValidationStatusName (Entry->Status));
+    if ((Entry->Status == ValidationPassed) || (Entry->Status == ValidationFailed)) {
+      fprintf (
+        FpOut,
+        ", \"revision\": \"0x%08x\", \"processor_signature\": \"0x%08x\", \"total_size\": %u, \"extended_signatures\": %u",
+        (unsigned) Entry->Revision,
+        (unsigned) Entry->ProcessorSignature,
+        (unsigned) Entry->TotalSize,
+        (unsigned) Entry->ExtendedSignatureCount
+        );
+    }
+    if (Entry->Reason != NULL) {
+      fprintf (FpOut, ", \"reason\": \"%s\"", Entry->Reason);
+    }
+    fprintf (FpOut, "}");
   }
-  else {
-    Buffer += 4;
-    Buffer += ACM_PKCS_1_5_RSA_SIGNATURE_SHA256_SIZE;
+  fprintf (FpOut, "%s],\n", (gValidation.MicrocodeNumber == 0) ? "" : "\n  ");
+  fprintf (FpOut, "  \"startup_acm\": [");
+  for (Index = 0; Index < gValidation.AcmNumber; Index++) {
+    fprintf (
+      FpOut,
+      "%s\n    {\"index\": %u, \"address\": \"0x%08x\", \"size\": %u, \"status\": \"%s\"}",
+      (Index == 0) ? "" : ",",
+      (unsigned) Index,
+      (unsigned) gValidation.Acm[Index].Address,
+      (unsigned) gValidation.Acm[Index].Size,
+      ValidationStatusName (gValidation.Acm[Index].Status)
+      );
   }
-  Buffer += Acm->ScratchSize * 4;
+  fprintf (FpOut, "%s]\n", (gValidation.AcmNumber == 0) ? "" : "\n  ");
+  fprintf (FpOut, "}\n");
 
-  if ((Acm->HeaderVersion == ACM_HEADER_VERSION_4) || (Acm->HeaderVersion == ACM_HEADER_VERSION_5)) {
-    Buffer += 60;  //add reserved bytes.
+  if (fclose (FpOut) != 0) {
+    Error (NULL, 0, 0, "Unable to write the report file", "%s", FileName);
+    return STATUS_ERROR;
   }
+  return STATUS_SUCCESS;
+}
 
-  if ((Acm->ModuleSubType & ACM_MODULE_SUBTYPE_ANC_MODULE) == 0) {
-    ChipsetAcmInformationTable = (CHIPSET_ACM_INFORMATION_TABLE *)Buffer;
-    if ((UINTN)ChipsetAcmInformationTable >= (UINTN)Acm + AcmMaxSize) {
-      printf ("ACM invalid : ChipsetAcmInformationTable!\n");
-      return FALSE;
-    }
+/**
+  Release the validation results.
+**/
+VOID
+FreeValidationResult (
+  VOID
+  )
+{
+  free (gValidation.Microcode);
+  free (gValidation.Acm);
+  memset (&gValidation, 0, sizeof (gValidation));
+}
 
-    if (CompareGuid ((EFI_GUID *)&ChipsetAcmInformationTable->Guid, (EFI_GUID *)&mChipsetAcmInformationTableGuid03) != 0) {
-      printf ("ACM invalid : ChipsetACMGuid!\n");
-      return FALSE;
-    }
-    if (ChipsetAcmInformationTable->ChipsetACMType != CHIPSET_ACM_TYPE_BIOS) {
-      printf ("ACM invalid : ChipsetACMType!\n");
-      return FALSE;
-    }
-    if (ChipsetAcmInformationTable->Version < CHIPSET_ACM_INFORMATION_TABLE_VERSION_3) {
-      printf ("ACM invalid : ChipsetACMVersion!\n");
-      return FALSE;
-    }
-    if ((UINTN)ChipsetAcmInformationTable + ChipsetAcmInformationTable->Length > (UINTN)Acm + AcmMaxSize) {
-      printf ("ACM invalid : ChipsetACMLength!\n");
-      return FALSE;
-    }
+typedef
+INTN
+(*FIT_SORT_COMPARE) (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  );
 
-    if (ChipsetAcmInformationTable->ChipsetIDList >= AcmMaxSize) {
-      printf ("ACM invalid : ChipsetACMChipsetIDList!\n");
-      return FALSE;
-    }
-    ChipsetIdList = (CHIPSET_ID_LIST *)((UINTN)Acm + ChipsetAcmInformationTable->ChipsetIDList);
-    if (ChipsetIdList->Count == 0) {
-      printf ("ACM invalid : ChipsetACMChipsetIDListCount!\n");
-      return FALSE;
-    }
-    if (ChipsetAcmInformationTable->ChipsetIDList + sizeof(CHIPSET_ID_LIST) + (ChipsetIdList->Count - 1) * sizeof(ACM_CHIPSET_ID) > AcmMaxSize) {
-      printf ("ACM invalid : ChipsetACMChipsetIDList!\n");
-      return FALSE;
-    }
+/**
+  Compare two FIT context entries by address.
+**/
+INTN
+CompareFitContextEntryAddress (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  UINT32  LeftAddress;
+  UINT32  RightAddress;
 
-    if (ChipsetAcmInformationTable->Version < CHIPSET_ACM_INFORMATION_TABLE_VERSION_4) {
-      goto End;
-    }
+  LeftAddress  = ((CONST FIT_TABLE_CONTEXT_ENTRY *)Left)->Address;
+  RightAddress = ((CONST FIT_TABLE_CONTEXT_ENTRY *)Right)->Address;
+  return (LeftAddress > RightAddress) - (LeftAddress < RightAddress);
+}
 
-    if (ChipsetAcmInformationTable->ProcessorIDList >= AcmMaxSize) {
-      printf ("ACM invalid : ChipsetACMProcessorIDList!\n");
-      return FALSE;
-    }
-    ProcessorIdList = (PROCESSOR_ID_LIST *)((UINTN)Acm + ChipsetAcmInformationTable->ProcessorIDList);
-    if (ProcessorIdList->Count == 0) {
-      printf ("ACM invalid : ChipsetACMProcessorIdListCount!\n");
-      return FALSE;
-    }
-    if (ChipsetAcmInformationTable->ChipsetIDList + sizeof(PROCESSOR_ID_LIST) + (ChipsetIdList->Count - 1) * sizeof(ACM_PROCESSOR_ID) > AcmMaxSize) {
-      printf ("ACM invalid : ChipsetACMProcessorIdList!\n");
-      return FALSE;
+/**
+  Compare two FIT entries by type.
+**/
+INTN
+CompareFitEntryType (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  return (INTN)((CONST FIRMWARE_INTERFACE_TABLE_ENTRY *)Left)->Type -
+         (INTN)((CONST FIRMWARE_INTERFACE_TABLE_ENTRY *)Right)->Type;
+}
+
+/**
+  Sort an array keeping the order of equal elements.
+
+  This is a bottom-up merge sort, the FIT relies on entries of the same type
+  staying in the order they were added (e.g. BiosModule by address). If the
+  scratch buffer cannot be allocated an in-place insertion sort is used.
+
+  @param Base             The array to sort.
+  @param Count            Number of elements.
+  @param ElementSize      Size of one element.
+  @param Compare          Comparison function.
+**/
+VOID
+StableSort (
+  IN OUT VOID              *Base,
+  IN     UINTN             Count,
+  IN     UINTN             ElementSize,
+  IN     FIT_SORT_COMPARE  Compare
+  )
+{
+  UINT8  *Source;
+  UINT8  *Target;
+  UINT8  *Scratch;
+  UINT8  *Swap;
+  UINT8  Byte;
+  UINTN  Width;
+  UINTN  Start;
+  UINTN  Middle;
+  UINTN  End;
+  UINTN  Left;
+  UINTN  Right;
+  UINTN  Out;
+  UINTN  Index;
+  UINTN  SubIndex;
+
+  if (Count < 2) {
+    return;
+  }
+
+  Scratch = malloc (Count * ElementSize);
+  if (Scratch == NULL) {
+    for (Index = 1; Index < Count; Index++) {
+      for (SubIndex = Index; SubIndex > 0; SubIndex--) {
+        Source = (UINT8 *)Base + (SubIndex - 1) * ElementSize;
+        Target = Source + ElementSize;
+        if (Compare (Source, Target) <= 0) {
+          break;
+        }
+        for (Out = 0; Out < ElementSize; Out++) {
+          Byte        = Source[Out];
+          Source[Out] = Target[Out];
+          Target[Out] = Byte;
+        }
+      }
     }
+    return;
   }
 
-End:
+  Source = Base;
+  Target = Scratch;
+  for (Width = 1; Width < Count; Width *= 2) {
+    for (Start = 0; Start < Count; Start += 2 * Width) {
+      Middle = (Start + Width < Count) ? Start + Width : Count;
+      End    = (Start + 2 * Width < Count) ? Start + 2 * Width : Count;
+      Left   = Start;
+      Right  = Middle;
+      for (Out = Start; Out < End; Out++) {
+        if ((Left < Middle) &&
+            ((Right >= End) || (Compare (Source + Left * ElementSize, Source + Right * ElementSize) <= 0))) {
+          memcpy (Target + Out * ElementSize, Source + Left * ElementSize, ElementSize);
+          Left++;
+        } else {
+          memcpy (Target + Out * ElementSize, Source + Right * ElementSize, ElementSize);
+          Right++;
+        }
+      }
+    }
+    Swap   = Source;
+    Source = Target;
+    Target = Swap;
+  }
 
-  return TRUE;
+  if (Source != Base) {
+    memcpy (Base, Source, Count * ElementSize);
+  }
+  free (Scratch);
 }
 
 /**
@@ -3010,9 +4218,6 @@ FillFitTable (
   UINT32                          FitEntrySizeValue;
   UINT32                          Index;
   UINT8                           Checksum;
-  UINTN                           SubIndex;
-  FIT_TABLE_CONTEXT_ENTRY         TempContextEntry;
-  FIRMWARE_INTERFACE_TABLE_ENTRY  TempTableEntry;
   PROCESSOR_ID                    FMS;
   PROCESSOR_ID                    FMSMask;
 
@@ -3134,17 +4339,7 @@ FillFitTable (
   //
   // BiosModule segments order needs to be put from low address to high for Btg requirement
   //
-  if (gFitTableContext.BiosModuleNumber > 1) {
-    for (Index = 0; Index < (UINTN)gFitTableContext.BiosModuleNumber - 1; Index++){
-      for (SubIndex = 0; SubIndex < gFitTableContext.BiosModuleNumber - Index - 1; SubIndex++) {
-        if (gFitTableContext.BiosModule[SubIndex].Address > gFitTableContext.BiosModule[SubIndex + 1].Address) {
-          CopyMem (&TempContextEntry, &gFitTableContext.BiosModule[SubIndex], sizeof(FIT_TABLE_CONTEXT_ENTRY));
-          CopyMem (&gFitTableContext.BiosModule[SubIndex], &gFitTableContext.BiosModule[SubIndex + 1], sizeof(FIT_TABLE_CONTEXT_ENTRY));
-          CopyMem (&gFitTableContext.BiosModule[SubIndex + 1], &TempContextEntry, sizeof(FIT_TABLE_CONTEXT_ENTRY));
-        }
-      }
-    }
-  }
+  StableSort (gFitTableContext.BiosModule, gFitTableContext.BiosModuleNumber, sizeof (FIT_TABLE_CONTEXT_ENTRY), CompareFitContextEntryAddress);
   for (Index = 0; Index < gFitTableContext.BiosModuleNumber; Index++) {
     FitEntrySizeValue           = gFitTableContext.BiosModule[Index].Size / 16;
     FitEntry[FitIndex].Address  = gFitTableContext.BiosModule[Index].Address;
@@ -3198,15 +4393,7 @@ FillFitTable (
   //
   // The FIT records must always be arranged in the ascending order of their type attribute in the FIT.
   //
-  for (Index = 0; Index < (UINTN)FitIndex - 1; Index++){
-    for (SubIndex = 0; SubIndex < FitIndex - Index - 1; SubIndex++) {
-      if (FitEntry[SubIndex].Type > FitEntry[SubIndex + 1].Type) {
-        CopyMem (&TempTableEntry, &FitEntry[SubIndex], sizeof(FIRMWARE_INTERFACE_TABLE_ENTRY));
-        CopyMem (&FitEntry[SubIndex], &FitEntry[SubIndex + 1], sizeof(FIRMWARE_INTERFACE_TABLE_ENTRY));
-        CopyMem (&FitEntry[SubIndex + 1], &TempTableEntry, sizeof(FIRMWARE_INTERFACE_TABLE_ENTRY));
-      }
-    }
-  }
+  StableSort (FitEntry, FitIndex, sizeof (FIRMWARE_INTERFACE_TABLE_ENTRY), CompareFitEntryType);
 
   //
   // Update FIT header signature as final step
@@ -3276,11 +4463,101 @@ ClearFitTable (
 }
 
 /**
-  Read input file.
+  Update an existing output file in place, writing only the byte ranges
+  whose content differs from the new image.
+
+  @param FileName          The output file name.
+  @param FileData          The output file data.
+  @param FileSize          The output file size.
+
+  @retval STATUS_SUCCESS   The output file is up to date.
+  @retval STATUS_WARNING   The file is missing or its size differs, write it whole.
+  @retval STATUS_ERROR     The file could not be read or written.
+**/
+STATUS
+PatchOutputFile (
+  IN CHAR8   *FileName,
+  IN UINT8   *FileData,
+  IN UINT32  FileSize
+  )
+{
+  FILE                        *FpOut;
+  UINT8                       *Chunk;
+  UINT32                      Offset;
+  UINT32                      Length;
+  UINT32                      First;
+  UINT32                      Last;
+  UINT32                      PatchedBytes;
+  UINT32                      PatchedRanges;
+  STATUS                      Status;
+
+  if ((FpOut = fopen (FileName, "r+b")) == NULL) {
+    return STATUS_WARNING;
+  }
+  fseek (FpOut, 0, SEEK_END);
+  if ((UINT32)ftell (FpOut) != FileSize) {
+    fclose (FpOut);
+    return STATUS_WARNING;
+  }
+
+  Chunk = malloc (PATCH_CHUNK_SIZE);
+  if (Chunk == NULL) {
+    fclose (FpOut);
+    return STATUS_WARNING;
+  }
+
+  Status        = STATUS_SUCCESS;
+  PatchedBytes  = 0;
+  PatchedRanges = 0;
+  for (Offset = 0; Offset < FileSize; Offset += Length) {
+    Length = FileSize - Offset;
+    if (Length > PATCH_CHUNK_SIZE) {
+      Length = PATCH_CHUNK_SIZE;
+    }
+
+    fseek (FpOut, Offset, SEEK_SET);
+    if (fread (Chunk, 1, Length, FpOut) != Length) {
+      Error (NULL, 0, 0, "Read output file error!", NULL);
+      Status = STATUS_ERROR;
+      break;
+    }
+    if (memcmp (Chunk, FileData + Offset, Length) == 0) {
+      continue;
+    }
+
+    //
+    // Only write from the first to the last differing byte of the chunk
+    //
+    for (First = 0; Chunk[First] == FileData[Offset + First]; First++) {
+    }
+    for (Last = Length - 1; Chunk[Last] == FileData[Offset + Last]; Last--) {
+    }
+
+    fseek (FpOut, Offset + First, SEEK_SET);
+    if (fwrite (FileData + Offset + First, 1, Last - First + 1, FpOut) != Last - First + 1) {
+      Error (NULL, 0, 0, "Write output file error!", NULL);
+      Status = STATUS_ERROR;
+      break;
+    }
+    PatchedBytes += Last - First + 1;
+    PatchedRanges++;
+  }
+
+  free (Chunk);
+  fclose (FpOut);
+
+  if (Status == STATUS_SUCCESS) {
+    printf ("Patched %u bytes in %u ranges of %s\n", (unsigned)PatchedBytes, (unsigned)PatchedRanges, FileName);
+  }
+  return Status;
+}
+
+/**
+  Write output file.
 
-  @param FileName          The input file name.
-  @param FileData          The input file data.
-  @paramFileSize           The input file size.
+  @param FileName          The output file name.
+  @param FileData          The output file data.
+  @param FileSize          The output file size.
 
   @retval STATUS_SUCCESS   Write file data successfully.
   @retval STATUS_ERROR     The file data is not written.
@@ -3293,6 +4570,8 @@ WriteOutputFile (
   )
 {
   FILE                        *FpOut;
+  STATUS                      Status;
+  UINT8                       *FileCopy;
 
   //
   //Check the File Path
@@ -3303,28 +4582,52 @@ WriteOutputFile (
     return STATUS_ERROR;
   }
 
+  if (gInPlace) {
+    Status = PatchOutputFile (FileName, FileData, FileSize);
+    if (Status != STATUS_WARNING) {
+      return Status;
+    }
+  }
+
+  //
+  // The data may be a copy-on-write mapping of this very file. Truncating
+  // the file would drop every page FitGen did not modify, so copy it first.
+  //
+  FileCopy = NULL;
+  if (IsMappedFile (FileName)) {
+    FileCopy = malloc (FileSize);
+    if (FileCopy == NULL) {
+      Error (NULL, 0, 0, "No sufficient memory to allocate!", NULL);
+      return STATUS_ERROR;
+    }
+    memcpy (FileCopy, FileData, FileSize);
+    FileData = FileCopy;
+  }
+
   //
   // Open the output FvRecovery.fv file
   //
   if ((FpOut = fopen (FileName, "w+b")) == NULL) {
     Error (NULL, 0, 0, "Unable to open file", "%s", FileName);
+    free (FileCopy);
     return STATUS_ERROR;
   }
   //
   // Write the output FvRecovery.fv file
   //
+  Status = STATUS_SUCCESS;
   if ((fwrite (FileData, 1, FileSize, FpOut)) != FileSize) {
     Error (NULL, 0, 0, "Write output file error!", NULL);
-    fclose (FpOut);
-    return STATUS_ERROR;
+    Status = STATUS_ERROR;
   }
 
   //
   // Close the output FvRecovery.fv file
   //
   fclose (FpOut);
+  free (FileCopy);
 
-  return STATUS_SUCCESS;
+  return Status;
 }
 
 
@@ -3556,11 +4859,19 @@ GetFitEntryInfo (
     FitEntrySizeValue = (((UINT32)FitEntry[FitIndex].Size[2]) << 16) + (((UINT32)FitEntry[FitIndex].Size[1]) << 8) + ((UINT32)FitEntry[FitIndex].Size[0]);
     switch (FitEntry[FitIndex].Type) {
     case FIT_TABLE_TYPE_MICROCODE:
+      if (!RESERVE_FIT_CONTEXT_ENTRY (Microcode)) {
+        Error (NULL, 0, 0, "Out of memory for FIT entries!", NULL);
+        return 0;
+      }
       gFitTableContext.Microcode[gFitTableContext.MicrocodeNumber].Address = (UINT32)FitEntry[FitIndex].Address;
       gFitTableContext.MicrocodeVersion                                    = FitEntry[FitIndex].Version;
       gFitTableContext.MicrocodeNumber ++;
       break;
     case FIT_TABLE_TYPE_STARTUP_ACM:
+      if (!RESERVE_FIT_CONTEXT_ENTRY (StartupAcm)) {
+        Error (NULL, 0, 0, "Out of memory for FIT entries!", NULL);
+        return 0;
+      }
       gFitTableContext.StartupAcm[gFitTableContext.StartupAcmNumber].Address = (UINT32)FitEntry[FitIndex].Address;
       gFitTableContext.StartupAcm[gFitTableContext.StartupAcmNumber].Size    = FitEntrySizeValue;
       gFitTableContext.StartupAcm[gFitTableContext.StartupAcmNumber].Type    = FitEntry[FitIndex].Type;
@@ -3579,6 +4890,10 @@ GetFitEntryInfo (
       gFitTableContext.ProtBootPolicy.Size = GetFirmwareInterfaceTableEntrySize (&FitEntry[FitIndex]);
       break;
     case FIT_TABLE_TYPE_BIOS_MODULE:
+      if (!RESERVE_FIT_CONTEXT_ENTRY (BiosModule)) {
+        Error (NULL, 0, 0, "Out of memory for FIT entries!", NULL);
+        return 0;
+      }
       gFitTableContext.BiosModule[gFitTableContext.BiosModuleNumber].Address = (UINT32)FitEntry[FitIndex].Address;
       gFitTableContext.BiosModule[gFitTableContext.BiosModuleNumber].Size    = FitEntrySizeValue * 16;
       gFitTableContext.BiosModuleVersion                                     = FitEntry[FitIndex].Version;
@@ -3587,6 +4902,10 @@ GetFitEntryInfo (
     case FIT_TABLE_TYPE_TPM_POLICY:
     case FIT_TABLE_TYPE_TXT_POLICY:
       if (FitEntry[FitIndex].Version == 0) {
+        if (!RESERVE_FIT_CONTEXT_ENTRY (PortModule)) {
+          Error (NULL, 0, 0, "Out of memory for FIT entries!", NULL);
+          return 0;
+        }
         gFitTableContext.PortModule[gFitTableContext.PortModuleNumber].Address = (UINT32)FitEntry[FitIndex].Address;
         gFitTableContext.PortModule[gFitTableContext.PortModuleNumber].Size    = (UINT32)(FitEntry[FitIndex].Address >> 32);
         gFitTableContext.PortModule[gFitTableContext.PortModuleNumber].Version = FitEntry[FitIndex].Version;
@@ -3596,6 +4915,10 @@ GetFitEntryInfo (
       }
       // Not Port Configure, pass through
     default: // Others
+      if (!RESERVE_FIT_CONTEXT_ENTRY (OptionalModule)) {
+        Error (NULL, 0, 0, "Out of memory for FIT entries!", NULL);
+        return 0;
+      }
       gFitTableContext.OptionalModule[gFitTableContext.OptionalModuleNumber].Address = (UINT32)FitEntry[FitIndex].Address;
       gFitTableContext.OptionalModule[gFitTableContext.OptionalModuleNumber].Size    = FitEntrySizeValue;
       gFitTableContext.OptionalModule[gFitTableContext.OptionalModuleNumber].Version = FitEntry[FitIndex].Version;
@@ -3640,6 +4963,8 @@ FitGen (
   UINT32                      FixedFitLocation;
 
   FileBufferRaw = NULL;
+  gProfileStart = GetWallTimeUs ();
+  gProfileLast  = gProfileStart;
   //
   // Step 0: Check FV or FD
   //
@@ -3661,12 +4986,23 @@ FitGen (
     }
     FdFileBuffer = FileBuffer;
     FdFileSize = FvRecoveryFileSize;
+    ProfilePoint ("Read input");
+
+    BuildFdIndex (FdFileBuffer, FdFileSize);
+    ProfilePoint ("Index FD");
   } else {
     Status = ReadInputFile (argv[2], &FdFileBuffer, &FdFileSize, &FileBufferRaw);
     if (Status != STATUS_SUCCESS) {
       Error (NULL, 0, 0, "Unable to open file", "%s", argv[2]);
       goto exitFunc;
     }
+    ProfilePoint ("Read input");
+
+    //
+    // Index all FVs and FFS files once, every GUID lookup below uses it
+    //
+    BuildFdIndex (FdFileBuffer, FdFileSize);
+    ProfilePoint ("Index FD");
 
     //
     // Get Fvrecovery information
@@ -3683,6 +5019,7 @@ FitGen (
   // Step 2: Calculate FIT entry number.
   //
   FitEntryNumber = GetFitEntryNumber (argc, argv, FdFileBuffer, FdFileSize);
+  ProfilePoint ("Parse FIT entries");
   if (!gFitTableContext.Clear) {
     if (FitEntryNumber == 0) {
       Status = STATUS_ERROR;
@@ -3725,23 +5062,46 @@ FitGen (
       MEMORY_TO_FLASH (FitTableOffset, FdFileBuffer, FdFileSize),
       FitTableSize
       );
+    ProfilePoint ("Find FIT space");
+
+    //
+    // Validate Microcode
+    //
+    if (ValidateMicrocodeEntries (FdFileBuffer, FdFileSize) == STATUS_ERROR) {
+      Status = STATUS_ERROR;
+      goto exitFunc;
+    }
+    ProfilePoint ("Check Microcode");
 
     //
     // Get ACM buffer
     //
+    if (gFitTableContext.StartupAcmNumber != 0) {
+      gValidation.Acm = calloc (gFitTableContext.StartupAcmNumber, sizeof (ACM_VALIDATION));
+      if (gValidation.Acm == NULL) {
+        Error (NULL, 0, 0, "Out of memory for StartupAcm validation!", NULL);
+        Status = STATUS_ERROR;
+        goto exitFunc;
+      }
+      gValidation.AcmNumber = gFitTableContext.StartupAcmNumber;
+    }
     for (Index = 0; Index < (INTN)gFitTableContext.StartupAcmNumber; Index ++) {
       printf("ACM address:%08x\n", gFitTableContext.StartupAcm[Index].Address);
       printf("ACM size:%08x\n", gFitTableContext.StartupAcm[Index].Size);
+      gValidation.Acm[Index].Address = gFitTableContext.StartupAcm[Index].Address;
+      gValidation.Acm[Index].Size    = gFitTableContext.StartupAcm[Index].Size;
       if (gFitTableContext.StartupAcm[Index].Address != 0) {
         printf("get AcmBuffer\n");
         AcmBuffer = FLASH_TO_MEMORY(gFitTableContext.StartupAcm[Index].Address, FdFileBuffer, FdFileSize);
         if ((AcmBuffer < FdFileBuffer) || (AcmBuffer + gFitTableContext.StartupAcm[Index].Size > FdFileBuffer + FdFileSize)) {
           printf ("ACM out of range - can not validate it\n");
           AcmBuffer = NULL;
+          gValidation.Acm[Index].Status = ValidationOutOfRange;
         }
 
         if (AcmBuffer != NULL) {
           if (CheckAcm((ACM_FORMAT *)AcmBuffer, gFitTableContext.StartupAcm[Index].Size)) {
+            gValidation.Acm[Index].Status = ValidationPassed;
             DumpAcm((ACM_FORMAT *)AcmBuffer);
 
             if (gFitTableContext.StartupAcm[Index].Version >= 0x200) {
@@ -3756,6 +5116,7 @@ FitGen (
             }
           }
           else {
+            gValidation.Acm[Index].Status = ValidationFailed;
             if (Index == 0) {
               Status = STATUS_ERROR;
               goto exitFunc;
@@ -3765,10 +5126,13 @@ FitGen (
       }
     }
 
+    ProfilePoint ("Check ACM");
+
     //
     // Step 4: Fill the FIT table one by one
     //
     FillFitTable (FdFileBuffer, FdFileSize, FitTableOffset);
+    ProfilePoint ("Fill FIT table");
 
     //
     // For debug
@@ -3795,6 +5159,7 @@ FitGen (
     //
     ClearFitTable (FdFileBuffer, FdFileSize);
     printf ("Clear FIT table Done!\n");
+    ProfilePoint ("Clear FIT table");
   }
 
   //
@@ -3805,10 +5170,22 @@ FitGen (
   } else {
     Status = WriteOutputFile (argv[3], FdFileBuffer, FdFileSize);
   }
+  ProfilePoint ("Write output");
 
 exitFunc:
+  if (gReportFileName != NULL) {
+    if ((WriteValidationReport (gReportFileName) != STATUS_SUCCESS) && (Status == STATUS_SUCCESS)) {
+      Status = STATUS_ERROR;
+    }
+  }
+  FreeValidationResult ();
+  FreeFdIndex ();
+  FreeFitTableContext ();
   if (FileBufferRaw != NULL) {
-    free ((VOID *)FileBufferRaw);
+    FreeFileBuffer ((VOID *)FileBufferRaw);
+  }
+  if (gProfile) {
+    printf ("PROFILE: %-24s %10llu us\n", "Total", (unsigned long long)(GetWallTimeUs () - gProfileStart));
   }
   return Status;
 }
@@ -3919,8 +5296,9 @@ FitView (
   PrintFitTable (FileBuffer, FvRecoveryFileSize);
 
 exitFunc:
+  FreeFitTableContext ();
   if (FileBufferRaw != NULL) {
-    free ((VOID *)FileBufferRaw);
+    FreeFileBuffer ((VOID *)FileBufferRaw);
   }
   return Status;
 }
@@ -3940,6 +5318,9 @@ main (
   char  **argv
   )
 {
+  int  Index;
+  int  NewArgc;
+
   SetUtilityName (UTILITY_NAME);
 
   //
@@ -3947,6 +5328,40 @@ main (
   //
   PrintUtilityInfo ();
 
+  //
+  // The -- options may appear anywhere, drop them so positional parsing is
+  // unchanged
+  //
+  for (Index = 0, NewArgc = 0; Index < argc; Index++) {
+    if (stricmp (argv[Index], "--profile") == 0) {
+      gProfile = TRUE;
+      continue;
+    }
+    if (stricmp (argv[Index], "--no-mmap") == 0) {
+      gNoMmap = TRUE;
+      continue;
+    }
+    if (stricmp (argv[Index], "--inplace") == 0) {
+      gInPlace = TRUE;
+      continue;
+    }
+    if ((stricmp (argv[Index], "--threads") == 0) || (stricmp (argv[Index], "--report") == 0)) {
+      if (Index + 1 >= argc) {
+        Error (NULL, 0, 0, "Missing value for option", "%s", argv[Index]);
+        return STATUS_ERROR;
+      }
+      if (stricmp (argv[Index], "--threads") == 0) {
+        gValidationThreads = (UINT32) atoi (argv[Index + 1]);
+      } else {
+        gReportFileName = argv[Index + 1];
+      }
+      Index++;
+      continue;
+    }
+    argv[NewArgc++] = argv[Index];
+  }
+  argc = NewArgc;
+
   //
   // Verify the correct number of arguments
   //
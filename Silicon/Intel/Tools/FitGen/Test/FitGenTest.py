@@ -0,0 +1,205 @@
+## @file
+# Regression tests for the FitGen utility
+#
+# The FitGen binary is taken from the FITGEN environment variable, or from
+# PATH when it is not set.
+#
+#   python3 FitGenTest.py
+#
+# Copyright (c) 2010 - 2022, Intel Corporation. All rights reserved.<BR>
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+import os
+import shutil
+import struct
+import subprocess
+import tempfile
+import unittest
+import uuid
+
+FV_LENGTH           = 0x40000
+FV_BLOCK_SIZE       = 0x1000
+FV_HEADER_LENGTH    = 0x48
+FFS_HEADER_LENGTH   = 0x18
+
+FFS2_GUID   = uuid.UUID ('8C8CE578-8A3D-4F1C-9935-896185C32DD3')
+VTF_GUID    = uuid.UUID ('1BA0062E-C779-4582-8566-336AE8F78F09')
+
+FV_BASE_ADDRESS     = 0x100000000 - FV_LENGTH
+
+FIT_ENTRY_SIZE      = 16
+FIT_POINTER_OFFSET  = 0x40
+FIT_TYPE_HEADER     = 0x00
+FIT_TYPE_MICROCODE  = 0x01
+
+MICROCODE_HEADER_SIZE = 48
+MICROCODE_TOTAL_SIZE  = 0x100
+
+FITGEN_ARGS = ['-F', '0x40', '-NA', '-B', '0xFFFC0000', '0x1000']
+
+def FfsFile (Name, Type, Data):
+    Size   = FFS_HEADER_LENGTH + len (Data)
+    Header = Name.bytes_le + b'\0\0' + bytes ([Type, 0]) + struct.pack ('<I', Size)[:3] + b'\xf8'
+    return Header + Data
+
+def Microcode (Revision):
+    """A minimal microcode update with a valid header and checksum."""
+    Update = bytearray (MICROCODE_TOTAL_SIZE)
+    struct.pack_into (
+      '<9I', Update, 0,
+      1,                                              # HeaderVersion
+      Revision,                                       # UpdateRevision
+      0x01012022,                                     # Date
+      0x000906A0,                                     # ProcessorSignature
+      0,                                              # Checksum
+      1,                                              # LoaderRevision
+      0x80,                                           # ProcessorFlags
+      MICROCODE_TOTAL_SIZE - MICROCODE_HEADER_SIZE,   # DataSize
+      MICROCODE_TOTAL_SIZE                            # TotalSize
+      )
+    Sum = sum (struct.unpack ('<%dI' % (MICROCODE_TOTAL_SIZE // 4), bytes (Update))) & 0xFFFFFFFF
+    struct.pack_into ('<I', Update, 16, (0x100000000 - Sum) & 0xFFFFFFFF)
+    return bytes (Update)
+
+def FvImage (RawData = bytes (range (256)) * 8):
+    """A single FV at the top of 4GB, holding one raw file, a pad file and the VTF."""
+    Header = bytearray (FV_HEADER_LENGTH)
+    Header[16:32] = FFS2_GUID.bytes_le
+    struct.pack_into ('<Q', Header, 32, FV_LENGTH)
+    Header[40:44] = b'_FVH'
+    struct.pack_into ('<I', Header, 44, 0x0004FEFF)
+    struct.pack_into ('<H', Header, 48, FV_HEADER_LENGTH)
+    Header[55] = 2
+    struct.pack_into ('<II', Header, 56, FV_LENGTH // FV_BLOCK_SIZE, FV_BLOCK_SIZE)
+    Sum = sum (struct.unpack ('<%dH' % (FV_HEADER_LENGTH // 2), bytes (Header))) & 0xFFFF
+    struct.pack_into ('<H', Header, 50, (0x10000 - Sum) & 0xFFFF)
+
+    Image = bytearray (Header)
+    Image += FfsFile (uuid.UUID (int = 1), 0x01, RawData)
+    Vtf = FfsFile (VTF_GUID, 0x02, b'\xff' * (FV_BLOCK_SIZE - FFS_HEADER_LENGTH))
+    Free = FV_LENGTH - len (Image) - len (Vtf)
+    Image += FfsFile (uuid.UUID (bytes = b'\xff' * 16), 0xF0, b'\xff' * (Free - FFS_HEADER_LENGTH))
+    Image += Vtf
+    assert len (Image) == FV_LENGTH
+    return bytes (Image)
+
+def FitGenPath ():
+    return os.environ.get ('FITGEN') or shutil.which ('FitGen')
+
+@unittest.skipIf (FitGenPath () is None, 'FitGen not found, set FITGEN')
+class FitGenTest (unittest.TestCase):
+
+    def setUp (self):
+        self.TempDir = tempfile.mkdtemp ()
+        self.Image   = FvImage ()
+
+    def tearDown (self):
+        shutil.rmtree (self.TempDir)
+
+    def WriteImage (self, Name):
+        Path = os.path.join (self.TempDir, Name)
+        with open (Path, 'wb') as File:
+            File.write (self.Image)
+        return Path
+
+    def RunFitGen (self, *Args):
+        Result = subprocess.run (
+                   [FitGenPath ()] + list (Args),
+                   stdout = subprocess.PIPE,
+                   stderr = subprocess.STDOUT
+                   )
+        self.assertEqual (Result.returncode, 0, Result.stdout.decode (errors = 'replace'))
+        return Result.stdout.decode (errors = 'replace')
+
+    def Reference (self):
+        Input  = self.WriteImage ('Reference.fd')
+        Output = os.path.join (self.TempDir, 'ReferenceOut.fd')
+        self.RunFitGen (Input, Output, *FITGEN_ARGS)
+        with open (Output, 'rb') as File:
+            return File.read ()
+
+    def CheckSameInputOutput (self, *Options):
+        Expected = self.Reference ()
+        Image    = self.WriteImage ('Image.fd')
+        self.RunFitGen (Image, Image, *(FITGEN_ARGS + list (Options)))
+        with open (Image, 'rb') as File:
+            Actual = File.read ()
+        self.assertEqual (len (Actual), len (self.Image))
+        self.assertNotEqual (Actual, self.Image)
+        self.assertEqual (Actual, Expected)
+
+    def testSameInputOutput (self):
+        self.CheckSameInputOutput ()
+
+    def testSameInputOutputNoMmap (self):
+        self.CheckSameInputOutput ('--no-mmap')
+
+    def testSameInputOutputInPlace (self):
+        self.CheckSameInputOutput ('--inplace')
+
+    def testBootPolicyWithoutAcm (self):
+        #
+        # -BP places its record after the first startup ACM, it has to cope
+        # with no -S being given
+        #
+        Input  = self.WriteImage ('Image.fd')
+        Output = os.path.join (self.TempDir, 'Output.fd')
+        self.RunFitGen (Input, Output, *(FITGEN_ARGS + ['-BP', '0x100']))
+        self.assertEqual (os.path.getsize (Output), len (self.Image))
+
+    def testManyMicrocodeEntries (self):
+        #
+        # Far more microcode updates than the former fixed limit of 32 FIT
+        # entries per type, all passed with -M in ascending address order
+        #
+        Count     = 300
+        RawOffset = FV_HEADER_LENGTH + FFS_HEADER_LENGTH
+        self.Image = FvImage (b''.join (Microcode (Index + 1) for Index in range (Count)))
+        Addresses = [FV_BASE_ADDRESS + RawOffset + Index * MICROCODE_TOTAL_SIZE for Index in range (Count)]
+
+        Args = []
+        for Address in Addresses:
+            Args += ['-M', '0x%x' % Address, '0x%x' % MICROCODE_TOTAL_SIZE]
+        Input  = self.WriteImage ('Image.fd')
+        Output = os.path.join (self.TempDir, 'Output.fd')
+        Log = self.RunFitGen (Input, Output, *(FITGEN_ARGS + Args))
+        self.assertNotIn ('WARNING: Microcode', Log)
+        with open (Output, 'rb') as File:
+            Image = File.read ()
+        self.assertEqual (len (Image), len (self.Image))
+
+        #
+        # The FIT pointer holds the address of the header entry, whose size
+        # field is the number of entries of the whole table
+        #
+        FitAddress, = struct.unpack_from ('<Q', Image, len (Image) - FIT_POINTER_OFFSET)
+        self.assertEqual (FitAddress % FIT_ENTRY_SIZE, 0)
+        FitOffset = FitAddress - FV_BASE_ADDRESS
+        self.assertTrue (0 <= FitOffset < len (Image))
+        self.assertEqual (Image[FitOffset:FitOffset + 8], b'_FIT_   ')
+        EntryNumber = int.from_bytes (Image[FitOffset + 8:FitOffset + 11], 'little')
+        self.assertEqual (EntryNumber, 1 + Count + 1)   # header, microcode, BIOS module
+        self.assertLessEqual (FitOffset + EntryNumber * FIT_ENTRY_SIZE, len (Image))
+        Table = Image[FitOffset:FitOffset + EntryNumber * FIT_ENTRY_SIZE]
+
+        #
+        # Entries are sorted by type, the microcode updates stay in the given order
+        #
+        Entries = [struct.unpack_from ('<Q3sBHBB', Table, Index * FIT_ENTRY_SIZE) for Index in range (EntryNumber)]
+        Types   = [Entry[4] & 0x7F for Entry in Entries]
+        self.assertEqual (Types[0], FIT_TYPE_HEADER)
+        self.assertEqual (Types, sorted (Types))
+        self.assertEqual ([Entry[0] for Entry in Entries if Entry[4] & 0x7F == FIT_TYPE_MICROCODE], Addresses)
+
+        #
+        # The header checksum is valid and covers every entry
+        #
+        self.assertTrue (Entries[0][4] & 0x80)
+        self.assertEqual (sum (Table) & 0xFF, 0)
+
+if __name__ == '__main__':
+    unittest.main ()
@@ -98,7 +98,7 @@ EFI_SIMPLE_NETWORK_MODE Pp2SnpModeTemplate = {
   },                                                    // Permanent Address
   NET_IFTYPE_ETHERNET,                                  // IfType
   TRUE,                                                 // MacAddressChangeable
-  FALSE,                                                // MultipleTxSupported
+  TRUE,                                                 // MultipleTxSupported
   TRUE,                                                 // MediaPresentSupported
   FALSE                                                 // MediaPresent
 };
@@ -142,6 +142,98 @@ QueueRemove (
   return Buffer;
 }
 
+STATIC
+UINTN
+QueueCount (
+  IN PP2DXE_CONTEXT *Pp2Context
+  )
+{
+  return (Pp2Context->CompletionQueueTail + QUEUE_DEPTH -
+          Pp2Context->CompletionQueueHead) % QUEUE_DEPTH;
+}
+
+/*
+ * Move buffers of the frames already sent by the hardware from the
+ * in-flight ring to the completion queue. Reading the sent counter
+ * clears it, so all reported descriptors are retired at once. There is
+ * always room in the completion queue, as Transmit never lets the sum
+ * of in-flight and completed buffers exceed its capacity.
+ */
+STATIC
+VOID
+Pp2DxeTxReap (
+  IN PP2DXE_CONTEXT *Pp2Context
+  )
+{
+  PP2DXE_PORT *Port = &Pp2Context->Port;
+  INTN TxSent;
+
+  if (Pp2Context->TxInFlightCount == 0) {
+    return;
+  }
+
+  TxSent = Mvpp2TxqSentDescProc (Port, &Port->Txqs[0]);
+  if ((UINTN)TxSent > Pp2Context->TxInFlightCount) {
+    DEBUG ((DEBUG_WARN, "Pp2Dxe: %Ld frames reported sent, %Lu in flight\n",
+      (INT64)TxSent, (UINT64)Pp2Context->TxInFlightCount));
+    TxSent = Pp2Context->TxInFlightCount;
+  }
+
+  while (TxSent-- > 0 && Pp2Context->TxInFlightCount > 0) {
+    QueueInsert (Pp2Context, Pp2Context->TxInFlight[Pp2Context->TxInFlightHead]);
+    Pp2Context->TxInFlight[Pp2Context->TxInFlightHead] = NULL;
+    Pp2Context->TxInFlightHead = (Pp2Context->TxInFlightHead + 1) % PP2DXE_TX_INFLIGHT_MAX;
+    Pp2Context->TxInFlightCount--;
+  }
+}
+
+/*
+ * Return all buffers of the already processed packets to their BM pools
+ * and release the corresponding RX descriptors with a single status
+ * register update. The high address bits register is only rewritten
+ * when it differs from the previous buffer.
+ */
+STATIC
+VOID
+Pp2DxeRxRefill (
+  IN PP2DXE_CONTEXT *Pp2Context
+  )
+{
+  PP2DXE_PORT *Port = &Pp2Context->Port;
+  MVPP2_SHARED *Mvpp2Shared = Port->Priv;
+  PP2DXE_RX_REFILL *Refill;
+  UINT32 HighBits;
+  UINT32 LastHighBits;
+  UINTN Index;
+
+  if (Pp2Context->RxRefillCount == 0) {
+    return;
+  }
+
+  LastHighBits = MAX_UINT32;
+  for (Index = 0; Index < Pp2Context->RxRefillCount; Index++) {
+    Refill = &Pp2Context->RxRefill[Index];
+
+    HighBits = (Upper32Bits (Refill->VirtAddr) & MVPP22_ADDR_HIGH_MASK) << MVPP22_BM_VIRT_HIGH_RLS_OFFST;
+    HighBits |= (Upper32Bits (Refill->PhysAddr) & MVPP22_ADDR_HIGH_MASK) << MVPP22_BM_PHY_HIGH_RLS_OFFSET;
+    if (HighBits != LastHighBits) {
+      Mvpp2Write (Mvpp2Shared, MVPP22_BM_PHY_VIRT_HIGH_RLS_REG, HighBits);
+      LastHighBits = HighBits;
+    }
+
+    Mvpp2Write (Mvpp2Shared, MVPP2_BM_VIRT_RLS_REG, (UINT32)Refill->VirtAddr);
+    Mvpp2Write (Mvpp2Shared, MVPP2_BM_PHY_RLS_REG (Refill->PoolId), (UINT32)Refill->PhysAddr);
+  }
+
+  /* Update counters with all packets received and refilled */
+  Mvpp2RxqStatusUpdate (Port,
+    Port->Rxqs[0].Id,
+    Pp2Context->RxRefillCount,
+    Pp2Context->RxRefillCount);
+
+  Pp2Context->RxRefillCount = 0;
+}
+
 STATIC
 EFI_STATUS
 Pp2DxeBmPoolInit (
@@ -687,6 +779,9 @@ Pp2DxeHalt (
   MVPP2_SHARED *Mvpp2Shared = Pp2Context->Port.Priv;
   INTN Index;
 
+  /* Return the buffers of already processed packets before stopping BM */
+  Pp2DxeRxRefill (Pp2Context);
+
   if (Mvpp2Shared->BmEnabled) {
     for (Index = 0; Index < MVPP2_MAX_PORT; Index++) {
       Mvpp2BmStop(Mvpp2Shared, Index);
@@ -699,6 +794,22 @@ Pp2DxeHalt (
   Mvpp2IngressDisable(Port);
   Mvpp2EgressDisable(Port);
 
+  /* Frames still queued in hardware are dropped, hand their buffers back */
+  while (Pp2Context->TxInFlightCount > 0) {
+    QueueInsert (Pp2Context, Pp2Context->TxInFlight[Pp2Context->TxInFlightHead]);
+    Pp2Context->TxInFlight[Pp2Context->TxInFlightHead] = NULL;
+    Pp2Context->TxInFlightHead = (Pp2Context->TxInFlightHead + 1) % PP2DXE_TX_INFLIGHT_MAX;
+    Pp2Context->TxInFlightCount--;
+  }
+
+  /*
+   * Reading the sent counter clears it, so descriptors retired above are
+   * not reported again once the port is restarted.
+   */
+  Mvpp2TxqSentDescProc (Port, &Port->Txqs[0]);
+
+  Pp2Context->RxPending = 0;
+
   MvGop110PortEventsMask(Port);
   MvGop110PortDisable(Port);
 }
@@ -1064,6 +1175,7 @@ Pp2SnpGetStatus (
   Snp->Mode->MediaPresent = LinkUp;
 
   if (TxBuf != NULL) {
+    Pp2DxeTxReap (Pp2Context);
     *TxBuf = QueueRemove (Pp2Context);
   }
 
@@ -1087,9 +1199,6 @@ Pp2SnpTransmit (
   MVPP2_SHARED *Mvpp2Shared = Pp2Context->Port.Priv;
   MVPP2_TX_QUEUE *AggrTxq = Mvpp2Shared->AggrTxqs;
   MVPP2_TX_DESC *TxDesc;
-  EFI_STATUS Status;
-  INTN PollingCount;
-  INTN TxSent;
   UINT8 *DataPtr = Buffer;
   UINT16 EtherType;
   UINT32 State = This->Mode->State;
@@ -1133,6 +1242,16 @@ Pp2SnpTransmit (
     ReturnUnlock(SavedTpl, EFI_NOT_READY);
   }
 
+  /*
+   * Retire the frames sent so far and make sure the buffer can be tracked
+   * until it is collected through GetStatus.
+   */
+  Pp2DxeTxReap (Pp2Context);
+  if (Pp2Context->TxInFlightCount >= PP2DXE_TX_INFLIGHT_MAX ||
+      Pp2Context->TxInFlightCount + QueueCount (Pp2Context) >= QUEUE_DEPTH - 1) {
+    ReturnUnlock (SavedTpl, EFI_NOT_READY);
+  }
+
   /* Fetch next descriptor */
   TxDesc = Mvpp2TxqNextDescGet(AggrTxq);
 
@@ -1164,41 +1283,18 @@ Pp2SnpTransmit (
 
   InvalidateDataCacheRange (DataPtr, BufferSize);
 
-  /* Issue send */
-  Mvpp2AggrTxqPendDescAdd(Port, 1);
-
   /*
-   * Egress processing:
-   * Wait until packet is passed from per-cpu aggregated queue
-   * to physical per-port TXQ.
+   * Issue send. The hardware moves the descriptor from the aggregated
+   * queue to the physical port TXQ on its own, completion is checked
+   * lazily by Pp2DxeTxReap, so the caller can queue the next frame
+   * without waiting for this one to leave the wire.
    */
-  PollingCount = 0;
-  TxSent = Mvpp2AggrTxqPendDescNumGet(Mvpp2Shared, 0);
-  do {
-    if (PollingCount++ > MVPP2_TX_SEND_MAX_POLLING_COUNT) {
-      DEBUG((DEBUG_ERROR, "Pp2Dxe: transmit polling failed\n"));
-      ReturnUnlock(SavedTpl, EFI_TIMEOUT);
-    }
-    TxSent = Mvpp2AggrTxqPendDescNumGet(Mvpp2Shared, 0);
-  } while (TxSent);
-
-  /* Wait for packet to be transmitted by hardware. */
-  PollingCount = 0;
-  TxSent = Mvpp2TxqSentDescProc(Port, &Port->Txqs[0]);
-  while (!TxSent) {
-    if (PollingCount++ > MVPP2_TX_SEND_MAX_POLLING_COUNT) {
-      DEBUG((DEBUG_ERROR, "Pp2Dxe: transmit polling failed\n"));
-      ReturnUnlock(SavedTpl, EFI_TIMEOUT);
-    }
-    TxSent = Mvpp2TxqSentDescProc(Port, &Port->Txqs[0]);
-  }
+  Pp2Context->TxInFlight[(Pp2Context->TxInFlightHead + Pp2Context->TxInFlightCount) %
+    PP2DXE_TX_INFLIGHT_MAX] = Buffer;
+  Pp2Context->TxInFlightCount++;
+  Mvpp2AggrTxqPendDescAdd(Port, 1);
 
-  /*
-   * At this point TxSent has increased - HW sent the packet
-   * Add buffer to completion queue and return.
-   */
-  Status = QueueInsert (Pp2Context, Buffer);
-  ReturnUnlock (SavedTpl, Status);
+  ReturnUnlock (SavedTpl, EFI_SUCCESS);
 }
 
 EFI_STATUS
@@ -1213,7 +1309,6 @@ Pp2SnpReceive (
   OUT UINT16                     *EtherType OPTIONAL
   )
 {
-  INTN ReceivedPackets;
   PP2DXE_CONTEXT *Pp2Context;
   PP2DXE_PORT *Port;
   UINTN PhysAddr, VirtAddr;
@@ -1225,6 +1320,7 @@ Pp2SnpReceive (
   UINT8 *DataPtr;
   MVPP2_RX_DESC *RxDesc;
   MVPP2_RX_QUEUE *Rxq;
+  PP2DXE_RX_REFILL *Refill;
 
   /* Check input parameters. */
   if (This == NULL || Buffer == NULL || BufferSize == NULL) {
@@ -1258,14 +1354,21 @@ Pp2SnpReceive (
   Rxq = &Port->Rxqs[0];
   ASSERT (Rxq != NULL);
 
-  ReceivedPackets = Mvpp2RxqReceived(Port, Rxq->Id);
-
-  if (ReceivedPackets == 0) {
-    ReturnUnlock(SavedTpl, EFI_NOT_READY);
+  /*
+   * The occupied descriptors counter is only read once all descriptors
+   * reported by the previous read were consumed. Processed descriptors
+   * are released to the hardware in batches by Pp2DxeRxRefill.
+   */
+  if (Pp2Context->RxPending == 0) {
+    Pp2DxeRxRefill (Pp2Context);
+    Pp2Context->RxPending = Mvpp2RxqReceived(Port, Rxq->Id);
+    if (Pp2Context->RxPending == 0) {
+      ReturnUnlock(SavedTpl, EFI_NOT_READY);
+    }
   }
 
   /* Process one packet per call */
-  RxDesc = Mvpp2RxqNextDescGet(Rxq);
+  RxDesc = Rxq->Descs + Rxq->NextDescToProc;
   StatusReg = RxDesc->status;
 
   /* extract addresses from descriptor */
@@ -1315,12 +1418,20 @@ Pp2SnpReceive (
   Status = EFI_SUCCESS;
 
 drop:
-  /* Refill: pass packet back to BM */
+  /* Consume the descriptor and queue its buffer for returning to BM */
+  Mvpp2RxqNextDescGet(Rxq);
+  Pp2Context->RxPending--;
+
   PoolId = (StatusReg & MVPP2_RXD_BM_POOL_ID_MASK) >> MVPP2_RXD_BM_POOL_ID_OFFS;
-  Mvpp2BmPoolPut (Pp2Context->Port.Priv, PoolId, PhysAddr, VirtAddr);
+  Refill = &Pp2Context->RxRefill[Pp2Context->RxRefillCount++];
+  Refill->PoolId = PoolId;
+  Refill->PhysAddr = PhysAddr;
+  Refill->VirtAddr = VirtAddr;
 
-  /* Update counters with 1 packet received and 1 packet refilled */
-  Mvpp2RxqStatusUpdate(Port, Rxq->Id, 1, 1);
+  if (Pp2Context->RxPending == 0 ||
+      Pp2Context->RxRefillCount == PP2DXE_RX_REFILL_BATCH) {
+    Pp2DxeRxRefill (Pp2Context);
+  }
 
   ReturnUnlock(SavedTpl, Status);
 }
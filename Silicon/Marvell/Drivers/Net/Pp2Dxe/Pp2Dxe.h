@@ -142,12 +142,6 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define WRAP                              (2 + ETH_HLEN + 4 + 32)
 #define MTU                               1500
 
-/*
- * Maximum retries of checking, wheter HW really sent the packet
- * after it was done is software.
- */
-#define MVPP2_TX_SEND_MAX_POLLING_COUNT   10000
-
 /* Structures */
 typedef struct {
   /* Physical number of this Tx queue */
@@ -323,7 +317,27 @@ typedef struct {
   EFI_DEVICE_PATH_PROTOCOL  End;
 } PP2_DEVICE_PATH;
 
-#define QUEUE_DEPTH 64
+/*
+ * Transmit buffers stay owned by the driver from Transmit until they are
+ * handed back through GetStatus. Up to PP2DXE_TX_INFLIGHT_MAX of them may
+ * be queued in hardware at once, the completion queue has to hold all of
+ * them plus the ones already recycled, but not yet collected by the caller.
+ */
+#define PP2DXE_TX_INFLIGHT_MAX              (MVPP2_MAX_TXD - 1)
+#define QUEUE_DEPTH                         128
+
+/*
+ * Number of received buffers returned to the BM pools and number of RX
+ * descriptors released to the hardware in a single batch.
+ */
+#define PP2DXE_RX_REFILL_BATCH              16
+
+typedef struct {
+  INT32                       PoolId;
+  UINTN                       PhysAddr;
+  UINTN                       VirtAddr;
+} PP2DXE_RX_REFILL;
+
 typedef struct {
   UINT32                      Signature;
   INTN                        Instance;
@@ -338,6 +352,12 @@ typedef struct {
   VOID                        *CompletionQueue[QUEUE_DEPTH];
   UINTN                       CompletionQueueHead;
   UINTN                       CompletionQueueTail;
+  VOID                        *TxInFlight[PP2DXE_TX_INFLIGHT_MAX];
+  UINTN                       TxInFlightHead;
+  UINTN                       TxInFlightCount;
+  UINTN                       RxPending;
+  PP2DXE_RX_REFILL            RxRefill[PP2DXE_RX_REFILL_BATCH];
+  UINTN                       RxRefillCount;
   EFI_EVENT                   EfiExitBootServicesEvent;
   PP2_DEVICE_PATH             *DevicePath;
   EFI_ADAPTER_INFORMATION_PROTOCOL Aip;
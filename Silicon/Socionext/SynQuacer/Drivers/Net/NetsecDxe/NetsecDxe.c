@@ -116,6 +116,96 @@ Probe (
   return EFI_SUCCESS;
 }
 
+/*
+ *  Drain all received packets from the RX ring into the driver-side queue
+ *  with a single HAL call, which also refills the drained descriptors.
+ *  Only called once the previous batch has been consumed.
+ */
+STATIC
+VOID
+NetsecPollRx (
+  IN  NETSEC_DRIVER       *LanDriver
+  )
+{
+  ogma_err_t          ogma_err;
+  ogma_uint16         Num;
+
+  ASSERT (LanDriver->RxQueueHead == LanDriver->RxQueueCount);
+
+  ogma_err = ogma_get_rx_pkt_data_burst (LanDriver->Handle,
+                                         OGMA_DESC_RING_ID_NRM_RX,
+                                         NETSEC_RX_QUEUE_SIZE,
+                                         LanDriver->RxPktInfo,
+                                         LanDriver->RxFragInfo,
+                                         LanDriver->RxPktLen,
+                                         LanDriver->RxPktHandle,
+                                         &Num);
+  if (ogma_err != OGMA_ERR_OK) {
+    DEBUG ((DEBUG_ERROR,
+      "NETSEC: ogma_get_rx_pkt_data_burst failed with error code: %d\n",
+      (INT32)ogma_err));
+  }
+
+  LanDriver->RxQueueHead = 0;
+  LanDriver->RxQueueCount = Num;
+}
+
+/*
+ *  Unmap and release the packet at the head of the RX queue
+ */
+STATIC
+VOID
+NetsecDequeueRx (
+  IN  NETSEC_DRIVER       *LanDriver
+  )
+{
+  UINT16              Index;
+
+  Index = LanDriver->RxQueueHead++;
+  pfdep_free_pkt_buf (LanDriver->Handle,
+    LanDriver->RxFragInfo[Index].len, LanDriver->RxFragInfo[Index].addr,
+    LanDriver->RxFragInfo[Index].phys_addr, PFDEP_TRUE,
+    LanDriver->RxPktHandle[Index]);
+}
+
+/*
+ *  Reap all completed transmits in one go, marking their buffers as
+ *  released so that GetStatus() can recycle them
+ */
+STATIC
+VOID
+NetsecReapTx (
+  IN  NETSEC_DRIVER       *LanDriver
+  )
+{
+  ogma_clear_desc_ring_irq_status (LanDriver->Handle,
+                                   OGMA_DESC_RING_ID_NRM_TX,
+                                   OGMA_CH_IRQ_REG_EMPTY);
+
+  ogma_clean_tx_desc_ring (LanDriver->Handle, OGMA_DESC_RING_ID_NRM_TX);
+}
+
+/*
+ *  Mark the counters the driver does not maintain as unsupported, and clear
+ *  the others
+ */
+STATIC
+VOID
+NetsecResetStatistics (
+  IN  NETSEC_DRIVER       *LanDriver
+  )
+{
+  SetMem (&LanDriver->Stats, sizeof (LanDriver->Stats), 0xFF);
+
+  LanDriver->Stats.RxTotalFrames   = 0;
+  LanDriver->Stats.RxGoodFrames    = 0;
+  LanDriver->Stats.RxDroppedFrames = 0;
+  LanDriver->Stats.RxTotalBytes    = 0;
+  LanDriver->Stats.TxTotalFrames   = 0;
+  LanDriver->Stats.TxGoodFrames    = 0;
+  LanDriver->Stats.TxTotalBytes    = 0;
+}
+
 /*
  *  UEFI Stop() function
  */
@@ -420,6 +510,11 @@ SnpShutdown (
   ogma_stop_desc_ring (LanDriver->Handle, OGMA_DESC_RING_ID_NRM_RX);
   ogma_stop_desc_ring (LanDriver->Handle, OGMA_DESC_RING_ID_NRM_TX);
 
+  // Drop the packets that were drained from the ring but never received
+  while (LanDriver->RxQueueHead < LanDriver->RxQueueCount) {
+    NetsecDequeueRx (LanDriver);
+  }
+
   Snp->Mode->State = EfiSimpleNetworkStarted;
   Status = EFI_SUCCESS;
 
@@ -593,6 +688,84 @@ ExitUnlock:
   return Status;
 }
 
+/*
+ *  UEFI Statistics() function
+ */
+STATIC
+EFI_STATUS
+EFIAPI
+SnpStatistics (
+  IN        EFI_SIMPLE_NETWORK_PROTOCOL *Snp,
+  IN        BOOLEAN                     Reset,
+  IN  OUT   UINTN                       *StatSize   OPTIONAL,
+      OUT   EFI_NETWORK_STATISTICS      *Statistics OPTIONAL
+  )
+{
+  NETSEC_DRIVER       *LanDriver;
+  EFI_TPL             SavedTpl;
+  EFI_STATUS          Status;
+
+  // Check Snp Instance
+  if (Snp == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // Check pointless condition
+  if (!Reset && StatSize == NULL && Statistics == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  // Check the parameters
+  if (StatSize == NULL && Statistics != NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // Serialize access to data and registers
+  SavedTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  // Check that driver was started and initialised
+  switch (Snp->Mode->State) {
+  case EfiSimpleNetworkInitialized:
+    break;
+  case EfiSimpleNetworkStarted:
+    DEBUG ((DEBUG_WARN, "NETSEC: Driver not yet initialized\n"));
+    ReturnUnlock (EFI_DEVICE_ERROR);
+  case EfiSimpleNetworkStopped:
+    DEBUG ((DEBUG_WARN, "NETSEC: Driver not started\n"));
+    ReturnUnlock (EFI_NOT_STARTED);
+  default:
+    DEBUG ((DEBUG_ERROR, "NETSEC: Driver in an invalid state: %u\n",
+      (UINTN)Snp->Mode->State));
+    ReturnUnlock (EFI_DEVICE_ERROR);
+  }
+
+  // Find the LanDriver structure
+  LanDriver = INSTANCE_FROM_SNP_THIS (Snp);
+
+  Status = EFI_SUCCESS;
+
+  // Copy out as much of the counters as the caller has room for
+  if (StatSize != NULL) {
+    if (Statistics != NULL) {
+      CopyMem (Statistics, &LanDriver->Stats,
+        MIN (*StatSize, sizeof (EFI_NETWORK_STATISTICS)));
+    }
+    if (Statistics == NULL || *StatSize < sizeof (EFI_NETWORK_STATISTICS)) {
+      Status = EFI_BUFFER_TOO_SMALL;
+    }
+    *StatSize = sizeof (EFI_NETWORK_STATISTICS);
+  }
+
+  if (Reset) {
+    NetsecResetStatistics (LanDriver);
+  }
+
+  // Restore TPL and return
+ExitUnlock:
+  gBS->RestoreTPL (SavedTpl);
+  return Status;
+}
+
 /*
  *  UEFI GetStatus () function
  */
@@ -611,8 +784,6 @@ SnpGetStatus (
   pfdep_pkt_handle_t        pkt_handle;
   LIST_ENTRY                *Link;
 
-  ogma_err_t              ogma_err;
-
   // Check preliminaries
   if (Snp == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -640,24 +811,23 @@ SnpGetStatus (
   // Find the LanDriver structure
   LanDriver = INSTANCE_FROM_SNP_THIS (Snp);
 
-  ogma_err = ogma_clean_tx_desc_ring (LanDriver->Handle,
-                                      OGMA_DESC_RING_ID_NRM_TX);
-
   if (TxBuff != NULL) {
     *TxBuff = NULL;
     //
-    // Find a buffer in the list that has been released
+    // The hardware completes transmits in order, so only the oldest buffer
+    // in the list needs checking. Reap completions in bulk only when it has
+    // not been released yet.
     //
-    for (Link = GetFirstNode (&LanDriver->TxBufferList);
-         !IsNull (&LanDriver->TxBufferList, Link);
-         Link = GetNextNode (&LanDriver->TxBufferList, Link)) {
-
+    if (!IsListEmpty (&LanDriver->TxBufferList)) {
+      Link = GetFirstNode (&LanDriver->TxBufferList);
       pkt_handle = BASE_CR (Link, PACKET_HANDLE, Link);
+      if (!pkt_handle->Released) {
+        NetsecReapTx (LanDriver);
+      }
       if (pkt_handle->Released) {
         *TxBuff = pkt_handle->Buffer;
         RemoveEntryList (Link);
         FreePool (pkt_handle);
-        break;
       }
     }
   }
@@ -738,23 +908,16 @@ SnpTransmit (
   // Find the LanDriver structure
   LanDriver = INSTANCE_FROM_SNP_THIS (Snp);
 
-  ogma_err = ogma_clear_desc_ring_irq_status (LanDriver->Handle,
-                                              OGMA_DESC_RING_ID_NRM_TX,
-                                              OGMA_CH_IRQ_REG_EMPTY);
-  if (ogma_err != OGMA_ERR_OK) {
-    DEBUG ((DEBUG_ERROR,
-      "NETSEC: ogma_clear_desc_ring_irq_status failed with error code: %d\n",
-      (INT32)ogma_err));
-    ReturnUnlock (EFI_DEVICE_ERROR);
-  }
-
-  ogma_err = ogma_clean_tx_desc_ring (LanDriver->Handle,
-                                      OGMA_DESC_RING_ID_NRM_TX);
-  if (ogma_err != OGMA_ERR_OK) {
-    DEBUG ((DEBUG_ERROR,
-      "NETSEC: ogma_clean_tx_desc_ring failed with error code: %d\n",
-      (INT32)ogma_err));
-    ReturnUnlock (EFI_DEVICE_ERROR);
+  // Only reap completed transmits once the ring has run out of room
+  tx_avail_num = ogma_get_tx_avail_num (LanDriver->Handle,
+                                        OGMA_DESC_RING_ID_NRM_TX);
+  if (tx_avail_num < SCAT_NUM) {
+    NetsecReapTx (LanDriver);
+    tx_avail_num = ogma_get_tx_avail_num (LanDriver->Handle,
+                                          OGMA_DESC_RING_ID_NRM_TX);
+    if (tx_avail_num < SCAT_NUM) {
+      ReturnUnlock (EFI_NOT_READY);
+    }
   }
 
   // Ensure header is correct size if non-zero
@@ -803,12 +966,6 @@ SnpTransmit (
   tx_pkt_ctrl.pass_through_flag     = OGMA_TRUE;
   tx_pkt_ctrl.target_desc_ring_id   = OGMA_DESC_RING_ID_GMAC;
 
-  // check empty slot
-  do {
-    tx_avail_num = ogma_get_tx_avail_num (LanDriver->Handle,
-                                          OGMA_DESC_RING_ID_NRM_TX);
-  } while (tx_avail_num < SCAT_NUM);
-
   // send
   ogma_err = ogma_set_tx_pkt_data (LanDriver->Handle,
                                    OGMA_DESC_RING_ID_NRM_TX,
@@ -819,13 +976,17 @@ SnpTransmit (
 
   if (ogma_err != OGMA_ERR_OK) {
     DmaUnmap (pkt_handle->Mapping);
-    FreePool (pkt_handle);
     DEBUG ((DEBUG_ERROR,
       "NETSEC: ogma_set_tx_pkt_data failed with error code: %d\n",
       (INT32)ogma_err));
+    LanDriver->Stats.TxTotalFrames++;
     ReturnUnlock (EFI_DEVICE_ERROR);
   }
 
+  LanDriver->Stats.TxTotalFrames++;
+  LanDriver->Stats.TxGoodFrames++;
+  LanDriver->Stats.TxTotalBytes += BufSize;
+
   //
   // Queue the descriptor so we can release the buffer once it has been
   // consumed by the hardware.
@@ -861,9 +1022,7 @@ SnpReceive (
   EFI_STATUS          Status;
   NETSEC_DRIVER       *LanDriver;
 
-  ogma_err_t          ogma_err;
-  ogma_rx_pkt_info_t  rx_pkt_info;
-  ogma_frag_info_t    rx_data;
+  UINT16              Index;
   ogma_uint16         len;
   pfdep_pkt_handle_t  pkt_handle;
 
@@ -894,43 +1053,54 @@ SnpReceive (
   // Find the LanDriver structure
   LanDriver = INSTANCE_FROM_SNP_THIS (Snp);
 
-  if (ogma_get_rx_num (LanDriver->Handle, OGMA_DESC_RING_ID_NRM_RX) > 0) {
-
-    ogma_err = ogma_get_rx_pkt_data (LanDriver->Handle,
-                                    OGMA_DESC_RING_ID_NRM_RX,
-                                    &rx_pkt_info, &rx_data, &len, &pkt_handle);
-    if (ogma_err != OGMA_ERR_OK) {
-      DEBUG ((DEBUG_ERROR,
-        "NETSEC: ogma_get_rx_pkt_data failed with error code: %d\n",
-        (INT32)ogma_err));
-      ReturnUnlock (EFI_DEVICE_ERROR);
-    }
-
-    DmaUnmap (pkt_handle->Mapping);
-    pkt_handle->Mapping = NULL;
+  //
+  // Once the previous batch has been consumed, drain everything the hardware
+  // has received since in one go, and reap the completed transmits along
+  // with it. Everything is polled, so no interrupts need to be re-armed.
+  //
+  if (LanDriver->RxQueueHead == LanDriver->RxQueueCount) {
+    NetsecPollRx (LanDriver);
+    NetsecReapTx (LanDriver);
+  }
 
-    CopyMem (Data, (VOID *)rx_data.addr, len);
-    *BuffSize = len;
+  // Skip over packets the hardware flagged as bad
+  while (LanDriver->RxQueueHead < LanDriver->RxQueueCount &&
+         LanDriver->RxPktInfo[LanDriver->RxQueueHead].err_flag) {
+    LanDriver->Stats.RxTotalFrames++;
+    LanDriver->Stats.RxDroppedFrames++;
+    NetsecDequeueRx (LanDriver);
+  }
 
-    pfdep_free_pkt_buf (LanDriver->Handle, rx_data.len, rx_data.addr,
-      rx_data.phys_addr, PFDEP_TRUE, pkt_handle);
-  } else {
+  if (LanDriver->RxQueueHead == LanDriver->RxQueueCount) {
     // not received any packets
     ReturnUnlock (EFI_NOT_READY);
   }
 
-  if (HdrSize != NULL) {
-    *HdrSize = LanDriver->SnpMode.MediaHeaderSize;
+  Index = LanDriver->RxQueueHead;
+  len = LanDriver->RxPktLen[Index];
+  pkt_handle = LanDriver->RxPktHandle[Index];
+
+  // Leave the packet queued until the caller offers a large enough buffer
+  if (*BuffSize < len) {
+    *BuffSize = len;
+    ReturnUnlock (EFI_BUFFER_TOO_SMALL);
   }
 
-  ogma_clear_desc_ring_irq_status (LanDriver->Handle,
-                                   OGMA_DESC_RING_ID_NRM_TX,
-                                   OGMA_CH_IRQ_REG_EMPTY);
+  DmaUnmap (pkt_handle->Mapping);
+  pkt_handle->Mapping = NULL;
 
-  ogma_clean_tx_desc_ring (LanDriver->Handle, OGMA_DESC_RING_ID_NRM_TX);
+  CopyMem (Data, (VOID *)LanDriver->RxFragInfo[Index].addr, len);
+  *BuffSize = len;
 
-  ogma_enable_top_irq (LanDriver->Handle,
-                       OGMA_TOP_IRQ_REG_NRM_TX | OGMA_TOP_IRQ_REG_NRM_RX);
+  NetsecDequeueRx (LanDriver);
+
+  LanDriver->Stats.RxTotalFrames++;
+  LanDriver->Stats.RxGoodFrames++;
+  LanDriver->Stats.RxTotalBytes += len;
+
+  if (HdrSize != NULL) {
+    *HdrSize = LanDriver->SnpMode.MediaHeaderSize;
+  }
 
   Status = EFI_SUCCESS;
 
@@ -1083,7 +1253,7 @@ NetsecInit (
   Snp->Shutdown = SnpShutdown;
   Snp->ReceiveFilters = SnpReceiveFilters;
   Snp->StationAddress = NULL;
-  Snp->Statistics = NULL;
+  Snp->Statistics = SnpStatistics;
   Snp->MCastIpToMac = NULL;
   Snp->NvData = NULL;
   Snp->GetStatus = SnpGetStatus;
@@ -1121,13 +1291,15 @@ NetsecInit (
   // Mac address is changeable
   SnpMode->MacAddressChangeable = TRUE;
 
-  // We can only transmit one packet at a time
-  SnpMode->MultipleTxSupported = FALSE;
+  // Transmits are queued on the descriptor ring and reaped in bulk
+  SnpMode->MultipleTxSupported = TRUE;
 
   // MediaPresent checks for cable connection and partner link
   SnpMode->MediaPresentSupported = TRUE;
   SnpMode->MediaPresent = FALSE;
 
+  NetsecResetStatistics (LanDriver);
+
   LanDriver->Aip.GetInformation     = NetsecAipGetInformation;
   LanDriver->Aip.SetInformation     = NetsecAipSetInformation;
   LanDriver->Aip.GetSupportedTypes  = NetsecAipGetSupportedTypes;
@@ -17,6 +17,7 @@
 #include <Library/IoLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/NetLib.h>
+#include <Library/PcdLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
 
@@ -36,6 +37,9 @@ extern EFI_DRIVER_BINDING_PROTOCOL  gNetsecDriverBinding;
 
 #define ReturnUnlock(s)   do { Status = (s); goto ExitUnlock; } while (0)
 
+// A batched RX poll can drain the whole ring
+#define NETSEC_RX_QUEUE_SIZE        FixedPcdGet16 (PcdDecRxDescNum)
+
 /*------------------------------------------------------------------------------
   NETSEC Information Structure
 ------------------------------------------------------------------------------*/
@@ -61,6 +65,15 @@ typedef struct {
   // List of submitted TX buffers
   LIST_ENTRY                        TxBufferList;
 
+  // Packets drained from the RX ring by a single batched poll, returned by
+  // SnpReceive() in order starting at RxQueueHead
+  ogma_rx_pkt_info_t                RxPktInfo[NETSEC_RX_QUEUE_SIZE];
+  ogma_frag_info_t                  RxFragInfo[NETSEC_RX_QUEUE_SIZE];
+  ogma_uint16                       RxPktLen[NETSEC_RX_QUEUE_SIZE];
+  pfdep_pkt_handle_t                RxPktHandle[NETSEC_RX_QUEUE_SIZE];
+  UINT16                            RxQueueHead;
+  UINT16                            RxQueueCount;
+
   EFI_EVENT                         ExitBootEvent;
 
   EFI_EVENT                         PhyStatusEvent;
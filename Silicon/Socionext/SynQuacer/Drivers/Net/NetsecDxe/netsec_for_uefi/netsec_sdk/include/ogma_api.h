@@ -536,6 +536,17 @@ ogma_err_t ogma_get_rx_pkt_data (
     pfdep_pkt_handle_t *pkt_handle_p
     );
 
+ogma_err_t ogma_get_rx_pkt_data_burst (
+    ogma_handle_t ogma_handle,
+    ogma_desc_ring_id_t ring_id,
+    ogma_uint16 max_num,
+    ogma_rx_pkt_info_t *rx_pkt_info_p,
+    ogma_frag_info_t *frag_info_p,
+    ogma_uint16 *len_p,
+    pfdep_pkt_handle_t *pkt_handle_p,
+    ogma_uint16 *num_p
+    );
+
 ogma_err_t ogma_enable_top_irq (
     ogma_handle_t ogma_handle,
     ogma_uint32 irq_factor
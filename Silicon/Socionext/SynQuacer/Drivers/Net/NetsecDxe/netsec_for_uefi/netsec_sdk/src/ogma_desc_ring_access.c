@@ -1342,6 +1342,117 @@ end:
     return ogma_err;
 }
 
+/*
+ * Drain up to max_num received packets from the ring in one go: the RX
+ * packet counter is read and the soft lock taken once, and every drained
+ * descriptor is refilled with a fresh buffer before it is handed back to
+ * the hardware. The i-th packet is returned in the i-th element of each
+ * output array, and the number of packets in *num_p.
+ */
+ogma_err_t ogma_get_rx_pkt_data_burst (
+    ogma_handle_t ogma_handle,
+    ogma_desc_ring_id_t ring_id,
+    ogma_uint16 max_num,
+    ogma_rx_pkt_info_t *rx_pkt_info_p,
+    ogma_frag_info_t *frag_info_p,
+    ogma_uint16 *len_p,
+    pfdep_pkt_handle_t *pkt_handle_p,
+    ogma_uint16 *num_p
+    )
+{
+
+    ogma_err_t ogma_err = OGMA_ERR_OK;
+    ogma_ctrl_t *ctrl_p = (ogma_ctrl_t *)ogma_handle;
+    ogma_desc_ring_t *desc_ring_p;
+    ogma_frag_info_t tmp_frag_info;
+    ogma_uint32 result;
+    ogma_uint16 num = 0;
+
+    pfdep_err_t pfdep_err;
+    pfdep_pkt_handle_t tmp_pkt_handle;
+    pfdep_soft_lock_ctx_t soft_lock_ctx;
+
+    if ( ( ctrl_p == NULL) ||
+         ( rx_pkt_info_p == NULL) ||
+         ( frag_info_p == NULL) ||
+         ( len_p == NULL) ||
+         ( pkt_handle_p == NULL) ||
+         ( num_p == NULL) ||
+         ( ring_id > OGMA_DESC_RING_ID_MAX) ) {
+        return OGMA_ERR_PARAM;
+    }
+
+    *num_p = 0;
+
+    if ( !ctrl_p->desc_ring[ring_id].param.valid_flag) {
+        return OGMA_ERR_NOTAVAIL;
+    }
+
+    if ( !ctrl_p->desc_ring[ring_id].rx_desc_ring_flag) {
+        return OGMA_ERR_PARAM;
+    }
+
+    desc_ring_p = &ctrl_p->desc_ring[ring_id];
+
+    if ( ( pfdep_err = pfdep_acquire_soft_lock(
+              &desc_ring_p->soft_lock,
+              &soft_lock_ctx ) ) != PFDEP_ERR_OK) {
+        return OGMA_ERR_INTERRUPT;
+    }
+
+    result = ogma_read_reg( ctrl_p, rx_pkt_cnt_reg_addr[ring_id]);
+
+    desc_ring_p->rx_num += result;
+
+    if ( result != 0) {
+        ogma_inc_desc_head_idx( ctrl_p, desc_ring_p, ( ogma_uint16)result);
+    }
+
+    tmp_frag_info.len = ctrl_p->rx_pkt_buf_len;
+
+    pfdep_read_mem_barrier();
+
+    while ( ( num < max_num) && ( desc_ring_p->rx_num != 0) ) {
+
+        if ( ( pfdep_err = pfdep_alloc_pkt_buf (
+                   ctrl_p->dev_handle,
+                   tmp_frag_info.len,
+                   &tmp_frag_info.addr,
+                   &tmp_frag_info.phys_addr,
+                   &tmp_pkt_handle) ) != PFDEP_ERR_OK) {
+            /* Leave the remaining packets for the next call */
+            ogma_err = OGMA_ERR_ALLOC;
+            break;
+        }
+
+        ogma_get_rx_desc_entry( ctrl_p,
+                                desc_ring_p,
+                                desc_ring_p->tail_idx,
+                                &rx_pkt_info_p[num],
+                                &frag_info_p[num],
+                                &len_p[num],
+                                &pkt_handle_p[num]);
+
+        ogma_set_rx_desc_entry( ctrl_p,
+                                desc_ring_p,
+                                desc_ring_p->tail_idx,
+                                &tmp_frag_info,
+                                tmp_pkt_handle);
+
+        ogma_inc_desc_tail_idx( ctrl_p, desc_ring_p, 1);
+
+        --desc_ring_p->rx_num;
+        ++num;
+    }
+
+    *num_p = num;
+
+    pfdep_release_soft_lock( &desc_ring_p->soft_lock,
+                             &soft_lock_ctx);
+
+    return ogma_err;
+}
+
 ogma_err_t ogma_set_irq_coalesce_param (
     ogma_handle_t ogma_handle,
     ogma_desc_ring_id_t ring_id,
@@ -13,7 +13,7 @@
 #include <Library/DmaLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/NetLib.h>
-#include <Library/SynchronizationLib.h>
+#include <Library/PcdLib.h>
 
 /**********************************************************************
  * Variable definitions
@@ -99,10 +99,12 @@ pfdep_dma_free (
 // On the receive path, we allocate a new packet and link it into the RX ring
 // before returning the received packet to the caller. This means we perform
 // one allocation and one free operation for each buffer received.
-// So let's cache a single packet, and get rid of most of the alloc/free
-// overhead on the RX path.
+// The RX path drains and refills the ring in batches, so keep a stack of up
+// to one ring's worth of spare packets, and get rid of the alloc/free
+// overhead on the RX path. All callers run at TPL_CALLBACK.
 //
-STATIC pfdep_pkt_handle_t mSparePacketBuffer;
+STATIC pfdep_pkt_handle_t mSparePacketBuffers[FixedPcdGet16 (PcdDecRxDescNum)];
+STATIC UINTN  mSparePacketBufferCount;
 STATIC UINT32 mSparePacketBufferSize;
 
 pfdep_err_t
@@ -119,8 +121,8 @@ pfdep_alloc_pkt_buf (
 
   NumBytes = ALIGN_VALUE (len, mCpu->DmaBufferAlignment);
 
-  if (InterlockedCompareExchange32 (&mSparePacketBufferSize, len, 0) == len) {
-    *pkt_handle_p = mSparePacketBuffer;
+  if (mSparePacketBufferCount > 0 && mSparePacketBufferSize == len) {
+    *pkt_handle_p = mSparePacketBuffers[--mSparePacketBufferCount];
   } else {
     *pkt_handle_p = AllocateZeroPool (NumBytes + sizeof(PACKET_HANDLE) +
                                       (mCpu->DmaBufferAlignment - 8));
@@ -162,8 +164,10 @@ pfdep_free_pkt_buf (
 
   if (pkt_handle->RecycleForTx) {
       pkt_handle->Released = TRUE;
-  } else if (!InterlockedCompareExchange32 (&mSparePacketBufferSize, 0, len)) {
-    mSparePacketBuffer = pkt_handle;
+  } else if (mSparePacketBufferCount < ARRAY_SIZE (mSparePacketBuffers) &&
+             (mSparePacketBufferCount == 0 || mSparePacketBufferSize == len)) {
+    mSparePacketBufferSize = len;
+    mSparePacketBuffers[mSparePacketBufferCount++] = pkt_handle;
   } else {
     FreePool (pkt_handle);
   }
@@ -10,9 +10,9 @@
 
 #include <Library/DebugLib.h>
 #include <Library/DevicePathLib.h>
-#include <Library/DmaLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/NetLib.h>
+#include <Library/PcdLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
 STATIC
@@ -117,10 +117,6 @@ DriverStart (
   SIMPLE_NETWORK_DEVICE_PATH       *DevicePath;
   UINT64                           DefaultMacAddress;
   EFI_MAC_ADDRESS                  *SwapMacAddressPtr;
-  UINTN                            DescriptorSize;
-  UINTN                            BufferSize;
-  UINTN                            *RxBufferAddr;
-  EFI_PHYSICAL_ADDRESS             RxBufferAddrMap;
 
   // Allocate Resources
   Snp = AllocatePages (EFI_SIZE_TO_PAGES (sizeof (SIMPLE_NETWORK_DRIVER)));
@@ -135,51 +131,13 @@ DriverStart (
                               Controller,
                               EFI_OPEN_PROTOCOL_BY_DRIVER);
 
-  // Size for descriptor
-  DescriptorSize = EFI_PAGES_TO_SIZE (sizeof (DESIGNWARE_HW_DESCRIPTOR));
-  // Size for transmit and receive buffer
-  BufferSize = ETH_BUFSIZE;
-
-  for (int Index=0; Index < DESC_NUM; Index++) {
-    //DMA TxdescRing allocate buffer and map
-    Status = DmaAllocateBuffer (EfiBootServicesData,
-               EFI_SIZE_TO_PAGES (sizeof (DESIGNWARE_HW_DESCRIPTOR)), (VOID *)&Snp->MacDriver.TxdescRing[Index]);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a () for TxdescRing: %r\n", __FUNCTION__, Status));
-      return Status;
-    }
-
-    Status = DmaMap (MapOperationBusMasterCommonBuffer, Snp->MacDriver.TxdescRing[Index],
-               &DescriptorSize, &Snp->MacDriver.TxdescRingMap[Index].AddrMap, &Snp->MacDriver.TxdescRingMap[Index].Mapping);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a () for TxdescRing: %r\n", __FUNCTION__, Status));
-      return Status;
-    }
-
-    // DMA RxdescRing allocte buffer and map
-    Status = DmaAllocateBuffer (EfiBootServicesData,
-               EFI_SIZE_TO_PAGES (sizeof (DESIGNWARE_HW_DESCRIPTOR)), (VOID *)&Snp->MacDriver.RxdescRing[Index]);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a () for RxdescRing: %r\n", __FUNCTION__, Status));
-      return Status;
-    }
-
-    Status = DmaMap (MapOperationBusMasterCommonBuffer, Snp->MacDriver.RxdescRing[Index],
-               &DescriptorSize, &Snp->MacDriver.RxdescRingMap[Index].AddrMap, &Snp->MacDriver.RxdescRingMap[Index].Mapping);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a () for RxdescRing: %r\n", __FUNCTION__, Status));
-      return Status;
-    }
-
-    //DMA mapping for receive buffer
-    RxBufferAddr = (UINTN*)((UINTN)Snp->MacDriver.RxBuffer + (Index * BufferSize));
-    Status = DmaMap (MapOperationBusMasterWrite,  (VOID *) RxBufferAddr,
-               &BufferSize, &RxBufferAddrMap, &Snp->MacDriver.RxBufNum[Index].Mapping);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a () for Rxbuffer: %r\n", __FUNCTION__, Status));
-      return Status;
-    }
-    Snp->MacDriver.RxBufNum[Index].AddrMap= RxBufferAddrMap;
+  // Allocate and map the descriptor rings and packet buffers once; they stay
+  // mapped until the driver is stopped
+  Status = EmacDmaAllocate (&Snp->MacDriver,
+             PcdGet32 (PcdDwEmacTxDescriptorCount),
+             PcdGet32 (PcdDwEmacRxDescriptorCount));
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
   DevicePath = (SIMPLE_NETWORK_DEVICE_PATH*)AllocateCopyPool (sizeof (SIMPLE_NETWORK_DEVICE_PATH), &PathTemplate);
@@ -216,12 +174,14 @@ DriverStart (
   Snp->Snp.Transmit = SnpTransmit;
   Snp->Snp.Receive = SnpReceive;
 
-  Snp->RecycledTxBuf = AllocatePool (sizeof (UINT64) * SNP_TX_BUFFER_INCREASE);
+  // Each transmit descriptor holds at most one unrecycled caller buffer
+  Snp->RecycledTxBuf = AllocatePool (sizeof (UINT64) * Snp->MacDriver.TxDescriptorCount);
   if (Snp->RecycledTxBuf == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
+    EmacDmaFree (&Snp->MacDriver);
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  Snp->MaxRecycledTxBuf = SNP_TX_BUFFER_INCREASE;
+  Snp->MaxRecycledTxBuf = Snp->MacDriver.TxDescriptorCount;
   Snp->RecycledTxBufCount = 0;
 
   // Start completing simple network mode structure
@@ -253,8 +213,8 @@ DriverStart (
   // Mac address is changeable as it is loaded from erasable memory
   SnpMode->MacAddressChangeable = TRUE;
 
-  // Can only transmit one packet at a time
-  SnpMode->MultipleTxSupported = FALSE;
+  // Up to one packet per transmit descriptor can be outstanding
+  SnpMode->MultipleTxSupported = TRUE;
 
   // MediaPresent checks for cable connection and partner link
   SnpMode->MediaPresentSupported = TRUE;
@@ -335,7 +295,10 @@ DriverStop (
     return Status;
   }
 
+  // The DMA engines must be idle before their rings and buffers go away
+  EmacStopTxRx (Snp->MacBase);
   FreePool (Snp->RecycledTxBuf);
+  EmacDmaFree (&Snp->MacDriver);
   FreePages (Snp, EFI_SIZE_TO_PAGES (sizeof (SIMPLE_NETWORK_DRIVER)));
 
   return Status;
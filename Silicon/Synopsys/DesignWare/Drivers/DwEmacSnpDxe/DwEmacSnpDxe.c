@@ -16,10 +16,10 @@
 #include "EmacDxeUtil.h"
 #include "PhyDxeUtil.h"
 
+#include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/NetLib.h>
-#include <Library/DmaLib.h>
 
 /**
   Change the state of a network interface from "stopped" to "started."
@@ -768,6 +768,42 @@ SnpNvData (
 }
 
 
+/**
+  Move the caller buffers of all transmits the DMA engine has completed to
+  the recycled transmit buffer list.
+
+  @param Snp    The driver instance.
+
+**/
+STATIC
+VOID
+SnpRecycleTxBuffers (
+  IN  SIMPLE_NETWORK_DRIVER   *Snp
+  )
+{
+  EMAC_DRIVER                *MacDriver;
+  DESIGNWARE_HW_DESCRIPTOR   *TxDescriptor;
+  UINT32                     DescNum;
+
+  MacDriver = &Snp->MacDriver;
+  while (MacDriver->TxPendingCount > 0) {
+    DescNum = MacDriver->TxCurrentDescriptorNum;
+    TxDescriptor = &MacDriver->TxdescRing[DescNum];
+    if ((TxDescriptor->Tdes0 & TDES0_OWN) != 0) {
+      break;
+    }
+
+    ASSERT (Snp->RecycledTxBufCount < Snp->MaxRecycledTxBuf);
+    Snp->RecycledTxBuf[Snp->RecycledTxBufCount] = (UINT64)(UINTN)MacDriver->TxBufferOwner[DescNum];
+    Snp->RecycledTxBufCount++;
+    MacDriver->TxBufferOwner[DescNum] = NULL;
+
+    MacDriver->TxPendingCount--;
+    MacDriver->TxCurrentDescriptorNum = (DescNum + 1) % MacDriver->TxDescriptorCount;
+  }
+}
+
+
 /**
   Reads the current interrupt status and recycled transmit buffer status from a
   network interface.
@@ -837,6 +873,12 @@ SnpGetStatus (
 
   // TxBuff
   if (TxBuff != NULL) {
+    if (EFI_ERROR (EfiAcquireLockOrFail (&Snp->Lock))) {
+      return EFI_ACCESS_DENIED;
+    }
+
+    SnpRecycleTxBuffers (Snp);
+
     // Get a recycled buf from Snp->RecycledTxBuf
     if (Snp->RecycledTxBufCount == 0) {
       *TxBuff = NULL;
@@ -844,6 +886,8 @@ SnpGetStatus (
       Snp->RecycledTxBufCount--;
       *TxBuff = (VOID *)(UINTN) Snp->RecycledTxBuf[Snp->RecycledTxBufCount];
     }
+
+    EfiReleaseLock (&Snp->Lock);
   }
 
   // Check DMA Irq status
@@ -921,28 +965,15 @@ SnpTransmit (
   )
 {
   SIMPLE_NETWORK_DRIVER      *Snp;
+  EMAC_DRIVER                *MacDriver;
   UINT32                     DescNum;
   DESIGNWARE_HW_DESCRIPTOR   *TxDescriptor;
-  DESIGNWARE_HW_DESCRIPTOR   *TxDescriptorMap;
   UINT8                      *EthernetPacket;
-  UINT64                     *Tmp;
-  EFI_STATUS                 Status;
-  UINTN                      BufferSizeBuf;
-  EFI_PHYSICAL_ADDRESS       TxBufferAddrMap;
 
-  BufferSizeBuf = ETH_BUFSIZE;
   EthernetPacket = Data;
 
   Snp = INSTANCE_FROM_SNP_THIS (This);
 
-  if (EFI_ERROR (EfiAcquireLockOrFail (&Snp->Lock))) {
-    return EFI_ACCESS_DENIED;
-  }
-
-  if ((Snp->MaxRecycledTxBuf + SNP_TX_BUFFER_INCREASE) >= SNP_MAX_TX_BUFFER_NUM) {
-    return EFI_NOT_READY;
-  }
-
   // Check preliminaries
   if ((This == NULL) || (Data == NULL)) {
     return EFI_INVALID_PARAMETER;
@@ -951,12 +982,6 @@ SnpTransmit (
     return EFI_NOT_STARTED;
   }
 
-  Snp->MacDriver.TxCurrentDescriptorNum = Snp->MacDriver.TxNextDescriptorNum;
-  DescNum = Snp->MacDriver.TxCurrentDescriptorNum;
-
-  TxDescriptor = Snp->MacDriver.TxdescRing[DescNum];
-  TxDescriptorMap = (VOID *)(UINTN)Snp->MacDriver.TxdescRingMap[DescNum].AddrMap;
-
   // Ensure header is correct size if non-zero
   if (HdrSize) {
     if (HdrSize != Snp->SnpMode.MediaHeaderSize) {
@@ -972,6 +997,26 @@ SnpTransmit (
   if (BuffSize < Snp->SnpMode.MediaHeaderSize) {
     return EFI_BUFFER_TOO_SMALL;
   }
+  if (BuffSize > TX_MAX_FRAME_SIZE) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (EFI_ERROR (EfiAcquireLockOrFail (&Snp->Lock))) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  MacDriver = &Snp->MacDriver;
+
+  // Every queued packet needs a free descriptor now and a slot in the recycled
+  // buffer list once it has been sent
+  SnpRecycleTxBuffers (Snp);
+  if (MacDriver->TxPendingCount + Snp->RecycledTxBufCount >= Snp->MaxRecycledTxBuf) {
+    EfiReleaseLock (&Snp->Lock);
+    return EFI_NOT_READY;
+  }
+
+  DescNum = MacDriver->TxNextDescriptorNum;
+  TxDescriptor = &MacDriver->TxdescRing[DescNum];
 
   if (HdrSize) {
     EthernetPacket[0] = DstAddr->Addr[0];
@@ -992,50 +1037,29 @@ SnpTransmit (
     EthernetPacket[12] = (*Protocol & 0xFF00) >> 8;
   }
 
-  CopyMem ((VOID *)(UINTN)TxDescriptor->Addr, EthernetPacket, BuffSize);
-
-  Status = DmaMap (MapOperationBusMasterRead, (VOID *)(UINTN)TxDescriptor->Addr,
-             &BufferSizeBuf, &TxBufferAddrMap, &Snp->MappingTxbuf);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a () for Txbuffer: %r\n", __FUNCTION__, Status));
-    return Status;
-  }
-  TxDescriptorMap->Addr = TxBufferAddrMap;
+  // The packet buffers are mapped once at driver start, so a copy is all that
+  // is needed to hand the packet to the DMA engine
+  CopyMem (EMAC_TX_BUFFER (MacDriver, DescNum), EthernetPacket, BuffSize);
 
   TxDescriptor->Tdes1 = (BuffSize << TDES1_SIZE1SHFT) &
                          TDES1_SIZE1MASK;
 
-  TxDescriptor->Tdes0 |= (TDES0_TXFIRST |
-                          TDES0_TXLAST |
-                          TDES0_OWN);
+  // Make the buffer and length visible before handing over ownership
+  MemoryFence ();
+  TxDescriptor->Tdes0 = TDES0_TXCHAIN |
+                        TDES0_TXFIRST |
+                        TDES0_TXLAST |
+                        TDES0_OWN;
 
-  // Increase descriptor number
-  DescNum++;
+  MacDriver->TxBufferOwner[DescNum] = Data;
+  MacDriver->TxPendingCount++;
 
-  if (DescNum >= CONFIG_TX_DESCR_NUM) {
-    DescNum = 0;
-  }
-
-  Snp->MacDriver.TxNextDescriptorNum = DescNum;
-
-  if (Snp->RecycledTxBufCount < Snp->MaxRecycledTxBuf) {
-    Snp->RecycledTxBuf[Snp->RecycledTxBufCount] = (UINT64)(UINTN)Data;
-    Snp->RecycledTxBufCount ++;
-  } else {
-    Tmp = AllocatePool (sizeof (UINT64) * (Snp->MaxRecycledTxBuf + SNP_TX_BUFFER_INCREASE));
-    if (Tmp == NULL) {
-      return EFI_DEVICE_ERROR;
-    }
-    CopyMem (Tmp, Snp->RecycledTxBuf, sizeof (UINT64) * Snp->RecycledTxBufCount);
-    FreePool (Snp->RecycledTxBuf);
-    Snp->RecycledTxBuf = Tmp;
-    Snp->MaxRecycledTxBuf += SNP_TX_BUFFER_INCREASE;
-  }
+  // Increase descriptor number
+  MacDriver->TxNextDescriptorNum = (DescNum + 1) % MacDriver->TxDescriptorCount;
 
   // Start the transmission
   EmacDmaStart (Snp->MacBase);
 
-  DmaUnmap (Snp->MappingTxbuf);
   EfiReleaseLock (&Snp->Lock);
   return EFI_SUCCESS;
 }
@@ -1102,6 +1126,7 @@ SnpReceive (
   )
 {
   SIMPLE_NETWORK_DRIVER      *Snp;
+  EMAC_DRIVER                *MacDriver;
   EFI_MAC_ADDRESS            Dst;
   EFI_MAC_ADDRESS            Src;
   UINT32                     Length;
@@ -1109,14 +1134,8 @@ SnpReceive (
   UINT8                      *RawData;
   UINT32                     DescNum;
   DESIGNWARE_HW_DESCRIPTOR   *RxDescriptor;
-  DESIGNWARE_HW_DESCRIPTOR   *RxDescriptorMap;
-  UINTN                      BufferSizeBuf;
-  UINTN                      *RxBufferAddr;
-  EFI_PHYSICAL_ADDRESS       RxBufferAddrMap;
   EFI_STATUS                 Status;
 
-  BufferSizeBuf = ETH_BUFSIZE;
-
   Snp = INSTANCE_FROM_SNP_THIS (This);
 
   // Check preliminaries
@@ -1132,83 +1151,88 @@ SnpReceive (
     return EFI_ACCESS_DENIED;
   }
 
-  Snp->MacDriver.RxCurrentDescriptorNum = Snp->MacDriver.RxNextDescriptorNum;
-  DescNum = Snp->MacDriver.RxCurrentDescriptorNum;
-  RxDescriptor = Snp->MacDriver.RxdescRing[DescNum];
-  RxBufferAddr = (UINTN*)((UINTN)Snp->MacDriver.RxBuffer +
-                          (DescNum * BufferSizeBuf));
-  RxDescriptorMap = (VOID *)(UINTN)Snp->MacDriver.RxdescRingMap[DescNum].AddrMap;
-
+  MacDriver = &Snp->MacDriver;
   RawData = (UINT8 *) Data;
 
-  DescriptorStatus = RxDescriptor->Tdes0;
-  if (DescriptorStatus & ((UINT32)RDES0_OWN)) {
-    goto ReleaseLock;
-  }
-
-  if (DescriptorStatus & RDES0_SAF) {
-    DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Source Address Filter Fail\n"));
-    return EFI_DEVICE_ERROR;
-  }
-
-  if (DescriptorStatus & RDES0_AFM) {
-    DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Destination Address Filter Fail\n"));
-    return EFI_DEVICE_ERROR;
-  }
-
-  if (DescriptorStatus & RDES0_ES) {
-    // Check for errors
-    if (DescriptorStatus & RDES0_RE) {
-      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Receive Error\n"));
-    }
-    if (DescriptorStatus & RDES0_DE) {
-      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Receive Error\n"));
-    }
-    if (DescriptorStatus & RDES0_RWT) {
-      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Watchdog Timeout\n"));
-    }
-    if (DescriptorStatus & RDES0_LC) {
-      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Late Collision\n"));
-    }
-    if (DescriptorStatus & RDES0_GF) {
-      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Giant Frame\n"));
-    }
-    if (DescriptorStatus & RDES0_OE) {
-      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Overflow Error\n"));
-    }
-    if (DescriptorStatus & RDES0_LE) {
-      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error:Length Error\n"));
-    }
-    if (DescriptorStatus & RDES0_DBE) {
-      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Dribble Bit Error\n"));
+  //
+  // Walk the ready descriptors until a good frame turns up. Bad frames are
+  // handed straight back to the DMA engine so that they cannot stall the
+  // ring, and the caller does not have to poll once per bad frame.
+  //
+  for (;;) {
+    DescNum = MacDriver->RxNextDescriptorNum;
+    RxDescriptor = &MacDriver->RxdescRing[DescNum];
+
+    DescriptorStatus = RxDescriptor->Tdes0;
+    if (DescriptorStatus & ((UINT32)RDES0_OWN)) {
+      Status = EFI_NOT_READY;
+      goto ReleaseLock;
     }
 
-    // Check descriptor error status
-    if (DescriptorStatus & RDES0_CE) {
-      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: CRC Error\n"));
+    // Read the frame only after seeing the descriptor released
+    MemoryFence ();
+
+    Length = (DescriptorStatus >> RDES0_FL_SHIFT) & RDES0_FL_MASK;
+
+    if (DescriptorStatus & RDES0_SAF) {
+      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Source Address Filter Fail\n"));
+    } else if (DescriptorStatus & RDES0_AFM) {
+      DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Destination Address Filter Fail\n"));
+    } else if (DescriptorStatus & RDES0_ES) {
+      // Check for errors
+      if (DescriptorStatus & RDES0_RE) {
+        DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Receive Error\n"));
+      }
+      if (DescriptorStatus & RDES0_DE) {
+        DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Receive Error\n"));
+      }
+      if (DescriptorStatus & RDES0_RWT) {
+        DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Watchdog Timeout\n"));
+      }
+      if (DescriptorStatus & RDES0_LC) {
+        DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Late Collision\n"));
+      }
+      if (DescriptorStatus & RDES0_GF) {
+        DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Giant Frame\n"));
+      }
+      if (DescriptorStatus & RDES0_OE) {
+        DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Overflow Error\n"));
+      }
+      if (DescriptorStatus & RDES0_LE) {
+        DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error:Length Error\n"));
+      }
+      if (DescriptorStatus & RDES0_DBE) {
+        DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: Dribble Bit Error\n"));
+      }
+
+      // Check descriptor error status
+      if (DescriptorStatus & RDES0_CE) {
+        DEBUG ((DEBUG_WARN, "SNP:DXE: Rx Descritpor Status Error: CRC Error\n"));
+      }
+    } else if (!Length) {
+      DEBUG ((DEBUG_WARN, "SNP:DXE: Error: Invalid Frame Packet length \r\n"));
+    } else {
+      break;
     }
-    return EFI_DEVICE_ERROR;
-  }
 
-  Length = (DescriptorStatus >> RDES0_FL_SHIFT) & RDES0_FL_MASK;
-  if (!Length) {
-    DEBUG ((DEBUG_WARN, "SNP:DXE: Error: Invalid Frame Packet length \r\n"));
-    return EFI_NOT_READY;
+    RxDescriptor->Tdes0 = (UINT32)RDES0_OWN;
+    MacDriver->RxNextDescriptorNum = (DescNum + 1) % MacDriver->RxDescriptorCount;
   }
-  // Check buffer size
+
+  // Check buffer size; the frame stays queued until a large enough buffer
+  // is offered
   if (*BuffSize < Length) {
     DEBUG ((DEBUG_WARN, "SNP:DXE: Error: Buffer size is too small\n"));
-    return EFI_BUFFER_TOO_SMALL;
+    *BuffSize = Length;
+    Status = EFI_BUFFER_TOO_SMALL;
+    goto ReleaseLock;
   }
   *BuffSize = Length;
 
   if (HdrSize != NULL)
     *HdrSize = Snp->SnpMode.MediaHeaderSize;
 
-  DmaUnmap (Snp->MacDriver.RxBufNum[DescNum].Mapping);
-  Snp->MacDriver.RxBufNum[DescNum].Mapping = NULL;
-
-  CopyMem (RawData, (VOID *)RxBufferAddr, *BuffSize);
+  CopyMem (RawData, EMAC_RX_BUFFER (MacDriver, DescNum), *BuffSize);
 
   if (DstAddr != NULL) {
     Dst.Addr[0] = RawData[0];
@@ -1238,31 +1262,16 @@ SnpReceive (
     *Protocol = NTOHS (RawData[12] | (RawData[13] >> 8) | (RawData[14] >> 16) | (RawData[15] >> 24));
   }
 
-  // DMA map for the current receive buffer
-  Status = DmaMap (MapOperationBusMasterWrite,  (VOID *)RxBufferAddr,
-             &BufferSizeBuf, &RxBufferAddrMap, &Snp->MacDriver.RxBufNum[DescNum].Mapping);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a () for Rxbuffer: %r\n", __FUNCTION__, Status));
-    return Status;
-  }
-  Snp->MacDriver.RxBufNum[DescNum].AddrMap = RxBufferAddrMap;
-  RxDescriptorMap->Addr = Snp->MacDriver.RxBufNum[DescNum].AddrMap;
-
-  RxDescriptor->Tdes0 |= (UINT32)RDES0_OWN;
+  // Hand the descriptor back; its buffer stays mapped
+  RxDescriptor->Tdes0 = (UINT32)RDES0_OWN;
 
   // Increase descriptor number
-  DescNum++;
-
-  if (DescNum >= CONFIG_RX_DESCR_NUM) {
-    DescNum = 0;
-  }
-  Snp->MacDriver.RxNextDescriptorNum = DescNum;
-
-  EfiReleaseLock (&Snp->Lock);
-  return EFI_SUCCESS;
+  MacDriver->RxNextDescriptorNum = (DescNum + 1) % MacDriver->RxDescriptorCount;
+  Status = EFI_SUCCESS;
 
 ReleaseLock:
+  // Descriptors may have been returned to a ring the DMA found full
+  EmacRxPollDemand (Snp->MacBase);
   EfiReleaseLock (&Snp->Lock);
-  return EFI_NOT_READY;
+  return Status;
 }
-
@@ -60,15 +60,13 @@ typedef struct {
   // Array of the recycled transmit buffer address
   UINT64                                 *RecycledTxBuf;
 
-  // The maximum number of recycled buffer pointers in RecycledTxBuf
+  // The maximum number of recycled buffer pointers in RecycledTxBuf, one
+  // per transmit descriptor
   UINT32                                 MaxRecycledTxBuf;
 
   // Current number of recycled buffer pointers in RecycledTxBuf
   UINT32                                 RecycledTxBufCount;
 
-  // For TX buffer DmaUnmap
-  VOID                                   *MappingTxbuf;
-
 } SIMPLE_NETWORK_DRIVER;
 
 extern EFI_COMPONENT_NAME_PROTOCOL       gSnpComponentName;
@@ -76,10 +74,6 @@ extern EFI_COMPONENT_NAME2_PROTOCOL      gSnpComponentName2;
 
 #define SNP_DRIVER_SIGNATURE             SIGNATURE_32('A', 'S', 'N', 'P')
 #define INSTANCE_FROM_SNP_THIS(a)        CR(a, SIMPLE_NETWORK_DRIVER, Snp, SNP_DRIVER_SIGNATURE)
-#define SNP_TX_BUFFER_INCREASE           32
-#define SNP_MAX_TX_BUFFER_NUM            65536
-#define DESC_NUM                         10
-#define ETH_BUFSIZE                      0x800
 /*---------------------------------------------------------------------------------------------------------------------
 
   UEFI-Compliant functions for EFI_SIMPLE_NETWORK_PROTOCOL
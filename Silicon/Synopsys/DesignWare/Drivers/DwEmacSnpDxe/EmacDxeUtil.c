@@ -18,8 +18,10 @@
 
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/DmaLib.h>
 #include <Library/IoLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/TimerLib.h>
 
 VOID
 EFIAPI
@@ -99,6 +101,127 @@ EmacDxeInitialization (
 }
 
 
+STATIC
+EFI_STATUS
+EmacDmaAllocCommonBuffer (
+  IN  UINTN       Size,
+  OUT VOID        **Buffer,
+  OUT MAP_INFO    *Map
+  )
+{
+  EFI_STATUS      Status;
+  UINTN           Pages;
+  UINTN           MapSize;
+
+  Pages = EFI_SIZE_TO_PAGES (Size);
+  Status = DmaAllocateBuffer (EfiBootServicesData, Pages, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  MapSize = EFI_PAGES_TO_SIZE (Pages);
+  Status = DmaMap (MapOperationBusMasterCommonBuffer, *Buffer, &MapSize,
+             &Map->AddrMap, &Map->Mapping);
+  if (!EFI_ERROR (Status) &&
+      ((MapSize != EFI_PAGES_TO_SIZE (Pages)) ||
+       (Map->AddrMap + MapSize > SIZE_4GB))) {
+    // The descriptors only hold 32-bit bus addresses
+    DmaUnmap (Map->Mapping);
+    Status = EFI_UNSUPPORTED;
+  }
+  if (EFI_ERROR (Status)) {
+    DmaFreeBuffer (Pages, *Buffer);
+    *Buffer = NULL;
+    return Status;
+  }
+
+  ZeroMem (*Buffer, MapSize);
+  return EFI_SUCCESS;
+}
+
+
+STATIC
+VOID
+EmacDmaFreeCommonBuffer (
+  IN  UINTN       Size,
+  IN  VOID        *Buffer,
+  IN  MAP_INFO    *Map
+  )
+{
+  if (Buffer != NULL) {
+    DmaUnmap (Map->Mapping);
+    DmaFreeBuffer (EFI_SIZE_TO_PAGES (Size), Buffer);
+  }
+}
+
+
+EFI_STATUS
+EFIAPI
+EmacDmaAllocate (
+  IN  EMAC_DRIVER   *EmacDriver,
+  IN  UINT32        TxDescriptorCount,
+  IN  UINT32        RxDescriptorCount
+  )
+{
+  EFI_STATUS        Status;
+
+  // At least three descriptors must be chained before any is reused
+  ASSERT (TxDescriptorCount >= 3 && RxDescriptorCount >= 3);
+
+  ZeroMem (EmacDriver, sizeof (*EmacDriver));
+  EmacDriver->TxDescriptorCount = TxDescriptorCount;
+  EmacDriver->RxDescriptorCount = RxDescriptorCount;
+
+  EmacDriver->TxBufferOwner = AllocateZeroPool (TxDescriptorCount * sizeof (VOID *));
+  if (EmacDriver->TxBufferOwner == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = EmacDmaAllocCommonBuffer (TxDescriptorCount * sizeof (DESIGNWARE_HW_DESCRIPTOR),
+             (VOID **)&EmacDriver->TxdescRing, &EmacDriver->TxdescRingMap);
+  if (!EFI_ERROR (Status)) {
+    Status = EmacDmaAllocCommonBuffer (RxDescriptorCount * sizeof (DESIGNWARE_HW_DESCRIPTOR),
+               (VOID **)&EmacDriver->RxdescRing, &EmacDriver->RxdescRingMap);
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = EmacDmaAllocCommonBuffer (TxDescriptorCount * CONFIG_ETH_BUFSIZE,
+               (VOID **)&EmacDriver->TxBuffer, &EmacDriver->TxBufferMap);
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = EmacDmaAllocCommonBuffer (RxDescriptorCount * CONFIG_ETH_BUFSIZE,
+               (VOID **)&EmacDriver->RxBuffer, &EmacDriver->RxBufferMap);
+  }
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "SNP:MAC: %a (): %r\n", __FUNCTION__, Status));
+    EmacDmaFree (EmacDriver);
+  }
+
+  return Status;
+}
+
+
+VOID
+EFIAPI
+EmacDmaFree (
+  IN  EMAC_DRIVER   *EmacDriver
+  )
+{
+  EmacDmaFreeCommonBuffer (EmacDriver->RxDescriptorCount * CONFIG_ETH_BUFSIZE,
+    EmacDriver->RxBuffer, &EmacDriver->RxBufferMap);
+  EmacDmaFreeCommonBuffer (EmacDriver->TxDescriptorCount * CONFIG_ETH_BUFSIZE,
+    EmacDriver->TxBuffer, &EmacDriver->TxBufferMap);
+  EmacDmaFreeCommonBuffer (EmacDriver->RxDescriptorCount * sizeof (DESIGNWARE_HW_DESCRIPTOR),
+    EmacDriver->RxdescRing, &EmacDriver->RxdescRingMap);
+  EmacDmaFreeCommonBuffer (EmacDriver->TxDescriptorCount * sizeof (DESIGNWARE_HW_DESCRIPTOR),
+    EmacDriver->TxdescRing, &EmacDriver->TxdescRingMap);
+  if (EmacDriver->TxBufferOwner != NULL) {
+    FreePool (EmacDriver->TxBufferOwner);
+  }
+
+  ZeroMem (EmacDriver, sizeof (*EmacDriver));
+}
+
+
 EFI_STATUS
 EFIAPI
 EmacDmaInit (
@@ -227,30 +350,31 @@ EmacSetupTxdesc (
   IN  UINTN         MacBaseAddress
  )
 {
-  INTN                       Index;
+  UINT32                     Index;
   DESIGNWARE_HW_DESCRIPTOR   *TxDescriptor;
 
-  for (Index = 0; Index < CONFIG_TX_DESCR_NUM; Index++) {
-    TxDescriptor = (VOID *)(UINTN)EmacDriver->TxdescRingMap[Index].AddrMap;
-    TxDescriptor->Addr = (UINT32)(UINTN)&EmacDriver->TxBuffer[Index * CONFIG_ETH_BUFSIZE];
-    if (Index < 9) {
-      TxDescriptor->AddrNext = (UINT32)(UINTN)EmacDriver->TxdescRingMap[Index + 1].AddrMap;
-    }
+  for (Index = 0; Index < EmacDriver->TxDescriptorCount; Index++) {
+    TxDescriptor = &EmacDriver->TxdescRing[Index];
+    TxDescriptor->Addr = (UINT32)(EmacDriver->TxBufferMap.AddrMap +
+                                  Index * CONFIG_ETH_BUFSIZE);
+    // The last descriptor chains back to the first one
+    TxDescriptor->AddrNext = (UINT32)(EmacDriver->TxdescRingMap.AddrMap +
+                                      ((Index + 1) % EmacDriver->TxDescriptorCount) *
+                                      sizeof (DESIGNWARE_HW_DESCRIPTOR));
     TxDescriptor->Tdes0 = TDES0_TXCHAIN;
     TxDescriptor->Tdes1 = 0;
+    EmacDriver->TxBufferOwner[Index] = NULL;
   }
 
-  // Correcting the last pointer of the chain
-  TxDescriptor->AddrNext = (UINT32)(UINTN)EmacDriver->TxdescRingMap[0].AddrMap;
-
   // Write the address of tx descriptor list
   MmioWrite32 (MacBaseAddress +
               DW_EMAC_DMAGRP_TRANSMIT_DESCRIPTOR_LIST_ADDRESS_OFST,
-              (UINT32)(UINTN)EmacDriver->TxdescRingMap[0].AddrMap);
+              (UINT32)EmacDriver->TxdescRingMap.AddrMap);
 
   // Initialize the descriptor number
   EmacDriver->TxCurrentDescriptorNum = 0;
   EmacDriver->TxNextDescriptorNum = 0;
+  EmacDriver->TxPendingCount = 0;
 
   return EFI_SUCCESS;
 }
@@ -263,26 +387,25 @@ EmacSetupRxdesc (
   IN  UINTN         MacBaseAddress
   )
 {
-  INTN                        Index;
+  UINT32                      Index;
   DESIGNWARE_HW_DESCRIPTOR    *RxDescriptor;
 
-  for (Index = 0; Index < CONFIG_RX_DESCR_NUM; Index++) {
-    RxDescriptor = (VOID *)(UINTN)EmacDriver->RxdescRingMap[Index].AddrMap;
-    RxDescriptor->Addr = EmacDriver->RxBufNum[Index].AddrMap;
-    if (Index < 9) {
-      RxDescriptor->AddrNext = (UINT32)(UINTN)EmacDriver->RxdescRingMap[Index + 1].AddrMap;
-    }
-    RxDescriptor->Tdes0 = RDES0_OWN;
+  for (Index = 0; Index < EmacDriver->RxDescriptorCount; Index++) {
+    RxDescriptor = &EmacDriver->RxdescRing[Index];
+    RxDescriptor->Addr = (UINT32)(EmacDriver->RxBufferMap.AddrMap +
+                                  Index * CONFIG_ETH_BUFSIZE);
+    // The last descriptor chains back to the first one
+    RxDescriptor->AddrNext = (UINT32)(EmacDriver->RxdescRingMap.AddrMap +
+                                      ((Index + 1) % EmacDriver->RxDescriptorCount) *
+                                      sizeof (DESIGNWARE_HW_DESCRIPTOR));
     RxDescriptor->Tdes1 = RDES1_CHAINED | RX_MAX_PACKET;
+    RxDescriptor->Tdes0 = RDES0_OWN;
   }
 
-  // Correcting the last pointer of the chain
-  RxDescriptor->AddrNext = (UINT32)(UINTN)EmacDriver->RxdescRingMap[0].AddrMap;
-
-  // Write the address of tx descriptor list
+  // Write the address of rx descriptor list
   MmioWrite32(MacBaseAddress +
               DW_EMAC_DMAGRP_RECEIVE_DESCRIPTOR_LIST_ADDRESS_OFST,
-              (UINT32)(UINTN)EmacDriver->RxdescRingMap[0].AddrMap);
+              (UINT32)EmacDriver->RxdescRingMap.AddrMap);
 
   // Initialize the descriptor number
   EmacDriver->RxCurrentDescriptorNum = 0;
@@ -449,6 +572,9 @@ EmacStopTxRx (
    IN  UINTN   MacBaseAddress
   )
 {
+  UINT32   DmaStatus;
+  UINTN    Timeout;
+
   DEBUG ((DEBUG_INFO, "SNP:MAC: %a ()\r\n", __FUNCTION__));
 
   // Stop DMA TX
@@ -472,6 +598,19 @@ EmacStopTxRx (
              DW_EMAC_DMAGRP_OPERATION_MODE_OFST,
              DW_EMAC_DMAGRP_OPERATION_MODE_SR_CLR_MSK);
 
+  // Both engines finish the frame in flight before they stop, wait for that
+  // so the descriptor rings and buffers may be released afterwards
+  for (Timeout = DMA_STOP_TIMEOUT_US; Timeout > 0; Timeout--) {
+    DmaStatus = MmioRead32 (MacBaseAddress + DW_EMAC_DMAGRP_STATUS_OFST);
+    if (DW_EMAC_DMAGRP_STATUS_TS_GET (DmaStatus) == 0 &&
+        DW_EMAC_DMAGRP_STATUS_RS_GET (DmaStatus) == 0) {
+      break;
+    }
+    MicroSecondDelay (1);
+  }
+  if (Timeout == 0) {
+    DEBUG ((DEBUG_WARN, "SNP:MAC: DMA did not stop, status 0x%08x\r\n", DmaStatus));
+  }
 }
 
 
@@ -489,6 +628,19 @@ EmacDmaStart (
 }
 
 
+VOID
+EFIAPI
+EmacRxPollDemand (
+  IN  UINTN   MacBaseAddress
+  )
+{
+  // Resume reception if the DMA suspended on a full ring
+  MmioWrite32 (MacBaseAddress +
+               DW_EMAC_DMAGRP_RECEIVE_POLL_DEMAND_OFST,
+               0x1);
+}
+
+
 VOID
 EFIAPI
 EmacGetDmaStatus (
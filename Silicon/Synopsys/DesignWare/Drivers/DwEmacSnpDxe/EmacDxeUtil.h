@@ -25,10 +25,10 @@
 #define RX_MAX_PACKET                                             1600
 
 #define CONFIG_ETH_BUFSIZE                                         2048
-#define CONFIG_TX_DESCR_NUM                                        10
-#define CONFIG_RX_DESCR_NUM                                        10
-#define TX_TOTAL_BUFSIZE                                           (CONFIG_ETH_BUFSIZE * CONFIG_TX_DESCR_NUM)
-#define RX_TOTAL_BUFSIZE                                           (CONFIG_ETH_BUFSIZE * CONFIG_RX_DESCR_NUM)
+// Largest buffer a single TX descriptor may describe
+#define TX_MAX_FRAME_SIZE                                          2047
+// How long EmacStopTxRx waits for the DMA engines to go idle
+#define DMA_STOP_TIMEOUT_US                                        10000
 
 // DMA status error bit
 #define RX_DMA_WRITE_DATA_TRANSFER_ERROR                           0x0
@@ -136,6 +136,8 @@
 
 #define DW_EMAC_DMAGRP_BUS_MODE_SWR_GET(value)                      (((value) & 0x00000001) >> 0)
 #define DW_EMAC_DMAGRP_STATUS_EB_GET(value)                         (((value) & 0x03800000) >> 23)
+#define DW_EMAC_DMAGRP_STATUS_TS_GET(value)                         (((value) & 0x00700000) >> 20)
+#define DW_EMAC_DMAGRP_STATUS_RS_GET(value)                         (((value) & 0x000e0000) >> 17)
 #define DW_EMAC_GMACGRP_GMII_ADDRESS_GB_GET(value)                  (((value) & 0x00000001) >> 0)
 #define DW_EMAC_GMACGRP_GMII_DATA_GD_GET(value)                     (((value) & 0x0000ffff) >> 0)
 #define DW_EMAC_DMAGRP_OPERATION_MODE_FTF_GET(value)                (((value) & 0x00100000) >> 20)
@@ -241,20 +243,38 @@ typedef struct {
   void                        *Mapping;
 } MAP_INFO;
 
+//
+// The descriptor rings and the packet buffers behind them are each one
+// contiguous common buffer, allocated and mapped once when the driver starts.
+// Descriptor N owns the CONFIG_ETH_BUFSIZE bytes at offset
+// N * CONFIG_ETH_BUFSIZE of the matching packet buffer.
+//
 typedef struct {
-  DESIGNWARE_HW_DESCRIPTOR    *TxdescRing[CONFIG_TX_DESCR_NUM];
-  DESIGNWARE_HW_DESCRIPTOR    *RxdescRing[CONFIG_RX_DESCR_NUM];
-  CHAR8                       TxBuffer[TX_TOTAL_BUFSIZE];
-  CHAR8                       RxBuffer[RX_TOTAL_BUFSIZE];
-  MAP_INFO                    TxdescRingMap[CONFIG_TX_DESCR_NUM ];
-  MAP_INFO                    RxdescRingMap[CONFIG_RX_DESCR_NUM ];
-  MAP_INFO                    RxBufNum[CONFIG_TX_DESCR_NUM];
+  DESIGNWARE_HW_DESCRIPTOR    *TxdescRing;
+  DESIGNWARE_HW_DESCRIPTOR    *RxdescRing;
+  UINT8                       *TxBuffer;
+  UINT8                       *RxBuffer;
+  MAP_INFO                    TxdescRingMap;
+  MAP_INFO                    RxdescRingMap;
+  MAP_INFO                    TxBufferMap;
+  MAP_INFO                    RxBufferMap;
+  // Caller buffer of each outstanding transmit, returned by GetStatus
+  VOID                        **TxBufferOwner;
+  UINT32                      TxDescriptorCount;
+  UINT32                      RxDescriptorCount;
+  // Number of transmit descriptors still owned by the DMA engine
+  UINT32                      TxPendingCount;
+  // Oldest outstanding transmit descriptor
   UINT32                      TxCurrentDescriptorNum;
+  // Next free transmit descriptor
   UINT32                      TxNextDescriptorNum;
   UINT32                      RxCurrentDescriptorNum;
   UINT32                      RxNextDescriptorNum;
 } EMAC_DRIVER;
 
+#define EMAC_TX_BUFFER(Emac, Index)    ((Emac)->TxBuffer + (Index) * CONFIG_ETH_BUFSIZE)
+#define EMAC_RX_BUFFER(Emac, Index)    ((Emac)->RxBuffer + (Index) * CONFIG_ETH_BUFSIZE)
+
 VOID
 EFIAPI
 EmacSetMacAddress (
@@ -276,6 +296,20 @@ EmacDxeInitialization (
   IN  UINTN                   MacBaseAddress
   );
 
+EFI_STATUS
+EFIAPI
+EmacDmaAllocate (
+  IN  EMAC_DRIVER             *EmacDriver,
+  IN  UINT32                  TxDescriptorCount,
+  IN  UINT32                  RxDescriptorCount
+  );
+
+VOID
+EFIAPI
+EmacDmaFree (
+  IN  EMAC_DRIVER             *EmacDriver
+  );
+
 EFI_STATUS
 EFIAPI
 EmacDmaInit (
@@ -338,6 +372,12 @@ EmacDmaStart (
   IN  UINTN                   MacBaseAddress
   );
 
+VOID
+EFIAPI
+EmacRxPollDemand (
+  IN  UINTN                   MacBaseAddress
+  );
+
 
 VOID
 EFIAPI
@@ -31,6 +31,7 @@
 #define DWEMMC_BLOCK_SIZE               512
 #define DWEMMC_DMA_BUF_SIZE             (512 * 8)
 #define DWEMMC_MAX_DESC_PAGES           512
+#define DWEMMC_POLL_DELAY_US            10
 
 typedef struct {
   UINT32                        Des0;
@@ -41,6 +42,7 @@ typedef struct {
 
 EFI_MMC_HOST_PROTOCOL     *gpMmcHost;
 DWEMMC_IDMAC_DESCRIPTOR   *gpIdmacDesc;
+STATIC UINTN              mIdmacDescCount;
 EFI_GUID mDwEmmcDevicePathGuid = EFI_CALLER_ID_GUID;
 STATIC UINT32 mDwEmmcCommand;
 STATIC UINT32 mDwEmmcArgument;
@@ -290,7 +292,7 @@ SendCommand (
             DWEMMC_INT_RCRC | DWEMMC_INT_RE;
   ErrMask |= DWEMMC_INT_DCRC | DWEMMC_INT_DRT | DWEMMC_INT_SBE;
   do {
-    MicroSecondDelay(500);
+    MicroSecondDelay (DWEMMC_POLL_DELAY_US);
     Data = MmioRead32 (DWEMMC_RINTSTS);
 
     if (Data & ErrMask) {
@@ -455,6 +457,29 @@ DwEmmcAdjustFifoThreshold (
   MmioWrite32 (DWEMMC_FIFOTH, FifoThreshold);
 }
 
+/*
+ * Link all descriptors into a ring once, so that a transfer only has
+ * to fill in the buffers and flags of the descriptors it uses.
+ */
+VOID
+InitIdmacRing (
+  IN DWEMMC_IDMAC_DESCRIPTOR*    IdmacDesc,
+  IN UINTN                      Count
+  )
+{
+  UINTN  Idx;
+
+  for (Idx = 0; Idx < Count; Idx++) {
+    (IdmacDesc + Idx)->Des0 = 0;
+    (IdmacDesc + Idx)->Des1 = 0;
+    (IdmacDesc + Idx)->Des2 = 0;
+    /* Next Descriptor Address */
+    (IdmacDesc + Idx)->Des3 = (UINT32)((UINTN)IdmacDesc +
+                                       (sizeof(DWEMMC_IDMAC_DESCRIPTOR) * ((Idx + 1) % Count)));
+  }
+  WriteBackDataCacheRange (IdmacDesc, Count * sizeof (DWEMMC_IDMAC_DESCRIPTOR));
+}
+
 EFI_STATUS
 PrepareDmaData (
   IN DWEMMC_IDMAC_DESCRIPTOR*    IdmacDesc,
@@ -464,7 +489,14 @@ PrepareDmaData (
 {
   UINTN  Cnt, Blks, Idx, LastIdx;
 
+  if (Length == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
   Cnt = (Length + DWEMMC_DMA_BUF_SIZE - 1) / DWEMMC_DMA_BUF_SIZE;
+  if (Cnt > mIdmacDescCount) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
   Blks = (Length + DWEMMC_BLOCK_SIZE - 1) / DWEMMC_BLOCK_SIZE;
   Length = DWEMMC_BLOCK_SIZE * Blks;
 
@@ -474,20 +506,16 @@ PrepareDmaData (
     (IdmacDesc + Idx)->Des1 = DWEMMC_IDMAC_DES1_BS1(DWEMMC_DMA_BUF_SIZE);
     /* Buffer Address */
     (IdmacDesc + Idx)->Des2 = (UINT32)((UINTN)Buffer + DWEMMC_DMA_BUF_SIZE * Idx);
-    /* Next Descriptor Address */
-    (IdmacDesc + Idx)->Des3 = (UINT32)((UINTN)IdmacDesc +
-                                       (sizeof(DWEMMC_IDMAC_DESCRIPTOR) * (Idx + 1)));
   }
   /* First Descriptor */
   IdmacDesc->Des0 |= DWEMMC_IDMAC_DES0_FS;
-  /* Last Descriptor */
+  /* Last Descriptor, the IDMAC stops here rather than following the ring */
   LastIdx = Cnt - 1;
   (IdmacDesc + LastIdx)->Des0 |= DWEMMC_IDMAC_DES0_LD;
   (IdmacDesc + LastIdx)->Des0 &= ~(DWEMMC_IDMAC_DES0_DIC | DWEMMC_IDMAC_DES0_CH);
   (IdmacDesc + LastIdx)->Des1 = DWEMMC_IDMAC_DES1_BS1(Length -
                                                       (LastIdx * DWEMMC_DMA_BUF_SIZE));
-  /* Set the Next field of Last Descriptor */
-  (IdmacDesc + LastIdx)->Des3 = 0;
+  WriteBackDataCacheRange (IdmacDesc, Cnt * sizeof (DWEMMC_IDMAC_DESCRIPTOR));
   MmioWrite32 (DWEMMC_DBADDR, (UINT32)((UINTN)IdmacDesc));
 
   return EFI_SUCCESS;
@@ -520,15 +548,10 @@ DwEmmcReadBlockData (
   )
 {
   EFI_STATUS  Status;
-  UINT32      DescPages, CountPerPage, Count;
   EFI_TPL     Tpl;
 
   Tpl = gBS->RaiseTPL (TPL_NOTIFY);
 
-  CountPerPage = EFI_PAGE_SIZE / 16;
-  Count = (Length + DWEMMC_DMA_BUF_SIZE - 1) / DWEMMC_DMA_BUF_SIZE;
-  DescPages = (Count + CountPerPage - 1) / CountPerPage;
-
   InvalidateDataCacheRange (Buffer, Length);
 
   Status = PrepareDmaData (gpIdmacDesc, Length, Buffer);
@@ -536,7 +559,6 @@ DwEmmcReadBlockData (
     goto out;
   }
 
-  WriteBackDataCacheRange (gpIdmacDesc, DescPages * EFI_PAGE_SIZE);
   StartDma (Length);
 
   Status = SendCommand (mDwEmmcCommand, mDwEmmcArgument);
@@ -559,15 +581,10 @@ DwEmmcWriteBlockData (
   )
 {
   EFI_STATUS  Status;
-  UINT32      DescPages, CountPerPage, Count;
   EFI_TPL     Tpl;
 
   Tpl = gBS->RaiseTPL (TPL_NOTIFY);
 
-  CountPerPage = EFI_PAGE_SIZE / 16;
-  Count = (Length + DWEMMC_DMA_BUF_SIZE - 1) / DWEMMC_DMA_BUF_SIZE;
-  DescPages = (Count + CountPerPage - 1) / CountPerPage;
-
   WriteBackDataCacheRange (Buffer, Length);
 
   Status = PrepareDmaData (gpIdmacDesc, Length, Buffer);
@@ -575,7 +592,6 @@ DwEmmcWriteBlockData (
     goto out;
   }
 
-  WriteBackDataCacheRange (gpIdmacDesc, DescPages * EFI_PAGE_SIZE);
   StartDma (Length);
 
   Status = SendCommand (mDwEmmcCommand, mDwEmmcArgument);
@@ -683,6 +699,9 @@ DwEmmcDxeInitialize (
   if (gpIdmacDesc == NULL) {
     return EFI_BUFFER_TOO_SMALL;
   }
+  mIdmacDescCount = EFI_PAGES_TO_SIZE (DWEMMC_MAX_DESC_PAGES) /
+                    sizeof (DWEMMC_IDMAC_DESCRIPTOR);
+  InitIdmacRing (gpIdmacDesc, mIdmacDescCount);
 
   DEBUG ((DEBUG_BLKIO, "DwEmmcDxeInitialize()\n"));
 